@@ -114,16 +114,44 @@ static inline Optional<size_t> memmem_optional(const void* haystack, size_t hays
         return {};
     }
 
+    size_t skipped = 0;
+#ifndef KERNEL
+    // Jump from one place where the needle could start to the next with memchr(), which is a lot faster than
+    // looking at every byte like the searches below do. Comparing the rest of the needle at each of those places
+    // adds up to quadratic time though, so once that has looked at more bytes than memchr() got to skip, fall
+    // back to the searches below, which take linear time.
+    auto* haystack_bytes = (const u8*)haystack;
+    auto* needle_bytes = (const u8*)needle;
+    size_t last_start = haystack_length - needle_length;
+    size_t compared = 0;
+    while (compared <= 64 + skipped) {
+        auto* candidate = (const u8*)__builtin_memchr(haystack_bytes + skipped, needle_bytes[0], last_start - skipped + 1);
+        if (!candidate)
+            return {};
+        skipped = candidate - haystack_bytes;
+        if (__builtin_memcmp(candidate + 1, needle_bytes + 1, needle_length - 1) == 0)
+            return skipped;
+        compared += needle_length - 1;
+        if (++skipped > last_start)
+            return {};
+    }
+    haystack = haystack_bytes + skipped;
+    haystack_length -= skipped;
+#endif
+
     if (needle_length < 32) {
         auto ptr = bitap_bitwise(haystack, haystack_length, needle, needle_length);
         if (ptr)
-            return static_cast<size_t>((FlatPtr)ptr - (FlatPtr)haystack);
+            return skipped + static_cast<size_t>((FlatPtr)ptr - (FlatPtr)haystack);
         return {};
     }
 
     // Fallback to KMP.
     Array<Span<const u8>, 1> spans { Span<const u8> { (const u8*)haystack, haystack_length } };
-    return memmem(spans.begin(), spans.end(), { (const u8*)needle, needle_length });
+    auto offset = memmem(spans.begin(), spans.end(), { (const u8*)needle, needle_length });
+    if (offset.has_value())
+        return skipped + offset.value();
+    return {};
 }
 
 static inline const void* memmem(const void* haystack, size_t haystack_length, const void* needle, size_t needle_length)
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+// An I/O ring is created with io_ring_create() and mapped into userspace with mmap() on the returned fd.
+// The mapping starts with an IORingHeader, followed by the submission entries and then the completion entries.
+// Userspace fills in submission entries and moves submission_tail forward, then calls io_ring_enter().
+// The kernel moves submission_head forward as it takes them, and posts one completion for each of them.
+
+enum class IORingOpcode : u8 {
+    Nop,
+    Read,
+    Write,
+    Fsync,
+    Send,
+    Recv,
+    Accept,
+    Poll,
+};
+
+// Read and Write use and move the file offset like read() and write() do, unless a different offset is given.
+constexpr u64 IO_RING_CURRENT_OFFSET = ~(u64)0;
+
+constexpr u32 IO_RING_MAX_ENTRIES = 4096;
+
+struct IORingSubmission {
+    IORingOpcode opcode;
+    u8 reserved;
+    u16 poll_events; // POLLIN and/or POLLOUT for Poll.
+    i32 fd;
+    u32 length;
+    i32 flags; // MSG_* for Send and Recv, SOCK_NONBLOCK and SOCK_CLOEXEC for Accept.
+    u64 offset;
+    u64 buffer;
+    u64 user_data;
+};
+
+struct IORingCompletion {
+    u64 user_data;
+    i32 result; // What the equivalent syscall would have returned, or a negated errno.
+    u32 reserved;
+};
+
+struct IORingHeader {
+    u32 submission_head; // Only written by the kernel.
+    u32 submission_tail; // Only written by userspace.
+    u32 completion_head; // Only written by userspace.
+    u32 completion_tail; // Only written by the kernel.
+    u32 submission_entries;
+    u32 completion_entries;
+    u32 submissions_offset;
+    u32 completions_offset;
+};
+
+constexpr size_t io_ring_submissions_offset()
+{
+    return (sizeof(IORingHeader) + 63) & ~(size_t)63;
+}
+
+constexpr size_t io_ring_completions_offset(u32 entries)
+{
+    return io_ring_submissions_offset() + entries * sizeof(IORingSubmission);
+}
+
+// There are twice as many completion entries as submission entries.
+constexpr size_t io_ring_mapping_size(u32 entries)
+{
+    return (io_ring_completions_offset(entries) + 2 * entries * sizeof(IORingCompletion) + 4095) & ~(size_t)4095;
+}
@@ -81,7 +81,7 @@ enum class NeedsBigProcessLock {
     S(fstat, NeedsBigProcessLock::Yes)                      \
     S(fstatvfs, NeedsBigProcessLock::Yes)                   \
     S(ftruncate, NeedsBigProcessLock::Yes)                  \
-    S(futex, NeedsBigProcessLock::Yes)                      \
+    S(futex, NeedsBigProcessLock::No)                       \
     S(get_dir_entries, NeedsBigProcessLock::Yes)            \
     S(get_process_name, NeedsBigProcessLock::Yes)           \
     S(get_stack_bounds, NeedsBigProcessLock::No)            \
@@ -109,6 +109,8 @@ enum class NeedsBigProcessLock {
     S(halt, NeedsBigProcessLock::Yes)                       \
     S(inode_watcher_add_watch, NeedsBigProcessLock::Yes)    \
     S(inode_watcher_remove_watch, NeedsBigProcessLock::Yes) \
+    S(io_ring_create, NeedsBigProcessLock::Yes)             \
+    S(io_ring_enter, NeedsBigProcessLock::Yes)              \
     S(ioctl, NeedsBigProcessLock::Yes)                      \
     S(join_thread, NeedsBigProcessLock::Yes)                \
     S(kill, NeedsBigProcessLock::Yes)                       \
@@ -135,6 +137,7 @@ enum class NeedsBigProcessLock {
     S(pipe, NeedsBigProcessLock::Yes)                       \
     S(pledge, NeedsBigProcessLock::Yes)                     \
     S(poll, NeedsBigProcessLock::Yes)                       \
+    S(posix_spawn, NeedsBigProcessLock::Yes)                \
     S(prctl, NeedsBigProcessLock::Yes)                      \
     S(profiling_disable, NeedsBigProcessLock::Yes)          \
     S(profiling_enable, NeedsBigProcessLock::Yes)           \
@@ -180,6 +183,7 @@ enum class NeedsBigProcessLock {
     S(sigreturn, NeedsBigProcessLock::Yes)                  \
     S(socket, NeedsBigProcessLock::Yes)                     \
     S(socketpair, NeedsBigProcessLock::Yes)                 \
+    S(splice, NeedsBigProcessLock::Yes)                     \
     S(stat, NeedsBigProcessLock::Yes)                       \
     S(statvfs, NeedsBigProcessLock::Yes)                    \
     S(symlink, NeedsBigProcessLock::Yes)                    \
@@ -397,6 +401,34 @@ struct SC_execve_params {
     StringListArgument environment;
 };
 
+enum class SpawnFileActionType {
+    Open,
+    Close,
+    Dup2,
+    Chdir,
+    Fchdir,
+};
+
+struct SC_spawn_file_action {
+    SpawnFileActionType type;
+    int fd;
+    int new_fd;
+    int options;
+    u16 mode;
+    StringArgument path;
+};
+
+struct SC_posix_spawn_params {
+    StringArgument path;
+    StringListArgument arguments;
+    StringListArgument environment;
+    const SC_spawn_file_action* file_actions;
+    size_t file_action_count;
+    int flags;
+    pid_t pgroup;
+    int sched_priority;
+};
+
 struct SC_readlink_params {
     StringArgument path;
     MutableBufferArgument<char, size_t> buffer;
@@ -488,6 +520,15 @@ struct SC_statvfs_params {
     struct statvfs* buf;
 };
 
+struct SC_splice_params {
+    int fd_in;
+    int64_t* offset_in;
+    int fd_out;
+    int64_t* offset_out;
+    size_t length;
+    unsigned flags;
+};
+
 void initialize();
 int sync();
 
@@ -16,7 +16,7 @@ namespace Kernel {
 class PageDirectoryEntry {
 public:
     PhysicalPtr page_table_base() const { return PhysicalAddress::physical_page_base(m_raw); }
-    void set_page_table_base(u32 value)
+    void set_page_table_base(PhysicalPtr value)
     {
         m_raw &= 0x8000000000000fffULL;
         m_raw |= PhysicalAddress::physical_page_base(value);
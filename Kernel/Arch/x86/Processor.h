@@ -105,7 +105,15 @@ struct DeferredCallEntry {
 class Processor;
 // Note: We only support 8 processors at most at the moment,
 // so allocate 8 slots of inline capacity in the container.
-using ProcessorContainer = Array<Processor*, 8>;
+static constexpr size_t max_processor_count = 8;
+using ProcessorContainer = Array<Processor*, max_processor_count>;
+
+struct TLBStatistics {
+    u64 shootdowns_sent { 0 };
+    u64 shootdown_ipis_sent { 0 };
+    u64 shootdowns_received { 0 };
+    u64 full_flushes { 0 };
+};
 
 class Processor {
     friend class ProcessorInfo;
@@ -133,6 +141,8 @@ class Processor {
     ProcessorInfo* m_info;
     Thread* m_current_thread;
     Thread* m_idle_thread;
+    Memory::PageDirectory* m_active_page_directory;
+    TLBStatistics m_tlb_statistics;
 
     Atomic<ProcessorMessageEntry*> m_message_queue;
 
@@ -157,6 +167,7 @@ class Processor {
     bool smp_enqueue_message(ProcessorMessage&);
     static void smp_unicast_message(u32 cpu, ProcessorMessage& msg, bool async);
     static void smp_broadcast_message(ProcessorMessage& msg);
+    static size_t smp_multicast_message(u32 cpu_mask, ProcessorMessage& msg);
     static void smp_broadcast_wait_sync(ProcessorMessage& msg);
     static void smp_broadcast_halt();
 
@@ -169,6 +180,8 @@ class Processor {
     void cpu_detect();
     void cpu_setup();
 
+    void flush_tlb_local_for(Memory::PageDirectory const&, VirtualAddress, size_t page_count);
+
     String features_string() const;
 
 public:
@@ -219,6 +232,12 @@ public:
     static void flush_tlb_local(VirtualAddress vaddr, size_t page_count);
     static void flush_tlb(Memory::PageDirectory const*, VirtualAddress, size_t);
 
+    void activate_page_directory(Memory::PageDirectory&);
+    Memory::PageDirectory* active_page_directory() const { return m_active_page_directory; }
+    static bool is_pcid_enabled();
+
+    TLBStatistics const& tlb_statistics() const { return m_tlb_statistics; }
+
     Descriptor& get_gdt_entry(u16 selector);
     void flush_gdt();
     const DescriptorTablePointer& get_gdtr();
@@ -401,7 +420,7 @@ public:
     bool smp_process_pending_messages();
 
     static void smp_unicast(u32 cpu, Function<void()>, bool async);
-    static void smp_broadcast_flush_tlb(Memory::PageDirectory const*, VirtualAddress, size_t);
+    static void smp_multicast_flush_tlb(u32 cpu_mask, Memory::PageDirectory const*, VirtualAddress, size_t);
     static u32 smp_wake_n_idle_processors(u32 wake_count);
 
     static void deferred_call_queue(Function<void()> callback);
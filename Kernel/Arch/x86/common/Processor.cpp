@@ -10,6 +10,7 @@
 #include <AK/Types.h>
 
 #include <Kernel/Interrupts/APIC.h>
+#include <Kernel/Memory/PageDirectory.h>
 #include <Kernel/Memory/ProcessPagingScope.h>
 #include <Kernel/Process.h>
 #include <Kernel/Sections.h>
@@ -32,6 +33,15 @@ READONLY_AFTER_INIT FPUState Processor::s_clean_fpu_state;
 READONLY_AFTER_INIT static ProcessorContainer s_processors {};
 READONLY_AFTER_INIT Atomic<u32> Processor::g_total_processors;
 READONLY_AFTER_INIT static volatile bool s_smp_enabled;
+READONLY_AFTER_INIT static bool s_pcid_enabled;
+
+// Flushing a range one page at a time stops paying off somewhere around here.
+static constexpr size_t tlb_full_flush_threshold = 32;
+
+#if ARCH(X86_64)
+// Bit 63 of CR3 tells the CPU to keep the TLB entries tagged with the new PCID.
+static constexpr FlatPtr cr3_pcid_no_flush = (FlatPtr)1 << 63;
+#endif
 
 static Atomic<ProcessorMessage*> s_message_pool;
 Atomic<u32> Processor::s_idle_cpu_mask { 0 };
@@ -47,6 +57,11 @@ bool Processor::is_smp_enabled()
     return s_smp_enabled;
 }
 
+bool Processor::is_pcid_enabled()
+{
+    return s_pcid_enabled;
+}
+
 UNMAP_AFTER_INIT static void sse_init()
 {
     write_cr0((read_cr0() & 0xfffffffbu) | 0x2);
@@ -88,6 +103,8 @@ UNMAP_AFTER_INIT void Processor::cpu_detect()
         set_feature(CPUFeature::SSE3);
     if (processor_info.ecx() & (1 << 9))
         set_feature(CPUFeature::SSSE3);
+    if (processor_info.ecx() & (1 << 17))
+        set_feature(CPUFeature::PCID);
     if (processor_info.ecx() & (1 << 19))
         set_feature(CPUFeature::SSE4_1);
     if (processor_info.ecx() & (1 << 20))
@@ -175,6 +192,18 @@ UNMAP_AFTER_INIT void Processor::cpu_setup()
         write_cr4(read_cr4() | 0x80);
     }
 
+#if ARCH(X86_64)
+    // PCIDs are only safe to use if the kernel's mappings are global, since they're shared by every address space.
+    if (m_cpu == 0)
+        s_pcid_enabled = has_feature(CPUFeature::PCID) && has_feature(CPUFeature::PGE);
+    if (s_pcid_enabled) {
+        VERIFY(has_feature(CPUFeature::PCID));
+        // Turn on CR4.PCIDE, which requires CR3 to have a PCID of 0.
+        VERIFY((read_cr3() & 0xfff) == 0);
+        write_cr4(read_cr4() | 0x20000);
+    }
+#endif
+
     if (has_feature(CPUFeature::NX)) {
         // Turn on IA32_EFER.NXE
         asm volatile(
@@ -275,6 +304,8 @@ String Processor::features_string() const
             return "lm";
         case CPUFeature::HYPERVISOR:
             return "hypervisor";
+        case CPUFeature::PCID:
+            return "pcid";
             // no default statement here intentionally so that we get
             // a warning if a new feature is forgotten to be added here
         }
@@ -309,6 +340,8 @@ UNMAP_AFTER_INIT void Processor::early_initialize(u32 cpu)
     m_message_queue = nullptr;
     m_idle_thread = nullptr;
     m_current_thread = nullptr;
+    m_active_page_directory = nullptr;
+    m_tlb_statistics = {};
     m_info = nullptr;
 
     m_halt_requested = false;
@@ -670,6 +703,14 @@ void Processor::check_invoke_scheduler()
 
 void Processor::flush_tlb_local(VirtualAddress vaddr, size_t page_count)
 {
+    // Reloading CR3 throws away all the non-global entries, which are all the userspace ones.
+    if (page_count > tlb_full_flush_threshold && Memory::is_user_address(vaddr)) {
+        if (Processor::is_initialized())
+            Processor::current().m_tlb_statistics.full_flushes++;
+        flush_entire_tlb_local();
+        return;
+    }
+
     auto ptr = vaddr.as_ptr();
     while (page_count > 0) {
         // clang-format off
@@ -683,12 +724,69 @@ void Processor::flush_tlb_local(VirtualAddress vaddr, size_t page_count)
     }
 }
 
+void Processor::flush_tlb_local_for(Memory::PageDirectory const& page_directory, VirtualAddress vaddr, size_t page_count)
+{
+    if (Memory::is_user_address(vaddr) && m_active_page_directory != &page_directory) {
+        // Without PCIDs, we threw away the entries of this page directory when we stopped using it. With them, the
+        // entries are still around, but don't need to be flushed until the page directory is used again.
+        u32 cpu_bit = 1u << m_cpu;
+        if (s_pcid_enabled && (page_directory.m_tlb_cpu_mask.load() & cpu_bit)) {
+            page_directory.m_stale_tlb_cpu_mask.fetch_or(cpu_bit);
+            page_directory.m_tlb_cpu_mask.fetch_and(~cpu_bit);
+        }
+        return;
+    }
+    flush_tlb_local(vaddr, page_count);
+}
+
 void Processor::flush_tlb(Memory::PageDirectory const* page_directory, VirtualAddress vaddr, size_t page_count)
 {
-    if (s_smp_enabled && (!Memory::is_user_address(vaddr) || Process::current()->thread_count() > 1))
-        smp_broadcast_flush_tlb(page_directory, vaddr, page_count);
-    else
-        flush_tlb_local(vaddr, page_count);
+    ScopedCritical critical;
+    auto& processor = Processor::current();
+    if (s_smp_enabled) {
+        // Kernel mappings are shared by everyone, but userspace ones only concern the CPUs that used the page directory.
+        u32 cpu_mask;
+        if (Memory::is_user_address(vaddr)) {
+            // The page tables were changed before we got here, and the CPU that starts using the page directory
+            // after we've read the mask will see those changes.
+            AK::atomic_thread_fence(AK::MemoryOrder::memory_order_seq_cst);
+            cpu_mask = page_directory->m_tlb_cpu_mask.load();
+        } else {
+            cpu_mask = (1u << count()) - 1;
+        }
+        cpu_mask &= ~(1u << processor.get_id());
+        if (cpu_mask) {
+            smp_multicast_flush_tlb(cpu_mask, page_directory, vaddr, page_count);
+            return;
+        }
+    }
+    processor.flush_tlb_local_for(*page_directory, vaddr, page_count);
+}
+
+void Processor::activate_page_directory(Memory::PageDirectory& page_directory)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    u32 cpu_bit = 1u << m_cpu;
+
+    // Without PCIDs, loading CR3 throws away all the entries of the page directory we're leaving.
+    auto* previous_page_directory = m_active_page_directory;
+    if (!s_pcid_enabled && previous_page_directory && previous_page_directory != &page_directory)
+        previous_page_directory->m_tlb_cpu_mask.fetch_and(~cpu_bit);
+
+    // Anyone changing the page directory from now on will have to tell us about it.
+    page_directory.m_tlb_cpu_mask.fetch_or(cpu_bit);
+    m_active_page_directory = &page_directory;
+
+    FlatPtr cr3 = page_directory.cr3();
+#if ARCH(X86_64)
+    if (s_pcid_enabled && page_directory.pcid() != 0) {
+        cr3 |= page_directory.pcid();
+        // The entries we still have are only good if nothing changed while we weren't looking.
+        if (!(page_directory.m_stale_tlb_cpu_mask.fetch_and(~cpu_bit) & cpu_bit))
+            cr3 |= cr3_pcid_no_flush;
+    }
+#endif
+    write_cr3(cr3);
 }
 
 void Processor::smp_return_to_pool(ProcessorMessage& msg)
@@ -851,13 +949,9 @@ bool Processor::smp_process_pending_messages()
                 if (Memory::is_user_address(VirtualAddress(msg->flush_tlb.ptr))) {
                     // We assume that we don't cross into kernel land!
                     VERIFY(Memory::is_user_range(VirtualAddress(msg->flush_tlb.ptr), msg->flush_tlb.page_count * PAGE_SIZE));
-                    if (read_cr3() != msg->flush_tlb.page_directory->cr3()) {
-                        // This processor isn't using this page directory right now, we can ignore this request
-                        dbgln_if(SMP_DEBUG, "SMP[{}]: No need to flush {} pages at {}", id(), msg->flush_tlb.page_count, VirtualAddress(msg->flush_tlb.ptr));
-                        break;
-                    }
                 }
-                flush_tlb_local(VirtualAddress(msg->flush_tlb.ptr), msg->flush_tlb.page_count);
+                m_tlb_statistics.shootdowns_received++;
+                flush_tlb_local_for(*msg->flush_tlb.page_directory, VirtualAddress(msg->flush_tlb.ptr), msg->flush_tlb.page_count);
                 break;
             }
 
@@ -927,6 +1021,38 @@ void Processor::smp_broadcast_message(ProcessorMessage& msg)
         APIC::the().broadcast_ipi();
 }
 
+size_t Processor::smp_multicast_message(u32 cpu_mask, ProcessorMessage& msg)
+{
+    auto& cur_proc = Processor::current();
+    VERIFY(!(cpu_mask & (1u << cur_proc.get_id())));
+
+    dbgln_if(SMP_DEBUG, "SMP[{}]: Multicast message {} to cpus: {:#x} proc: {}", cur_proc.get_id(), VirtualAddress(&msg), cpu_mask, VirtualAddress(&cur_proc));
+
+    msg.refs.store(__builtin_popcount(cpu_mask), AK::MemoryOrder::memory_order_release);
+    VERIFY(msg.refs > 0);
+    u32 ipi_mask = 0;
+    for_each(
+        [&](Processor& proc) {
+            u32 cpu_bit = 1u << proc.get_id();
+            if ((cpu_mask & cpu_bit) && proc.smp_enqueue_message(msg))
+                ipi_mask |= cpu_bit;
+        });
+
+    // Processors that already had messages queued have an IPI on its way.
+    if (!ipi_mask)
+        return 0;
+    u32 all_other_cpus = ((1u << count()) - 1) & ~(1u << cur_proc.get_id());
+    if (ipi_mask == all_other_cpus) {
+        APIC::the().broadcast_ipi();
+        return __builtin_popcount(ipi_mask);
+    }
+    for (u32 cpu = 0; cpu < count(); cpu++) {
+        if (ipi_mask & (1u << cpu))
+            APIC::the().send_ipi(cpu);
+    }
+    return __builtin_popcount(ipi_mask);
+}
+
 void Processor::smp_broadcast_wait_sync(ProcessorMessage& msg)
 {
     auto& cur_proc = Processor::current();
@@ -985,7 +1111,7 @@ void Processor::smp_unicast(u32 cpu, Function<void()> callback, bool async)
     smp_unicast_message(cpu, msg, async);
 }
 
-void Processor::smp_broadcast_flush_tlb(Memory::PageDirectory const* page_directory, VirtualAddress vaddr, size_t page_count)
+void Processor::smp_multicast_flush_tlb(u32 cpu_mask, Memory::PageDirectory const* page_directory, VirtualAddress vaddr, size_t page_count)
 {
     auto& msg = smp_get_from_pool();
     msg.async = false;
@@ -993,9 +1119,14 @@ void Processor::smp_broadcast_flush_tlb(Memory::PageDirectory const* page_direct
     msg.flush_tlb.page_directory = page_directory;
     msg.flush_tlb.ptr = vaddr.as_ptr();
     msg.flush_tlb.page_count = page_count;
-    smp_broadcast_message(msg);
+    auto ipi_count = smp_multicast_message(cpu_mask, msg);
+
+    auto& processor = Processor::current();
+    processor.m_tlb_statistics.shootdowns_sent++;
+    processor.m_tlb_statistics.shootdown_ipis_sent += ipi_count;
+
     // While the other processors handle this request, we'll flush ours
-    flush_tlb_local(vaddr, page_count);
+    processor.flush_tlb_local_for(*page_directory, vaddr, page_count);
     // Now wait until everybody is done as well
     smp_broadcast_wait_sync(msg);
 }
@@ -1240,7 +1371,6 @@ extern "C" void enter_thread_context(Thread* from_thread, Thread* to_thread)
     bool has_fxsr = Processor::current().has_feature(CPUFeature::FXSR);
     Processor::set_current_thread(*to_thread);
 
-    auto& from_regs = from_thread->regs();
     auto& to_regs = to_thread->regs();
 
     if (has_fxsr)
@@ -1251,6 +1381,7 @@ extern "C" void enter_thread_context(Thread* from_thread, Thread* to_thread)
                      : "=m"(from_thread->fpu_state()));
 
 #if ARCH(I386)
+    auto& from_regs = from_thread->regs();
     from_regs.fs = get_fs();
     from_regs.gs = get_gs();
     set_fs(to_regs.fs);
@@ -1276,8 +1407,8 @@ extern "C" void enter_thread_context(Thread* from_thread, Thread* to_thread)
     fs_base_msr.set(to_thread->thread_specific_data().get());
 #endif
 
-    if (from_regs.cr3 != to_regs.cr3)
-        write_cr3(to_regs.cr3);
+    if (processor.active_page_directory() != to_regs.page_directory)
+        processor.activate_page_directory(*to_regs.page_directory);
 
     to_thread->set_cpu(processor.get_id());
 
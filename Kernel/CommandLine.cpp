@@ -198,6 +198,19 @@ UNMAP_AFTER_INIT AHCIResetMode CommandLine::ahci_reset_mode() const
     PANIC("Unknown AHCIResetMode: {}", ahci_reset_mode);
 }
 
+IOSchedulerPolicy CommandLine::io_scheduler_policy() const
+{
+    const auto io_scheduler = lookup("io_scheduler"sv).value_or("deadline"sv);
+    if (io_scheduler == "noop"sv) {
+        return IOSchedulerPolicy::Noop;
+    } else if (io_scheduler == "deadline"sv) {
+        return IOSchedulerPolicy::Deadline;
+    } else if (io_scheduler == "fair"sv) {
+        return IOSchedulerPolicy::Fair;
+    }
+    PANIC("Unknown IOSchedulerPolicy: {}", io_scheduler);
+}
+
 BootMode CommandLine::boot_mode(Validate should_validate) const
 {
     const auto boot_mode = lookup("boot_mode"sv).value_or("graphical"sv);
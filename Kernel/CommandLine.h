@@ -42,6 +42,12 @@ enum class AHCIResetMode {
     Aggressive,
 };
 
+enum class IOSchedulerPolicy {
+    Noop,
+    Deadline,
+    Fair,
+};
+
 class CommandLine {
     AK_MAKE_ETERNAL;
 
@@ -76,6 +82,7 @@ public:
     [[nodiscard]] bool disable_usb() const;
     [[nodiscard]] bool disable_virtio() const;
     [[nodiscard]] AHCIResetMode ahci_reset_mode() const;
+    [[nodiscard]] IOSchedulerPolicy io_scheduler_policy() const;
     [[nodiscard]] String userspace_init() const;
     [[nodiscard]] Vector<String> userspace_init_args() const;
     [[nodiscard]] String root_device() const;
@@ -63,7 +63,7 @@ public:
 
     void do_start(ScopedSpinLock<SpinLock<u8>>&& requests_lock)
     {
-        if (is_completed_result(m_result))
+        if (m_result != Pending)
             return;
         m_result = Started;
         requests_lock.unlock();
@@ -80,6 +80,9 @@ public:
     }
     void* get_private() const { return m_private; }
 
+    // The process the request is made on behalf of.
+    Process const& process() const { return *m_process; }
+
     template<typename... Args>
     [[nodiscard]] bool write_to_buffer(UserOrKernelBuffer& buffer, Args... args)
     {
@@ -60,16 +60,45 @@ String Device::absolute_path(const FileDescription&) const
     return absolute_path();
 }
 
+void Device::queue_request(NonnullRefPtr<AsyncDeviceRequest> request)
+{
+    m_queued_requests.append(move(request));
+}
+
+RefPtr<AsyncDeviceRequest> Device::dequeue_request()
+{
+    if (m_queued_requests.is_empty())
+        return {};
+    auto request = m_queued_requests.first();
+    m_queued_requests.remove(m_queued_requests.begin());
+    return request;
+}
+
+void Device::start_next_request(ScopedSpinLock<SpinLock<u8>>&& lock)
+{
+    VERIFY(lock.have_lock());
+    if (m_started_request_count >= max_started_requests())
+        return;
+    auto request = dequeue_request();
+    if (!request)
+        return;
+    ++m_started_request_count;
+    m_started_requests.append(request);
+    request->do_start(move(lock));
+}
+
 void Device::process_next_queued_request(Badge<AsyncDeviceRequest>, const AsyncDeviceRequest& completed_request)
 {
     ScopedSpinLock lock(m_requests_lock);
-    VERIFY(!m_requests.is_empty());
-    VERIFY(m_requests.first().ptr() == &completed_request);
-    m_requests.remove(m_requests.begin());
-    if (!m_requests.is_empty()) {
-        auto* next_request = m_requests.first().ptr();
-        next_request->do_start(move(lock));
-    }
+    VERIFY(m_started_request_count > 0);
+    auto it = m_started_requests.begin();
+    while (it != m_started_requests.end() && (*it).ptr() != &completed_request)
+        ++it;
+    VERIFY(it != m_started_requests.end());
+    m_started_requests.remove(it);
+    --m_started_request_count;
+
+    start_next_request(move(lock));
 
     evaluate_block_conditions();
 }
@@ -53,14 +53,21 @@ public:
     {
         auto request = adopt_ref(*new AsyncRequestType(*this, forward<Args>(args)...));
         ScopedSpinLock lock(m_requests_lock);
-        bool was_empty = m_requests.is_empty();
-        m_requests.append(request);
-        if (was_empty)
-            request->do_start(move(lock));
+        queue_request(request);
+        start_next_request(move(lock));
         return request;
     }
 
 protected:
+    // How many requests may be started before the first of them completes. Devices that keep a queue of their own
+    // can take all of them at once.
+    virtual size_t max_started_requests() const { return 1; }
+
+    // The order in which the requests that haven't been started yet are started, first come first served by default.
+    // Both are called with the requests lock held.
+    virtual void queue_request(NonnullRefPtr<AsyncDeviceRequest>);
+    virtual RefPtr<AsyncDeviceRequest> dequeue_request();
+
     Device(unsigned major, unsigned minor);
     void set_uid(uid_t uid) { m_uid = uid; }
     void set_gid(gid_t gid) { m_gid = gid; }
@@ -73,8 +80,12 @@ private:
     uid_t m_uid { 0 };
     gid_t m_gid { 0 };
 
+    void start_next_request(ScopedSpinLock<SpinLock<u8>>&&);
+
     SpinLock<u8> m_requests_lock;
-    DoublyLinkedList<RefPtr<AsyncDeviceRequest>> m_requests;
+    DoublyLinkedList<RefPtr<AsyncDeviceRequest>> m_queued_requests;
+    DoublyLinkedList<RefPtr<AsyncDeviceRequest>> m_started_requests;
+    size_t m_started_request_count { 0 };
 };
 
 }
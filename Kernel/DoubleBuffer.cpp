@@ -85,6 +85,117 @@ KResultOr<size_t> DoubleBuffer::read(UserOrKernelBuffer& data, size_t size)
     return nread;
 }
 
+ReadonlyBytes DoubleBuffer::readable_bytes()
+{
+    if (m_read_buffer_index >= m_read_buffer->size && m_write_buffer->size != 0)
+        flip();
+    return { m_read_buffer->data + m_read_buffer_index, m_read_buffer->size - m_read_buffer_index };
+}
+
+void DoubleBuffer::did_read(size_t size)
+{
+    m_read_buffer_index += size;
+    compute_lockfree_metadata();
+    if (m_unblock_callback && size > 0 && m_space_for_writing > 0)
+        m_unblock_callback();
+}
+
+void DoubleBuffer::did_write(size_t size)
+{
+    m_write_buffer->size += size;
+    compute_lockfree_metadata();
+    if (m_unblock_callback && size > 0 && !m_empty)
+        m_unblock_callback();
+}
+
+KResultOr<size_t> DoubleBuffer::read_with(size_t size, Function<KResultOr<size_t>(ReadonlyBytes)> callback)
+{
+    if (!size || m_storage->is_null())
+        return 0;
+    MutexLocker locker(m_lock);
+    auto bytes = readable_bytes();
+    if (bytes.is_empty())
+        return 0;
+    auto result = callback(bytes.trim(size));
+    if (result.is_error())
+        return result;
+    VERIFY(result.value() <= min(size, bytes.size()));
+    did_read(result.value());
+    return result;
+}
+
+KResultOr<size_t> DoubleBuffer::write_with(size_t size, Function<KResultOr<size_t>(Bytes)> callback)
+{
+    if (!size || m_storage->is_null())
+        return 0;
+    MutexLocker locker(m_lock);
+    size_t bytes_to_write = min(size, m_space_for_writing);
+    if (bytes_to_write == 0)
+        return 0;
+    auto result = callback({ m_write_buffer->data + m_write_buffer->size, bytes_to_write });
+    if (result.is_error())
+        return result;
+    VERIFY(result.value() <= bytes_to_write);
+    did_write(result.value());
+    return result;
+}
+
+KResultOr<size_t> DoubleBuffer::transfer_to(DoubleBuffer& other, size_t size)
+{
+    VERIFY(&other != this);
+    if (!size || m_storage->is_null() || other.m_storage->is_null())
+        return 0;
+
+    // Always in the same order, so that two transfers the other way around can't deadlock.
+    auto& first = this < &other ? *this : other;
+    auto& second = this < &other ? other : *this;
+    MutexLocker first_locker(first.m_lock);
+    MutexLocker second_locker(second.m_lock);
+
+    auto bytes = readable_bytes();
+    size_t nmoved = min(size, min(bytes.size(), other.m_space_for_writing));
+    if (nmoved == 0)
+        return 0;
+    memcpy(other.m_write_buffer->data + other.m_write_buffer->size, bytes.data(), nmoved);
+    did_read(nmoved);
+    other.did_write(nmoved);
+    return nmoved;
+}
+
+KResult DoubleBuffer::try_resize(size_t capacity)
+{
+    VERIFY(capacity > 0);
+    auto storage = KBuffer::try_create_with_size(capacity * 2, Memory::Region::Access::ReadWrite, "DoubleBuffer");
+    if (!storage)
+        return ENOMEM;
+
+    MutexLocker locker(m_lock);
+    if (unread_size() > capacity)
+        return EBUSY;
+
+    // Everything that hasn't been read yet goes into the new write buffer, in order.
+    auto* new_data = storage->data();
+    size_t new_size = 0;
+    memcpy(new_data, m_read_buffer->data + m_read_buffer_index, m_read_buffer->size - m_read_buffer_index);
+    new_size += m_read_buffer->size - m_read_buffer_index;
+    memcpy(new_data + new_size, m_write_buffer->data, m_write_buffer->size);
+    new_size += m_write_buffer->size;
+
+    m_storage = storage.release_nonnull();
+    m_capacity = capacity;
+    m_write_buffer = &m_buffer1;
+    m_read_buffer = &m_buffer2;
+    m_buffer1.data = m_storage->data();
+    m_buffer1.size = new_size;
+    m_buffer2.data = m_storage->data() + capacity;
+    m_buffer2.size = 0;
+    m_read_buffer_index = 0;
+    compute_lockfree_metadata();
+    if (m_unblock_callback && m_space_for_writing > 0)
+        m_unblock_callback();
+    return KSuccess;
+}
+
 KResultOr<size_t> DoubleBuffer::peek(UserOrKernelBuffer& data, size_t size)
 {
     if (!size || m_storage->is_null())
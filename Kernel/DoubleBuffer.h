@@ -35,10 +35,21 @@ public:
         return peek(buffer, size);
     }
 
+    // Lets the callback use the data right where it is in the buffer, and drops as many bytes as it says it used.
+    [[nodiscard]] KResultOr<size_t> read_with(size_t, Function<KResultOr<size_t>(ReadonlyBytes)>);
+    // Lets the callback fill in free space right in the buffer, and keeps as many bytes as it says it filled in.
+    [[nodiscard]] KResultOr<size_t> write_with(size_t, Function<KResultOr<size_t>(Bytes)>);
+    // Moves data into another buffer, with one copy instead of two through a buffer in between.
+    [[nodiscard]] KResultOr<size_t> transfer_to(DoubleBuffer&, size_t);
+
     bool is_empty() const { return m_empty; }
 
+    size_t capacity() const { return m_capacity; }
     size_t space_for_writing() const { return m_space_for_writing; }
 
+    // Keeps what hasn't been read yet, and fails with EBUSY if that doesn't fit into the new capacity.
+    [[nodiscard]] KResult try_resize(size_t capacity);
+
     void set_unblock_callback(Function<void()> callback)
     {
         VERIFY(!m_unblock_callback);
@@ -49,6 +60,10 @@ private:
     explicit DoubleBuffer(size_t capacity, NonnullOwnPtr<KBuffer> storage);
     void flip();
     void compute_lockfree_metadata();
+    size_t unread_size() const { return m_read_buffer->size - m_read_buffer_index + m_write_buffer->size; }
+    ReadonlyBytes readable_bytes();
+    void did_read(size_t);
+    void did_write(size_t);
 
     struct InnerBuffer {
         u8* data { nullptr };
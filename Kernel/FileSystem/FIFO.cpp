@@ -28,7 +28,7 @@ static Atomic<int> s_next_fifo_id = 1;
 
 RefPtr<FIFO> FIFO::try_create(uid_t uid)
 {
-    auto buffer = DoubleBuffer::try_create();
+    auto buffer = DoubleBuffer::try_create(default_capacity);
     if (buffer)
         return adopt_ref_if_nonnull(new (nothrow) FIFO(uid, buffer.release_nonnull()));
     return {};
@@ -142,18 +142,65 @@ KResultOr<size_t> FIFO::read(FileDescription& fd, u64, UserOrKernelBuffer& buffe
     return m_buffer->read(buffer, size);
 }
 
-KResultOr<size_t> FIFO::write(FileDescription& fd, u64, const UserOrKernelBuffer& buffer, size_t size)
+KResult FIFO::check_can_be_written_to()
 {
     if (!m_readers) {
         Thread::current()->send_signal(SIGPIPE, Process::current());
         return EPIPE;
     }
+    return KSuccess;
+}
+
+KResultOr<size_t> FIFO::write(FileDescription& fd, u64, const UserOrKernelBuffer& buffer, size_t size)
+{
+    if (auto result = check_can_be_written_to(); result.is_error())
+        return result;
     if (!fd.is_blocking() && m_buffer->space_for_writing() == 0)
         return EAGAIN;
 
     return m_buffer->write(buffer, size);
 }
 
+KResultOr<size_t> FIFO::splice_to(FileDescription& out, Optional<u64> out_offset, size_t size)
+{
+    if (m_buffer->is_empty() && !m_writers)
+        return 0;
+
+    if (out.is_fifo()) {
+        auto& out_fifo = *out.fifo();
+        if (auto result = out_fifo.check_can_be_written_to(); result.is_error())
+            return result;
+        return m_buffer->transfer_to(*out_fifo.m_buffer, size);
+    }
+
+    return m_buffer->read_with(size, [&](ReadonlyBytes bytes) -> KResultOr<size_t> {
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(const_cast<u8*>(bytes.data()));
+        if (out_offset.has_value())
+            return out.write(out_offset.value(), buffer, bytes.size());
+        return out.write(buffer, bytes.size());
+    });
+}
+
+KResultOr<size_t> FIFO::splice_from(FileDescription& in, Optional<u64> in_offset, size_t size)
+{
+    if (auto result = check_can_be_written_to(); result.is_error())
+        return result;
+
+    return m_buffer->write_with(size, [&](Bytes bytes) -> KResultOr<size_t> {
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(bytes.data());
+        if (in_offset.has_value())
+            return in.read(buffer, in_offset.value(), bytes.size());
+        return in.read(buffer, bytes.size());
+    });
+}
+
+KResult FIFO::set_capacity(size_t capacity)
+{
+    if (capacity > max_capacity)
+        return EPERM;
+    return m_buffer->try_resize(max<size_t>(Memory::page_round_up(capacity), PAGE_SIZE));
+}
+
 String FIFO::absolute_path(const FileDescription&) const
 {
     return String::formatted("fifo:{}", m_fifo_id);
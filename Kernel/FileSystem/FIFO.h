@@ -38,6 +38,16 @@ public:
     void detach(Direction);
 #pragma GCC diagnostic pop
 
+    // For splice(), which moves data between the pipe's buffer and another file directly, instead of through a buffer
+    // in userspace.
+    KResultOr<size_t> splice_to(FileDescription& out, Optional<u64> out_offset, size_t);
+    KResultOr<size_t> splice_from(FileDescription& in, Optional<u64> in_offset, size_t);
+
+    static constexpr size_t default_capacity = 64 * KiB;
+    static constexpr size_t max_capacity = 1 * MiB;
+    size_t capacity() const { return m_buffer->capacity(); }
+    KResult set_capacity(size_t);
+
 private:
     // ^File
     virtual KResultOr<size_t> write(FileDescription&, u64, const UserOrKernelBuffer&, size_t) override;
@@ -49,6 +59,8 @@ private:
     virtual StringView class_name() const override { return "FIFO"; }
     virtual bool is_fifo() const override { return true; }
 
+    KResult check_can_be_written_to();
+
     explicit FIFO(uid_t, NonnullOwnPtr<DoubleBuffer> buffer);
 
     unsigned m_writers { 0 };
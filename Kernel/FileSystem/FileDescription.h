@@ -85,6 +85,9 @@ public:
     const InodeWatcher* inode_watcher() const;
     InodeWatcher* inode_watcher();
 
+    bool is_io_ring() const;
+    IORing* io_ring();
+
     bool is_master_pty() const;
     const MasterPTY* master_pty() const;
     MasterPTY* master_pty();
@@ -0,0 +1,426 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/NumericLimits.h>
+#include <Kernel/Debug.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/FileSystem/FileSystem.h>
+#include <Kernel/FileSystem/IORing.h>
+#include <Kernel/FileSystem/Inode.h>
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Net/Socket.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+KResultOr<NonnullRefPtr<IORing>> IORing::try_create(Process& process, u32 entries)
+{
+    // The indices wrap around, so the sizes have to be powers of two.
+    if (entries == 0 || entries > IO_RING_MAX_ENTRIES || (entries & (entries - 1)) != 0)
+        return EINVAL;
+
+    auto size = io_ring_mapping_size(entries);
+    auto vmobject = Memory::AnonymousVMObject::try_create_with_size(size, AllocationStrategy::AllocateNow);
+    if (!vmobject)
+        return ENOMEM;
+    auto kernel_region = MM.allocate_kernel_region_with_vmobject(*vmobject, size, "IORing", Memory::Region::Access::ReadWrite);
+    if (!kernel_region)
+        return ENOMEM;
+
+    auto ring = adopt_ref_if_nonnull(new (nothrow) IORing(process.pid(), entries, vmobject.release_nonnull(), kernel_region.release_nonnull()));
+    if (!ring)
+        return ENOMEM;
+    return ring.release_nonnull();
+}
+
+IORing::IORing(ProcessID owner, u32 entries, NonnullRefPtr<Memory::AnonymousVMObject> vmobject, NonnullOwnPtr<Memory::Region> kernel_region)
+    : m_owner(owner)
+    , m_entries(entries)
+    , m_vmobject(move(vmobject))
+    , m_kernel_region(move(kernel_region))
+{
+    auto& header = this->header();
+    header.submission_entries = m_entries;
+    header.completion_entries = 2 * m_entries;
+    header.submissions_offset = io_ring_submissions_offset();
+    header.completions_offset = io_ring_completions_offset(m_entries);
+}
+
+IORing::~IORing()
+{
+}
+
+KResultOr<Memory::Region*> IORing::mmap(Process& process, FileDescription&, Memory::VirtualRange const& range, u64 offset, int prot, bool shared)
+{
+    // Both sides have to see the same pages, so only a shared mapping of the whole thing makes sense.
+    if (offset != 0 || !shared)
+        return EINVAL;
+    if (range.size() != m_vmobject->size())
+        return EINVAL;
+    return process.address_space().allocate_region_with_vmobject(range, m_vmobject, 0, "IORing", prot, true);
+}
+
+bool IORing::can_read(const FileDescription&, size_t) const
+{
+    return unconsumed_completions() > 0 || m_parked_operation_might_be_ready.load(AK::MemoryOrder::memory_order_relaxed);
+}
+
+u32 IORing::unconsumed_completions() const
+{
+    // The head comes from userspace. If it makes no sense, the ring counts as full until it does.
+    u32 head = AK::atomic_load(&header().completion_head, AK::MemoryOrder::memory_order_acquire);
+    return min(m_completion_tail - head, 2 * m_entries);
+}
+
+void IORing::post_completion(u64 user_data, i32 result)
+{
+    VERIFY(m_lock.is_locked());
+    auto& completion = completions()[m_completion_tail & (2 * m_entries - 1)];
+    completion.user_data = user_data;
+    completion.result = result;
+    completion.reserved = 0;
+    ++m_completion_tail;
+    AK::atomic_store(&header().completion_tail, m_completion_tail, AK::MemoryOrder::memory_order_release);
+}
+
+IORing::Watch::Watch(IORing& ring, FileDescription& description, BlockFlags flags)
+    : m_ring(ring)
+    , m_description(description)
+    , m_flags(flags)
+{
+    // This always stays in the block condition, until the operation is done and this goes away.
+    auto added = set_block_condition(m_description->block_condition());
+    VERIFY(added);
+}
+
+IORing::Watch::~Watch()
+{
+}
+
+bool IORing::Watch::unblock(bool from_add_blocker, void*)
+{
+    if (m_description->should_unblock(m_flags) != BlockFlags::None)
+        m_ring.operation_might_be_ready(from_add_blocker);
+    return false;
+}
+
+void IORing::operation_might_be_ready(bool from_add_blocker)
+{
+    if (m_parked_operation_might_be_ready.exchange(true, AK::MemoryOrder::memory_order_relaxed))
+        return;
+    // When the watch is only being set up, we're in enter() and will tell everyone when we're done there.
+    if (!from_add_blocker)
+        evaluate_block_conditions();
+}
+
+static Optional<UserOrKernelBuffer> user_buffer_for(const IORingSubmission& submission)
+{
+    if (submission.buffer > NumericLimits<FlatPtr>::max())
+        return {};
+    return UserOrKernelBuffer::for_user_buffer(reinterpret_cast<u8*>(static_cast<FlatPtr>(submission.buffer)), submission.length);
+}
+
+bool IORing::try_perform(Process& process, Operation& operation, i32& result)
+{
+    auto& submission = operation.submission;
+    auto fail = [&](KResult error) {
+        result = error.error();
+        return true;
+    };
+    auto wait_for = [&](BlockFlags flags) {
+        operation.waiting_for = flags;
+        return false;
+    };
+
+    if (submission.opcode == IORingOpcode::Nop) {
+        result = 0;
+        return true;
+    }
+
+    if (!operation.description) {
+        operation.description = process.fds().file_description(submission.fd);
+        if (!operation.description)
+            return fail(EBADF);
+        // A ring waiting for itself would keep itself alive forever.
+        if (operation.description->is_io_ring())
+            return fail(EINVAL);
+    }
+    auto& description = *operation.description;
+
+    if (submission.length > (u32)NumericLimits<i32>::max())
+        return fail(EINVAL);
+
+    switch (submission.opcode) {
+    case IORingOpcode::Read: {
+        if (!description.is_readable())
+            return fail(EBADF);
+        if (description.is_directory())
+            return fail(EISDIR);
+        if (!description.can_read())
+            return wait_for(BlockFlags::Read);
+        auto buffer = user_buffer_for(submission);
+        if (!buffer.has_value())
+            return fail(EFAULT);
+        KResultOr<size_t> nread = 0;
+        if (submission.offset == IO_RING_CURRENT_OFFSET) {
+            nread = description.read(buffer.value(), submission.length);
+        } else {
+            if (!description.file().is_seekable())
+                return fail(ESPIPE);
+            nread = description.read(buffer.value(), submission.offset, submission.length);
+        }
+        if (nread.is_error())
+            return fail(nread.error());
+        result = nread.value();
+        return true;
+    }
+    case IORingOpcode::Write: {
+        if (!description.is_writable())
+            return fail(EBADF);
+        if (!description.can_write())
+            return wait_for(BlockFlags::Write);
+        auto buffer = user_buffer_for(submission);
+        if (!buffer.has_value())
+            return fail(EFAULT);
+        KResultOr<size_t> nwritten = 0;
+        if (!description.file().is_seekable()) {
+            if (submission.offset != IO_RING_CURRENT_OFFSET)
+                return fail(ESPIPE);
+            // Pipes and sockets may not have room for all of it, and waiting for that would hold up the whole ring.
+            bool original_blocking = description.is_blocking();
+            description.set_blocking(false);
+            nwritten = description.write(buffer.value(), submission.length);
+            description.set_blocking(original_blocking);
+        } else if (submission.offset == IO_RING_CURRENT_OFFSET) {
+            if (description.should_append()) {
+                auto seek_result = description.seek(0, SEEK_END);
+                if (seek_result.is_error())
+                    return fail(seek_result.error());
+            }
+            nwritten = description.write(buffer.value(), submission.length);
+        } else {
+            nwritten = description.write(submission.offset, buffer.value(), submission.length);
+        }
+        if (nwritten.is_error()) {
+            if (nwritten.error() == EAGAIN)
+                return wait_for(BlockFlags::Write);
+            return fail(nwritten.error());
+        }
+        result = nwritten.value();
+        return true;
+    }
+    case IORingOpcode::Fsync: {
+        auto* inode = description.inode();
+        if (!inode)
+            return fail(EINVAL);
+        if (inode->is_metadata_dirty())
+            inode->flush_metadata();
+        inode->fs().flush_writes();
+        result = 0;
+        return true;
+    }
+    case IORingOpcode::Send:
+    case IORingOpcode::Recv: {
+        if (!description.is_socket())
+            return fail(ENOTSOCK);
+        auto& socket = *description.socket();
+        bool is_send = submission.opcode == IORingOpcode::Send;
+        if (is_send && socket.is_shut_down_for_writing())
+            return fail(EPIPE);
+        if (!is_send && socket.is_shut_down_for_reading()) {
+            result = 0;
+            return true;
+        }
+        if (is_send ? !description.can_write() : !description.can_read())
+            return wait_for(is_send ? BlockFlags::Write : BlockFlags::Read);
+        auto buffer = user_buffer_for(submission);
+        if (!buffer.has_value())
+            return fail(EFAULT);
+
+        // Nothing in here may block, if it turns out there isn't enough room or data after all, wait some more.
+        bool original_blocking = description.is_blocking();
+        description.set_blocking(false);
+        KResultOr<size_t> ntransferred = 0;
+        if (is_send) {
+            ntransferred = socket.sendto(description, buffer.value(), submission.length, submission.flags, {}, 0);
+        } else {
+            Time timestamp {};
+            ntransferred = socket.recvfrom(description, buffer.value(), submission.length, submission.flags, {}, {}, timestamp);
+        }
+        description.set_blocking(original_blocking);
+
+        if (ntransferred.is_error()) {
+            if (ntransferred.error() == EAGAIN)
+                return wait_for(is_send ? BlockFlags::Write : BlockFlags::Read);
+            return fail(ntransferred.error());
+        }
+        result = min(ntransferred.value(), (size_t)NumericLimits<i32>::max());
+        return true;
+    }
+    case IORingOpcode::Accept: {
+        REQUIRE_PROMISE(accept);
+        if (!description.is_socket())
+            return fail(ENOTSOCK);
+        auto& socket = *description.socket();
+        if (!socket.can_accept())
+            return wait_for(BlockFlags::Accept);
+
+        auto fd_or_error = process.fds().allocate();
+        if (fd_or_error.is_error())
+            return fail(fd_or_error.error());
+        auto accepted_socket_fd = fd_or_error.release_value();
+        auto accepted_socket = socket.accept();
+        VERIFY(accepted_socket);
+
+        auto accepted_socket_description_result = FileDescription::create(*accepted_socket);
+        if (accepted_socket_description_result.is_error())
+            return fail(accepted_socket_description_result.error());
+        auto accepted_socket_description = accepted_socket_description_result.release_value();
+        accepted_socket_description->set_readable(true);
+        accepted_socket_description->set_writable(true);
+        if (submission.flags & SOCK_NONBLOCK)
+            accepted_socket_description->set_blocking(false);
+        process.fds()[accepted_socket_fd.fd].set(move(accepted_socket_description), (submission.flags & SOCK_CLOEXEC) ? FD_CLOEXEC : 0);
+
+        // NOTE: Moving this state to Completed is what causes connect() to unblock on the client side.
+        accepted_socket->set_setup_state(Socket::SetupState::Completed);
+        result = accepted_socket_fd.fd;
+        return true;
+    }
+    case IORingOpcode::Poll: {
+        if (!submission.poll_events || (submission.poll_events & ~(POLLIN | POLLOUT)))
+            return fail(EINVAL);
+        BlockFlags flags = BlockFlags::None;
+        if (submission.poll_events & POLLIN)
+            flags |= BlockFlags::Read;
+        if (submission.poll_events & POLLOUT)
+            flags |= BlockFlags::Write;
+        auto unblocked_flags = description.should_unblock(flags);
+        if (unblocked_flags == BlockFlags::None)
+            return wait_for(flags);
+        result = 0;
+        if (has_flag(unblocked_flags, BlockFlags::Read))
+            result |= POLLIN;
+        if (has_flag(unblocked_flags, BlockFlags::Write))
+            result |= POLLOUT;
+        return true;
+    }
+    default:
+        return fail(EINVAL);
+    }
+}
+
+bool IORing::complete_ready_operations(Process& process)
+{
+    VERIFY(m_lock.is_locked());
+    // Clear this first, so that something becoming ready while we go through them isn't missed.
+    m_parked_operation_might_be_ready.store(false, AK::MemoryOrder::memory_order_relaxed);
+
+    bool did_complete = false;
+    for (size_t i = 0; i < m_parked_operations.size();) {
+        auto& operation = m_parked_operations[i];
+        if (operation.description->should_unblock(operation.waiting_for) == BlockFlags::None) {
+            ++i;
+            continue;
+        }
+        auto previous_waiting_for = operation.waiting_for;
+        i32 result = 0;
+        if (!try_perform(process, operation, result)) {
+            if (operation.waiting_for != previous_waiting_for) {
+                operation.watch = nullptr;
+                operation.watch = adopt_own_if_nonnull(new (nothrow) Watch(*this, *operation.description, operation.waiting_for));
+                if (!operation.watch) {
+                    post_completion(operation.submission.user_data, KResult(ENOMEM).error());
+                    m_parked_operations.remove(i);
+                    did_complete = true;
+                    continue;
+                }
+            }
+            ++i;
+            continue;
+        }
+        post_completion(operation.submission.user_data, result);
+        m_parked_operations.remove(i);
+        did_complete = true;
+    }
+    return did_complete;
+}
+
+KResultOr<size_t> IORing::enter(Process& process, u32 to_submit, u32 min_complete)
+{
+    // The operations use the caller's file descriptors, which only match the ones they were submitted with in this process.
+    if (process.pid() != m_owner)
+        return EPERM;
+
+    MutexLocker locker(m_lock);
+    bool did_complete = complete_ready_operations(process);
+
+    auto& header = this->header();
+    u32 completion_entries = 2 * m_entries;
+    u32 available = min(AK::atomic_load(&header.submission_tail, AK::MemoryOrder::memory_order_acquire) - m_submission_head, m_entries);
+    size_t submitted = 0;
+    while (submitted < to_submit && submitted < available) {
+        // Every operation in flight has a completion entry set aside for it, so posting one never has to wait.
+        if (unconsumed_completions() + m_parked_operations.size() >= completion_entries)
+            break;
+
+        Operation operation {};
+        memcpy(&operation.submission, &submissions()[m_submission_head & (m_entries - 1)], sizeof(IORingSubmission));
+        ++m_submission_head;
+        AK::atomic_store(&header.submission_head, m_submission_head, AK::MemoryOrder::memory_order_release);
+        ++submitted;
+
+        dbgln_if(IO_DEBUG, "IORing @ {}: submission {} for fd {}, user data {}", this, (u8)operation.submission.opcode, operation.submission.fd, operation.submission.user_data);
+
+        i32 result = 0;
+        if (try_perform(process, operation, result)) {
+            post_completion(operation.submission.user_data, result);
+            did_complete = true;
+            continue;
+        }
+
+        VERIFY(operation.waiting_for != BlockFlags::None);
+        auto user_data = operation.submission.user_data;
+        operation.watch = adopt_own_if_nonnull(new (nothrow) Watch(*this, *operation.description, operation.waiting_for));
+        auto parked_operation = adopt_own_if_nonnull(new (nothrow) Operation(move(operation)));
+        if (!parked_operation || !parked_operation->watch || !m_parked_operations.try_append(parked_operation.release_nonnull())) {
+            post_completion(user_data, KResult(ENOMEM).error());
+            did_complete = true;
+        }
+    }
+
+    while (unconsumed_completions() < min_complete && !m_parked_operations.is_empty()) {
+        if (m_parked_operation_might_be_ready.load(AK::MemoryOrder::memory_order_relaxed)) {
+            did_complete |= complete_ready_operations(process);
+            continue;
+        }
+
+        Thread::SelectBlocker::FDVector fds_info;
+        for (auto& operation : m_parked_operations) {
+            if (!fds_info.try_append({ *operation.description, operation.waiting_for }))
+                return ENOMEM;
+        }
+
+        locker.unlock();
+        auto block_result = Thread::current()->block<Thread::SelectBlocker>({}, fds_info);
+        locker.lock();
+
+        if (block_result.was_interrupted()) {
+            if (submitted == 0 && !did_complete)
+                return EINTR;
+            break;
+        }
+        did_complete |= complete_ready_operations(process);
+    }
+
+    // Anyone else waiting for the ring to become readable has to take another look now.
+    if (did_complete || m_parked_operation_might_be_ready.load(AK::MemoryOrder::memory_order_relaxed))
+        evaluate_block_conditions();
+
+    return submitted;
+}
+
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/NonnullOwnPtrVector.h>
+#include <Kernel/API/IORing.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/Forward.h>
+#include <Kernel/Locking/Mutex.h>
+#include <Kernel/Memory/AnonymousVMObject.h>
+#include <Kernel/Memory/Region.h>
+
+namespace Kernel {
+
+// The kernel side of an I/O ring, see Kernel/API/IORing.h for the layout that is shared with userspace.
+//
+// Everything happens in the context of io_ring_enter(), so the operations can use the caller's
+// file descriptors and buffers directly. Operations that can't make progress yet (reading from an
+// empty pipe or socket, accepting with no pending connections, ...) are parked instead of blocking.
+// Parked operations keep watching their file's block condition, and the ring becomes readable once
+// one of them can make progress, so that it can be waited on with select() and poll() like any other fd.
+// They are then finished by the next io_ring_enter().
+class IORing final : public File {
+public:
+    static KResultOr<NonnullRefPtr<IORing>> try_create(Process&, u32 entries);
+    virtual ~IORing() override;
+
+    KResultOr<size_t> enter(Process&, u32 to_submit, u32 min_complete);
+
+    virtual bool can_read(const FileDescription&, size_t) const override;
+    virtual bool can_write(const FileDescription&, size_t) const override { return false; }
+    virtual KResultOr<size_t> read(FileDescription&, u64, UserOrKernelBuffer&, size_t) override { return ENOTSUP; }
+    virtual KResultOr<size_t> write(FileDescription&, u64, const UserOrKernelBuffer&, size_t) override { return ENOTSUP; }
+    virtual KResultOr<Memory::Region*> mmap(Process&, FileDescription&, Memory::VirtualRange const&, u64 offset, int prot, bool shared) override;
+
+    virtual String absolute_path(const FileDescription&) const override { return ":io-ring:"; }
+    virtual StringView class_name() const override { return "IORing"; }
+    virtual bool is_io_ring() const override { return true; }
+
+private:
+    using BlockFlags = Thread::FileBlocker::BlockFlags;
+
+    // Not a blocker for a thread, it only tells the ring when the file it's waiting for might be ready.
+    class Watch final : public Thread::FileBlocker {
+    public:
+        Watch(IORing&, FileDescription&, BlockFlags);
+        virtual ~Watch() override;
+
+        virtual StringView state_string() const override { return "IORing"sv; }
+        virtual void not_blocking(bool) override { }
+        virtual bool unblock(bool from_add_blocker, void*) override;
+
+    private:
+        IORing& m_ring;
+        NonnullRefPtr<FileDescription> m_description;
+        BlockFlags m_flags;
+    };
+
+    struct Operation {
+        IORingSubmission submission;
+        RefPtr<FileDescription> description;
+        BlockFlags waiting_for { BlockFlags::None };
+        OwnPtr<Watch> watch;
+    };
+
+    IORing(ProcessID owner, u32 entries, NonnullRefPtr<Memory::AnonymousVMObject>, NonnullOwnPtr<Memory::Region>);
+
+    IORingHeader& header() { return *reinterpret_cast<IORingHeader*>(m_kernel_region->vaddr().as_ptr()); }
+    const IORingHeader& header() const { return *reinterpret_cast<const IORingHeader*>(m_kernel_region->vaddr().as_ptr()); }
+    IORingSubmission* submissions() { return reinterpret_cast<IORingSubmission*>(m_kernel_region->vaddr().offset(io_ring_submissions_offset()).as_ptr()); }
+    IORingCompletion* completions() { return reinterpret_cast<IORingCompletion*>(m_kernel_region->vaddr().offset(io_ring_completions_offset(m_entries)).as_ptr()); }
+
+    u32 unconsumed_completions() const;
+    void post_completion(u64 user_data, i32 result);
+
+    // Returns false if the operation has to wait until its file is ready, and fills in what it waits for.
+    bool try_perform(Process&, Operation&, i32& result);
+    bool complete_ready_operations(Process&);
+    void operation_might_be_ready(bool from_add_blocker);
+
+    ProcessID m_owner;
+    u32 m_entries { 0 };
+    NonnullRefPtr<Memory::AnonymousVMObject> m_vmobject;
+    NonnullOwnPtr<Memory::Region> m_kernel_region;
+
+    Mutex m_lock { "IORing" };
+    u32 m_submission_head { 0 };
+    u32 m_completion_tail { 0 };
+    NonnullOwnPtrVector<Operation> m_parked_operations;
+    Atomic<bool> m_parked_operation_might_be_ready { false };
+};
+
+}
@@ -314,6 +314,8 @@ RefPtr<Inode> ProcFSProcessDirectoryInode::lookup(StringView name)
         return ProcFSProcessPropertyInode::create_for_pid_property(procfs(), SegmentedProcFSIndex::MainProcessProperty::VirtualMemoryStats, associated_pid());
     if (name == "root")
         return ProcFSProcessPropertyInode::create_for_pid_property(procfs(), SegmentedProcFSIndex::MainProcessProperty::RootLink, associated_pid());
+    if (name == "io")
+        return ProcFSProcessPropertyInode::create_for_pid_property(procfs(), SegmentedProcFSIndex::MainProcessProperty::IOStatistics, associated_pid());
     return nullptr;
 }
 
@@ -559,6 +561,8 @@ KResult ProcFSProcessPropertyInode::try_to_acquire_data(Process& process, KBuffe
         return process.procfs_get_virtual_memory_stats(builder);
     case SegmentedProcFSIndex::MainProcessProperty::RootLink:
         return process.procfs_get_root_link(builder);
+    case SegmentedProcFSIndex::MainProcessProperty::IOStatistics:
+        return process.procfs_get_io_stats(builder);
     default:
         VERIFY_NOT_REACHED();
     }
@@ -28,6 +28,7 @@ class IPv4Socket;
 class Inode;
 class InodeIdentifier;
 class InodeWatcher;
+class IORing;
 class KBuffer;
 class KResult;
 class LocalSocket;
@@ -46,6 +47,7 @@ class ProcFSSystemBoolean;
 class ProcFSSystemDirectory;
 class Process;
 class ProcessGroup;
+class Processor;
 class RecursiveSpinLock;
 class Scheduler;
 class Socket;
@@ -4,8 +4,12 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Array.h>
+#include <AK/HashFunctions.h>
+#include <AK/Singleton.h>
 #include <Kernel/Debug.h>
 #include <Kernel/FutexQueue.h>
+#include <Kernel/Process.h>
 #include <Kernel/Thread.h>
 
 namespace Kernel {
@@ -165,4 +169,132 @@ void FutexQueue::did_remove()
     VERIFY(is_empty_and_no_imminent_waits_locked());
 }
 
+static constexpr size_t private_futex_bucket_count = 256;
+static Singleton<Array<PrivateFutexBucket, private_futex_bucket_count>> s_private_futex_buckets;
+
+PrivateFutexBucket& PrivateFutexBucket::for_futex(Process const& process, FlatPtr user_address)
+{
+    auto hash = pair_int_hash(ptr_hash(&process), ptr_hash(user_address));
+    return (*s_private_futex_buckets)[hash % private_futex_bucket_count];
+}
+
+static bool is_waiting_on(Thread::FutexBlocker& blocker, void* data, Process const& process, FlatPtr user_address)
+{
+    VERIFY(data);
+    return blocker.user_address() == user_address && &static_cast<Thread*>(data)->process() == &process;
+}
+
+bool PrivateFutexBucket::should_add_blocker(Thread::Blocker& b, void* data)
+{
+    VERIFY(data != nullptr);
+    VERIFY(m_lock.is_locked());
+    VERIFY(b.blocker_type() == Thread::Blocker::Type::Futex);
+    auto& blocker = static_cast<Thread::FutexBlocker&>(b);
+
+    if (blocker.wake_sequence() != m_wake_sequence.load(AK::MemoryOrder::memory_order_relaxed)) {
+        dbgln_if(FUTEXQUEUE_DEBUG, "PrivateFutexBucket @ {}: should not block thread {}: woken up since it checked the futex", this, *static_cast<Thread*>(data));
+        return false;
+    }
+    return true;
+}
+
+u32 PrivateFutexBucket::wake_n(Process const& process, FlatPtr user_address, u32 wake_count, const Optional<u32>& bitset)
+{
+    if (wake_count == 0)
+        return 0;
+    ScopedSpinLock lock(m_lock);
+    m_wake_sequence.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+    dbgln_if(FUTEXQUEUE_DEBUG, "PrivateFutexBucket @ {}: wake_n({:p}, {})", this, user_address, wake_count);
+    u32 did_wake = 0;
+    do_unblock([&](Thread::Blocker& b, void* data, bool& stop_iterating) {
+        VERIFY(b.blocker_type() == Thread::Blocker::Type::Futex);
+        auto& blocker = static_cast<Thread::FutexBlocker&>(b);
+        if (!is_waiting_on(blocker, data, process, user_address))
+            return false;
+        if (bitset.has_value() ? blocker.unblock_bitset(bitset.value()) : blocker.unblock()) {
+            if (++did_wake >= wake_count)
+                stop_iterating = true;
+            return true;
+        }
+        return false;
+    });
+    return did_wake;
+}
+
+u32 PrivateFutexBucket::wake_n_requeue(Process const& process, FlatPtr user_address, u32 wake_count, PrivateFutexBucket& target, FlatPtr target_user_address, u32 requeue_count)
+{
+    if (&target == this) {
+        ScopedSpinLock lock(m_lock);
+        return wake_n_requeue_locked(process, user_address, wake_count, target, target_user_address, requeue_count);
+    }
+
+    // Always in the same order, so that two requeues the other way around can't deadlock.
+    auto& first = this < &target ? *this : target;
+    auto& second = this < &target ? target : *this;
+    ScopedSpinLock first_lock(first.m_lock);
+    ScopedSpinLock second_lock(second.m_lock);
+    return wake_n_requeue_locked(process, user_address, wake_count, target, target_user_address, requeue_count);
+}
+
+u32 PrivateFutexBucket::wake_n_requeue_locked(Process const& process, FlatPtr user_address, u32 wake_count, PrivateFutexBucket& target, FlatPtr target_user_address, u32 requeue_count)
+{
+    VERIFY(m_lock.is_locked());
+    VERIFY(target.m_lock.is_locked());
+    m_wake_sequence.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+    dbgln_if(FUTEXQUEUE_DEBUG, "PrivateFutexBucket @ {}: wake_n_requeue({:p}, {}, {:p}, {})", this, user_address, wake_count, target_user_address, requeue_count);
+
+    u32 did_wake = 0;
+    Vector<BlockerInfo, 4> blockers_to_requeue;
+    do_unblock([&](Thread::Blocker& b, void* data, bool& stop_iterating) {
+        VERIFY(b.blocker_type() == Thread::Blocker::Type::Futex);
+        auto& blocker = static_cast<Thread::FutexBlocker&>(b);
+        if (!is_waiting_on(blocker, data, process, user_address))
+            return false;
+        if (did_wake < wake_count) {
+            if (!blocker.unblock())
+                return false;
+            ++did_wake;
+            return true;
+        }
+        if (blockers_to_requeue.size() < requeue_count) {
+            // This takes it out of this bucket, it goes into the target one below.
+            blockers_to_requeue.append({ &blocker, data });
+            return true;
+        }
+        stop_iterating = true;
+        return false;
+    });
+
+    u32 did_requeue = blockers_to_requeue.size();
+    for (auto& info : blockers_to_requeue) {
+        auto& blocker = *static_cast<Thread::FutexBlocker*>(info.blocker);
+        blocker.begin_requeue();
+        blocker.finish_requeue(target, target_user_address);
+    }
+    target.do_append_blockers(move(blockers_to_requeue));
+    return did_wake + did_requeue;
+}
+
+u32 PrivateFutexBucket::wake_all_in_process(Process const& process)
+{
+    u32 did_wake = 0;
+    for (auto& bucket : *s_private_futex_buckets) {
+        ScopedSpinLock lock(bucket.m_lock);
+        bucket.m_wake_sequence.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+        bucket.do_unblock([&](Thread::Blocker& b, void* data, bool&) {
+            VERIFY(b.blocker_type() == Thread::Blocker::Type::Futex);
+            VERIFY(data);
+            auto& blocker = static_cast<Thread::FutexBlocker&>(b);
+            if (&static_cast<Thread*>(data)->process() != &process)
+                return false;
+            if (blocker.unblock(true)) {
+                did_wake++;
+                return true;
+            }
+            return false;
+        });
+    }
+    return did_wake;
+}
+
 }
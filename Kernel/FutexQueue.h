@@ -57,4 +57,33 @@ private:
     bool m_was_removed { false };
 };
 
+// Private futexes don't get a FutexQueue of their own. All of them share a fixed table of these
+// instead, picked by hashing the process and the address, so waiting never has to allocate a queue
+// and waiters on unrelated futexes rarely contend for the same lock.
+class PrivateFutexBucket final : public Thread::BlockCondition {
+public:
+    static PrivateFutexBucket& for_futex(Process const&, FlatPtr user_address);
+    static u32 wake_all_in_process(Process const&);
+
+    // Every wake bumps this. A waiter fetches it before checking the value of the futex,
+    // and doesn't go to sleep if there has been a wake in the meantime, since that might have been for it.
+    u32 wake_sequence() const { return m_wake_sequence.load(AK::MemoryOrder::memory_order_acquire); }
+
+    Thread::BlockResult wait_on(const Thread::BlockTimeout& timeout, FlatPtr user_address, u32 wake_sequence, u32 bitset)
+    {
+        return Thread::current()->block<Thread::FutexBlocker>(timeout, *this, bitset, user_address, wake_sequence);
+    }
+
+    u32 wake_n(Process const&, FlatPtr user_address, u32 wake_count, const Optional<u32>& bitset);
+    u32 wake_n_requeue(Process const&, FlatPtr user_address, u32 wake_count, PrivateFutexBucket& target, FlatPtr target_user_address, u32 requeue_count);
+
+protected:
+    virtual bool should_add_blocker(Thread::Blocker&, void*) override;
+
+private:
+    u32 wake_n_requeue_locked(Process const&, FlatPtr user_address, u32 wake_count, PrivateFutexBucket& target, FlatPtr target_user_address, u32 requeue_count);
+
+    Atomic<u32> m_wake_sequence { 0 };
+};
+
 }
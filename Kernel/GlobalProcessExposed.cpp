@@ -395,6 +395,20 @@ private:
             json.add(String::formatted("{}_num_allocated", prefix), num_allocated);
             json.add(String::formatted("{}_num_free", prefix), num_free);
         });
+        {
+            auto caches = json.add_array("slab_caches");
+            SlabCache::for_each([&caches](SlabCache const& cache) {
+                auto statistics = cache.statistics();
+                auto cache_object = caches.add_object();
+                cache_object.add("name", cache.name());
+                cache_object.add("object_size", statistics.object_size);
+                cache_object.add("allocated", statistics.allocated);
+                cache_object.add("free", statistics.free);
+                cache_object.add("allocation_count", statistics.allocation_count);
+                cache_object.add("depot_refill_count", statistics.depot_refill_count);
+                cache_object.add("depot_flush_count", statistics.depot_flush_count);
+            });
+        }
         json.finish();
         return true;
     }
@@ -538,6 +552,33 @@ private:
         return true;
     }
 };
+class ProcFSSystemStatistics final : public ProcFSGlobalInformation {
+public:
+    static NonnullRefPtr<ProcFSSystemStatistics> must_create();
+
+private:
+    ProcFSSystemStatistics();
+    virtual bool output(KBufferBuilder& builder) override
+    {
+        JsonObjectSerializer<KBufferBuilder> json { builder };
+        json.add("uptime_ms", TimeManagement::the().uptime_ms());
+        json.add("pcid", Processor::is_pcid_enabled());
+        auto processors = json.add_array("processors");
+        Processor::for_each(
+            [&](Processor& proc) {
+                auto& tlb_statistics = proc.tlb_statistics();
+                auto obj = processors.add_object();
+                obj.add("processor", proc.get_id());
+                obj.add("tlb_shootdowns_sent", tlb_statistics.shootdowns_sent);
+                obj.add("tlb_shootdown_ipis_sent", tlb_statistics.shootdown_ipis_sent);
+                obj.add("tlb_shootdowns_received", tlb_statistics.shootdowns_received);
+                obj.add("tlb_full_flushes", tlb_statistics.full_flushes);
+            });
+        processors.finish();
+        json.finish();
+        return true;
+    }
+};
 class ProcFSDmesg final : public ProcFSGlobalInformation {
 public:
     static NonnullRefPtr<ProcFSDmesg> must_create();
@@ -754,6 +795,10 @@ UNMAP_AFTER_INIT NonnullRefPtr<ProcFSCPUInformation> ProcFSCPUInformation::must_
 {
     return adopt_ref_if_nonnull(new (nothrow) ProcFSCPUInformation).release_nonnull();
 }
+UNMAP_AFTER_INIT NonnullRefPtr<ProcFSSystemStatistics> ProcFSSystemStatistics::must_create()
+{
+    return adopt_ref_if_nonnull(new (nothrow) ProcFSSystemStatistics).release_nonnull();
+}
 UNMAP_AFTER_INIT NonnullRefPtr<ProcFSDmesg> ProcFSDmesg::must_create()
 {
     return adopt_ref_if_nonnull(new (nothrow) ProcFSDmesg).release_nonnull();
@@ -816,6 +861,10 @@ UNMAP_AFTER_INIT ProcFSCPUInformation::ProcFSCPUInformation()
     : ProcFSGlobalInformation("cpuinfo"sv)
 {
 }
+UNMAP_AFTER_INIT ProcFSSystemStatistics::ProcFSSystemStatistics()
+    : ProcFSGlobalInformation("stat"sv)
+{
+}
 UNMAP_AFTER_INIT ProcFSDmesg::ProcFSDmesg()
     : ProcFSGlobalInformation("dmesg"sv)
 {
@@ -880,6 +929,7 @@ UNMAP_AFTER_INIT NonnullRefPtr<ProcFSRootDirectory> ProcFSRootDirectory::must_cr
     directory->m_components.append(ProcFSMemoryStatus::must_create());
     directory->m_components.append(ProcFSOverallProcesses::must_create());
     directory->m_components.append(ProcFSCPUInformation::must_create());
+    directory->m_components.append(ProcFSSystemStatistics::must_create());
     directory->m_components.append(ProcFSDmesg::must_create());
     directory->m_components.append(ProcFSInterrupts::must_create());
     directory->m_components.append(ProcFSKeymap::must_create());
@@ -6,171 +6,189 @@
 
 #include <AK/Assertions.h>
 #include <AK/Memory.h>
+#include <Kernel/Arch/x86/InterruptDisabler.h>
 #include <Kernel/Heap/SlabAllocator.h>
 #include <Kernel/Heap/kmalloc.h>
-#include <Kernel/Memory/Region.h>
-#include <Kernel/Sections.h>
 
 #define SANITIZE_SLABS
 
 namespace Kernel {
 
-template<size_t templated_slab_size>
-class SlabAllocator {
-public:
-    SlabAllocator() = default;
+// How much memory a cache takes from kmalloc() at once, unless its objects are so large that fewer than
+// min_objects_per_chunk would fit.
+static constexpr size_t chunk_size = 16 * KiB;
+static constexpr size_t min_objects_per_chunk = 8;
 
-    void init(size_t size)
-    {
-        m_base = kmalloc_eternal(size);
-        m_end = (u8*)m_base + size;
-        FreeSlab* slabs = (FreeSlab*)m_base;
-        m_slab_count = size / templated_slab_size;
-        for (size_t i = 1; i < m_slab_count; ++i) {
-            slabs[i].next = &slabs[i - 1];
-        }
-        slabs[0].next = nullptr;
-        m_freelist = &slabs[m_slab_count - 1];
-        m_num_allocated = 0;
-    }
+static SpinLock<u8> s_caches_lock;
+static SlabCache* s_first_cache;
 
-    constexpr size_t slab_size() const { return templated_slab_size; }
-    size_t slab_count() const { return m_slab_count; }
-
-    void* alloc()
-    {
-        FreeSlab* free_slab;
+void* SlabCache::allocate()
+{
+    void* object = nullptr;
+    for (;;) {
         {
-            // We want to avoid being swapped out in the middle of this
-            ScopedCritical critical;
-            FreeSlab* next_free;
-            free_slab = m_freelist.load(AK::memory_order_consume);
-            do {
-                if (!free_slab)
-                    return kmalloc(slab_size());
-                // It's possible another processor is doing the same thing at
-                // the same time, so next_free *can* be a bogus pointer. However,
-                // in that case compare_exchange_strong would fail and we would
-                // try again.
-                next_free = free_slab->next;
-            } while (!m_freelist.compare_exchange_strong(free_slab, next_free, AK::memory_order_acq_rel));
-
-            m_num_allocated++;
+            // Interrupt handlers allocate as well, so nothing may get between us and our magazine.
+            InterruptDisabler disabler;
+            auto& magazine = m_magazines[Processor::id()];
+            if (magazine.count == 0)
+                refill(magazine);
+            if (magazine.count > 0) {
+                object = magazine.objects[--magazine.count];
+                ++magazine.allocation_count;
+                break;
+            }
         }
+        // Growing the cache may allocate from this very cache again, so it can't be done with our magazine in hand.
+        if (!grow())
+            return nullptr;
+    }
 
 #ifdef SANITIZE_SLABS
-        memset(free_slab, SLAB_ALLOC_SCRUB_BYTE, slab_size());
+    memset(object, SLAB_ALLOC_SCRUB_BYTE, m_object_size);
 #endif
-        return free_slab;
-    }
+    return object;
+}
 
-    void dealloc(void* ptr)
-    {
-        VERIFY(ptr);
-        if (ptr < m_base || ptr >= m_end) {
-            kfree(ptr);
-            return;
-        }
-        FreeSlab* free_slab = (FreeSlab*)ptr;
+void SlabCache::deallocate(void* object)
+{
+    VERIFY(object);
 #ifdef SANITIZE_SLABS
-        if (slab_size() > sizeof(FreeSlab*))
-            memset(free_slab->padding, SLAB_DEALLOC_SCRUB_BYTE, sizeof(FreeSlab::padding));
+    memset(object, SLAB_DEALLOC_SCRUB_BYTE, m_object_size);
 #endif
 
-        // We want to avoid being swapped out in the middle of this
-        ScopedCritical critical;
-        FreeSlab* next_free = m_freelist.load(AK::memory_order_consume);
-        do {
-            free_slab->next = next_free;
-        } while (!m_freelist.compare_exchange_strong(next_free, free_slab, AK::memory_order_acq_rel));
+    InterruptDisabler disabler;
+    auto& magazine = m_magazines[Processor::id()];
+    if (magazine.count == magazine_capacity)
+        flush(magazine);
+    magazine.objects[magazine.count++] = object;
+}
 
-        m_num_allocated--;
+void SlabCache::refill(Magazine& magazine)
+{
+    ScopedSpinLock lock(m_lock);
+    if (!m_depot)
+        return;
+    // Only fill half of it, so that a few frees right after don't send everything straight back.
+    while (m_depot && magazine.count < magazine_capacity / 2) {
+        auto* object = m_depot;
+        m_depot = object->next;
+        --m_depot_count;
+        magazine.objects[magazine.count++] = object;
     }
+    ++m_depot_refill_count;
+}
 
-    size_t num_allocated() const { return m_num_allocated; }
-    size_t num_free() const { return m_slab_count - m_num_allocated; }
-
-private:
-    struct FreeSlab {
-        FreeSlab* next;
-        char padding[templated_slab_size - sizeof(FreeSlab*)];
-    };
-
-    Atomic<FreeSlab*> m_freelist { nullptr };
-    Atomic<size_t, AK::MemoryOrder::memory_order_relaxed> m_num_allocated;
-    size_t m_slab_count;
-    void* m_base { nullptr };
-    void* m_end { nullptr };
+void SlabCache::flush(Magazine& magazine)
+{
+    ScopedSpinLock lock(m_lock);
+    while (magazine.count > magazine_capacity / 2) {
+        auto* object = static_cast<FreeObject*>(magazine.objects[--magazine.count]);
+        object->next = m_depot;
+        m_depot = object;
+        ++m_depot_count;
+    }
+    ++m_depot_flush_count;
+}
 
-    static_assert(sizeof(FreeSlab) == templated_slab_size);
-};
+bool SlabCache::grow()
+{
+    size_t object_count = max(chunk_size / m_object_size, min_objects_per_chunk);
+    auto* memory = static_cast<u8*>(kmalloc(object_count * m_object_size + m_alignment));
+    if (!memory)
+        return false;
+    memory = reinterpret_cast<u8*>(round_up_to_power_of_two(reinterpret_cast<FlatPtr>(memory), m_alignment));
 
-static SlabAllocator<16> s_slab_allocator_16;
-static SlabAllocator<32> s_slab_allocator_32;
-static SlabAllocator<64> s_slab_allocator_64;
-static SlabAllocator<128> s_slab_allocator_128;
-static SlabAllocator<256> s_slab_allocator_256;
+    {
+        ScopedSpinLock lock(s_caches_lock);
+        if (!m_registered) {
+            m_next_cache = s_first_cache;
+            s_first_cache = this;
+            m_registered = true;
+        }
+    }
 
-#if ARCH(I386)
-static_assert(sizeof(Memory::Region) <= s_slab_allocator_128.slab_size());
-#endif
+    ScopedSpinLock lock(m_lock);
+    for (size_t i = 0; i < object_count; ++i) {
+        auto* object = reinterpret_cast<FreeObject*>(memory + i * m_object_size);
+        object->next = m_depot;
+        m_depot = object;
+    }
+    m_depot_count += object_count;
+    m_object_count += object_count;
+    return true;
+}
 
-template<typename Callback>
-void for_each_allocator(Callback callback)
+SlabCache::Statistics SlabCache::statistics() const
 {
-    callback(s_slab_allocator_16);
-    callback(s_slab_allocator_32);
-    callback(s_slab_allocator_64);
-    callback(s_slab_allocator_128);
-    callback(s_slab_allocator_256);
+    Statistics statistics;
+    statistics.object_size = m_object_size;
+
+    // The magazines belong to their processors, so this is only a snapshot of them.
+    size_t free = 0;
+    for (auto& magazine : m_magazines) {
+        free += magazine.count;
+        statistics.allocation_count += magazine.allocation_count;
+    }
+
+    ScopedSpinLock lock(m_lock);
+    free += m_depot_count;
+    statistics.free = min(free, m_object_count);
+    statistics.allocated = m_object_count - statistics.free;
+    statistics.depot_refill_count = m_depot_refill_count;
+    statistics.depot_flush_count = m_depot_flush_count;
+    return statistics;
 }
 
-UNMAP_AFTER_INIT void slab_alloc_init()
+void SlabCache::for_each(Function<void(SlabCache const&)> callback)
 {
-    s_slab_allocator_16.init(128 * KiB);
-    s_slab_allocator_32.init(128 * KiB);
-    s_slab_allocator_64.init(512 * KiB);
-    s_slab_allocator_128.init(512 * KiB);
-    s_slab_allocator_256.init(128 * KiB);
+    SlabCache* first_cache;
+    {
+        ScopedSpinLock lock(s_caches_lock);
+        first_cache = s_first_cache;
+    }
+    // Caches are only ever added at the front, and never go away.
+    for (auto* cache = first_cache; cache; cache = cache->m_next_cache)
+        callback(*cache);
 }
 
-void* slab_alloc(size_t slab_size)
+static constinit SlabCache s_slab_cache_16 { "slab-16", 16 };
+static constinit SlabCache s_slab_cache_32 { "slab-32", 32 };
+static constinit SlabCache s_slab_cache_64 { "slab-64", 64 };
+static constinit SlabCache s_slab_cache_128 { "slab-128", 128 };
+static constinit SlabCache s_slab_cache_256 { "slab-256", 256 };
+
+static SlabCache& slab_cache_for_size(size_t slab_size)
 {
     if (slab_size <= 16)
-        return s_slab_allocator_16.alloc();
+        return s_slab_cache_16;
     if (slab_size <= 32)
-        return s_slab_allocator_32.alloc();
+        return s_slab_cache_32;
     if (slab_size <= 64)
-        return s_slab_allocator_64.alloc();
+        return s_slab_cache_64;
     if (slab_size <= 128)
-        return s_slab_allocator_128.alloc();
+        return s_slab_cache_128;
     if (slab_size <= 256)
-        return s_slab_allocator_256.alloc();
+        return s_slab_cache_256;
     VERIFY_NOT_REACHED();
 }
 
+void* slab_alloc(size_t slab_size)
+{
+    return slab_cache_for_size(slab_size).allocate();
+}
+
 void slab_dealloc(void* ptr, size_t slab_size)
 {
-    if (slab_size <= 16)
-        return s_slab_allocator_16.dealloc(ptr);
-    if (slab_size <= 32)
-        return s_slab_allocator_32.dealloc(ptr);
-    if (slab_size <= 64)
-        return s_slab_allocator_64.dealloc(ptr);
-    if (slab_size <= 128)
-        return s_slab_allocator_128.dealloc(ptr);
-    if (slab_size <= 256)
-        return s_slab_allocator_256.dealloc(ptr);
-    VERIFY_NOT_REACHED();
+    slab_cache_for_size(slab_size).deallocate(ptr);
 }
 
 void slab_alloc_stats(Function<void(size_t slab_size, size_t allocated, size_t free)> callback)
 {
-    for_each_allocator([&](auto& allocator) {
-        auto num_allocated = allocator.num_allocated();
-        auto num_free = allocator.slab_count() - num_allocated;
-        callback(allocator.slab_size(), num_allocated, num_free);
-    });
+    Array<SlabCache*, 5> caches { &s_slab_cache_16, &s_slab_cache_32, &s_slab_cache_64, &s_slab_cache_128, &s_slab_cache_256 };
+    for (auto* cache : caches) {
+        auto statistics = cache->statistics();
+        callback(statistics.object_size, statistics.allocated, statistics.free);
+    }
 }
 
 }
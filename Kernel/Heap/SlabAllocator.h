@@ -6,38 +6,114 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/Function.h>
+#include <AK/StdLibExtras.h>
+#include <AK/StringView.h>
 #include <AK/Types.h>
+#include <Kernel/Locking/SpinLock.h>
 
 namespace Kernel {
 
 #define SLAB_ALLOC_SCRUB_BYTE 0xab
 #define SLAB_DEALLOC_SCRUB_BYTE 0xbc
 
+// A cache of objects of a single size. Each processor keeps a magazine of free objects that it allocates from and
+// frees into with nothing but interrupts disabled, and only takes the cache lock to move half a magazine to or from
+// the shared depot. The memory comes from kmalloc() in chunks, and is kept by the cache once it has it.
+class SlabCache {
+    AK_MAKE_NONCOPYABLE(SlabCache);
+    AK_MAKE_NONMOVABLE(SlabCache);
+
+public:
+    struct Statistics {
+        size_t object_size { 0 };
+        size_t allocated { 0 };
+        size_t free { 0 };
+        u64 allocation_count { 0 };
+        u64 depot_refill_count { 0 };
+        u64 depot_flush_count { 0 };
+    };
+
+    constexpr SlabCache(StringView name, size_t object_size, size_t alignment = sizeof(void*))
+        : m_name(name)
+        , m_alignment(max(alignment, sizeof(void*)))
+        , m_object_size(round_up_to_power_of_two(object_size, max(alignment, sizeof(void*))))
+    {
+    }
+
+    [[nodiscard]] void* allocate();
+    void deallocate(void*);
+
+    StringView name() const { return m_name; }
+    size_t object_size() const { return m_object_size; }
+    Statistics statistics() const;
+
+    static void for_each(Function<void(SlabCache const&)>);
+
+private:
+    static constexpr size_t magazine_capacity = 32;
+
+    struct FreeObject {
+        FreeObject* next;
+    };
+
+    // Only ever touched by its own processor, so it gets a cache line of its own.
+    struct alignas(64) Magazine {
+        Array<void*, magazine_capacity> objects {};
+        size_t count { 0 };
+        u64 allocation_count { 0 };
+    };
+
+    void refill(Magazine&);
+    void flush(Magazine&);
+    bool grow();
+
+    StringView m_name;
+    size_t m_alignment { 0 };
+    size_t m_object_size { 0 };
+    Array<Magazine, max_processor_count> m_magazines {};
+
+    mutable SpinLock<u8> m_lock;
+    FreeObject* m_depot { nullptr };
+    size_t m_depot_count { 0 };
+    size_t m_object_count { 0 };
+    u64 m_depot_refill_count { 0 };
+    u64 m_depot_flush_count { 0 };
+
+    SlabCache* m_next_cache { nullptr };
+    bool m_registered { false };
+};
+
 void* slab_alloc(size_t slab_size);
 void slab_dealloc(void*, size_t slab_size);
-void slab_alloc_init();
 void slab_alloc_stats(Function<void(size_t slab_size, size_t allocated, size_t free)>);
 
-#define MAKE_SLAB_ALLOCATED(type)                                            \
-public:                                                                      \
-    [[nodiscard]] void* operator new(size_t)                                 \
-    {                                                                        \
-        void* ptr = slab_alloc(sizeof(type));                                \
-        VERIFY(ptr);                                                         \
-        return ptr;                                                          \
-    }                                                                        \
-    [[nodiscard]] void* operator new(size_t, const std::nothrow_t&) noexcept \
-    {                                                                        \
-        return slab_alloc(sizeof(type));                                     \
-    }                                                                        \
-    void operator delete(void* ptr) noexcept                                 \
-    {                                                                        \
-        if (!ptr)                                                            \
-            return;                                                          \
-        slab_dealloc(ptr, sizeof(type));                                     \
-    }                                                                        \
-                                                                             \
+// Gives the type a SlabCache of its own, which shows up by the type's name in /proc/memstat.
+#define MAKE_SLAB_ALLOCATED(type)                                                     \
+public:                                                                               \
+    static SlabCache& slab_cache()                                                    \
+    {                                                                                 \
+        static constinit SlabCache cache { #type, sizeof(type), alignof(type) };      \
+        return cache;                                                                 \
+    }                                                                                 \
+    [[nodiscard]] void* operator new(size_t)                                          \
+    {                                                                                 \
+        void* ptr = slab_cache().allocate();                                          \
+        VERIFY(ptr);                                                                  \
+        return ptr;                                                                   \
+    }                                                                                 \
+    [[nodiscard]] void* operator new(size_t, const std::nothrow_t&) noexcept          \
+    {                                                                                 \
+        return slab_cache().allocate();                                               \
+    }                                                                                 \
+    void operator delete(void* ptr) noexcept                                          \
+    {                                                                                 \
+        if (!ptr)                                                                     \
+            return;                                                                   \
+        slab_cache().deallocate(ptr);                                                 \
+    }                                                                                 \
+                                                                                      \
 private:
 
 }
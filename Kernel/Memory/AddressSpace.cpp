@@ -5,6 +5,8 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/NonnullOwnPtrVector.h>
+#include <AK/ScopeGuard.h>
 #include <Kernel/Locking/SpinLock.h>
 #include <Kernel/Memory/AddressSpace.h>
 #include <Kernel/Memory/AnonymousVMObject.h>
@@ -102,10 +104,20 @@ KResult AddressSpace::unmap_mmap_range(VirtualAddress addr, size_t size)
 
     Vector<Region*, 2> new_regions;
 
+    // Rather than having every region tell the other CPUs about it, we flush the whole range once at the end.
+    // Until then, the old regions have to stay around, so that no one else gets their pages while a stale TLB
+    // entry might still point at them.
+    NonnullOwnPtrVector<Region> unmapped_regions;
+    ScopeGuard flush_guard = [&] {
+        MM.flush_tlb(&page_directory(), range_to_unmap.base(), range_to_unmap.size() / PAGE_SIZE);
+    };
+
     for (auto* old_region : regions) {
         // If it's a full match we can remove the entire old region.
         if (old_region->range().intersect(range_to_unmap).size() == old_region->size()) {
-            deallocate_region(*old_region);
+            auto region = take_region(*old_region);
+            region->unmap(Region::ShouldDeallocateVirtualRange::Yes, ShouldFlushTLB::No);
+            unmapped_regions.append(move(region));
             continue;
         }
 
@@ -114,10 +126,11 @@ KResult AddressSpace::unmap_mmap_range(VirtualAddress addr, size_t size)
         auto region = take_region(*old_region);
 
         // We manually unmap the old region here, specifying that we *don't* want the VM deallocated.
-        region->unmap(Region::ShouldDeallocateVirtualRange::No);
+        region->unmap(Region::ShouldDeallocateVirtualRange::No, ShouldFlushTLB::No);
 
         // Otherwise, split the regions and collect them for future mapping.
         auto split_regions_or_error = try_split_region_around_range(*region, range_to_unmap);
+        unmapped_regions.append(move(region));
         if (split_regions_or_error.is_error())
             return split_regions_or_error.error();
 
@@ -159,6 +172,7 @@ KResultOr<Region*> AddressSpace::try_allocate_split_region(Region const& source_
     region->set_syscall_region(source_region.is_syscall_region());
     region->set_mmap(source_region.is_mmap());
     region->set_stack(source_region.is_stack());
+    region->set_wants_huge_pages(source_region.wants_huge_pages());
     size_t page_offset_in_source_region = (offset_in_vmobject - source_region.offset_in_vmobject()) / PAGE_SIZE;
     for (size_t i = 0; i < region->page_count(); ++i) {
         if (source_region.should_cow(page_offset_in_source_region + i))
@@ -257,6 +257,39 @@ NonnullRefPtr<PhysicalPage> AnonymousVMObject::allocate_committed_page(Badge<Reg
     return m_unused_committed_pages->take_one();
 }
 
+bool AnonymousVMObject::try_allocate_huge_page(Badge<Region>, size_t first_page_index)
+{
+    VERIFY(first_page_index + pages_per_huge_page <= page_count());
+    if (is_volatile())
+        return false;
+
+    // All of the pages have to be untouched, and either all committed or all not.
+    auto& first_page = physical_pages()[first_page_index];
+    if (!first_page || (!first_page->is_lazy_committed_page() && !first_page->is_shared_zero_page()))
+        return false;
+    bool committed = first_page->is_lazy_committed_page();
+    for (size_t i = 1; i < pages_per_huge_page; ++i) {
+        if (physical_pages()[first_page_index + i] != first_page)
+            return false;
+    }
+
+    NonnullRefPtrVector<PhysicalPage> pages;
+    if (committed)
+        pages = m_unused_committed_pages->take_huge_page();
+    else
+        pages = MM.allocate_user_physical_huge_page();
+    if (pages.is_empty())
+        return false;
+
+    for (size_t i = 0; i < pages_per_huge_page; ++i) {
+        physical_pages()[first_page_index + i] = pages[i];
+        // Nobody else can have these pages yet, so there is nothing to copy on write.
+        if (!m_cow_map.is_null())
+            m_cow_map.set(first_page_index + i, false);
+    }
+    return true;
+}
+
 Bitmap& AnonymousVMObject::ensure_cow_map()
 {
     if (m_cow_map.is_null())
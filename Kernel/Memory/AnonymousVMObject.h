@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <Kernel/Heap/SlabAllocator.h>
 #include <Kernel/Memory/AllocationStrategy.h>
 #include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Memory/PageFaultResponse.h>
@@ -15,6 +16,7 @@
 namespace Kernel::Memory {
 
 class AnonymousVMObject final : public VMObject {
+    MAKE_SLAB_ALLOCATED(AnonymousVMObject)
 public:
     virtual ~AnonymousVMObject() override;
 
@@ -26,6 +28,7 @@ public:
     virtual RefPtr<VMObject> try_clone() override;
 
     [[nodiscard]] NonnullRefPtr<PhysicalPage> allocate_committed_page(Badge<Region>);
+    bool try_allocate_huge_page(Badge<Region>, size_t first_page_index);
     PageFaultResponse handle_cow_fault(size_t, VirtualAddress);
     size_t cow_pages() const;
     bool should_cow(size_t page_index, bool) const;
@@ -7,6 +7,7 @@
 #include <AK/Assertions.h>
 #include <AK/Memory.h>
 #include <AK/StringView.h>
+#include <Kernel/Arch/x86/InterruptDisabler.h>
 #include <Kernel/BootInfo.h>
 #include <Kernel/CMOS.h>
 #include <Kernel/FileSystem/Inode.h>
@@ -516,7 +517,7 @@ PageTableEntry* MemoryManager::pte(PageDirectory& page_directory, VirtualAddress
 
     auto* pd = quickmap_pd(const_cast<PageDirectory&>(page_directory), page_directory_table_index);
     PageDirectoryEntry const& pde = pd[page_directory_index];
-    if (!pde.is_present())
+    if (!pde.is_present() || pde.is_huge())
         return nullptr;
 
     return &quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()))[page_table_index];
@@ -533,6 +534,42 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     PageDirectoryEntry& pde = pd[page_directory_index];
+    if (pde.is_present() && pde.is_huge()) {
+        // Break the huge page up into a page table that maps the same pages, so that one of them can be changed.
+        bool did_purge = false;
+        auto page_table = allocate_user_physical_page(ShouldZeroFill::No, &did_purge);
+        if (!page_table) {
+            dbgln("MM: Unable to allocate page table to split the huge page at {}", vaddr);
+            return nullptr;
+        }
+        if (did_purge) {
+            // Purging may have remapped (and split) this very huge page already.
+            pd = quickmap_pd(page_directory, page_directory_table_index);
+            VERIFY(&pde == &pd[page_directory_index]); // Sanity check
+        }
+        if (pde.is_huge()) {
+            auto huge_page_base = pde.page_table_base() & ~(PhysicalPtr)PageDirectoryEntry::NoExecute;
+            auto* page_table_entries = quickmap_pt(page_table->paddr());
+            for (size_t i = 0; i < pages_per_huge_page; ++i) {
+                auto& pte = page_table_entries[i];
+                pte.clear();
+                pte.set_physical_page_base(huge_page_base + i * PAGE_SIZE);
+                pte.set_writable(pde.is_writable());
+                pte.set_user_allowed(pde.is_user_allowed());
+                pte.set_cache_disabled(pde.is_cache_disabled());
+                pte.set_execute_disabled(pde.is_execute_disabled());
+                pte.set_present(true);
+            }
+            pde.set_huge(false);
+            pde.set_page_table_base(page_table->paddr().get());
+            pde.set_writable(true);
+            pde.set_user_allowed(true);
+            pde.set_cache_disabled(false);
+            pde.set_execute_disabled(false);
+            auto result = page_directory.m_page_tables.set(vaddr.get() & ~(FlatPtr)0x1fffff, move(page_table));
+            VERIFY(result == AK::HashSetResult::InsertedNewEntry);
+        }
+    }
     if (!pde.is_present()) {
         bool did_purge = false;
         auto page_table = allocate_user_physical_page(ShouldZeroFill::Yes, &did_purge);
@@ -564,6 +601,26 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
     return &quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()))[page_table_index];
 }
 
+PageDirectoryEntry* MemoryManager::ensure_huge_pde(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    VERIFY(s_mm_lock.own_lock());
+    VERIFY(page_directory.get_lock().own_lock());
+    VERIFY(vaddr.get() % huge_page_size == 0);
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x1ff;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+
+    auto* pd = quickmap_pd(page_directory, page_directory_table_index);
+    PageDirectoryEntry& pde = pd[page_directory_index];
+    if (pde.is_present() && !pde.is_huge()) {
+        // The page table isn't needed anymore, since the huge page replaces all of its entries.
+        pde.clear();
+        auto result = page_directory.m_page_tables.remove(vaddr.get());
+        VERIFY(result);
+    }
+    return &pde;
+}
+
 void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress vaddr, bool is_last_release)
 {
     VERIFY_INTERRUPTS_DISABLED();
@@ -575,6 +632,11 @@ void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress va
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     PageDirectoryEntry& pde = pd[page_directory_index];
+    if (pde.is_present() && pde.is_huge()) {
+        // Huge pages are only used for regions that cover all of them, so the whole thing goes away.
+        pde.clear();
+        return;
+    }
     if (pde.is_present()) {
         auto* page_table = quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()));
         auto& pte = page_table[page_table_index];
@@ -675,10 +737,10 @@ Region* MemoryManager::find_region_from_vaddr(VirtualAddress vaddr)
 {
     if (auto* region = kernel_region_from_vaddr(vaddr))
         return region;
-    auto page_directory = PageDirectory::find_by_cr3(read_cr3());
-    if (!page_directory)
+    // CR3 may have a PCID in it, so ask the processor which page directory it's using instead.
+    auto* page_directory = Processor::current().active_page_directory();
+    if (!page_directory || !page_directory->address_space())
         return nullptr;
-    VERIFY(page_directory->address_space());
     return find_user_region_from_vaddr(*page_directory->address_space(), vaddr);
 }
 
@@ -808,7 +870,27 @@ void MemoryManager::deallocate_physical_page(PhysicalAddress paddr)
     --m_system_memory_info.super_physical_pages_used;
 }
 
-RefPtr<PhysicalPage> MemoryManager::find_free_user_physical_page(bool committed)
+RefPtr<PhysicalPage> MemoryManager::take_zeroed_page(bool any_processor)
+{
+    VERIFY(s_mm_lock.is_locked());
+    auto& mm_data = get_data();
+    if (mm_data.m_zeroed_page_count > 0)
+        return move(mm_data.m_zeroed_pages[--mm_data.m_zeroed_page_count]);
+    if (!any_processor)
+        return {};
+
+    RefPtr<PhysicalPage> page;
+    Processor::for_each([&](Processor& processor) {
+        auto* data = processor.get_specific<MemoryManagerData>();
+        if (!data || data->m_zeroed_page_count == 0)
+            return IterationDecision::Continue;
+        page = move(data->m_zeroed_pages[--data->m_zeroed_page_count]);
+        return IterationDecision::Break;
+    });
+    return page;
+}
+
+RefPtr<PhysicalPage> MemoryManager::find_free_user_physical_page(bool committed, ShouldZeroFill should_zero_fill)
 {
     VERIFY(s_mm_lock.is_locked());
     RefPtr<PhysicalPage> page;
@@ -822,33 +904,206 @@ RefPtr<PhysicalPage> MemoryManager::find_free_user_physical_page(bool committed)
             return {};
         m_system_memory_info.user_physical_pages_uncommitted--;
     }
-    for (auto& region : m_user_physical_regions) {
-        page = region.take_free_page();
-        if (!page.is_null()) {
-            ++m_system_memory_info.user_physical_pages_used;
-            break;
+
+    // Pages that have been zeroed already are saved for those who need them zeroed.
+    bool is_zeroed = false;
+    if (should_zero_fill == ShouldZeroFill::Yes) {
+        page = take_zeroed_page(false);
+        is_zeroed = !page.is_null();
+    }
+    if (page.is_null()) {
+        for (auto& region : m_user_physical_regions) {
+            page = region.take_free_page();
+            if (!page.is_null())
+                break;
         }
     }
+    if (page.is_null()) {
+        // The free pages that are left might all be sitting in the zeroed page pools.
+        page = take_zeroed_page(true);
+        is_zeroed = !page.is_null();
+    }
     VERIFY(!committed || !page.is_null());
+    if (page.is_null())
+        return {};
+    ++m_system_memory_info.user_physical_pages_used;
+
+    if (should_zero_fill == ShouldZeroFill::Yes && !is_zeroed) {
+        auto* ptr = quickmap_page(*page);
+        memset(ptr, 0, PAGE_SIZE);
+        unquickmap_page();
+    }
     return page;
 }
 
-NonnullRefPtr<PhysicalPage> MemoryManager::allocate_committed_user_physical_page(Badge<CommittedPhysicalPageSet>, ShouldZeroFill should_zero_fill)
+// Zeroes pages without pulling them into the cache, since nobody is going to touch them for a while.
+static void zero_pages_with_non_temporal_stores(u8* pages, size_t page_count)
 {
+#if ARCH(I386)
+    if (!Processor::current().has_feature(CPUFeature::SSE2)) {
+        fast_u32_fill((u32*)pages, 0, page_count * PAGE_SIZE / sizeof(u32));
+        return;
+    }
+#endif
+    auto* words = (FlatPtr*)pages;
+    for (size_t i = 0; i < page_count * PAGE_SIZE / sizeof(FlatPtr); i += 4) {
+        asm volatile(
+            "movnti %[zero], 0(%[words])\n"
+            "movnti %[zero], %c[word_size](%[words])\n"
+            "movnti %[zero], 2*%c[word_size](%[words])\n"
+            "movnti %[zero], 3*%c[word_size](%[words])\n"
+            :
+            : [words] "r"(words + i), [zero] "r"((FlatPtr)0), [word_size] "i"(sizeof(FlatPtr))
+            : "memory");
+    }
+    // Non-temporal stores are weakly ordered, so they have to be done before anyone else gets to see the pages.
+    asm volatile("sfence" ::
+                     : "memory");
+}
+
+static MemoryManagerData* zeroed_page_pool_with_room()
+{
+    VERIFY(s_mm_lock.is_locked());
+    MemoryManagerData* pool = nullptr;
+    Processor::for_each([&](Processor& processor) {
+        auto* data = processor.get_specific<MemoryManagerData>();
+        if (!data || data->m_zeroed_page_count == MemoryManagerData::zeroed_page_pool_capacity)
+            return IterationDecision::Continue;
+        pool = data;
+        return IterationDecision::Break;
+    });
+    return pool;
+}
+
+bool MemoryManager::refill_zeroed_page_pool()
+{
+    static constexpr size_t batch_page_count = 16;
+
+    NonnullRefPtrVector<PhysicalPage> pages;
+    {
+        ScopedSpinLock lock(s_mm_lock);
+        if (!zeroed_page_pool_with_room())
+            return false;
+
+        // Leave some free pages for everyone else.
+        while (pages.size() < batch_page_count && m_system_memory_info.user_physical_pages_uncommitted >= 4 * MemoryManagerData::zeroed_page_pool_capacity) {
+            RefPtr<PhysicalPage> page;
+            for (auto& region : m_user_physical_regions) {
+                page = region.take_free_page();
+                if (!page.is_null())
+                    break;
+            }
+            if (page.is_null())
+                break;
+            // The pages count as used while they're being zeroed, so that nobody counts on getting them in the meantime.
+            --m_system_memory_info.user_physical_pages_uncommitted;
+            ++m_system_memory_info.user_physical_pages_used;
+            pages.append(page.release_nonnull());
+        }
+    }
+    if (pages.is_empty())
+        return false;
+
+    // The zeroing is done through a mapping of our own, so that it doesn't have to hold the MM lock and keep interrupts disabled.
+    {
+        auto vmobject = AnonymousVMObject::try_create_with_physical_pages(pages.span());
+        if (!vmobject)
+            return false;
+        auto region = allocate_kernel_region_with_vmobject(*vmobject, pages.size() * PAGE_SIZE, "Page zeroing", Region::Access::ReadWrite);
+        if (!region)
+            return false;
+        zero_pages_with_non_temporal_stores(region->vaddr().as_ptr(), pages.size());
+    }
+
+    // Pages in the pools count as free again. The ones that don't fit anymore are freed along with the vector.
     ScopedSpinLock lock(s_mm_lock);
-    auto page = find_free_user_physical_page(true);
-    if (should_zero_fill == ShouldZeroFill::Yes) {
-        auto* ptr = quickmap_page(*page);
-        memset(ptr, 0, PAGE_SIZE);
+    for (auto& page : pages) {
+        auto* pool = zeroed_page_pool_with_room();
+        if (!pool)
+            break;
+        ++m_system_memory_info.user_physical_pages_uncommitted;
+        --m_system_memory_info.user_physical_pages_used;
+        pool->m_zeroed_pages[pool->m_zeroed_page_count++] = page;
+    }
+    return true;
+}
+
+NonnullRefPtrVector<PhysicalPage> MemoryManager::find_free_user_physical_huge_page(bool committed)
+{
+    VERIFY(s_mm_lock.is_locked());
+    if (committed)
+        VERIFY(m_system_memory_info.user_physical_pages_committed >= pages_per_huge_page);
+    else if (m_system_memory_info.user_physical_pages_uncommitted < pages_per_huge_page)
+        return {};
+
+    NonnullRefPtrVector<PhysicalPage> pages;
+    for (auto& region : m_user_physical_regions) {
+        pages = region.take_contiguous_free_pages(pages_per_huge_page);
+        if (!pages.is_empty())
+            break;
+    }
+    // Unlike with single pages, running out of huge pages is fine, even for committed ones, since the caller
+    // can always fall back to taking them one at a time.
+    if (pages.is_empty())
+        return {};
+
+    // Zones are aligned to their size, and so are the blocks allocated from them.
+    VERIFY(pages[0].paddr().get() % huge_page_size == 0);
+
+    if (committed)
+        m_system_memory_info.user_physical_pages_committed -= pages_per_huge_page;
+    else
+        m_system_memory_info.user_physical_pages_uncommitted -= pages_per_huge_page;
+    m_system_memory_info.user_physical_pages_used += pages_per_huge_page;
+    return pages;
+}
+
+// The pages are ours alone by now, so this doesn't need the MM lock, which would otherwise be held
+// for as long as it takes to zero 2 MiB.
+void MemoryManager::zero_huge_page(NonnullRefPtrVector<PhysicalPage> const& pages)
+{
+    VERIFY(!s_mm_lock.own_lock());
+    for (auto& page : pages) {
+        InterruptDisabler disabler;
+        auto* ptr = quickmap_page(page.paddr());
+        fast_u32_fill((u32*)ptr, 0, PAGE_SIZE / sizeof(u32));
         unquickmap_page();
     }
+}
+
+NonnullRefPtrVector<PhysicalPage> MemoryManager::allocate_committed_user_physical_huge_page(Badge<CommittedPhysicalPageSet>)
+{
+    NonnullRefPtrVector<PhysicalPage> pages;
+    {
+        ScopedSpinLock lock(s_mm_lock);
+        pages = find_free_user_physical_huge_page(true);
+    }
+    zero_huge_page(pages);
+    return pages;
+}
+
+NonnullRefPtrVector<PhysicalPage> MemoryManager::allocate_user_physical_huge_page()
+{
+    NonnullRefPtrVector<PhysicalPage> pages;
+    {
+        ScopedSpinLock lock(s_mm_lock);
+        pages = find_free_user_physical_huge_page(false);
+    }
+    zero_huge_page(pages);
+    return pages;
+}
+
+NonnullRefPtr<PhysicalPage> MemoryManager::allocate_committed_user_physical_page(Badge<CommittedPhysicalPageSet>, ShouldZeroFill should_zero_fill)
+{
+    ScopedSpinLock lock(s_mm_lock);
+    auto page = find_free_user_physical_page(true, should_zero_fill);
     return page.release_nonnull();
 }
 
 RefPtr<PhysicalPage> MemoryManager::allocate_user_physical_page(ShouldZeroFill should_zero_fill, bool* did_purge)
 {
     ScopedSpinLock lock(s_mm_lock);
-    auto page = find_free_user_physical_page(false);
+    auto page = find_free_user_physical_page(false, should_zero_fill);
     bool purged_pages = false;
 
     if (!page) {
@@ -862,7 +1117,7 @@ RefPtr<PhysicalPage> MemoryManager::allocate_user_physical_page(ShouldZeroFill s
                 return IterationDecision::Continue;
             if (auto purged_page_count = anonymous_vmobject.purge()) {
                 dbgln("MM: Purge saved the day! Purged {} pages from AnonymousVMObject", purged_page_count);
-                page = find_free_user_physical_page(false);
+                page = find_free_user_physical_page(false, should_zero_fill);
                 purged_pages = true;
                 VERIFY(page);
                 return IterationDecision::Break;
@@ -875,12 +1130,6 @@ RefPtr<PhysicalPage> MemoryManager::allocate_user_physical_page(ShouldZeroFill s
         }
     }
 
-    if (should_zero_fill == ShouldZeroFill::Yes) {
-        auto* ptr = quickmap_page(*page);
-        memset(ptr, 0, PAGE_SIZE);
-        unquickmap_page();
-    }
-
     if (did_purge)
         *did_purge = purged_pages;
     return page;
@@ -932,8 +1181,8 @@ void MemoryManager::enter_space(AddressSpace& space)
     VERIFY(current_thread != nullptr);
     ScopedSpinLock lock(s_mm_lock);
 
-    current_thread->regs().cr3 = space.page_directory().cr3();
-    write_cr3(space.page_directory().cr3());
+    current_thread->regs().page_directory = &space.page_directory();
+    Processor::current().activate_page_directory(space.page_directory());
 }
 
 void MemoryManager::flush_tlb_local(VirtualAddress vaddr, size_t page_count)
@@ -957,6 +1206,7 @@ PageDirectoryEntry* MemoryManager::quickmap_pd(PageDirectory& directory, size_t
         pte.set_present(true);
         pte.set_writable(true);
         pte.set_user_allowed(false);
+        pte.set_global(true);
         // Because we must continue to hold the MM lock while we use this
         // mapping, it is sufficient to only flush on the current CPU. Other
         // CPUs trying to use this API must wait on the MM lock anyway
@@ -982,6 +1232,7 @@ PageTableEntry* MemoryManager::quickmap_pt(PhysicalAddress pt_paddr)
         pte.set_present(true);
         pte.set_writable(true);
         pte.set_user_allowed(false);
+        pte.set_global(true);
         // Because we must continue to hold the MM lock while we use this
         // mapping, it is sufficient to only flush on the current CPU. Other
         // CPUs trying to use this API must wait on the MM lock anyway
@@ -1013,6 +1264,7 @@ u8* MemoryManager::quickmap_page(PhysicalAddress const& physical_address)
         pte.set_present(true);
         pte.set_writable(true);
         pte.set_user_allowed(false);
+        pte.set_global(true);
         flush_tlb_local(vaddr);
     }
     return vaddr.as_ptr();
@@ -1126,6 +1378,16 @@ NonnullRefPtr<PhysicalPage> CommittedPhysicalPageSet::take_one()
     return MM.allocate_committed_user_physical_page({}, MemoryManager::ShouldZeroFill::Yes);
 }
 
+NonnullRefPtrVector<PhysicalPage> CommittedPhysicalPageSet::take_huge_page()
+{
+    if (m_page_count < pages_per_huge_page)
+        return {};
+    auto pages = MM.allocate_committed_user_physical_huge_page({});
+    if (!pages.is_empty())
+        m_page_count -= pages_per_huge_page;
+    return pages;
+}
+
 void CommittedPhysicalPageSet::uncommit_one()
 {
     VERIFY(m_page_count > 0);
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/Concepts.h>
 #include <AK/HashTable.h>
 #include <AK/NonnullOwnPtrVector.h>
@@ -41,6 +42,10 @@ constexpr FlatPtr page_round_down(FlatPtr x)
     return ((FlatPtr)(x)) & ~(PAGE_SIZE - 1);
 }
 
+// A page directory entry can map a whole huge page by itself, instead of pointing to a page table.
+constexpr size_t huge_page_size = 2 * MiB;
+constexpr size_t pages_per_huge_page = huge_page_size / PAGE_SIZE;
+
 inline FlatPtr virtual_to_low_physical(FlatPtr virtual_)
 {
     return virtual_ - physical_to_virtual_offset;
@@ -98,6 +103,12 @@ struct MemoryManagerData {
 
     PhysicalAddress m_last_quickmap_pd;
     PhysicalAddress m_last_quickmap_pt;
+
+    // Free pages that the PageZeroingTask has already zeroed, so that page faults on this processor don't have to.
+    // They still count as uncommitted (or committed) until they're handed out. Protected by s_mm_lock.
+    static constexpr size_t zeroed_page_pool_capacity = 64;
+    Array<RefPtr<PhysicalPage>, zeroed_page_pool_capacity> m_zeroed_pages;
+    size_t m_zeroed_page_count { 0 };
 };
 
 extern RecursiveSpinLock s_mm_lock;
@@ -126,6 +137,8 @@ public:
     size_t page_count() const { return m_page_count; }
 
     [[nodiscard]] NonnullRefPtr<PhysicalPage> take_one();
+    // Returns nothing if there isn't a free huge page, or not enough committed pages left for one.
+    [[nodiscard]] NonnullRefPtrVector<PhysicalPage> take_huge_page();
     void uncommit_one();
 
     void operator=(CommittedPhysicalPageSet&&) = delete;
@@ -136,6 +149,7 @@ private:
 
 class MemoryManager {
     AK_MAKE_ETERNAL
+    friend class AddressSpace;
     friend class PageDirectory;
     friend class AnonymousVMObject;
     friend class Region;
@@ -176,6 +190,11 @@ public:
 
     NonnullRefPtr<PhysicalPage> allocate_committed_user_physical_page(Badge<CommittedPhysicalPageSet>, ShouldZeroFill = ShouldZeroFill::Yes);
     RefPtr<PhysicalPage> allocate_user_physical_page(ShouldZeroFill = ShouldZeroFill::Yes, bool* did_purge = nullptr);
+    NonnullRefPtrVector<PhysicalPage> allocate_committed_user_physical_huge_page(Badge<CommittedPhysicalPageSet>);
+    NonnullRefPtrVector<PhysicalPage> allocate_user_physical_huge_page();
+
+    // Zeroes a few free pages for the pools of processors that are running low. Returns false if there's nothing to do.
+    bool refill_zeroed_page_pool();
     RefPtr<PhysicalPage> allocate_supervisor_physical_page();
     NonnullRefPtrVector<PhysicalPage> allocate_contiguous_supervisor_physical_pages(size_t size);
     void deallocate_physical_page(PhysicalAddress);
@@ -256,7 +275,10 @@ private:
 
     static Region* find_region_from_vaddr(VirtualAddress);
 
-    RefPtr<PhysicalPage> find_free_user_physical_page(bool);
+    RefPtr<PhysicalPage> find_free_user_physical_page(bool, ShouldZeroFill);
+    RefPtr<PhysicalPage> take_zeroed_page(bool any_processor);
+    NonnullRefPtrVector<PhysicalPage> find_free_user_physical_huge_page(bool);
+    void zero_huge_page(NonnullRefPtrVector<PhysicalPage> const&);
 
     ALWAYS_INLINE u8* quickmap_page(PhysicalPage& page)
     {
@@ -270,6 +292,7 @@ private:
 
     PageTableEntry* pte(PageDirectory&, VirtualAddress);
     PageTableEntry* ensure_pte(PageDirectory&, VirtualAddress);
+    PageDirectoryEntry* ensure_huge_pde(PageDirectory&, VirtualAddress);
     void release_pte(PageDirectory&, VirtualAddress, bool);
 
     RefPtr<PageDirectory> m_kernel_page_directory;
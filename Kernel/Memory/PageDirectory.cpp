@@ -4,7 +4,9 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Array.h>
 #include <AK/Memory.h>
+#include <AK/NumericLimits.h>
 #include <AK/Singleton.h>
 #include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Memory/PageDirectory.h>
@@ -25,6 +27,35 @@ static HashMap<FlatPtr, PageDirectory*>& cr3_map()
     return *s_cr3_map;
 }
 
+// PCID 0 belongs to the kernel page directory, and to anyone we run out of PCIDs for.
+static constexpr size_t pcid_count = 4096;
+static Array<u64, pcid_count / 64> s_pcids_in_use;
+
+static u16 allocate_pcid()
+{
+    VERIFY(s_mm_lock.own_lock());
+    if (!Processor::is_pcid_enabled())
+        return 0;
+    for (size_t i = 0; i < s_pcids_in_use.size(); ++i) {
+        auto free_pcids = ~s_pcids_in_use[i];
+        if (i == 0)
+            free_pcids &= ~(u64)1;
+        if (!free_pcids)
+            continue;
+        auto bit = __builtin_ctzll(free_pcids);
+        s_pcids_in_use[i] |= (u64)1 << bit;
+        return i * 64 + bit;
+    }
+    return 0;
+}
+
+static void deallocate_pcid(u16 pcid)
+{
+    VERIFY(s_mm_lock.own_lock());
+    if (pcid != 0)
+        s_pcids_in_use[pcid / 64] &= ~((u64)1 << (pcid % 64));
+}
+
 RefPtr<PageDirectory> PageDirectory::find_by_cr3(FlatPtr cr3)
 {
     ScopedSpinLock lock(s_mm_lock);
@@ -134,6 +165,10 @@ RefPtr<PageDirectory> PageDirectory::try_create_for_userspace(VirtualRangeAlloca
     auto* new_pd = MM.quickmap_pd(*directory, 0);
     memcpy(new_pd, &buffer, sizeof(PageDirectoryEntry));
 
+    // Whoever had this PCID before us may have left entries behind in any of the TLBs.
+    directory->m_pcid = allocate_pcid();
+    directory->m_stale_tlb_cpu_mask = NumericLimits<u32>::max();
+
     cr3_map().set(directory->cr3(), directory.ptr());
     return directory;
 }
@@ -162,6 +197,7 @@ PageDirectory::~PageDirectory()
     ScopedSpinLock lock(s_mm_lock);
     if (m_space)
         cr3_map().remove(cr3());
+    deallocate_pcid(m_pcid);
 }
 
 }
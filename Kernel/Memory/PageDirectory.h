@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
 #include <AK/HashMap.h>
 #include <AK/RefCounted.h>
 #include <AK/RefPtr.h>
@@ -17,6 +18,7 @@ namespace Kernel::Memory {
 
 class PageDirectory : public RefCounted<PageDirectory> {
     friend class MemoryManager;
+    friend class Kernel::Processor;
 
 public:
     static RefPtr<PageDirectory> try_create_for_userspace(VirtualRangeAllocator const* parent_range_allocator = nullptr);
@@ -36,6 +38,10 @@ public:
 #endif
     }
 
+    // The address space ID that tags our TLB entries, if the CPU supports them. 0 means that we don't have one,
+    // and that the TLB is flushed whenever we're switched to.
+    u16 pcid() const { return m_pcid; }
+
     VirtualRangeAllocator& range_allocator() { return m_range_allocator; }
     VirtualRangeAllocator const& range_allocator() const { return m_range_allocator; }
 
@@ -62,6 +68,13 @@ private:
 #endif
     HashMap<FlatPtr, RefPtr<PhysicalPage>> m_page_tables;
     RecursiveSpinLock m_lock;
+
+    // The CPUs that may have TLB entries for this page directory, and so have to be told when it changes.
+    mutable Atomic<u32> m_tlb_cpu_mask { 0 };
+    // The CPUs that were told about a change while they weren't using this page directory, and have to flush its
+    // entries before using it again. Only used with PCIDs.
+    mutable Atomic<u32> m_stale_tlb_cpu_mask { 0 };
+    u16 m_pcid { 0 };
 };
 
 }
@@ -39,28 +39,42 @@ PhysicalRegion::PhysicalRegion(PhysicalAddress lower, PhysicalAddress upper)
 
 void PhysicalRegion::initialize_zones()
 {
+    // The largest zones have 4096 pages (16 MiB).
+    static constexpr size_t max_pages_per_zone = 4096;
+
     size_t remaining_pages = m_pages;
     auto base_address = m_lower;
 
-    auto make_zones = [&](size_t pages_per_zone) {
-        size_t zone_count = 0;
-        auto first_address = base_address;
-        while (remaining_pages >= pages_per_zone) {
-            m_zones.append(make<PhysicalZone>(base_address, pages_per_zone));
-            base_address = base_address.offset(pages_per_zone * PAGE_SIZE);
-            m_usable_zones.append(m_zones.last());
-            remaining_pages -= pages_per_zone;
-            ++zone_count;
-        }
+    size_t zone_count = 0;
+    size_t pages_per_zone = 0;
+    auto first_address = base_address;
+    auto log_zones = [&] {
         if (zone_count)
-            dmesgln(" * {}x PhysicalZone ({} MiB) @ {:016x}-{:016x}", zone_count, pages_per_zone / 256, first_address.get(), base_address.get() - pages_per_zone * PAGE_SIZE - 1);
+            dmesgln(" * {}x PhysicalZone ({} KiB) @ {:016x}-{:016x}", zone_count, pages_per_zone * PAGE_SIZE / KiB, first_address.get(), base_address.get() - 1);
     };
 
-    // First make 16 MiB zones (with 4096 pages each)
-    make_zones(4096);
+    // Every zone is as large as it can be while starting on a multiple of its own size, so that the blocks it hands
+    // out are aligned to their size as well. Huge pages depend on this, as they have to start on a 2 MiB boundary.
+    while (remaining_pages > 0) {
+        size_t zone_pages = min(max_pages_per_zone, (size_t)1 << (sizeof(size_t) * 8 - 1 - __builtin_clzl(remaining_pages)));
+        auto page_number = base_address.get() / PAGE_SIZE;
+        if (page_number != 0)
+            zone_pages = min(zone_pages, (size_t)1 << __builtin_ctzll(page_number));
+
+        if (zone_pages != pages_per_zone) {
+            log_zones();
+            zone_count = 0;
+            pages_per_zone = zone_pages;
+            first_address = base_address;
+        }
 
-    // Then divide any remaining space into 1 MiB zones (with 256 pages each)
-    make_zones(256);
+        m_zones.append(make<PhysicalZone>(base_address, zone_pages));
+        m_usable_zones.append(m_zones.last());
+        base_address = base_address.offset(zone_pages * PAGE_SIZE);
+        remaining_pages -= zone_pages;
+        ++zone_count;
+    }
+    log_zones();
 }
 
 OwnPtr<PhysicalRegion> PhysicalRegion::try_take_pages_from_beginning(unsigned page_count)
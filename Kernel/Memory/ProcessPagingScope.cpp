@@ -13,15 +13,15 @@ namespace Kernel {
 ProcessPagingScope::ProcessPagingScope(Process& process)
 {
     VERIFY(Thread::current() != nullptr);
-    m_previous_cr3 = read_cr3();
+    m_previous_page_directory = Thread::current()->regs().page_directory;
     MM.enter_process_paging_scope(process);
 }
 
 ProcessPagingScope::~ProcessPagingScope()
 {
     InterruptDisabler disabler;
-    Thread::current()->regs().cr3 = m_previous_cr3;
-    write_cr3(m_previous_cr3);
+    Thread::current()->regs().page_directory = m_previous_page_directory;
+    Processor::current().activate_page_directory(*m_previous_page_directory);
 }
 
 }
@@ -17,7 +17,7 @@ public:
     ~ProcessPagingScope();
 
 private:
-    u32 m_previous_cr3 { 0 };
+    Memory::PageDirectory* m_previous_page_directory { nullptr };
 };
 
 }
@@ -69,6 +69,7 @@ OwnPtr<Region> Region::clone()
         region->set_mmap(m_mmap);
         region->set_shared(m_shared);
         region->set_syscall_region(is_syscall_region());
+        region->set_wants_huge_pages(m_huge_pages);
         return region;
     }
 
@@ -95,6 +96,7 @@ OwnPtr<Region> Region::clone()
     }
     clone_region->set_syscall_region(is_syscall_region());
     clone_region->set_mmap(m_mmap);
+    clone_region->set_wants_huge_pages(m_huge_pages);
     return clone_region;
 }
 
@@ -200,10 +202,77 @@ bool Region::map_individual_page_impl(size_t page_index)
         if (Processor::current().has_feature(CPUFeature::NX))
             pte->set_execute_disabled(!is_executable());
         pte->set_user_allowed(user_allowed);
+        // Kernel mappings are the same in every address space, so they can survive switching between them.
+        pte->set_global(!is_user_address(page_vaddr));
     }
     return true;
 }
 
+Optional<size_t> Region::huge_page_containing(size_t page_index) const
+{
+    auto huge_page_vaddr = VirtualAddress { vaddr_from_page_index(page_index).get() & ~(FlatPtr)(huge_page_size - 1) };
+    if (!m_range.contains(huge_page_vaddr, huge_page_size))
+        return {};
+    return page_index_from_address(huge_page_vaddr);
+}
+
+bool Region::can_map_huge_page(size_t page_index) const
+{
+    if (vaddr_from_page_index(page_index).get() % huge_page_size != 0 || page_index + pages_per_huge_page > page_count())
+        return false;
+    if (!is_user() || !vmobject().is_anonymous() || (!is_readable() && !is_writable()))
+        return false;
+
+    // All of the pages have to be allocated, physically contiguous, and mapped the same way.
+    auto* first_page = physical_page(page_index);
+    if (!first_page || first_page->paddr().get() % huge_page_size != 0)
+        return false;
+    auto base = first_page->paddr();
+    for (size_t i = 0; i < pages_per_huge_page; ++i) {
+        auto* page = physical_page(page_index + i);
+        if (!page || page->paddr() != base.offset(i * PAGE_SIZE) || should_cow(page_index + i))
+            return false;
+    }
+    return true;
+}
+
+void Region::map_huge_page_impl(size_t page_index)
+{
+    VERIFY(m_page_directory->get_lock().own_lock());
+    auto page_vaddr = vaddr_from_page_index(page_index);
+
+    // NOTE: We have to take the MM lock for PDE's to stay valid while we use them.
+    ScopedSpinLock mm_locker(s_mm_lock);
+
+    auto* pde = MM.ensure_huge_pde(*m_page_directory, page_vaddr);
+    pde->clear();
+    pde->set_page_table_base(physical_page(page_index)->paddr().get());
+    pde->set_huge(true);
+    pde->set_cache_disabled(!m_cacheable);
+    pde->set_writable(is_writable());
+    if (Processor::current().has_feature(CPUFeature::NX))
+        pde->set_execute_disabled(!is_executable());
+    pde->set_user_allowed(true);
+    pde->set_present(true);
+}
+
+size_t Region::map_pages_impl(size_t page_index, size_t page_count)
+{
+    size_t end_index = page_index + page_count;
+    size_t index = page_index;
+    while (index < end_index) {
+        if (index + pages_per_huge_page <= end_index && can_map_huge_page(index)) {
+            map_huge_page_impl(index);
+            index += pages_per_huge_page;
+            continue;
+        }
+        if (!map_individual_page_impl(index))
+            break;
+        ++index;
+    }
+    return index - page_index;
+}
+
 bool Region::do_remap_vmobject_page(size_t page_index, bool with_flush)
 {
     ScopedSpinLock lock(vmobject().m_lock);
@@ -213,7 +282,12 @@ bool Region::do_remap_vmobject_page(size_t page_index, bool with_flush)
         return true; // not an error, region doesn't map this page
     ScopedSpinLock page_lock(m_page_directory->get_lock());
     VERIFY(physical_page(page_index));
-    bool success = map_individual_page_impl(page_index);
+    bool success = true;
+    // Keep a huge page in one piece if the page still fits into it, rather than splitting it up for nothing.
+    if (auto huge_page_index = huge_page_containing(page_index); huge_page_index.has_value() && can_map_huge_page(huge_page_index.value()))
+        map_huge_page_impl(huge_page_index.value());
+    else
+        success = map_individual_page_impl(page_index);
     if (with_flush)
         MM.flush_tlb(m_page_directory, vaddr_from_page_index(page_index));
     return success;
@@ -230,7 +304,35 @@ bool Region::remap_vmobject_page(size_t page_index, bool with_flush)
     return success;
 }
 
-void Region::unmap(ShouldDeallocateVirtualRange deallocate_range)
+bool Region::do_remap_vmobject_page_range(size_t page_index, size_t page_count)
+{
+    ScopedSpinLock lock(vmobject().m_lock);
+    if (!m_page_directory)
+        return true; // not an error, region may have not yet mapped it
+    auto first_index = max(page_index, first_page_index());
+    auto end_index = min(page_index + page_count, first_page_index() + this->page_count());
+    if (first_index >= end_index)
+        return true; // not an error, region doesn't map these pages
+    ScopedSpinLock page_lock(m_page_directory->get_lock());
+    auto first_index_in_region = first_index - first_page_index();
+    auto count = end_index - first_index;
+    bool success = map_pages_impl(first_index_in_region, count) == count;
+    MM.flush_tlb(m_page_directory, vaddr_from_page_index(first_index_in_region), count);
+    return success;
+}
+
+bool Region::remap_vmobject_page_range(size_t page_index, size_t page_count)
+{
+    auto& vmobject = this->vmobject();
+    bool success = true;
+    vmobject.for_each_region([&](auto& region) {
+        if (!region.do_remap_vmobject_page_range(page_index, page_count))
+            success = false;
+    });
+    return success;
+}
+
+void Region::unmap(ShouldDeallocateVirtualRange deallocate_range, ShouldFlushTLB should_flush_tlb)
 {
     if (!m_page_directory)
         return;
@@ -241,7 +343,8 @@ void Region::unmap(ShouldDeallocateVirtualRange deallocate_range)
         auto vaddr = vaddr_from_page_index(i);
         MM.release_pte(*m_page_directory, vaddr, i == count - 1);
     }
-    MM.flush_tlb(m_page_directory, vaddr(), page_count());
+    if (should_flush_tlb == ShouldFlushTLB::Yes)
+        MM.flush_tlb(m_page_directory, vaddr(), page_count());
     if (deallocate_range == ShouldDeallocateVirtualRange::Yes) {
         m_page_directory->range_allocator().deallocate(range());
     }
@@ -266,12 +369,7 @@ bool Region::map(PageDirectory& page_directory, ShouldFlushTLB should_flush_tlb)
     }
 
     set_page_directory(page_directory);
-    size_t page_index = 0;
-    while (page_index < page_count()) {
-        if (!map_individual_page_impl(page_index))
-            break;
-        ++page_index;
-    }
+    size_t page_index = map_pages_impl(0, page_count());
     if (page_index > 0) {
         if (should_flush_tlb == ShouldFlushTLB::Yes)
             MM.flush_tlb(m_page_directory, vaddr(), page_index);
@@ -320,7 +418,7 @@ PageFaultResponse Region::handle_fault(PageFault const& fault)
         auto* phys_page = physical_page(page_index_in_region);
         if (phys_page->is_shared_zero_page() || phys_page->is_lazy_committed_page()) {
             dbgln_if(PAGE_FAULT_DEBUG, "NP(zero) fault in Region({})[{}] at {}", this, page_index_in_region, fault.vaddr());
-            return handle_zero_fault(page_index_in_region);
+            return handle_zero_fault(page_index_in_region, fault);
         }
         return handle_cow_fault(page_index_in_region);
     }
@@ -328,7 +426,7 @@ PageFaultResponse Region::handle_fault(PageFault const& fault)
     return PageFaultResponse::ShouldCrash;
 }
 
-PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region)
+PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region, PageFault const& fault)
 {
     VERIFY_INTERRUPTS_DISABLED();
     VERIFY(vmobject().is_anonymous());
@@ -349,6 +447,21 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region)
     if (current_thread != nullptr)
         current_thread->did_zero_fault();
 
+    if (m_huge_pages) {
+        // Fault in the whole huge page at once, if it's entirely ours and nothing in it has been touched yet.
+        if (auto huge_page_index = huge_page_containing(page_index_in_region); huge_page_index.has_value()) {
+            auto first_page_index_in_vmobject = translate_to_vmobject_page(huge_page_index.value());
+            if (static_cast<AnonymousVMObject&>(*m_vmobject).try_allocate_huge_page({}, first_page_index_in_vmobject)) {
+                dbgln_if(PAGE_FAULT_DEBUG, "      >> ALLOCATED HUGE {}", physical_page(huge_page_index.value())->paddr());
+                if (!remap_vmobject_page_range(first_page_index_in_vmobject, pages_per_huge_page)) {
+                    dmesgln("MM: handle_zero_fault was unable to allocate a page table to map huge page {}", physical_page(huge_page_index.value())->paddr());
+                    return PageFaultResponse::OutOfMemory;
+                }
+                return PageFaultResponse::Continue;
+            }
+        }
+    }
+
     if (page_slot->is_lazy_committed_page()) {
         VERIFY(m_vmobject->is_anonymous());
         page_slot = static_cast<AnonymousVMObject&>(*m_vmobject).allocate_committed_page({});
@@ -362,13 +475,39 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region)
         dbgln_if(PAGE_FAULT_DEBUG, "      >> ALLOCATED {}", page_slot->paddr());
     }
 
-    if (!remap_vmobject_page(page_index_in_vmobject)) {
+    // Pages that are written to in order will most likely go on being written to in order, so fault in the next few
+    // right away instead of taking a fault for each of them.
+    size_t faulted_page_count = 1;
+    if (fault.is_write() && page_index_in_region == m_next_sequential_zero_fault_page_index)
+        faulted_page_count += fault_around_zero_pages(page_index_in_region + 1);
+    m_next_sequential_zero_fault_page_index = page_index_in_region + faulted_page_count;
+
+    if (!remap_vmobject_page_range(page_index_in_vmobject, faulted_page_count)) {
         dmesgln("MM: handle_zero_fault was unable to allocate a page table to map {}", page_slot);
         return PageFaultResponse::OutOfMemory;
     }
     return PageFaultResponse::Continue;
 }
 
+size_t Region::fault_around_zero_pages(size_t page_index_in_region)
+{
+    static constexpr size_t fault_around_page_count = 15;
+
+    // Only pages that are committed already, so that this never has to go looking for memory.
+    auto& vmobject = static_cast<AnonymousVMObject&>(*m_vmobject);
+    if (vmobject.is_volatile())
+        return 0;
+    size_t count = 0;
+    while (count < fault_around_page_count && page_index_in_region + count < page_count()) {
+        auto& page_slot = physical_page_slot(page_index_in_region + count);
+        if (!page_slot || !page_slot->is_lazy_committed_page())
+            break;
+        page_slot = vmobject.allocate_committed_page({});
+        ++count;
+    }
+    return count;
+}
+
 PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
 {
     VERIFY_INTERRUPTS_DISABLED();
@@ -85,6 +85,11 @@ public:
     bool is_mmap() const { return m_mmap; }
     void set_mmap(bool mmap) { m_mmap = mmap; }
 
+    // Whether faulting in an unallocated page may allocate the whole huge page around it at once.
+    // Pages that happen to be physically contiguous are mapped with huge pages either way.
+    bool wants_huge_pages() const { return m_huge_pages; }
+    void set_wants_huge_pages(bool huge_pages) { m_huge_pages = huge_pages; }
+
     bool is_user() const { return !is_kernel(); }
     bool is_kernel() const { return vaddr().get() < 0x00800000 || vaddr().get() >= kernel_mapping_base; }
 
@@ -175,7 +180,7 @@ public:
         No,
         Yes,
     };
-    void unmap(ShouldDeallocateVirtualRange = ShouldDeallocateVirtualRange::Yes);
+    void unmap(ShouldDeallocateVirtualRange = ShouldDeallocateVirtualRange::Yes, ShouldFlushTLB = ShouldFlushTLB::Yes);
 
     void remap();
 
@@ -187,6 +192,8 @@ private:
 
     bool remap_vmobject_page(size_t page_index, bool with_flush = true);
     bool do_remap_vmobject_page(size_t page_index, bool with_flush = true);
+    bool remap_vmobject_page_range(size_t page_index, size_t page_count);
+    bool do_remap_vmobject_page_range(size_t page_index, size_t page_count);
 
     void set_access_bit(Access access, bool b)
     {
@@ -198,13 +205,20 @@ private:
 
     PageFaultResponse handle_cow_fault(size_t page_index);
     PageFaultResponse handle_inode_fault(size_t page_index);
-    PageFaultResponse handle_zero_fault(size_t page_index);
+    PageFaultResponse handle_zero_fault(size_t page_index, PageFault const&);
+    size_t fault_around_zero_pages(size_t page_index);
 
     bool map_individual_page_impl(size_t page_index);
+    void map_huge_page_impl(size_t page_index);
+    size_t map_pages_impl(size_t page_index, size_t page_count);
+    Optional<size_t> huge_page_containing(size_t page_index) const;
+    bool can_map_huge_page(size_t page_index) const;
 
     RefPtr<PageDirectory> m_page_directory;
     VirtualRange m_range;
     size_t m_offset_in_vmobject { 0 };
+    // Where the next zero fault would be if the pages are being touched in order.
+    size_t m_next_sequential_zero_fault_page_index { 0 };
     NonnullRefPtr<VMObject> m_vmobject;
     OwnPtr<KString> m_name;
     u8 m_access { Region::None };
@@ -213,6 +227,7 @@ private:
     bool m_stack : 1 { false };
     bool m_mmap : 1 { false };
     bool m_syscall_region : 1 { false };
+    bool m_huge_pages : 1 { false };
     IntrusiveListNode<Region> m_memory_manager_list_node;
     IntrusiveListNode<Region> m_vmobject_list_node;
 
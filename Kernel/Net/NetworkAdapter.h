@@ -14,6 +14,7 @@
 #include <AK/WeakPtr.h>
 #include <AK/Weakable.h>
 #include <Kernel/Bus/PCI/Definitions.h>
+#include <Kernel/Heap/SlabAllocator.h>
 #include <Kernel/KBuffer.h>
 #include <Kernel/Net/ARP.h>
 #include <Kernel/Net/EthernetFrameHeader.h>
@@ -28,6 +29,8 @@ class NetworkAdapter;
 using NetworkByteBuffer = AK::Detail::ByteBuffer<1500>;
 
 struct PacketWithTimestamp : public RefCounted<PacketWithTimestamp> {
+    MAKE_SLAB_ALLOCATED(PacketWithTimestamp)
+public:
     PacketWithTimestamp(NonnullOwnPtr<KBuffer> buffer, Time timestamp)
         : buffer(move(buffer))
         , timestamp(timestamp)
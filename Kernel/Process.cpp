@@ -779,6 +779,28 @@ void Process::set_tty(TTY* tty)
     m_tty = tty;
 }
 
+Process::IOStatistics Process::io_statistics() const
+{
+    ScopedSpinLock lock(m_io_statistics_lock);
+    return m_io_statistics;
+}
+
+void Process::account_storage_read(size_t bytes, Time const& wait_time)
+{
+    ScopedSpinLock lock(m_io_statistics_lock);
+    ++m_io_statistics.read_requests;
+    m_io_statistics.read_bytes += bytes;
+    m_io_statistics.wait_time += wait_time;
+}
+
+void Process::account_storage_write(size_t bytes, Time const& wait_time)
+{
+    ScopedSpinLock lock(m_io_statistics_lock);
+    ++m_io_statistics.write_requests;
+    m_io_statistics.write_bytes += bytes;
+    m_io_statistics.wait_time += wait_time;
+}
+
 KResult Process::start_tracing_from(ProcessID tracer)
 {
     auto thread_tracer = ThreadTracer::create(tracer);
@@ -80,7 +80,6 @@ enum class VeilState {
     Locked,
 };
 
-typedef HashMap<FlatPtr, RefPtr<FutexQueue>> FutexQueues;
 
 struct LoadResult;
 
@@ -263,6 +262,8 @@ public:
     KResultOr<FlatPtr> sys$create_inode_watcher(u32 flags);
     KResultOr<FlatPtr> sys$inode_watcher_add_watch(Userspace<const Syscall::SC_inode_watcher_add_watch_params*> user_params);
     KResultOr<FlatPtr> sys$inode_watcher_remove_watch(int fd, int wd);
+    KResultOr<FlatPtr> sys$io_ring_create(u32 entries);
+    KResultOr<FlatPtr> sys$io_ring_enter(int fd, u32 to_submit, u32 min_complete);
     KResultOr<FlatPtr> sys$dbgputch(u8);
     KResultOr<FlatPtr> sys$dbgputstr(Userspace<const char*>, size_t);
     KResultOr<FlatPtr> sys$dump_backtrace();
@@ -321,6 +322,7 @@ public:
     KResultOr<FlatPtr> sys$ptsname(int fd, Userspace<char*>, size_t);
     KResultOr<FlatPtr> sys$fork(RegisterState&);
     KResultOr<FlatPtr> sys$execve(Userspace<const Syscall::SC_execve_params*>);
+    KResultOr<FlatPtr> sys$posix_spawn(Userspace<const Syscall::SC_posix_spawn_params*>);
     KResultOr<FlatPtr> sys$dup2(int old_fd, int new_fd);
     KResultOr<FlatPtr> sys$sigaction(int signum, Userspace<const sigaction*> act, Userspace<sigaction*> old_act);
     KResultOr<FlatPtr> sys$sigprocmask(int how, Userspace<const sigset_t*> set, Userspace<sigset_t*> old_set);
@@ -366,6 +368,7 @@ public:
     KResultOr<FlatPtr> sys$getsockname(Userspace<const Syscall::SC_getsockname_params*>);
     KResultOr<FlatPtr> sys$getpeername(Userspace<const Syscall::SC_getpeername_params*>);
     KResultOr<FlatPtr> sys$socketpair(Userspace<const Syscall::SC_socketpair_params*>);
+    KResultOr<FlatPtr> sys$splice(Userspace<Syscall::SC_splice_params const*>);
     KResultOr<FlatPtr> sys$sched_setparam(pid_t pid, Userspace<const struct sched_param*>);
     KResultOr<FlatPtr> sys$sched_getparam(pid_t pid, Userspace<struct sched_param*>);
     KResultOr<FlatPtr> sys$create_thread(void* (*)(void*), Userspace<const Syscall::SC_create_thread_params*>);
@@ -425,6 +428,18 @@ public:
     u32 m_ticks_in_user_for_dead_children { 0 };
     u32 m_ticks_in_kernel_for_dead_children { 0 };
 
+    // What the process has read from and written to storage devices, and how long it waited for it.
+    struct IOStatistics {
+        u64 read_requests { 0 };
+        u64 read_bytes { 0 };
+        u64 write_requests { 0 };
+        u64 write_bytes { 0 };
+        Time wait_time;
+    };
+    IOStatistics io_statistics() const;
+    void account_storage_read(size_t bytes, Time const& wait_time);
+    void account_storage_write(size_t bytes, Time const& wait_time);
+
     Custody& current_directory();
     Custody* executable() { return m_executable.ptr(); }
     const Custody* executable() const { return m_executable.ptr(); }
@@ -541,6 +556,7 @@ private:
 
     KResultOr<NonnullOwnPtr<KString>> get_syscall_path_argument(Userspace<const char*> user_path, size_t path_length) const;
     KResultOr<NonnullOwnPtr<KString>> get_syscall_path_argument(const Syscall::StringArgument&) const;
+    static bool copy_string_list_from_user(const Syscall::StringListArgument&, Vector<String>&);
 
     bool has_tracee_thread(ProcessID tracer_pid);
 
@@ -564,6 +580,7 @@ public:
     KResult procfs_get_binary_link(KBufferBuilder& builder) const;
     KResult procfs_get_root_link(KBufferBuilder& builder) const;
     KResult procfs_get_current_work_directory_link(KBufferBuilder& builder) const;
+    KResult procfs_get_io_stats(KBufferBuilder& builder) const;
     mode_t binary_link_required_mode() const;
     KResultOr<size_t> procfs_get_thread_stack(ThreadID thread_id, KBufferBuilder& builder) const;
     KResult traverse_stacks_directory(unsigned fsid, Function<bool(FileSystem::DirectoryEntryView const&)> callback) const;
@@ -754,8 +771,8 @@ private:
 
     OwnPtr<PerformanceEventBuffer> m_perf_event_buffer;
 
-    FutexQueues m_futex_queues;
-    SpinLock<u8> m_futex_lock;
+    IOStatistics m_io_statistics;
+    mutable SpinLock<u8> m_io_statistics_lock;
 
     // This member is used in the implementation of ptrace's PT_TRACEME flag.
     // If it is set to true, the process will stop at the next execve syscall
@@ -32,6 +32,7 @@ enum class MainProcessProperty {
     PerformanceEvents = 6,
     VirtualMemoryStats = 7,
     RootLink = 8,
+    IOStatistics = 9,
 };
 
 enum class ProcessSubDirectory {
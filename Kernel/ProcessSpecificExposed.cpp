@@ -64,6 +64,7 @@ KResult Process::traverse_as_directory(unsigned fsid, Function<bool(FileSystem::
     callback({ "perf_events", { fsid, SegmentedProcFSIndex::build_segmented_index_for_main_property_in_pid_directory(pid(), SegmentedProcFSIndex::MainProcessProperty::PerformanceEvents) }, 0 });
     callback({ "vm", { fsid, SegmentedProcFSIndex::build_segmented_index_for_main_property_in_pid_directory(pid(), SegmentedProcFSIndex::MainProcessProperty::VirtualMemoryStats) }, 0 });
     callback({ "root", { fsid, SegmentedProcFSIndex::build_segmented_index_for_main_property_in_pid_directory(pid(), SegmentedProcFSIndex::MainProcessProperty::RootLink) }, 0 });
+    callback({ "io", { fsid, SegmentedProcFSIndex::build_segmented_index_for_main_property_in_pid_directory(pid(), SegmentedProcFSIndex::MainProcessProperty::IOStatistics) }, 0 });
     return KSuccess;
 }
 
@@ -277,6 +278,19 @@ KResult Process::procfs_get_virtual_memory_stats(KBufferBuilder& builder) const
     return KSuccess;
 }
 
+KResult Process::procfs_get_io_stats(KBufferBuilder& builder) const
+{
+    auto statistics = io_statistics();
+    JsonObjectSerializer obj { builder };
+    obj.add("read_requests", statistics.read_requests);
+    obj.add("read_bytes", statistics.read_bytes);
+    obj.add("write_requests", statistics.write_requests);
+    obj.add("write_bytes", statistics.write_bytes);
+    obj.add("wait_time_us", statistics.wait_time.to_microseconds());
+    obj.finish();
+    return KSuccess;
+}
+
 KResult Process::procfs_get_current_work_directory_link(KBufferBuilder& builder) const
 {
     builder.append_bytes(const_cast<Process&>(*this).current_directory().absolute_path().bytes());
@@ -10,7 +10,6 @@
 #include <AK/Atomic.h>
 #include <Kernel/Locking/SpinLock.h>
 #include <Kernel/Memory/MemoryManager.h>
-#include <Kernel/Memory/ScatterGatherList.h>
 #include <Kernel/Memory/TypedMapping.h>
 #include <Kernel/Storage/AHCIPort.h>
 #include <Kernel/Storage/ATA.h>
@@ -44,12 +43,6 @@ AHCIPort::AHCIPort(const AHCIPortHandler& handler, volatile AHCI::PortRegisters&
     dbgln_if(AHCI_DEBUG, "AHCI Port {}: Command list page at {}", representative_port_index(), m_command_list_page->paddr());
     dbgln_if(AHCI_DEBUG, "AHCI Port {}: FIS receive page at {}", representative_port_index(), m_command_list_page->paddr());
 
-    for (size_t index = 0; index < 1; index++) {
-        m_dma_buffers.append(MM.allocate_supervisor_physical_page().release_nonnull());
-    }
-    for (size_t index = 0; index < 1; index++) {
-        m_command_table_pages.append(MM.allocate_supervisor_physical_page().release_nonnull());
-    }
     m_command_list_region = MM.allocate_kernel_region(m_command_list_page->paddr(), PAGE_SIZE, "AHCI Port Command List", Memory::Region::Access::ReadWrite, Memory::Region::Cacheable::No);
     dbgln_if(AHCI_DEBUG, "AHCI Port {}: Command list region at {}", representative_port_index(), m_command_list_region->vaddr());
 }
@@ -84,33 +77,14 @@ void AHCIPort::handle_interrupt()
         });
         return;
     }
-    if (m_interrupt_status.is_set(AHCI::PortInterruptFlag::DHR) || m_interrupt_status.is_set(AHCI::PortInterruptFlag::PS)) {
+    // Queued commands are completed with a Set Device Bits FIS, all others with a Device to Host Register FIS.
+    if (m_interrupt_status.is_set(AHCI::PortInterruptFlag::DHR) || m_interrupt_status.is_set(AHCI::PortInterruptFlag::PS) || m_interrupt_status.is_set(AHCI::PortInterruptFlag::SDB)) {
         m_wait_for_completion = false;
 
         // Now schedule reading/writing the buffer as soon as we leave the irq handler.
         // This is important so that we can safely access the buffers, which could
         // trigger page faults
-        if (!m_current_request) {
-            dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request handled, probably identify request", representative_port_index());
-        } else {
-            g_io_work->queue([this]() {
-                dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request handled", representative_port_index());
-                MutexLocker locker(m_lock);
-                VERIFY(m_current_request);
-                VERIFY(m_current_scatter_list);
-                if (m_current_request->request_type() == AsyncBlockDeviceRequest::Read) {
-                    if (!m_current_request->write_to_buffer(m_current_request->buffer(), m_current_scatter_list->dma_region().as_ptr(), m_connected_device->block_size() * m_current_request->block_count())) {
-                        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure, memory fault occurred when reading in data.", representative_port_index());
-                        m_current_scatter_list = nullptr;
-                        complete_current_request(AsyncDeviceRequest::MemoryFault);
-                        return;
-                    }
-                }
-                m_current_scatter_list = nullptr;
-                dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request success", representative_port_index());
-                complete_current_request(AsyncDeviceRequest::Success);
-            });
-        }
+        queue_completion_check();
     }
 
     m_interrupt_status.clear();
@@ -130,6 +104,8 @@ void AHCIPort::recover_from_fatal_error()
     stop_command_list_processing();
     stop_fis_receiving();
     m_interrupt_enable.clear();
+    lock.unlock();
+    fail_all_requests();
 }
 
 void AHCIPort::eject()
@@ -147,8 +123,11 @@ void AHCIPort::eject()
 
     auto unused_command_header = try_to_find_unused_command_header();
     VERIFY(unused_command_header.has_value());
+    auto& command_slot = m_command_slots[unused_command_header.value()];
+    if (!ensure_command_slot_memory(command_slot))
+        return;
     auto* command_list_entries = (volatile AHCI::CommandHeader*)m_command_list_region->vaddr().as_ptr();
-    command_list_entries[unused_command_header.value()].ctba = m_command_table_pages[unused_command_header.value()].paddr().get();
+    command_list_entries[unused_command_header.value()].ctba = command_slot.command_table_page->paddr().get();
     command_list_entries[unused_command_header.value()].ctbau = 0;
     command_list_entries[unused_command_header.value()].prdbc = 0;
     command_list_entries[unused_command_header.value()].prdtl = 0;
@@ -159,8 +138,7 @@ void AHCIPort::eject()
     // handshake error bit in PxSERR register if CFL is incorrect.
     command_list_entries[unused_command_header.value()].attributes = (size_t)FIS::DwordCount::RegisterHostToDevice | AHCI::CommandHeaderAttributes::P | AHCI::CommandHeaderAttributes::C | AHCI::CommandHeaderAttributes::A;
 
-    auto command_table_region = MM.allocate_kernel_region(m_command_table_pages[unused_command_header.value()].paddr().page_base(), Memory::page_round_up(sizeof(AHCI::CommandTable)), "AHCI Command Table", Memory::Region::Access::ReadWrite, Memory::Region::Cacheable::No);
-    auto& command_table = *(volatile AHCI::CommandTable*)command_table_region->vaddr().as_ptr();
+    auto& command_table = *(volatile AHCI::CommandTable*)command_slot.command_table_region->vaddr().as_ptr();
     memset(const_cast<u8*>(command_table.command_fis), 0, 64);
     auto& fis = *(volatile FIS::HostToDevice::Register*)command_table.command_fis;
     fis.header.fis_type = (u8)FIS::Type::RegisterHostToDevice;
@@ -212,6 +190,13 @@ bool AHCIPort::reset()
 
     dbgln_if(AHCI_DEBUG, "AHCI Port {}: Resetting", representative_port_index());
 
+    // Whatever the device was doing is lost now.
+    if (m_busy_command_slots != 0 || !m_pending_requests.is_empty()) {
+        lock.unlock();
+        fail_all_requests();
+        lock.lock();
+    }
+
     if (m_disabled_by_firmware) {
         dmesgln("AHCI Port {}: Disabled by firmware ", representative_port_index());
         return false;
@@ -289,6 +274,14 @@ bool AHCIPort::initialize(ScopedSpinLock<SpinLock<u8>>& main_lock)
             m_port_registers.cmd = m_port_registers.cmd | (1 << 24);
         }
 
+        // Word 76 says whether the device supports native command queuing, and word 75 how many commands it can queue.
+        m_native_command_queuing_enabled = m_parent_handler->hba_capabilities().native_command_queuing_supported && (identify_block->serial_ata_capabilities & (1 << 8)) && !is_atapi_attached();
+        if (m_native_command_queuing_enabled)
+            m_command_slot_count = min(m_parent_handler->hba_capabilities().max_command_list_entries_count, (identify_block->queue_depth & 0x1f) + 1u);
+        else
+            m_command_slot_count = 1;
+        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Native command queuing {}, {} command slots", representative_port_index(), m_native_command_queuing_enabled ? "enabled" : "disabled", m_command_slot_count);
+
         dmesgln("AHCI Port {}: Device found, Capacity={}, Bytes per logical sector={}, Bytes per physical sector={}", representative_port_index(), max_addressable_sector * logical_sector_size, logical_sector_size, physical_sector_size);
 
         // FIXME: We don't support ATAPI devices yet, so for now we don't "create" them
@@ -419,67 +412,198 @@ void AHCIPort::set_sleep_state() const
     m_port_registers.cmd = (m_port_registers.cmd & 0x0ffffff) | (0b1000 << 28);
 }
 
-size_t AHCIPort::calculate_descriptors_count(size_t block_count) const
+bool AHCIPort::ensure_command_slot_memory(CommandSlot& slot)
 {
-    VERIFY(m_connected_device);
-    size_t needed_dma_regions_count = Memory::page_round_up((block_count * m_connected_device->block_size())) / PAGE_SIZE;
-    VERIFY(needed_dma_regions_count <= m_dma_buffers.size());
-    return needed_dma_regions_count;
+    VERIFY(m_lock.is_locked());
+    if (slot.dma_region)
+        return true;
+
+    auto command_table_page = MM.allocate_supervisor_physical_page();
+    if (!command_table_page)
+        return false;
+    NonnullRefPtrVector<Memory::PhysicalPage> dma_pages;
+    for (size_t index = 0; index < max_dma_pages_per_command; index++) {
+        auto dma_page = MM.allocate_supervisor_physical_page();
+        if (!dma_page)
+            return false;
+        dma_pages.append(dma_page.release_nonnull());
+    }
+    auto command_table_region = MM.allocate_kernel_region(command_table_page->paddr().page_base(), Memory::page_round_up(sizeof(AHCI::CommandTable)), "AHCI Command Table", Memory::Region::Access::ReadWrite, Memory::Region::Cacheable::No);
+    auto dma_vmobject = Memory::AnonymousVMObject::try_create_with_physical_pages(dma_pages.span());
+    if (!command_table_region || !dma_vmobject)
+        return false;
+    auto dma_region = MM.allocate_kernel_region_with_vmobject(*dma_vmobject, max_transfer_size(), "AHCI DMA Buffer", Memory::Region::Access::ReadWrite);
+    if (!dma_region)
+        return false;
+
+    slot.command_table_page = move(command_table_page);
+    slot.command_table_region = move(command_table_region);
+    slot.dma_pages = move(dma_pages);
+    slot.dma_region = move(dma_region);
+    return true;
 }
 
-Optional<AsyncDeviceRequest::RequestResult> AHCIPort::prepare_and_set_scatter_list(AsyncBlockDeviceRequest& request)
+Optional<u8> AHCIPort::try_to_find_free_command_slot() const
 {
     VERIFY(m_lock.is_locked());
-    VERIFY(request.block_count() > 0);
-
-    NonnullRefPtrVector<Memory::PhysicalPage> allocated_dma_regions;
-    for (size_t index = 0; index < calculate_descriptors_count(request.block_count()); index++) {
-        allocated_dma_regions.append(m_dma_buffers.at(index));
+    for (size_t index = 0; index < m_command_slot_count; index++) {
+        if (!(m_busy_command_slots & (1u << index)))
+            return index;
     }
+    return {};
+}
 
-    m_current_scatter_list = Memory::ScatterGatherList::try_create(request, allocated_dma_regions.span(), m_connected_device->block_size());
-    if (!m_current_scatter_list)
-        return AsyncDeviceRequest::Failure;
+bool AHCIPort::add_request_to_command(CommandSlot& slot, AsyncBlockDeviceRequest& request)
+{
+    VERIFY(m_lock.is_locked());
+    size_t size = request.block_count() * m_connected_device->block_size();
+    size_t page_count = Memory::page_round_up(size) / PAGE_SIZE;
+    VERIFY(slot.dma_page_count + page_count <= max_dma_pages_per_command);
+
+    // Every request starts on a page of its own, so that each one can be copied in and out in one go.
     if (request.request_type() == AsyncBlockDeviceRequest::Write) {
-        if (!request.read_from_buffer(request.buffer(), m_current_scatter_list->dma_region().as_ptr(), m_connected_device->block_size() * request.block_count())) {
-            return AsyncDeviceRequest::MemoryFault;
+        if (!request.read_from_buffer(request.buffer(), slot.dma_region->vaddr().offset(slot.dma_page_count * PAGE_SIZE).as_ptr(), size)) {
+            dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure, memory fault occurred when writing out data.", representative_port_index());
+            request.complete(AsyncDeviceRequest::MemoryFault);
+            return false;
         }
     }
-    return {};
+    slot.requests.append(request);
+    slot.dma_page_count += page_count;
+    return true;
+}
+
+void AHCIPort::merge_adjacent_requests(CommandSlot& slot)
+{
+    VERIFY(m_lock.is_locked());
+    VERIFY(!slot.requests.is_empty());
+    auto request_type = slot.requests.first().request_type();
+    u64 next_block_index = slot.requests.last().block_index() + slot.requests.last().block_count();
+
+    for (size_t index = 0; index < m_pending_requests.size();) {
+        auto& request = m_pending_requests[index];
+        size_t page_count = Memory::page_round_up(request.block_count() * m_connected_device->block_size()) / PAGE_SIZE;
+        if (request.request_type() != request_type || request.block_index() != next_block_index || slot.dma_page_count + page_count > max_dma_pages_per_command) {
+            index++;
+            continue;
+        }
+        auto merged_request = m_pending_requests.take(index);
+        if (!add_request_to_command(slot, merged_request)) {
+            // The faulting request is done with, but the ones after it can't be merged anymore.
+            return;
+        }
+        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Merged request at block {} into the command", representative_port_index(), merged_request->block_index());
+        next_block_index += merged_request->block_count();
+        // Something that comes after the merged request might be further up the queue.
+        index = 0;
+    }
 }
 
 void AHCIPort::start_request(AsyncBlockDeviceRequest& request)
 {
     MutexLocker locker(m_lock);
     dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request start", representative_port_index());
-    VERIFY(!m_current_request);
-    VERIFY(!m_current_scatter_list);
+    VERIFY(request.block_count() > 0);
+    VERIFY(request.block_count() * m_connected_device->block_size() <= max_transfer_size());
+    m_pending_requests.append(request);
+    issue_pending_requests();
+}
 
-    m_current_request = request;
+void AHCIPort::issue_pending_requests()
+{
+    VERIFY(m_lock.is_locked());
+    while (!m_pending_requests.is_empty()) {
+        auto slot_index = try_to_find_free_command_slot();
+        if (!slot_index.has_value())
+            return;
+        auto& slot = m_command_slots[slot_index.value()];
+        VERIFY(slot.requests.is_empty());
+        if (!ensure_command_slot_memory(slot)) {
+            dbgln_if(AHCI_DEBUG, "AHCI Port {}: Could not allocate memory for command slot {}", representative_port_index(), slot_index.value());
+            // Without anything in flight, nothing would ever retry this.
+            if (m_busy_command_slots == 0) {
+                auto requests = move(m_pending_requests);
+                for (auto& request : requests)
+                    request.complete(AsyncDeviceRequest::Failure);
+            }
+            return;
+        }
 
-    auto result = prepare_and_set_scatter_list(request);
-    if (result.has_value()) {
-        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure.", representative_port_index());
-        locker.unlock();
-        complete_current_request(result.value());
-        return;
+        slot.dma_page_count = 0;
+        auto request = m_pending_requests.take_first();
+        if (!add_request_to_command(slot, request))
+            continue;
+        merge_adjacent_requests(slot);
+
+        if (!access_device(slot_index.value())) {
+            dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure.", representative_port_index());
+            complete_command(slot_index.value(), AsyncDeviceRequest::Failure);
+        }
     }
+}
 
-    auto success = access_device(request.request_type(), request.block_index(), request.block_count());
-    if (!success) {
-        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure.", representative_port_index());
-        locker.unlock();
-        complete_current_request(AsyncDeviceRequest::Failure);
+void AHCIPort::queue_completion_check()
+{
+    if (m_completion_check_queued.exchange(true))
         return;
+    g_io_work->queue([this]() {
+        // Anything that completes from here on needs another look.
+        m_completion_check_queued.store(false);
+        complete_finished_commands();
+    });
+}
+
+void AHCIPort::complete_finished_commands()
+{
+    MutexLocker locker(m_lock);
+    u32 finished_command_slots;
+    {
+        ScopedSpinLock lock(m_hard_lock);
+        // A command is done once the HBA has cleared its bit in PxCI, and for a queued command, the device its bit in PxSACT.
+        finished_command_slots = m_busy_command_slots & ~(m_port_registers.ci | m_port_registers.sact);
+    }
+    for (u8 slot_index = 0; slot_index < m_command_slot_count; slot_index++) {
+        if (finished_command_slots & (1u << slot_index)) {
+            dbgln_if(AHCI_DEBUG, "AHCI Port {}: Command in slot {} finished", representative_port_index(), slot_index);
+            complete_command(slot_index, AsyncDeviceRequest::Success);
+        }
+    }
+    issue_pending_requests();
+}
+
+void AHCIPort::complete_command(u8 slot_index, AsyncDeviceRequest::RequestResult result)
+{
+    VERIFY(m_lock.is_locked());
+    auto& slot = m_command_slots[slot_index];
+    m_busy_command_slots &= ~(1u << slot_index);
+
+    auto requests = move(slot.requests);
+    slot.dma_page_count = 0;
+    size_t offset = 0;
+    for (auto& request : requests) {
+        size_t size = request.block_count() * m_connected_device->block_size();
+        auto request_result = result;
+        if (request_result == AsyncDeviceRequest::Success && request.request_type() == AsyncBlockDeviceRequest::Read) {
+            if (!request.write_to_buffer(request.buffer(), slot.dma_region->vaddr().offset(offset).as_ptr(), size)) {
+                dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure, memory fault occurred when reading in data.", representative_port_index());
+                request_result = AsyncDeviceRequest::MemoryFault;
+            }
+        }
+        offset += Memory::page_round_up(size);
+        request.complete(request_result);
     }
 }
 
-void AHCIPort::complete_current_request(AsyncDeviceRequest::RequestResult result)
+void AHCIPort::fail_all_requests()
 {
-    VERIFY(m_current_request);
-    auto current_request = m_current_request;
-    m_current_request.clear();
-    current_request->complete(result);
+    MutexLocker locker(m_lock);
+    for (u8 slot_index = 0; slot_index < m_command_slot_count; slot_index++) {
+        if (m_busy_command_slots & (1u << slot_index))
+            complete_command(slot_index, AsyncDeviceRequest::Failure);
+    }
+    auto requests = move(m_pending_requests);
+    for (auto& request : requests)
+        request.complete(AsyncDeviceRequest::Failure);
 }
 
 bool AHCIPort::spin_until_ready() const
@@ -498,59 +622,64 @@ bool AHCIPort::spin_until_ready() const
     return true;
 }
 
-bool AHCIPort::access_device(AsyncBlockDeviceRequest::RequestType direction, u64 lba, u8 block_count)
+bool AHCIPort::access_device(u8 slot_index)
 {
     VERIFY(m_connected_device);
     VERIFY(is_operable());
     VERIFY(m_lock.is_locked());
-    VERIFY(m_current_scatter_list);
+    auto& slot = m_command_slots[slot_index];
+    VERIFY(!slot.requests.is_empty());
     ScopedSpinLock lock(m_hard_lock);
 
-    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Do a {}, lba {}, block count {}", representative_port_index(), direction == AsyncBlockDeviceRequest::RequestType::Write ? "write" : "read", lba, block_count);
-    if (!spin_until_ready())
+    auto direction = slot.requests.first().request_type();
+    u64 lba = slot.requests.first().block_index();
+    size_t block_count = 0;
+    for (auto& request : slot.requests)
+        block_count += request.block_count();
+
+    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Do a {}, lba {}, block count {} in slot {}", representative_port_index(), direction == AsyncBlockDeviceRequest::RequestType::Write ? "write" : "read", lba, block_count, slot_index);
+
+    // Queued commands may be sent while others are in flight, but anything else has to wait for the device to be idle.
+    if (m_busy_command_slots == 0 && !spin_until_ready())
         return false;
 
-    auto unused_command_header = try_to_find_unused_command_header();
-    VERIFY(unused_command_header.has_value());
+    auto& command_table = *(volatile AHCI::CommandTable*)slot.command_table_region->vaddr().as_ptr();
+    memset(const_cast<u8*>(command_table.command_fis), 0, 64);
+
+    // One descriptor for each page of each request, with the last one of each request covering only what it needs.
+    size_t scatter_entry_index = 0;
+    size_t dma_page_index = 0;
+    for (auto& request : slot.requests) {
+        size_t data_transfer_count = request.block_count() * m_connected_device->block_size();
+        while (data_transfer_count != 0) {
+            auto& dma_page = slot.dma_pages[dma_page_index++];
+            size_t byte_count = min(data_transfer_count, PAGE_SIZE);
+            dbgln_if(AHCI_DEBUG, "AHCI Port {}: Add a transfer scatter entry @ {}", representative_port_index(), dma_page.paddr());
+            command_table.descriptors[scatter_entry_index].base_high = 0;
+            command_table.descriptors[scatter_entry_index].base_low = dma_page.paddr().get();
+            command_table.descriptors[scatter_entry_index].reserved = 0;
+            command_table.descriptors[scatter_entry_index].byte_count = byte_count - 1;
+            data_transfer_count -= byte_count;
+            scatter_entry_index++;
+        }
+    }
+    VERIFY(scatter_entry_index > 0);
+    command_table.descriptors[scatter_entry_index - 1].byte_count = command_table.descriptors[scatter_entry_index - 1].byte_count | (1u << 31);
+
     auto* command_list_entries = (volatile AHCI::CommandHeader*)m_command_list_region->vaddr().as_ptr();
-    command_list_entries[unused_command_header.value()].ctba = m_command_table_pages[unused_command_header.value()].paddr().get();
-    command_list_entries[unused_command_header.value()].ctbau = 0;
-    command_list_entries[unused_command_header.value()].prdbc = 0;
-    command_list_entries[unused_command_header.value()].prdtl = m_current_scatter_list->scatters_count();
+    command_list_entries[slot_index].ctba = slot.command_table_page->paddr().get();
+    command_list_entries[slot_index].ctbau = 0;
+    command_list_entries[slot_index].prdbc = 0;
+    command_list_entries[slot_index].prdtl = scatter_entry_index;
 
     // Note: we must set the correct Dword count in this register. Real hardware
     // AHCI controllers do care about this field! QEMU doesn't care if we don't
     // set the correct CFL field in this register, real hardware will set an
     // handshake error bit in PxSERR register if CFL is incorrect.
-    command_list_entries[unused_command_header.value()].attributes = (size_t)FIS::DwordCount::RegisterHostToDevice | AHCI::CommandHeaderAttributes::P | (is_atapi_attached() ? AHCI::CommandHeaderAttributes::A : 0) | (direction == AsyncBlockDeviceRequest::RequestType::Write ? AHCI::CommandHeaderAttributes::W : 0);
-
-    dbgln_if(AHCI_DEBUG, "AHCI Port {}: CLE: ctba={:#08x}, ctbau={:#08x}, prdbc={:#08x}, prdtl={:#04x}, attributes={:#04x}", representative_port_index(), (u32)command_list_entries[unused_command_header.value()].ctba, (u32)command_list_entries[unused_command_header.value()].ctbau, (u32)command_list_entries[unused_command_header.value()].prdbc, (u16)command_list_entries[unused_command_header.value()].prdtl, (u16)command_list_entries[unused_command_header.value()].attributes);
-
-    auto command_table_region = MM.allocate_kernel_region(m_command_table_pages[unused_command_header.value()].paddr().page_base(), Memory::page_round_up(sizeof(AHCI::CommandTable)), "AHCI Command Table", Memory::Region::Access::ReadWrite, Memory::Region::Cacheable::No);
-    auto& command_table = *(volatile AHCI::CommandTable*)command_table_region->vaddr().as_ptr();
+    // The prefetch bit must not be set for queued commands.
+    command_list_entries[slot_index].attributes = (size_t)FIS::DwordCount::RegisterHostToDevice | (m_native_command_queuing_enabled ? 0 : AHCI::CommandHeaderAttributes::P) | (is_atapi_attached() ? AHCI::CommandHeaderAttributes::A : 0) | (direction == AsyncBlockDeviceRequest::RequestType::Write ? AHCI::CommandHeaderAttributes::W : 0);
 
-    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Allocated command table at {}", representative_port_index(), command_table_region->vaddr());
-
-    memset(const_cast<u8*>(command_table.command_fis), 0, 64);
-
-    size_t scatter_entry_index = 0;
-    size_t data_transfer_count = (block_count * m_connected_device->block_size());
-    for (auto scatter_page : m_current_scatter_list->vmobject().physical_pages()) {
-        VERIFY(data_transfer_count != 0);
-        VERIFY(scatter_page);
-        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Add a transfer scatter entry @ {}", representative_port_index(), scatter_page->paddr());
-        command_table.descriptors[scatter_entry_index].base_high = 0;
-        command_table.descriptors[scatter_entry_index].base_low = scatter_page->paddr().get();
-        if (data_transfer_count <= PAGE_SIZE) {
-            command_table.descriptors[scatter_entry_index].byte_count = data_transfer_count - 1;
-            data_transfer_count = 0;
-        } else {
-            command_table.descriptors[scatter_entry_index].byte_count = PAGE_SIZE - 1;
-            data_transfer_count -= PAGE_SIZE;
-        }
-        scatter_entry_index++;
-    }
-    command_table.descriptors[scatter_entry_index].byte_count = (PAGE_SIZE - 1) | (1 << 31);
+    dbgln_if(AHCI_DEBUG, "AHCI Port {}: CLE: ctba={:#08x}, ctbau={:#08x}, prdbc={:#08x}, prdtl={:#04x}, attributes={:#04x}", representative_port_index(), (u32)command_list_entries[slot_index].ctba, (u32)command_list_entries[slot_index].ctbau, (u32)command_list_entries[slot_index].prdbc, (u16)command_list_entries[slot_index].prdtl, (u16)command_list_entries[slot_index].attributes);
 
     memset(const_cast<u8*>(command_table.atapi_command), 0, 32);
 
@@ -559,11 +688,17 @@ bool AHCIPort::access_device(AsyncBlockDeviceRequest::RequestType direction, u64
     if (is_atapi_attached()) {
         fis.command = ATA_CMD_PACKET;
         TODO();
+    }
+
+    if (m_native_command_queuing_enabled) {
+        // READ/WRITE FPDMA QUEUED take the sector count in the features register, and the tag in the count register.
+        fis.command = direction == AsyncBlockDeviceRequest::RequestType::Write ? ATA_CMD_WRITE_FPDMA_QUEUED : ATA_CMD_READ_FPDMA_QUEUED;
+        fis.features_low = block_count & 0xff;
+        fis.features_high = (block_count >> 8) & 0xff;
+        fis.count = slot_index << 3;
     } else {
-        if (direction == AsyncBlockDeviceRequest::RequestType::Write)
-            fis.command = ATA_CMD_WRITE_DMA_EXT;
-        else
-            fis.command = ATA_CMD_READ_DMA_EXT;
+        fis.command = direction == AsyncBlockDeviceRequest::RequestType::Write ? ATA_CMD_WRITE_DMA_EXT : ATA_CMD_READ_DMA_EXT;
+        fis.count = block_count;
     }
 
     full_memory_barrier();
@@ -577,17 +712,14 @@ bool AHCIPort::access_device(AsyncBlockDeviceRequest::RequestType direction, u64
     fis.lba_low[0] = lba & 0xff;
     fis.lba_low[1] = (lba >> 8) & 0xff;
     fis.lba_low[2] = (lba >> 16) & 0xff;
-    fis.count = (block_count);
-
-    // The below loop waits until the port is no longer busy before issuing a new command
-    if (!spin_until_ready())
-        return false;
 
     full_memory_barrier();
-    mark_command_header_ready_to_process(unused_command_header.value());
+    m_busy_command_slots |= 1u << slot_index;
+    if (m_native_command_queuing_enabled)
+        m_port_registers.sact = 1u << slot_index;
+    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Marking command header at index {} as ready to process.", representative_port_index(), slot_index);
+    m_port_registers.ci = 1u << slot_index;
     full_memory_barrier();
-
-    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Do a {}, lba {}, block count {} @ {}, ended", representative_port_index(), direction == AsyncBlockDeviceRequest::RequestType::Write ? "write" : "read", lba, block_count, m_dma_buffers[0].paddr());
     return true;
 }
 
@@ -600,8 +732,11 @@ bool AHCIPort::identify_device(ScopedSpinLock<SpinLock<u8>>& main_lock)
 
     auto unused_command_header = try_to_find_unused_command_header();
     VERIFY(unused_command_header.has_value());
+    auto& command_slot = m_command_slots[unused_command_header.value()];
+    if (!ensure_command_slot_memory(command_slot))
+        return false;
     auto* command_list_entries = (volatile AHCI::CommandHeader*)m_command_list_region->vaddr().as_ptr();
-    command_list_entries[unused_command_header.value()].ctba = m_command_table_pages[unused_command_header.value()].paddr().get();
+    command_list_entries[unused_command_header.value()].ctba = command_slot.command_table_page->paddr().get();
     command_list_entries[unused_command_header.value()].ctbau = 0;
     command_list_entries[unused_command_header.value()].prdbc = 512;
     command_list_entries[unused_command_header.value()].prdtl = 1;
@@ -610,8 +745,7 @@ bool AHCIPort::identify_device(ScopedSpinLock<SpinLock<u8>>& main_lock)
     // QEMU doesn't care if we don't set the correct CFL field in this register, real hardware will set an handshake error bit in PxSERR register.
     command_list_entries[unused_command_header.value()].attributes = (size_t)FIS::DwordCount::RegisterHostToDevice | AHCI::CommandHeaderAttributes::P;
 
-    auto command_table_region = MM.allocate_kernel_region(m_command_table_pages[unused_command_header.value()].paddr().page_base(), Memory::page_round_up(sizeof(AHCI::CommandTable)), "AHCI Command Table", Memory::Region::Access::ReadWrite);
-    auto& command_table = *(volatile AHCI::CommandTable*)command_table_region->vaddr().as_ptr();
+    auto& command_table = *(volatile AHCI::CommandTable*)command_slot.command_table_region->vaddr().as_ptr();
     memset(const_cast<u8*>(command_table.command_fis), 0, 64);
     command_table.descriptors[0].base_high = 0;
     command_table.descriptors[0].base_low = m_parent_handler->get_identify_metadata_physical_region(m_port_index).get();
@@ -6,6 +6,9 @@
 
 #pragma once
 
+#include <AK/Array.h>
+#include <AK/Atomic.h>
+#include <AK/NonnullRefPtrVector.h>
 #include <AK/OwnPtr.h>
 #include <AK/RefPtr.h>
 #include <Kernel/Devices/Device.h>
@@ -15,7 +18,6 @@
 #include <Kernel/Locking/SpinLock.h>
 #include <Kernel/Memory/AnonymousVMObject.h>
 #include <Kernel/Memory/PhysicalPage.h>
-#include <Kernel/Memory/ScatterGatherList.h>
 #include <Kernel/PhysicalAddress.h>
 #include <Kernel/Random.h>
 #include <Kernel/Sections.h>
@@ -45,6 +47,11 @@ public:
 
     RefPtr<StorageDevice> connected_device() const { return m_connected_device; }
 
+    // Every command gets this much DMA memory, and adjacent requests are merged into one command as long as they fit.
+    static constexpr size_t max_dma_pages_per_command = 16;
+    static constexpr size_t max_transfer_size() { return max_dma_pages_per_command * PAGE_SIZE; }
+    size_t command_slot_count() const { return m_command_slot_count; }
+
     bool reset();
     UNMAP_AFTER_INIT bool initialize_without_reset();
     void handle_interrupt();
@@ -69,11 +76,27 @@ private:
     ALWAYS_INLINE void spin_up() const;
     ALWAYS_INLINE void power_on() const;
 
+    // Everything a single command needs. The memory is only allocated once the slot is used for the first time.
+    struct CommandSlot {
+        RefPtr<Memory::PhysicalPage> command_table_page;
+        OwnPtr<Memory::Region> command_table_region;
+        NonnullRefPtrVector<Memory::PhysicalPage> dma_pages;
+        OwnPtr<Memory::Region> dma_region;
+        NonnullRefPtrVector<AsyncBlockDeviceRequest> requests;
+        size_t dma_page_count { 0 };
+    };
+
     void start_request(AsyncBlockDeviceRequest&);
-    void complete_current_request(AsyncDeviceRequest::RequestResult);
-    bool access_device(AsyncBlockDeviceRequest::RequestType, u64 lba, u8 block_count);
-    size_t calculate_descriptors_count(size_t block_count) const;
-    [[nodiscard]] Optional<AsyncDeviceRequest::RequestResult> prepare_and_set_scatter_list(AsyncBlockDeviceRequest& request);
+    void issue_pending_requests();
+    void queue_completion_check();
+    void complete_finished_commands();
+    void complete_command(u8 slot_index, AsyncDeviceRequest::RequestResult);
+    void fail_all_requests();
+    bool ensure_command_slot_memory(CommandSlot&);
+    bool add_request_to_command(CommandSlot&, AsyncBlockDeviceRequest&);
+    void merge_adjacent_requests(CommandSlot&);
+    bool access_device(u8 slot_index);
+    Optional<u8> try_to_find_free_command_slot() const;
 
     ALWAYS_INLINE bool is_interrupts_enabled() const;
 
@@ -100,15 +123,19 @@ private:
     // Data members
 
     EntropySource m_entropy_source;
-    RefPtr<AsyncBlockDeviceRequest> m_current_request;
     SpinLock<u8> m_hard_lock;
     Mutex m_lock { "AHCIPort" };
 
     mutable bool m_wait_for_completion { false };
     bool m_wait_connect_for_completion { false };
 
-    NonnullRefPtrVector<Memory::PhysicalPage> m_dma_buffers;
-    NonnullRefPtrVector<Memory::PhysicalPage> m_command_table_pages;
+    Array<CommandSlot, 32> m_command_slots;
+    u32 m_busy_command_slots { 0 };
+    size_t m_command_slot_count { 1 };
+    bool m_native_command_queuing_enabled { false };
+    NonnullRefPtrVector<AsyncBlockDeviceRequest> m_pending_requests;
+    Atomic<bool> m_completion_check_queued { false };
+
     RefPtr<Memory::PhysicalPage> m_command_list_page;
     OwnPtr<Memory::Region> m_command_list_region;
     RefPtr<Memory::PhysicalPage> m_fis_receive_page;
@@ -120,7 +147,6 @@ private:
     AHCI::PortInterruptStatusBitField m_interrupt_status;
     AHCI::PortInterruptEnableBitField m_interrupt_enable;
 
-    RefPtr<Memory::ScatterGatherList> m_current_scatter_list;
     bool m_disabled_by_firmware { false };
 };
 }
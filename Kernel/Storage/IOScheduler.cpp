@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/Storage/IOScheduler.h>
+#include <Kernel/Time/TimeManagement.h>
+
+namespace Kernel {
+
+NonnullOwnPtr<IOScheduler> IOScheduler::create(IOSchedulerPolicy policy)
+{
+    switch (policy) {
+    case IOSchedulerPolicy::Noop:
+        return make<NoopIOScheduler>();
+    case IOSchedulerPolicy::Deadline:
+        return make<DeadlineIOScheduler>();
+    case IOSchedulerPolicy::Fair:
+        return make<FairIOScheduler>();
+    }
+    VERIFY_NOT_REACHED();
+}
+
+void NoopIOScheduler::add_request(NonnullRefPtr<AsyncBlockDeviceRequest> request)
+{
+    m_requests.append(move(request));
+}
+
+RefPtr<AsyncBlockDeviceRequest> NoopIOScheduler::take_next_request()
+{
+    if (m_requests.is_empty())
+        return {};
+    return m_requests.take_first();
+}
+
+Optional<size_t> DeadlineIOScheduler::first_at_or_after(Queue const& queue, u64 block_index)
+{
+    size_t low = 0;
+    size_t high = queue.size();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (queue[middle].request->block_index() < block_index)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    if (low == queue.size())
+        return {};
+    return low;
+}
+
+void DeadlineIOScheduler::add_request(NonnullRefPtr<AsyncBlockDeviceRequest> request)
+{
+    auto& queue = queue_for(request->request_type());
+    auto deadline = TimeManagement::the().monotonic_time() + (request->request_type() == AsyncBlockDeviceRequest::Read ? read_deadline : write_deadline);
+
+    // Requests for the same block stay in the order they were made.
+    size_t index = queue.size();
+    while (index > 0 && queue[index - 1].request->block_index() > request->block_index())
+        --index;
+    queue.insert(index, { move(request), deadline });
+}
+
+Optional<size_t> DeadlineIOScheduler::find_expired(Queue const& queue, Time const& now)
+{
+    Optional<size_t> oldest;
+    for (size_t i = 0; i < queue.size(); ++i) {
+        if (!oldest.has_value() || queue[i].deadline < queue[oldest.value()].deadline)
+            oldest = i;
+    }
+    if (oldest.has_value() && queue[oldest.value()].deadline <= now)
+        return oldest;
+    return {};
+}
+
+NonnullRefPtr<AsyncBlockDeviceRequest> DeadlineIOScheduler::take_from(Queue& queue, size_t index)
+{
+    auto request = queue.take(index).request;
+    m_next_block_index = request->block_index() + request->block_count();
+    return request;
+}
+
+RefPtr<AsyncBlockDeviceRequest> DeadlineIOScheduler::take_next_request()
+{
+    if (m_reads.is_empty() && m_writes.is_empty())
+        return {};
+
+    if (m_batch_remaining > 0) {
+        auto& queue = queue_for(m_batch_type);
+        if (auto index = first_at_or_after(queue, m_next_block_index); index.has_value()) {
+            --m_batch_remaining;
+            return take_from(queue, index.value());
+        }
+    }
+
+    // Time for a new batch. Reads go first, but writes can only be passed over so many times in a row.
+    if (!m_reads.is_empty() && (m_writes.is_empty() || m_times_writes_passed_over < max_times_writes_passed_over)) {
+        if (!m_writes.is_empty())
+            ++m_times_writes_passed_over;
+        m_batch_type = AsyncBlockDeviceRequest::Read;
+    } else {
+        m_times_writes_passed_over = 0;
+        m_batch_type = AsyncBlockDeviceRequest::Write;
+    }
+
+    // The batch starts at the oldest request if it has waited for too long, or else where the last sweep left off,
+    // going back to the start of the disk once it got to the end.
+    auto& queue = queue_for(m_batch_type);
+    auto index = find_expired(queue, TimeManagement::the().monotonic_time());
+    if (!index.has_value())
+        index = first_at_or_after(queue, m_next_block_index).value_or(0);
+    m_batch_remaining = batch_size - 1;
+    return take_from(queue, index.value());
+}
+
+void FairIOScheduler::add_request(NonnullRefPtr<AsyncBlockDeviceRequest> request)
+{
+    auto* process = &request->process();
+    for (auto& queue : m_queues) {
+        if (queue.process == process) {
+            queue.requests.append(move(request));
+            return;
+        }
+    }
+    auto queue = make<ProcessQueue>();
+    queue->process = process;
+    queue->requests.append(move(request));
+    m_queues.append(move(queue));
+}
+
+RefPtr<AsyncBlockDeviceRequest> FairIOScheduler::take_next_request()
+{
+    if (m_queues.is_empty())
+        return {};
+
+    if (m_blocks_started_in_turn >= blocks_per_turn) {
+        ++m_current_queue;
+        m_blocks_started_in_turn = 0;
+    }
+    if (m_current_queue >= m_queues.size())
+        m_current_queue = 0;
+
+    auto& queue = m_queues[m_current_queue];
+    auto request = queue.requests.take_first();
+    m_blocks_started_in_turn += request->block_count();
+
+    // The next process moves up into this one's place, and its turn starts right away.
+    if (queue.requests.is_empty()) {
+        m_queues.remove(m_current_queue);
+        m_blocks_started_in_turn = 0;
+    }
+    return request;
+}
+
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/NonnullOwnPtr.h>
+#include <AK/NonnullOwnPtrVector.h>
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/Time.h>
+#include <Kernel/CommandLine.h>
+#include <Kernel/Devices/BlockDevice.h>
+
+namespace Kernel {
+
+// Decides in which order the requests waiting for a StorageDevice are handed to it. Only requests that the device
+// hasn't been given yet can be reordered, so the device has to keep the number of requests it takes at once small.
+// All of it is called with the device's requests lock held.
+class IOScheduler {
+public:
+    static NonnullOwnPtr<IOScheduler> create(IOSchedulerPolicy);
+    virtual ~IOScheduler() = default;
+
+    virtual StringView name() const = 0;
+    virtual void add_request(NonnullRefPtr<AsyncBlockDeviceRequest>) = 0;
+    virtual RefPtr<AsyncBlockDeviceRequest> take_next_request() = 0;
+};
+
+// First come, first served, for devices that have no seek penalty or a scheduler of their own.
+class NoopIOScheduler final : public IOScheduler {
+public:
+    virtual StringView name() const override { return "noop"sv; }
+    virtual void add_request(NonnullRefPtr<AsyncBlockDeviceRequest>) override;
+    virtual RefPtr<AsyncBlockDeviceRequest> take_next_request() override;
+
+private:
+    NonnullRefPtrVector<AsyncBlockDeviceRequest> m_requests;
+};
+
+// Sweeps over the disk in order of block index, so that requests for neighbouring blocks go to the device one after
+// the other, where they can be merged. Reads are preferred over writes, since someone is usually waiting for them,
+// and every request is guaranteed to be started once it has waited for its deadline.
+class DeadlineIOScheduler final : public IOScheduler {
+public:
+    virtual StringView name() const override { return "deadline"sv; }
+    virtual void add_request(NonnullRefPtr<AsyncBlockDeviceRequest>) override;
+    virtual RefPtr<AsyncBlockDeviceRequest> take_next_request() override;
+
+private:
+    static constexpr Time read_deadline = Time::from_milliseconds(500);
+    static constexpr Time write_deadline = Time::from_milliseconds(5000);
+    // How many requests in a row go in one direction before the scheduler looks at the deadlines again.
+    static constexpr size_t batch_size = 16;
+    // How many times writes may be passed over for reads before it's their turn.
+    static constexpr size_t max_times_writes_passed_over = 2;
+
+    struct QueuedRequest {
+        NonnullRefPtr<AsyncBlockDeviceRequest> request;
+        Time deadline;
+    };
+
+    // Sorted by block index.
+    using Queue = Vector<QueuedRequest>;
+
+    Queue& queue_for(AsyncBlockDeviceRequest::RequestType type) { return type == AsyncBlockDeviceRequest::Read ? m_reads : m_writes; }
+    // The index of the first request for a block at or after block_index, if there is one.
+    static Optional<size_t> first_at_or_after(Queue const&, u64 block_index);
+    static Optional<size_t> find_expired(Queue const&, Time const& now);
+    NonnullRefPtr<AsyncBlockDeviceRequest> take_from(Queue&, size_t index);
+
+    Queue m_reads;
+    Queue m_writes;
+    AsyncBlockDeviceRequest::RequestType m_batch_type { AsyncBlockDeviceRequest::Read };
+    size_t m_batch_remaining { 0 };
+    size_t m_times_writes_passed_over { 0 };
+    u64 m_next_block_index { 0 };
+};
+
+// Takes turns between the processes that are waiting for the device, so that one with a lot of I/O to do can't
+// starve the others. Within a process, requests are started in the order they were made.
+class FairIOScheduler final : public IOScheduler {
+public:
+    virtual StringView name() const override { return "fair"sv; }
+    virtual void add_request(NonnullRefPtr<AsyncBlockDeviceRequest>) override;
+    virtual RefPtr<AsyncBlockDeviceRequest> take_next_request() override;
+
+private:
+    // How many blocks a process may have started before it's the next one's turn.
+    static constexpr size_t blocks_per_turn = 256;
+
+    struct ProcessQueue {
+        Process const* process { nullptr };
+        NonnullRefPtrVector<AsyncBlockDeviceRequest> requests;
+    };
+
+    NonnullOwnPtrVector<ProcessQueue> m_queues;
+    size_t m_current_queue { 0 };
+    size_t m_blocks_started_in_turn { 0 };
+};
+
+}
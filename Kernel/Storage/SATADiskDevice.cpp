@@ -32,6 +32,11 @@ StringView SATADiskDevice::class_name() const
     return "SATADiskDevice";
 }
 
+size_t SATADiskDevice::max_blocks_per_request() const
+{
+    return m_port->max_transfer_size() / block_size();
+}
+
 void SATADiskDevice::start_request(AsyncBlockDeviceRequest& request)
 {
     m_port->start_request(request);
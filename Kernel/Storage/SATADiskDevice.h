@@ -28,6 +28,7 @@ public:
     virtual ~SATADiskDevice() override;
 
     // ^StorageDevice
+    virtual size_t max_blocks_per_request() const override;
     // ^BlockDevice
     virtual void start_request(AsyncBlockDeviceRequest&) override;
     virtual String device_name() const override;
@@ -35,6 +36,11 @@ public:
 private:
     SATADiskDevice(const AHCIController&, const AHCIPort&, size_t sector_size, u64 max_addressable_block);
 
+    // ^Device
+    // Enough to keep all command slots busy and to give the port something to merge, while the rest waits in the I/O
+    // scheduler, where it can still be reordered.
+    virtual size_t max_started_requests() const override { return 2 * m_port->command_slot_count(); }
+
     // ^DiskDevice
     virtual StringView class_name() const override;
     NonnullRefPtr<AHCIPort> m_port;
@@ -10,12 +10,14 @@
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/Storage/StorageDevice.h>
 #include <Kernel/Storage/StorageManagement.h>
+#include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
 StorageDevice::StorageDevice(const StorageController& controller, size_t sector_size, u64 max_addressable_block)
     : BlockDevice(StorageManagement::major_number(), StorageManagement::minor_number(), sector_size)
     , m_storage_controller(controller)
+    , m_io_scheduler(IOScheduler::create(kernel_command_line().io_scheduler_policy()))
     , m_max_addressable_block(max_addressable_block)
 {
 }
@@ -23,6 +25,7 @@ StorageDevice::StorageDevice(const StorageController& controller, size_t sector_
 StorageDevice::StorageDevice(const StorageController& controller, int major, int minor, size_t sector_size, u64 max_addressable_block)
     : BlockDevice(major, minor, sector_size)
     , m_storage_controller(controller)
+    , m_io_scheduler(IOScheduler::create(kernel_command_line().io_scheduler_policy()))
     , m_max_addressable_block(max_addressable_block)
 {
 }
@@ -37,18 +40,37 @@ NonnullRefPtr<StorageController> StorageDevice::controller() const
     return m_storage_controller;
 }
 
+void StorageDevice::queue_request(NonnullRefPtr<AsyncDeviceRequest> request)
+{
+    m_io_scheduler->add_request(static_ptr_cast<AsyncBlockDeviceRequest>(move(request)));
+}
+
+RefPtr<AsyncDeviceRequest> StorageDevice::dequeue_request()
+{
+    return m_io_scheduler->take_next_request();
+}
+
+// Waits for the request, and charges the process that made it for the I/O and for the time it waited.
+static AsyncDeviceRequest::RequestWaitResult wait_for_request(AsyncBlockDeviceRequest& request)
+{
+    auto start = TimeManagement::the().monotonic_time();
+    auto result = request.wait();
+    auto wait_time = TimeManagement::the().monotonic_time() - start;
+    if (request.request_type() == AsyncBlockDeviceRequest::Read)
+        Process::current()->account_storage_read(request.buffer_size(), wait_time);
+    else
+        Process::current()->account_storage_write(request.buffer_size(), wait_time);
+    return result;
+}
+
 KResultOr<size_t> StorageDevice::read(FileDescription&, u64 offset, UserOrKernelBuffer& outbuf, size_t len)
 {
     unsigned index = offset / block_size();
-    u16 whole_blocks = len / block_size();
+    size_t whole_blocks = len / block_size();
     size_t remaining = len % block_size();
 
-    unsigned blocks_per_page = PAGE_SIZE / block_size();
-
-    // PATAChannel will chuck a wobbly if we try to read more than PAGE_SIZE
-    // at a time, because it uses a single page for its DMA buffer.
-    if (whole_blocks >= blocks_per_page) {
-        whole_blocks = blocks_per_page;
+    if (whole_blocks >= max_blocks_per_request()) {
+        whole_blocks = max_blocks_per_request();
         remaining = 0;
     }
 
@@ -56,7 +78,7 @@ KResultOr<size_t> StorageDevice::read(FileDescription&, u64 offset, UserOrKernel
 
     if (whole_blocks > 0) {
         auto read_request = make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Read, index, whole_blocks, outbuf, whole_blocks * block_size());
-        auto result = read_request->wait();
+        auto result = wait_for_request(*read_request);
         if (result.wait_result().was_interrupted())
             return EINTR;
         switch (result.request_result()) {
@@ -76,7 +98,7 @@ KResultOr<size_t> StorageDevice::read(FileDescription&, u64 offset, UserOrKernel
         auto data = ByteBuffer::create_uninitialized(block_size());
         auto data_buffer = UserOrKernelBuffer::for_kernel_buffer(data.data());
         auto read_request = make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Read, index + whole_blocks, 1, data_buffer, block_size());
-        auto result = read_request->wait();
+        auto result = wait_for_request(*read_request);
         if (result.wait_result().was_interrupted())
             return EINTR;
         switch (result.request_result()) {
@@ -105,15 +127,11 @@ bool StorageDevice::can_read(const FileDescription&, size_t offset) const
 KResultOr<size_t> StorageDevice::write(FileDescription&, u64 offset, const UserOrKernelBuffer& inbuf, size_t len)
 {
     unsigned index = offset / block_size();
-    u16 whole_blocks = len / block_size();
+    size_t whole_blocks = len / block_size();
     size_t remaining = len % block_size();
 
-    unsigned blocks_per_page = PAGE_SIZE / block_size();
-
-    // PATAChannel will chuck a wobbly if we try to write more than PAGE_SIZE
-    // at a time, because it uses a single page for its DMA buffer.
-    if (whole_blocks >= blocks_per_page) {
-        whole_blocks = blocks_per_page;
+    if (whole_blocks >= max_blocks_per_request()) {
+        whole_blocks = max_blocks_per_request();
         remaining = 0;
     }
 
@@ -121,7 +139,7 @@ KResultOr<size_t> StorageDevice::write(FileDescription&, u64 offset, const UserO
 
     if (whole_blocks > 0) {
         auto write_request = make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Write, index, whole_blocks, inbuf, whole_blocks * block_size());
-        auto result = write_request->wait();
+        auto result = wait_for_request(*write_request);
         if (result.wait_result().was_interrupted())
             return EINTR;
         switch (result.request_result()) {
@@ -146,7 +164,7 @@ KResultOr<size_t> StorageDevice::write(FileDescription&, u64 offset, const UserO
 
         {
             auto read_request = make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Read, index + whole_blocks, 1, data_buffer, block_size());
-            auto result = read_request->wait();
+            auto result = wait_for_request(*read_request);
             if (result.wait_result().was_interrupted())
                 return EINTR;
             switch (result.request_result()) {
@@ -167,7 +185,7 @@ KResultOr<size_t> StorageDevice::write(FileDescription&, u64 offset, const UserO
 
         {
             auto write_request = make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Write, index + whole_blocks, 1, data_buffer, block_size());
-            auto result = write_request->wait();
+            auto result = wait_for_request(*write_request);
             if (result.wait_result().was_interrupted())
                 return EINTR;
             switch (result.request_result()) {
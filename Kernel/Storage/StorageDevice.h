@@ -9,6 +9,7 @@
 #include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/Interrupts/IRQHandler.h>
 #include <Kernel/Locking/Mutex.h>
+#include <Kernel/Storage/IOScheduler.h>
 #include <Kernel/Storage/Partition/DiskPartition.h>
 #include <Kernel/Storage/StorageController.h>
 
@@ -23,6 +24,10 @@ public:
 
     NonnullRefPtr<StorageController> controller() const;
 
+    // PATAChannel will chuck a wobbly if we try to transfer more than PAGE_SIZE
+    // at a time, because it uses a single page for its DMA buffer, so that's the default.
+    virtual size_t max_blocks_per_request() const { return PAGE_SIZE / block_size(); }
+
     // ^BlockDevice
     virtual KResultOr<size_t> read(FileDescription&, u64, UserOrKernelBuffer&, size_t) override;
     virtual bool can_read(const FileDescription&, size_t) const override;
@@ -38,8 +43,13 @@ protected:
     // ^DiskDevice
     virtual StringView class_name() const override;
 
+    // ^Device
+    virtual void queue_request(NonnullRefPtr<AsyncDeviceRequest>) override;
+    virtual RefPtr<AsyncDeviceRequest> dequeue_request() override;
+
 private:
     NonnullRefPtr<StorageController> m_storage_controller;
+    NonnullOwnPtr<IOScheduler> m_io_scheduler;
     NonnullRefPtrVector<DiskPartition> m_partitions;
     u64 m_max_addressable_block;
 };
@@ -580,9 +580,6 @@ KResult Process::do_exec(NonnullRefPtr<FileDescription> main_program_description
     for (auto& property : m_coredump_properties)
         property = {};
 
-    auto current_thread = Thread::current();
-    current_thread->clear_signals();
-
     clear_futex_queues_on_exec();
 
     fds().change_each([&](auto& file_description_metadata) {
@@ -602,6 +599,7 @@ KResult Process::do_exec(NonnullRefPtr<FileDescription> main_program_description
     }
 
     new_main_thread = nullptr;
+    auto current_thread = Thread::current();
     if (&current_thread->process() == this) {
         new_main_thread = current_thread;
     } else {
@@ -612,6 +610,9 @@ KResult Process::do_exec(NonnullRefPtr<FileDescription> main_program_description
     }
     VERIFY(new_main_thread);
 
+    // NOTE: This isn't necessarily the current thread, posix_spawn() execs on behalf of a new process.
+    new_main_thread->clear_signals();
+
     auto auxv = generate_auxiliary_vector(load_result.load_base, load_result.entry_eip, uid(), euid(), gid(), egid(), path, main_program_fd);
 
     // NOTE: We create the new stack before disabling interrupts since it will zero-fault
@@ -674,7 +675,7 @@ KResult Process::do_exec(NonnullRefPtr<FileDescription> main_program_description
     regs.rip = load_result.entry_eip;
     regs.rsp = new_userspace_sp;
 #endif
-    regs.cr3 = address_space().page_directory().cr3();
+    regs.page_directory = &address_space().page_directory();
 
     {
         TemporaryChange profiling_disabler(m_profiling, was_profiling);
@@ -935,6 +936,29 @@ KResult Process::exec(String path, Vector<String> arguments, Vector<String> envi
     return KSuccess;
 }
 
+bool Process::copy_string_list_from_user(const Syscall::StringListArgument& list, Vector<String>& output)
+{
+    if (!list.length)
+        return true;
+    Checked<size_t> size = sizeof(*list.strings);
+    size *= list.length;
+    if (size.has_overflow())
+        return false;
+    Vector<Syscall::StringArgument, 32> strings;
+    if (!strings.try_resize(list.length))
+        return false;
+    if (!copy_from_user(strings.data(), list.strings, size.value()))
+        return false;
+    for (size_t i = 0; i < list.length; ++i) {
+        auto string = copy_string_from_user(strings[i]);
+        if (string.is_null())
+            return false;
+        if (!output.try_append(move(string)))
+            return false;
+    }
+    return true;
+}
+
 KResultOr<FlatPtr> Process::sys$execve(Userspace<const Syscall::SC_execve_params*> user_params)
 {
     VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
@@ -957,34 +981,12 @@ KResultOr<FlatPtr> Process::sys$execve(Userspace<const Syscall::SC_execve_params
         path = path_arg.value()->view();
     }
 
-    auto copy_user_strings = [](const auto& list, auto& output) {
-        if (!list.length)
-            return true;
-        Checked<size_t> size = sizeof(*list.strings);
-        size *= list.length;
-        if (size.has_overflow())
-            return false;
-        Vector<Syscall::StringArgument, 32> strings;
-        if (!strings.try_resize(list.length))
-            return false;
-        if (!copy_from_user(strings.data(), list.strings, size.value()))
-            return false;
-        for (size_t i = 0; i < list.length; ++i) {
-            auto string = copy_string_from_user(strings[i]);
-            if (string.is_null())
-                return false;
-            if (!output.try_append(move(string)))
-                return false;
-        }
-        return true;
-    };
-
     Vector<String> arguments;
-    if (!copy_user_strings(params.arguments, arguments))
+    if (!copy_string_list_from_user(params.arguments, arguments))
         return EFAULT;
 
     Vector<String> environment;
-    if (!copy_user_strings(params.environment, environment))
+    if (!copy_string_list_from_user(params.environment, environment))
         return EFAULT;
 
     auto result = exec(move(path), move(arguments), move(environment));
@@ -48,6 +48,18 @@ KResultOr<FlatPtr> Process::sys$fcntl(int fd, int cmd, u32 arg)
         return description->get_flock(Userspace<flock*>(arg));
     case F_SETLK:
         return description->apply_flock(*Process::current(), Userspace<const flock*>(arg));
+    case F_GETPIPE_SZ:
+        if (!description->is_fifo())
+            return EBADF;
+        return description->fifo()->capacity();
+    case F_SETPIPE_SZ: {
+        if (!description->is_fifo())
+            return EBADF;
+        auto* fifo = description->fifo();
+        if (auto result = fifo->set_capacity(arg); result.is_error())
+            return result;
+        return fifo->capacity();
+    }
     default:
         return EINVAL;
     }
@@ -11,6 +11,8 @@
 
 namespace Kernel {
 
+typedef HashMap<FlatPtr, RefPtr<FutexQueue>> FutexQueues;
+
 static SpinLock<u8> g_global_futex_lock;
 static Singleton<HashMap<Memory::VMObject*, FutexQueues>> g_global_futex_queues;
 
@@ -73,18 +75,12 @@ void FutexQueue::vmobject_deleted(Memory::VMObject& vmobject)
 
 void Process::clear_futex_queues_on_exec()
 {
-    ScopedSpinLock lock(m_futex_lock);
-    for (auto& it : m_futex_queues) {
-        bool did_wake_all;
-        it.value->wake_all(did_wake_all);
-        VERIFY(did_wake_all); // No one should be left behind...
-    }
-    m_futex_queues.clear();
+    PrivateFutexBucket::wake_all_in_process(*this);
 }
 
 KResultOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*> user_params)
 {
-    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
     Syscall::SC_futex_params params;
     if (!copy_from_user(&params, user_params))
         return EFAULT;
@@ -99,9 +95,7 @@ KResultOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*>
 
     switch (cmd) {
     case FUTEX_WAIT:
-    case FUTEX_WAIT_BITSET:
-    case FUTEX_REQUEUE:
-    case FUTEX_CMP_REQUEUE: {
+    case FUTEX_WAIT_BITSET: {
         if (params.timeout) {
             auto timeout_time = copy_time_from_user(params.timeout);
             if (!timeout_time.has_value())
@@ -120,8 +114,11 @@ KResultOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*>
     }
     }
 
+    // Private futexes are only ever looked at by threads of this process, so they're identified by their
+    // address alone and live in the PrivateFutexBucket table. Everything below that touches FutexQueues
+    // is only for shared futexes, which have to be found through the VMObject they live in.
     bool is_private = (params.futex_op & FUTEX_PRIVATE_FLAG) != 0;
-    auto& queue_lock = is_private ? m_futex_lock : g_global_futex_lock;
+    auto& queue_lock = g_global_futex_lock;
     auto user_address_or_offset = FlatPtr(params.userspace_address);
     auto user_address_or_offset2 = FlatPtr(params.userspace_address2);
 
@@ -129,6 +126,7 @@ KResultOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*>
     // acquiring the queue lock
     RefPtr<Memory::VMObject> vmobject, vmobject2;
     if (!is_private) {
+        ScopedSpinLock address_space_lock(address_space().get_lock());
         auto region = address_space().find_region_containing(Memory::VirtualRange { VirtualAddress { user_address_or_offset }, sizeof(u32) });
         if (!region)
             return EFAULT;
@@ -143,7 +141,7 @@ KResultOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*>
             if (!region2)
                 return EFAULT;
             vmobject2 = region2->vmobject();
-            user_address_or_offset2 = region->offset_in_vmobject_from_vaddr(VirtualAddress(user_address_or_offset2));
+            user_address_or_offset2 = region2->offset_in_vmobject_from_vaddr(VirtualAddress(user_address_or_offset2));
             break;
         }
         }
@@ -166,9 +164,9 @@ KResultOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*>
     };
 
     auto find_futex_queue = [&](Memory::VMObject* vmobject, FlatPtr user_address_or_offset, bool create_if_not_found, bool* did_create = nullptr) -> RefPtr<FutexQueue> {
-        VERIFY(is_private || vmobject);
+        VERIFY(!is_private && vmobject);
         VERIFY(!create_if_not_found || did_create != nullptr);
-        auto* queues = is_private ? &m_futex_queues : find_global_futex_queues(*vmobject, create_if_not_found);
+        auto* queues = find_global_futex_queues(*vmobject, create_if_not_found);
         if (!queues)
             return {};
         auto it = queues->find(user_address_or_offset);
@@ -185,7 +183,8 @@ KResultOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*>
     };
 
     auto remove_futex_queue = [&](Memory::VMObject* vmobject, FlatPtr user_address_or_offset) {
-        auto* queues = is_private ? &m_futex_queues : find_global_futex_queues(*vmobject, false);
+        VERIFY(!is_private);
+        auto* queues = find_global_futex_queues(*vmobject, false);
         if (queues) {
             if (auto it = queues->find(user_address_or_offset); it != queues->end()) {
                 if (it->value->try_remove()) {
@@ -193,7 +192,7 @@ KResultOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*>
                     queues->remove(it);
                 }
             }
-            if (!is_private && queues->is_empty())
+            if (queues->is_empty())
                 g_global_futex_queues->remove(vmobject);
         }
     };
@@ -201,6 +200,8 @@ KResultOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*>
     auto do_wake = [&](Memory::VMObject* vmobject, FlatPtr user_address_or_offset, u32 count, Optional<u32> bitmask) -> int {
         if (count == 0)
             return 0;
+        if (is_private)
+            return (int)PrivateFutexBucket::for_futex(*this, user_address_or_offset).wake_n(*this, user_address_or_offset, count, bitmask);
         ScopedSpinLock lock(queue_lock);
         auto futex_queue = find_futex_queue(vmobject, user_address_or_offset, false);
         if (!futex_queue)
@@ -214,7 +215,35 @@ KResultOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*>
         return (int)woke_count;
     };
 
+    auto do_private_wait = [&](u32 bitset) -> int {
+        auto& bucket = PrivateFutexBucket::for_futex(*this, user_address_or_offset);
+        for (;;) {
+            // The wake sequence has to be fetched before the value is checked, see PrivateFutexBucket.
+            auto wake_sequence = bucket.wake_sequence();
+            atomic_thread_fence(AK::MemoryOrder::memory_order_seq_cst);
+            auto user_value = user_atomic_load_relaxed(params.userspace_address);
+            if (!user_value.has_value())
+                return EFAULT;
+            if (user_value.value() != params.val) {
+                dbgln_if(FUTEX_DEBUG, "futex wait: EAGAIN. user value: {:p} @ {:p} != val: {}", user_value.value(), params.userspace_address, params.val);
+                return EAGAIN;
+            }
+            atomic_thread_fence(AK::MemoryOrder::memory_order_acquire);
+
+            auto block_result = bucket.wait_on(timeout, user_address_or_offset, wake_sequence, bitset);
+            if (block_result == Thread::BlockResult::InterruptedByTimeout)
+                return ETIMEDOUT;
+            // Something in the same bucket was woken up in the meantime. It might have been this futex,
+            // so go back and look at its value again.
+            if (block_result == Thread::BlockResult::NotBlocked)
+                continue;
+            return 0;
+        }
+    };
+
     auto do_wait = [&](u32 bitset) -> int {
+        if (is_private)
+            return do_private_wait(bitset);
         bool did_create;
         RefPtr<FutexQueue> futex_queue;
         do {
@@ -259,6 +288,12 @@ KResultOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*>
             return EAGAIN;
         atomic_thread_fence(AK::MemoryOrder::memory_order_acquire);
 
+        if (is_private) {
+            auto& bucket = PrivateFutexBucket::for_futex(*this, user_address_or_offset);
+            auto& target_bucket = PrivateFutexBucket::for_futex(*this, user_address_or_offset2);
+            return (int)bucket.wake_n_requeue(*this, user_address_or_offset, params.val, target_bucket, user_address_or_offset2, params.val2);
+        }
+
         int woken_or_requeued = 0;
         ScopedSpinLock lock(queue_lock);
         if (auto futex_queue = find_futex_queue(vmobject.ptr(), user_address_or_offset, false)) {
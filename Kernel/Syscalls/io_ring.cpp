@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/FileSystem/IORing.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+KResultOr<FlatPtr> Process::sys$io_ring_create(u32 entries)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    REQUIRE_PROMISE(stdio);
+
+    auto fd_or_error = m_fds.allocate();
+    if (fd_or_error.is_error())
+        return fd_or_error.error();
+    auto ring_fd = fd_or_error.release_value();
+
+    auto ring_or_error = IORing::try_create(*this, entries);
+    if (ring_or_error.is_error())
+        return ring_or_error.error();
+
+    auto description_or_error = FileDescription::create(*ring_or_error.value());
+    if (description_or_error.is_error())
+        return description_or_error.error();
+
+    // The ring is mapped shared and writable, which needs a description that is both readable and writable.
+    auto description = description_or_error.release_value();
+    description->set_readable(true);
+    description->set_writable(true);
+
+    // The operations on it refer to our file descriptors, so it makes no sense in a new program.
+    m_fds[ring_fd.fd].set(move(description), FD_CLOEXEC);
+    return ring_fd.fd;
+}
+
+KResultOr<FlatPtr> Process::sys$io_ring_enter(int fd, u32 to_submit, u32 min_complete)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    REQUIRE_PROMISE(stdio);
+
+    auto description = fds().file_description(fd);
+    if (!description)
+        return EBADF;
+    if (!description->is_io_ring())
+        return EBADF;
+
+    auto submitted_or_error = description->io_ring()->enter(*this, to_submit, min_complete);
+    if (submitted_or_error.is_error())
+        return submitted_or_error.error();
+    return submitted_or_error.value();
+}
+
+}
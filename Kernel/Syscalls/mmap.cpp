@@ -198,6 +198,10 @@ KResultOr<FlatPtr> Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> u
     if (map_stack && (!map_private || !map_anonymous))
         return EINVAL;
 
+    // Give large mappings a chance to use huge pages, which need the virtual address to be aligned as well.
+    if (!addr && !map_fixed && alignment <= PAGE_SIZE && size >= Memory::huge_page_size)
+        alignment = Memory::huge_page_size;
+
     Memory::Region* region = nullptr;
     Optional<Memory::VirtualRange> range;
 
@@ -470,6 +474,18 @@ KResultOr<FlatPtr> Process::sys$madvise(Userspace<void*> address, size_t size, i
     bool set_nonvolatile = advice & MADV_SET_NONVOLATILE;
     if (set_volatile && set_nonvolatile)
         return EINVAL;
+    bool huge_pages = advice & MADV_HUGEPAGE;
+    bool no_huge_pages = advice & MADV_NOHUGEPAGE;
+    if (huge_pages || no_huge_pages) {
+        if (huge_pages && no_huge_pages)
+            return EINVAL;
+        if (set_volatile || set_nonvolatile)
+            return EINVAL;
+        if (!region->vmobject().is_anonymous())
+            return EINVAL;
+        region->set_wants_huge_pages(huge_pages);
+        return 0;
+    }
     if (set_volatile || set_nonvolatile) {
         if (!region->vmobject().is_anonymous())
             return EINVAL;
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ScopeGuard.h>
+#include <Kernel/Debug.h>
+#include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/FileSystem/VirtualFileSystem.h>
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/PerformanceManager.h>
+#include <Kernel/Process.h>
+#include <Kernel/ProcessGroup.h>
+#include <Kernel/TTY/TTY.h>
+#include <LibC/limits.h>
+
+namespace Kernel {
+
+static constexpr size_t max_spawn_file_actions = 1024;
+
+// Unlike fork() followed by exec(), this never makes a copy of the caller's address space,
+// so how long it takes doesn't depend on how much memory the caller has mapped.
+// The new process starts out empty, gets its file descriptors and attributes set up right here,
+// and then the program is loaded into it from the caller's context.
+KResultOr<FlatPtr> Process::sys$posix_spawn(Userspace<const Syscall::SC_posix_spawn_params*> user_params)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    REQUIRE_PROMISE(proc);
+    REQUIRE_PROMISE(exec);
+
+    Syscall::SC_posix_spawn_params params;
+    if (!copy_from_user(&params, user_params))
+        return EFAULT;
+
+    if (params.arguments.length > ARG_MAX || params.environment.length > ARG_MAX || params.file_action_count > max_spawn_file_actions)
+        return E2BIG;
+
+    constexpr int supported_flags = POSIX_SPAWN_RESETIDS | POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSCHEDPARAM | POSIX_SPAWN_SETSCHEDULER | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSID;
+    if (params.flags & ~supported_flags)
+        return EINVAL;
+
+    // The file actions and the program are looked up with our credentials. That is only the same as
+    // doing it in the child if resetting the IDs doesn't change anything, so let userspace fork for the rest.
+    if ((params.flags & POSIX_SPAWN_RESETIDS) && (euid() != uid() || egid() != gid()))
+        return ENOTSUP;
+
+    if ((params.flags & POSIX_SPAWN_SETPGROUP) && params.pgroup < 0)
+        return EINVAL;
+
+    if ((params.flags & POSIX_SPAWN_SETSCHEDPARAM) && (params.sched_priority < THREAD_PRIORITY_MIN || params.sched_priority > THREAD_PRIORITY_MAX))
+        return EINVAL;
+
+    // NOTE: Everything has to be copied out of our address space up front,
+    //       since the child's address space is active while the program is loaded into it.
+    String path;
+    {
+        auto path_arg = get_syscall_path_argument(params.path);
+        if (path_arg.is_error())
+            return path_arg.error();
+        path = path_arg.value()->view();
+    }
+
+    Vector<String> arguments;
+    if (!copy_string_list_from_user(params.arguments, arguments))
+        return EFAULT;
+
+    Vector<String> environment;
+    if (!copy_string_list_from_user(params.environment, environment))
+        return EFAULT;
+
+    Vector<Syscall::SC_spawn_file_action> file_actions;
+    Vector<String> file_action_paths;
+    if (params.file_action_count) {
+        if (!file_actions.try_resize(params.file_action_count) || !file_action_paths.try_resize(params.file_action_count))
+            return ENOMEM;
+        if (!copy_from_user(file_actions.data(), params.file_actions, params.file_action_count * sizeof(Syscall::SC_spawn_file_action)))
+            return EFAULT;
+        for (size_t i = 0; i < file_actions.size(); ++i) {
+            auto& action = file_actions[i];
+            if (action.type == Syscall::SpawnFileActionType::Open) {
+                if (action.options & O_WRONLY)
+                    REQUIRE_PROMISE(wpath);
+                else if (action.options & O_RDONLY)
+                    REQUIRE_PROMISE(rpath);
+                if (action.options & O_CREAT)
+                    REQUIRE_PROMISE(cpath);
+                if (action.options & (O_NOFOLLOW_NOERROR | O_UNLINK_INTERNAL))
+                    return EINVAL;
+            }
+            if (action.type != Syscall::SpawnFileActionType::Open && action.type != Syscall::SpawnFileActionType::Chdir)
+                continue;
+            auto path_arg = get_syscall_path_argument(action.path);
+            if (path_arg.is_error())
+                return path_arg.error();
+            file_action_paths[i] = path_arg.value()->view();
+        }
+    }
+
+    RefPtr<Thread> child_first_thread;
+    auto child = Process::create(child_first_thread, m_name, uid(), gid(), pid(), false, m_cwd, m_executable, m_tty);
+    if (!child || !child_first_thread)
+        return ENOMEM;
+    child->m_root_directory = m_root_directory;
+    child->m_root_directory_relative_to_global_root = m_root_directory_relative_to_global_root;
+
+    if (auto result = child->m_fds.try_clone(m_fds); result.is_error())
+        return result.error();
+
+    child->m_pg = m_pg;
+
+    {
+        ProtectedDataMutationScope scope { *child };
+        child->m_protected_values.euid = m_protected_values.euid;
+        child->m_protected_values.egid = m_protected_values.egid;
+        child->m_protected_values.suid = m_protected_values.suid;
+        child->m_protected_values.sgid = m_protected_values.sgid;
+        child->m_protected_values.execpromises = m_protected_values.execpromises.load();
+        child->m_protected_values.has_execpromises = m_protected_values.has_execpromises.load();
+        child->m_protected_values.sid = m_protected_values.sid;
+        child->m_protected_values.extra_gids = m_protected_values.extra_gids;
+        child->m_protected_values.umask = m_protected_values.umask;
+    }
+
+    dbgln_if(FORK_DEBUG, "posix_spawn: child={} path={}", *child, path);
+
+    // The attributes are applied in the same order the fork() based version in LibC used to apply them.
+    // Resetting the IDs was dealt with above, and the signal mask and handlers are all reset by exec() anyway.
+    if (params.flags & POSIX_SPAWN_SETPGROUP) {
+        ProcessGroupID new_pgid = params.pgroup ? ProcessGroupID(params.pgroup) : ProcessGroupID(child->pid().value());
+        if (new_pgid != child->pid().value() && get_sid_from_pgid(new_pgid) != child->sid())
+            return EPERM;
+        child->m_pg = ProcessGroup::find_or_create(new_pgid);
+        if (!child->m_pg)
+            return ENOMEM;
+    }
+
+    if (params.flags & POSIX_SPAWN_SETSCHEDPARAM)
+        child_first_thread->set_priority((u32)params.sched_priority);
+
+    // FIXME: POSIX_SPAWN_SETSCHEDULER
+
+    if (params.flags & POSIX_SPAWN_SETSID) {
+        child->m_pg = ProcessGroup::create(ProcessGroupID(child->pid().value()));
+        if (!child->m_pg)
+            return ENOMEM;
+        child->m_tty = nullptr;
+        ProtectedDataMutationScope scope { *child };
+        child->m_protected_values.sid = child->pid().value();
+    }
+
+    auto& child_fds = child->m_fds;
+    for (size_t i = 0; i < file_actions.size(); ++i) {
+        auto& action = file_actions[i];
+        switch (action.type) {
+        case Syscall::SpawnFileActionType::Open: {
+            if (action.fd < 0 || static_cast<size_t>(action.fd) >= child_fds.max_open())
+                return EBADF;
+            auto description_or_error = VirtualFileSystem::the().open(file_action_paths[i], action.options, (action.mode & 0777) & ~child->umask(), child->current_directory());
+            if (description_or_error.is_error())
+                return description_or_error.error();
+            auto description = description_or_error.release_value();
+            if (description->inode() && description->inode()->socket())
+                return ENXIO;
+            if (!child_fds.m_fds_metadatas[action.fd].is_allocated())
+                child_fds.m_fds_metadatas[action.fd].allocate();
+            child_fds[action.fd].set(move(description), (action.options & O_CLOEXEC) ? FD_CLOEXEC : 0);
+            break;
+        }
+        case Syscall::SpawnFileActionType::Close: {
+            auto description = child_fds.file_description(action.fd);
+            if (!description)
+                return EBADF;
+            (void)description->close();
+            child_fds[action.fd] = {};
+            break;
+        }
+        case Syscall::SpawnFileActionType::Dup2: {
+            auto description = child_fds.file_description(action.fd);
+            if (!description)
+                return EBADF;
+            if (action.new_fd < 0 || static_cast<size_t>(action.new_fd) >= child_fds.max_open())
+                return EBADF;
+            // Unlike dup2() itself, this clears FD_CLOEXEC even when both descriptors are the same.
+            if (action.fd == action.new_fd) {
+                child_fds[action.new_fd].set_flags(child_fds[action.new_fd].flags() & ~FD_CLOEXEC);
+                break;
+            }
+            if (!child_fds.m_fds_metadatas[action.new_fd].is_allocated())
+                child_fds.m_fds_metadatas[action.new_fd].allocate();
+            child_fds[action.new_fd].set(*description);
+            break;
+        }
+        case Syscall::SpawnFileActionType::Chdir: {
+            auto directory_or_error = VirtualFileSystem::the().open_directory(file_action_paths[i], child->current_directory());
+            if (directory_or_error.is_error())
+                return directory_or_error.error();
+            child->m_cwd = *directory_or_error.value();
+            break;
+        }
+        case Syscall::SpawnFileActionType::Fchdir: {
+            auto description = child_fds.file_description(action.fd);
+            if (!description)
+                return EBADF;
+            if (!description->is_directory())
+                return ENOTDIR;
+            if (!description->metadata().may_execute(*child))
+                return EACCES;
+            child->m_cwd = description->custody();
+            break;
+        }
+        default:
+            return EINVAL;
+        }
+    }
+
+    {
+        ScopedSpinLock lock(g_scheduler_lock);
+        child_first_thread->set_affinity(Thread::current()->affinity());
+    }
+
+    {
+        // Loading the program switches over to the child's address space, so come back to ours afterwards.
+        ScopeGuard paging_scope_guard([this] {
+            Memory::MemoryManager::enter_process_paging_scope(*this);
+        });
+        auto result = child->exec(move(path), move(arguments), move(environment));
+        if (result.is_error())
+            return result.error();
+    }
+
+    Process::register_new(*child);
+
+    PerformanceManager::add_process_created_event(*child);
+
+    auto child_pid = child->pid().value();
+
+    // NOTE: All user processes have a leaked ref on them. It's balanced by Thread::WaitBlockCondition::finalize().
+    (void)child.leak_ref();
+
+    return child_pid;
+}
+
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/FIFO.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+using BlockFlags = Thread::FileBlocker::BlockFlags;
+
+static KResultOr<Optional<u64>> copy_offset_from_user(FileDescription const& description, int64_t* user_offset)
+{
+    if (!user_offset)
+        return Optional<u64> {};
+    if (description.is_fifo())
+        return ESPIPE;
+    int64_t offset;
+    if (!copy_from_user(&offset, user_offset))
+        return EFAULT;
+    if (offset < 0)
+        return EINVAL;
+    return Optional<u64> { offset };
+}
+
+KResultOr<FlatPtr> Process::sys$splice(Userspace<Syscall::SC_splice_params const*> user_params)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_splice_params params;
+    if (!copy_from_user(&params, user_params))
+        return EFAULT;
+    if (params.flags & ~(SPLICE_F_MOVE | SPLICE_F_NONBLOCK | SPLICE_F_MORE))
+        return EINVAL;
+    if (params.length > NumericLimits<ssize_t>::max())
+        return EINVAL;
+
+    auto in = fds().file_description(params.fd_in);
+    auto out = fds().file_description(params.fd_out);
+    if (!in || !out)
+        return EBADF;
+    if (!in->is_readable() || !out->is_writable())
+        return EBADF;
+    // One end has to be a pipe, and a pipe can't be spliced into itself.
+    if (!in->is_fifo() && !out->is_fifo())
+        return EINVAL;
+    if (&in->file() == &out->file())
+        return EINVAL;
+    // Like on Linux, since writing at the end of the file wouldn't go together with an output offset.
+    if (out->should_append() && out->file().is_seekable())
+        return EINVAL;
+
+    auto in_offset_or_error = copy_offset_from_user(*in, params.offset_in);
+    if (in_offset_or_error.is_error())
+        return in_offset_or_error.error();
+    auto in_offset = in_offset_or_error.release_value();
+    auto out_offset_or_error = copy_offset_from_user(*out, params.offset_out);
+    if (out_offset_or_error.is_error())
+        return out_offset_or_error.error();
+    auto out_offset = out_offset_or_error.release_value();
+
+    if (params.length == 0)
+        return 0;
+
+    // Wait for both ends the way read() and write() would.
+    bool may_block = !(params.flags & SPLICE_F_NONBLOCK);
+    if (!in->can_read()) {
+        if (!may_block || !in->is_blocking())
+            return EAGAIN;
+        auto unblock_flags = BlockFlags::None;
+        if (Thread::current()->block<Thread::ReadBlocker>({}, *in, unblock_flags).was_interrupted())
+            return EINTR;
+        if (!has_flag(unblock_flags, BlockFlags::Read))
+            return EAGAIN;
+    }
+    if (!out->can_write()) {
+        if (!may_block || !out->is_blocking())
+            return EAGAIN;
+        auto unblock_flags = BlockFlags::None;
+        if (Thread::current()->block<Thread::WriteBlocker>({}, *out, unblock_flags).was_interrupted())
+            return EINTR;
+        if (!has_flag(unblock_flags, BlockFlags::Write))
+            return EAGAIN;
+    }
+
+    auto result = in->is_fifo()
+        ? in->fifo()->splice_to(*out, out_offset, params.length)
+        : out->fifo()->splice_from(*in, in_offset, params.length);
+    if (result.is_error())
+        return result.error();
+    auto nmoved = result.value();
+
+    if (in_offset.has_value()) {
+        int64_t new_offset = in_offset.value() + nmoved;
+        if (!copy_to_user(params.offset_in, &new_offset))
+            return EFAULT;
+    }
+    if (out_offset.has_value()) {
+        int64_t new_offset = out_offset.value() + nmoved;
+        if (!copy_to_user(params.offset_out, &new_offset))
+            return EFAULT;
+    }
+    return nmoved;
+}
+
+}
@@ -73,7 +73,7 @@ KResultOr<FlatPtr> Process::sys$create_thread(void* (*entry)(void*), Userspace<c
     regs.rdx = params.rdx;
     regs.rcx = params.rcx;
 #endif
-    regs.cr3 = address_space().page_directory().cr3();
+    regs.page_directory = &address_space().page_directory();
 
     auto tsr_result = thread->make_thread_specific_region({});
     if (tsr_result.is_error())
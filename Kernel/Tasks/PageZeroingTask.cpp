@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Process.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Tasks/PageZeroingTask.h>
+#include <Kernel/Time/TimeManagement.h>
+
+namespace Kernel {
+
+static void page_zeroing_task(void*)
+{
+    Thread::current()->set_priority(THREAD_PRIORITY_MIN);
+    for (;;) {
+        // A few pages at a time, so that anything else that wants to run gets to run in between.
+        while (MM.refill_zeroed_page_pool())
+            ;
+        (void)Thread::current()->sleep(Time::from_milliseconds(10));
+    }
+}
+
+UNMAP_AFTER_INIT void PageZeroingTask::spawn()
+{
+    RefPtr<Thread> page_zeroing_thread;
+    auto page_zeroing_process = Process::create_kernel_process(page_zeroing_thread, "PageZeroingTask", page_zeroing_task, nullptr);
+    VERIFY(page_zeroing_process);
+}
+
+}
@@ -116,7 +116,7 @@ Thread::Thread(NonnullRefPtr<Process> process, NonnullOwnPtr<Memory::Region> ker
         m_regs.cs = GDT_SELECTOR_CODE3 | 3;
 #endif
 
-    m_regs.cr3 = m_process->address_space().page_directory().cr3();
+    m_regs.page_directory = &m_process->address_space().page_directory();
 
     m_kernel_stack_base = m_kernel_stack_region->vaddr().get();
     m_kernel_stack_top = m_kernel_stack_region->vaddr().offset(default_kernel_stack_size).get() & ~(FlatPtr)0x7u;
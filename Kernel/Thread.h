@@ -25,6 +25,7 @@
 #include <Kernel/Debug.h>
 #include <Kernel/FileSystem/InodeIdentifier.h>
 #include <Kernel/Forward.h>
+#include <Kernel/Heap/SlabAllocator.h>
 #include <Kernel/KResult.h>
 #include <Kernel/KString.h>
 #include <Kernel/Locking/LockMode.h>
@@ -110,7 +111,7 @@ struct ThreadRegisters {
 #else
     FlatPtr rflags;
 #endif
-    FlatPtr cr3;
+    Memory::PageDirectory* page_directory;
 
     FlatPtr ip() const
     {
@@ -136,6 +137,7 @@ class Thread
     , public Weakable<Thread> {
     AK_MAKE_NONCOPYABLE(Thread);
     AK_MAKE_NONMOVABLE(Thread);
+    MAKE_SLAB_ALLOCATED(Thread)
 
     friend class Mutex;
     friend class Process;
@@ -548,7 +550,7 @@ public:
 
     class FutexBlocker : public Blocker {
     public:
-        explicit FutexBlocker(FutexQueue&, u32);
+        explicit FutexBlocker(BlockCondition&, u32 bitset, FlatPtr user_address = 0, u32 wake_sequence = 0);
         virtual ~FutexBlocker();
 
         virtual Type blocker_type() const override { return Type::Futex; }
@@ -562,18 +564,24 @@ public:
 
         u32 bitset() const { return m_bitset; }
 
+        // Only used for private futexes, which share their queues with other futexes.
+        FlatPtr user_address() const { return m_user_address; }
+        u32 wake_sequence() const { return m_wake_sequence; }
+
         void begin_requeue()
         {
             // We need to hold the lock until we moved it over
             m_relock_flags = m_lock.lock();
         }
-        void finish_requeue(FutexQueue&);
+        void finish_requeue(BlockCondition&, FlatPtr user_address = 0);
 
         bool unblock_bitset(u32 bitset);
         bool unblock(bool force = false);
 
     protected:
         u32 m_bitset;
+        FlatPtr m_user_address { 0 };
+        u32 m_wake_sequence { 0 };
         u32 m_relock_flags { 0 };
         bool m_should_block { true };
         bool m_did_unblock { false };
@@ -142,8 +142,10 @@ bool Thread::QueueBlocker::unblock()
     return true;
 }
 
-Thread::FutexBlocker::FutexBlocker(FutexQueue& futex_queue, u32 bitset)
+Thread::FutexBlocker::FutexBlocker(BlockCondition& futex_queue, u32 bitset, FlatPtr user_address, u32 wake_sequence)
     : m_bitset(bitset)
+    , m_user_address(user_address)
+    , m_wake_sequence(wake_sequence)
 {
     if (!set_block_condition(futex_queue, Thread::current()))
         m_should_block = false;
@@ -153,10 +155,11 @@ Thread::FutexBlocker::~FutexBlocker()
 {
 }
 
-void Thread::FutexBlocker::finish_requeue(FutexQueue& futex_queue)
+void Thread::FutexBlocker::finish_requeue(BlockCondition& futex_queue, FlatPtr user_address)
 {
     VERIFY(m_lock.own_lock());
     set_block_condition_raw_locked(&futex_queue);
+    m_user_address = user_address;
     // We can now release the lock
     m_lock.unlock(m_relock_flags);
 }
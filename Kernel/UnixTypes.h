@@ -25,6 +25,10 @@
 #define O_CLOEXEC (1 << 11)
 #define O_DIRECT (1 << 12)
 
+#define SPLICE_F_MOVE 1
+#define SPLICE_F_NONBLOCK 2
+#define SPLICE_F_MORE 4
+
 // Kernel internal options.
 #define O_NOFOLLOW_NOERROR (1 << 29)
 #define O_UNLINK_INTERNAL (1 << 30)
@@ -103,6 +107,8 @@ enum {
 
 #define MADV_SET_VOLATILE 0x100
 #define MADV_SET_NONVOLATILE 0x200
+#define MADV_HUGEPAGE 0x400
+#define MADV_NOHUGEPAGE 0x800
 
 #define F_DUPFD 0
 #define F_GETFD 1
@@ -113,9 +119,19 @@ enum {
 #define F_GETLK 6
 #define F_SETLK 7
 #define F_SETLKW 8
+#define F_SETPIPE_SZ 9
+#define F_GETPIPE_SZ 10
 
 #define FD_CLOEXEC 1
 
+#define POSIX_SPAWN_RESETIDS (1 << 0)
+#define POSIX_SPAWN_SETPGROUP (1 << 1)
+#define POSIX_SPAWN_SETSCHEDPARAM (1 << 2)
+#define POSIX_SPAWN_SETSCHEDULER (1 << 3)
+#define POSIX_SPAWN_SETSIGDEF (1 << 4)
+#define POSIX_SPAWN_SETSIGMASK (1 << 5)
+#define POSIX_SPAWN_SETSID (1 << 6)
+
 #define _FUTEX_OP_SHIFT_OP 28
 #define _FUTEX_OP_MASK_OP 0xf
 #define _FUTEX_OP_SHIFT_CMP 24
@@ -112,12 +112,13 @@ chmod 755 mnt/res/devel/templates/*.postcreate
 echo "done"
 
 printf "creating initial filesystem structure... "
-for dir in bin etc proc mnt tmp boot mod var/run; do
+for dir in bin etc proc mnt tmp boot mod var/run var/cache/ld; do
     mkdir -p mnt/$dir
 done
 chmod 700 mnt/boot
 chmod 700 mnt/mod
 chmod 1777 mnt/tmp
+chmod 1777 mnt/var/cache/ld
 echo "done"
 
 printf "creating utmp file... "
@@ -66,3 +66,21 @@ TEST_CASE(kmp_two_chunks)
     EXPECT_EQ(result_2.value_or(9), 4u);
     EXPECT(!result_3.has_value());
 }
+
+TEST_CASE(many_false_candidates)
+{
+    // Lots of places where the first byte of the needle matches, but the rest doesn't,
+    // so that the search has to give up on skipping ahead with memchr() partway through.
+    Array<u8, 1024> haystack;
+    haystack.fill(1);
+    haystack[1000] = 2;
+    Array<u8, 2> short_needle { 1, 2 };
+    Array<u8, 33> long_needle;
+    long_needle.fill(1);
+    long_needle[32] = 2;
+    Array<u8, 2> missing_needle { 1, 3 };
+
+    EXPECT_EQ(AK::memmem(haystack.data(), haystack.size(), short_needle.data(), short_needle.size()), &haystack[999]);
+    EXPECT_EQ(AK::memmem(haystack.data(), haystack.size(), long_needle.data(), long_needle.size()), &haystack[968]);
+    EXPECT_EQ(AK::memmem(haystack.data(), haystack.size(), missing_needle.data(), missing_needle.size()), nullptr);
+}
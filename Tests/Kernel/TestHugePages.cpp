@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Random.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static constexpr size_t huge_page_size = 2 * MiB;
+
+static u32* map_huge(size_t size, bool huge_pages = true)
+{
+    auto* data = (u32*)mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
+    VERIFY(data != MAP_FAILED);
+    if (huge_pages)
+        VERIFY(madvise(data, size, MADV_HUGEPAGE) == 0);
+    return data;
+}
+
+static void fill(u32* data, size_t size)
+{
+    for (size_t i = 0; i < size / sizeof(u32); ++i)
+        data[i] = i;
+}
+
+static bool check(u32 const* data, size_t first_word, size_t word_count)
+{
+    for (size_t i = first_word; i < first_word + word_count; ++i) {
+        if (data[i] != i)
+            return false;
+    }
+    return true;
+}
+
+TEST_CASE(large_mappings_are_aligned)
+{
+    auto* data = map_huge(4 * huge_page_size, false);
+    EXPECT_EQ((FlatPtr)data % huge_page_size, 0u);
+    EXPECT_EQ(munmap(data, 4 * huge_page_size), 0);
+}
+
+TEST_CASE(madvise_rejects_conflicting_advice)
+{
+    auto* data = map_huge(huge_page_size, false);
+    EXPECT_EQ(madvise(data, huge_page_size, MADV_HUGEPAGE | MADV_NOHUGEPAGE), -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(madvise(data, huge_page_size, MADV_HUGEPAGE | MADV_SET_VOLATILE), -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(madvise(data, huge_page_size, MADV_NOHUGEPAGE), 0);
+    EXPECT_EQ(munmap(data, huge_page_size), 0);
+}
+
+TEST_CASE(huge_pages_keep_their_contents)
+{
+    constexpr size_t size = 4 * huge_page_size;
+    auto* data = map_huge(size);
+    fill(data, size);
+    EXPECT(check(data, 0, size / sizeof(u32)));
+    EXPECT_EQ(munmap(data, size), 0);
+}
+
+TEST_CASE(mprotect_splits_huge_page)
+{
+    constexpr size_t size = 2 * huge_page_size;
+    auto* data = map_huge(size);
+    fill(data, size);
+
+    // Make a single page in the middle of the first huge page read-only.
+    EXPECT_EQ(mprotect((u8*)data + 17 * PAGE_SIZE, PAGE_SIZE, PROT_READ), 0);
+    EXPECT(check(data, 0, size / sizeof(u32)));
+
+    // The rest of it has to stay writable.
+    data[1] = 1;
+    data[18 * PAGE_SIZE / sizeof(u32)] = 18 * PAGE_SIZE / sizeof(u32);
+    EXPECT(check(data, 0, size / sizeof(u32)));
+    EXPECT_EQ(munmap(data, size), 0);
+}
+
+TEST_CASE(munmap_splits_huge_page)
+{
+    constexpr size_t size = 2 * huge_page_size;
+    auto* data = map_huge(size);
+    fill(data, size);
+
+    size_t hole_offset = huge_page_size - 3 * PAGE_SIZE;
+    EXPECT_EQ(munmap((u8*)data + hole_offset, PAGE_SIZE), 0);
+    EXPECT(check(data, 0, hole_offset / sizeof(u32)));
+    EXPECT(check(data, (hole_offset + PAGE_SIZE) / sizeof(u32), (size - hole_offset - PAGE_SIZE) / sizeof(u32)));
+
+    EXPECT_EQ(munmap(data, hole_offset), 0);
+    EXPECT_EQ(munmap((u8*)data + hole_offset + PAGE_SIZE, size - hole_offset - PAGE_SIZE), 0);
+}
+
+TEST_CASE(fork_copies_huge_pages_on_write)
+{
+    constexpr size_t size = 2 * huge_page_size;
+    auto* data = map_huge(size);
+    fill(data, size);
+
+    pid_t pid = fork();
+    VERIFY(pid >= 0);
+    if (pid == 0) {
+        bool ok = check(data, 0, size / sizeof(u32));
+        data[5] = 0;
+        data[huge_page_size / sizeof(u32)] = 0;
+        _exit(ok && data[5] == 0 ? 0 : 1);
+    }
+
+    int status;
+    EXPECT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+    EXPECT(check(data, 0, size / sizeof(u32)));
+    EXPECT_EQ(munmap(data, size), 0);
+}
+
+static void benchmark_random_access(bool huge_pages)
+{
+    constexpr size_t size = 128 * MiB;
+    constexpr size_t accesses = 16 * 1024 * 1024;
+    auto* data = map_huge(size, huge_pages);
+    fill(data, size);
+
+    Core::ElapsedTimer timer;
+    timer.start();
+    u32 state = get_random<u32>();
+    u32 sum = 0;
+    for (size_t i = 0; i < accesses; ++i) {
+        state = state * 1103515245 + 12345;
+        sum += data[state % (size / sizeof(u32))];
+    }
+    outln("{} random reads from {} MiB with{} huge pages: {} ms (sum {})", accesses, size / MiB, huge_pages ? "" : "out", timer.elapsed(), sum);
+    EXPECT_EQ(munmap(data, size), 0);
+}
+
+BENCHMARK_CASE(random_access_without_huge_pages)
+{
+    benchmark_random_access(false);
+}
+
+BENCHMARK_CASE(random_access_with_huge_pages)
+{
+    benchmark_random_access(true);
+}
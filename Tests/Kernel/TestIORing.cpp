@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/String.h>
+#include <LibCore/EventLoop.h>
+#include <LibCore/IORing.h>
+#include <LibCore/Timer.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <serenity.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static NonnullRefPtr<Core::IORing> make_ring(unsigned entries = 16)
+{
+    auto ring_or_error = Core::IORing::create(entries);
+    if (ring_or_error.is_error()) {
+        warnln("{}", ring_or_error.error());
+        VERIFY_NOT_REACHED();
+    }
+    return ring_or_error.release_value();
+}
+
+TEST_CASE(invalid_rings_are_rejected)
+{
+    EXPECT_EQ(io_ring_create(0), -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(io_ring_create(12), -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(io_ring_create(IO_RING_MAX_ENTRIES * 2), -1);
+    EXPECT_EQ(errno, EINVAL);
+
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+    EXPECT_EQ(io_ring_enter(fds[0], 0, 0), -1);
+    EXPECT_EQ(errno, EBADF);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST_CASE(a_batch_takes_a_single_syscall)
+{
+    auto ring = make_ring();
+    Vector<int> results;
+    for (int i = 0; i < 10; ++i)
+        ring->nop([&](int result) { results.append(result); });
+    EXPECT_EQ(ring->enter_count(), 0u);
+    EXPECT_EQ(ring->operations_in_flight(), 10u);
+
+    EXPECT(ring->submit());
+    EXPECT_EQ(ring->enter_count(), 1u);
+    EXPECT_EQ(ring->operations_in_flight(), 0u);
+    EXPECT_EQ(results.size(), 10u);
+    for (auto result : results)
+        EXPECT_EQ(result, 0);
+}
+
+TEST_CASE(more_operations_than_entries)
+{
+    auto ring = make_ring(4);
+    int completed = 0;
+    for (int i = 0; i < 100; ++i)
+        ring->nop([&](int) { ++completed; });
+    EXPECT(ring->submit());
+    EXPECT_EQ(completed, 100);
+}
+
+TEST_CASE(file_read_and_write)
+{
+    char path[] = "/tmp/io-ring.XXXXXX";
+    int fd = mkstemp(path);
+    EXPECT(fd >= 0);
+    unlink(path);
+
+    auto ring = make_ring();
+    int write_result = 0;
+    int pwrite_result = 0;
+    ring->write(fd, "well hello friends"sv.bytes(), [&](int result) { write_result = result; });
+    ring->write(fd, "HELLO"sv.bytes(), [&](int result) { pwrite_result = result; }, 5);
+    EXPECT(ring->submit());
+    EXPECT_EQ(write_result, 18);
+    EXPECT_EQ(pwrite_result, 5);
+
+    // Writing at an offset leaves the file offset alone.
+    EXPECT_EQ(lseek(fd, 0, SEEK_CUR), 18);
+
+    char buffer[32] {};
+    int read_result = -1;
+    int fsync_result = -1;
+    ring->read(fd, { buffer, sizeof(buffer) }, [&](int result) { read_result = result; }, 0);
+    ring->fsync(fd, [&](int result) { fsync_result = result; });
+    EXPECT(ring->submit());
+    EXPECT_EQ(read_result, 18);
+    EXPECT_EQ(String(buffer, 18), "well HELLO friends");
+    EXPECT_EQ(fsync_result, 0);
+
+    // At the end of the file, there's nothing left to read from the current offset.
+    ring->read(fd, { buffer, sizeof(buffer) }, [&](int result) { read_result = result; });
+    EXPECT(ring->submit());
+    EXPECT_EQ(read_result, 0);
+    close(fd);
+}
+
+TEST_CASE(errors_are_reported_per_operation)
+{
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+
+    auto ring = make_ring();
+    char buffer[8];
+    int bad_fd_result = 0;
+    int seek_result = 0;
+    int nop_result = -1;
+    ring->read(1000, { buffer, sizeof(buffer) }, [&](int result) { bad_fd_result = result; });
+    ring->read(fds[0], { buffer, sizeof(buffer) }, [&](int result) { seek_result = result; }, 0);
+    ring->nop([&](int result) { nop_result = result; });
+    EXPECT(ring->submit());
+    EXPECT_EQ(bad_fd_result, -EBADF);
+    EXPECT_EQ(seek_result, -ESPIPE);
+    EXPECT_EQ(nop_result, 0);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST_CASE(pipe_read_waits_for_a_writer)
+{
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+
+    auto ring = make_ring();
+    char buffer[16];
+    int read_result = -1;
+    ring->read(fds[0], { buffer, sizeof(buffer) }, [&](int result) { read_result = result; });
+    EXPECT(ring->submit());
+    EXPECT_EQ(read_result, -1);
+    EXPECT_EQ(ring->operations_in_flight(), 1u);
+
+    // The ring becomes readable once the parked read can make progress.
+    pollfd ring_pollfd { ring->fd(), POLLIN, 0 };
+    EXPECT_EQ(poll(&ring_pollfd, 1, 0), 0);
+    EXPECT_EQ(write(fds[1], "hello", 5), 5);
+    EXPECT_EQ(poll(&ring_pollfd, 1, 1000), 1);
+
+    EXPECT(ring->submit_and_wait(1));
+    EXPECT_EQ(read_result, 5);
+    EXPECT_EQ(String(buffer, 5), "hello");
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST_CASE(large_pipe_write_does_not_block_the_ring)
+{
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+    int capacity = fcntl(fds[1], F_GETPIPE_SZ);
+    EXPECT(capacity > 0);
+
+    // The pipe is blocking, but the ring writes what fits and goes on with the next submission.
+    auto ring = make_ring();
+    static u8 buffer[256 * 1024];
+    int write_result = -1;
+    int nop_result = -1;
+    ring->write(fds[1], { buffer, sizeof(buffer) }, [&](int result) { write_result = result; });
+    ring->nop([&](int result) { nop_result = result; });
+    EXPECT(ring->submit());
+    EXPECT_EQ(write_result, capacity);
+    EXPECT_EQ(nop_result, 0);
+    EXPECT_EQ(fcntl(fds[1], F_GETFL) & O_NONBLOCK, 0);
+
+    // Once the pipe is full, the write waits for room like a read waits for data.
+    ring->write(fds[1], { buffer, sizeof(buffer) }, [&](int result) { write_result = result; });
+    EXPECT(ring->submit());
+    EXPECT_EQ(ring->operations_in_flight(), 1u);
+    EXPECT_EQ(read(fds[0], buffer, sizeof(buffer)), capacity);
+    EXPECT(ring->submit_and_wait(1));
+    EXPECT_EQ(write_result, capacity);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST_CASE(waiting_blocks_until_something_completes)
+{
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+
+    pid_t writer = fork();
+    if (writer == 0) {
+        usleep(100'000);
+        (void)write(fds[1], "x", 1);
+        _exit(0);
+    }
+
+    auto ring = make_ring();
+    char byte;
+    int read_result = -1;
+    int poll_result = -1;
+    ring->poll(fds[0], POLLIN, [&](int result) { poll_result = result; });
+    ring->read(fds[0], { &byte, 1 }, [&](int result) { read_result = result; });
+    EXPECT(ring->submit_and_wait(2));
+    EXPECT_EQ(poll_result, static_cast<int>(POLLIN));
+    EXPECT_EQ(read_result, 1);
+    EXPECT_EQ(byte, 'x');
+    waitpid(writer, nullptr, 0);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST_CASE(ring_belongs_to_its_process)
+{
+    auto ring = make_ring();
+    pid_t child = fork();
+    if (child == 0) {
+        // The file descriptor numbers in the submissions would mean something else here.
+        _exit(io_ring_enter(ring->fd(), 0, 0) == -1 && errno == EPERM ? 0 : 1);
+    }
+    int status;
+    EXPECT_EQ(waitpid(child, &status, 0), child);
+    EXPECT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+TEST_CASE(local_socket_accept_send_recv)
+{
+    constexpr char const* path = "/tmp/io-ring-test.socket";
+    unlink(path);
+    int server_fd = socket(AF_LOCAL, SOCK_STREAM, 0);
+    EXPECT(server_fd >= 0);
+    sockaddr_un address {};
+    address.sun_family = AF_LOCAL;
+    strlcpy(address.sun_path, path, sizeof(address.sun_path));
+    EXPECT_EQ(bind(server_fd, (sockaddr const*)&address, sizeof(address)), 0);
+    EXPECT_EQ(listen(server_fd, 1), 0);
+
+    // Connecting waits until the connection is accepted, so the client has to be somewhere else.
+    pid_t client = fork();
+    if (client == 0) {
+        int fd = socket(AF_LOCAL, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (sockaddr const*)&address, sizeof(address)) < 0)
+            _exit(1);
+        if (send(fd, "ping", 4, 0) != 4)
+            _exit(1);
+        char buffer[4];
+        if (recv(fd, buffer, sizeof(buffer), 0) != 4 || memcmp(buffer, "pong", 4) != 0)
+            _exit(1);
+        _exit(0);
+    }
+
+    auto ring = make_ring();
+    int connection_fd = -1;
+    ring->accept(server_fd, SOCK_CLOEXEC, [&](int result) { connection_fd = result; });
+    EXPECT(ring->submit_and_wait(1));
+    EXPECT(connection_fd >= 0);
+    EXPECT_EQ(fcntl(connection_fd, F_GETFD), FD_CLOEXEC);
+
+    char buffer[4];
+    int recv_result = -1;
+    ring->recv(connection_fd, { buffer, sizeof(buffer) }, 0, [&](int result) { recv_result = result; });
+    EXPECT(ring->submit_and_wait(1));
+    EXPECT_EQ(recv_result, 4);
+    EXPECT_EQ(String(buffer, 4), "ping");
+
+    int send_result = -1;
+    ring->send(connection_fd, "pong"sv.bytes(), 0, [&](int result) { send_result = result; });
+    EXPECT(ring->submit_and_wait(1));
+    EXPECT_EQ(send_result, 4);
+
+    int status;
+    EXPECT_EQ(waitpid(client, &status, 0), client);
+    EXPECT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    close(connection_fd);
+    close(server_fd);
+    unlink(path);
+}
+
+TEST_CASE(completions_are_delivered_by_the_event_loop)
+{
+    Core::EventLoop event_loop;
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+
+    auto ring = make_ring();
+    char buffer[16];
+    Vector<String> lines;
+    Function<void()> read_next = [&] {
+        ring->read(fds[0], { buffer, sizeof(buffer) }, [&](int result) {
+            if (result <= 0) {
+                event_loop.quit(0);
+                return;
+            }
+            lines.append(String(buffer, result));
+            read_next();
+        });
+    };
+    read_next();
+    EXPECT(ring->submit());
+
+    auto first_write_timer = Core::Timer::create_single_shot(100, [&] {
+        EXPECT_EQ(write(fds[1], "first", 5), 5);
+    });
+    first_write_timer->start();
+
+    auto second_write_timer = Core::Timer::create_single_shot(200, [&] {
+        EXPECT_EQ(write(fds[1], "second", 6), 6);
+        close(fds[1]);
+    });
+    second_write_timer->start();
+
+    auto catchall_timer = Core::Timer::create_single_shot(2000, [&] {
+        VERIFY_NOT_REACHED();
+    });
+    catchall_timer->start();
+
+    event_loop.exec();
+    EXPECT_EQ(lines.size(), 2u);
+    EXPECT_EQ(lines[0], "first");
+    EXPECT_EQ(lines[1], "second");
+    close(fds[0]);
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
+#include <AK/QuickSort.h>
+#include <AK/Random.h>
+#include <AK/Vector.h>
+#include <LibCore/File.h>
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+static constexpr char const* small_file_path = "/home/anon/.io-scheduler-test-small";
+static constexpr char const* bulk_file_path = "/home/anon/.io-scheduler-test-bulk";
+
+static JsonObject read_io_statistics()
+{
+    auto file = Core::File::construct("/proc/self/io");
+    VERIFY(file->open(Core::OpenMode::ReadOnly));
+    auto json = JsonValue::from_string(file->read_all());
+    VERIFY(json.has_value() && json.value().is_object());
+    return json.value().as_object();
+}
+
+static void write_file(char const* path, size_t size, int flags = 0)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | flags, 0600);
+    VERIFY(fd >= 0);
+    u8 buffer[64 * KiB];
+    memset(buffer, 0x5a, sizeof(buffer));
+    for (size_t offset = 0; offset < size; offset += sizeof(buffer))
+        VERIFY(write(fd, buffer, sizeof(buffer)) == sizeof(buffer));
+    close(fd);
+}
+
+TEST_CASE(storage_io_is_accounted)
+{
+    constexpr size_t size = 256 * KiB;
+    auto before = read_io_statistics();
+    write_file(small_file_path, size, O_DIRECT);
+
+    int fd = open(small_file_path, O_RDONLY | O_DIRECT);
+    EXPECT(fd >= 0);
+    u8 buffer[64 * KiB];
+    for (size_t offset = 0; offset < size; offset += sizeof(buffer))
+        EXPECT_EQ(read(fd, buffer, sizeof(buffer)), (ssize_t)sizeof(buffer));
+    close(fd);
+
+    auto after = read_io_statistics();
+    EXPECT(after.get("read_bytes").to_u64() - before.get("read_bytes").to_u64() >= size);
+    EXPECT(after.get("write_bytes").to_u64() - before.get("write_bytes").to_u64() >= size);
+    EXPECT(after.get("read_requests").to_u64() > before.get("read_requests").to_u64());
+    EXPECT(after.get("write_requests").to_u64() > before.get("write_requests").to_u64());
+    EXPECT(after.get("wait_time_us").to_u64() >= before.get("wait_time_us").to_u64());
+    EXPECT_EQ(unlink(small_file_path), 0);
+}
+
+static u64 microseconds_since(timespec const& start)
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start.tv_sec) * 1'000'000 + (now.tv_nsec - start.tv_nsec) / 1000;
+}
+
+// How long small random reads take, which is what an interactive program mostly does.
+static void measure_read_latencies(char const* description)
+{
+    constexpr size_t file_size = 4 * MiB;
+    constexpr size_t reads = 500;
+
+    int fd = open(small_file_path, O_RDONLY | O_DIRECT);
+    VERIFY(fd >= 0);
+    Vector<u64> latencies;
+    u8 buffer[4 * KiB];
+    for (size_t i = 0; i < reads; ++i) {
+        off_t offset = get_random_uniform(file_size / sizeof(buffer)) * sizeof(buffer);
+        timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        VERIFY(pread(fd, buffer, sizeof(buffer), offset) == sizeof(buffer));
+        latencies.append(microseconds_since(start));
+    }
+    close(fd);
+
+    quick_sort(latencies);
+    auto percentile = [&](size_t percent) { return latencies[min(latencies.size() - 1, latencies.size() * percent / 100)]; };
+    outln("{}: p50 {} us, p90 {} us, p99 {} us, max {} us", description, percentile(50), percentile(90), percentile(99), latencies.last());
+}
+
+// Run this once for every io_scheduler boot parameter to compare them.
+BENCHMARK_CASE(read_latency_during_bulk_writes)
+{
+    write_file(small_file_path, 4 * MiB);
+    measure_read_latencies("Random 4 KiB reads on their own");
+
+    // Something like a tar extracting a large archive in the background.
+    pid_t writer = fork();
+    VERIFY(writer >= 0);
+    if (writer == 0) {
+        for (;;)
+            write_file(bulk_file_path, 32 * MiB, O_DIRECT);
+    }
+    usleep(200'000);
+    measure_read_latencies("Random 4 KiB reads during bulk writes");
+
+    kill(writer, SIGKILL);
+    waitpid(writer, nullptr, 0);
+    unlink(bulk_file_path);
+    unlink(small_file_path);
+}
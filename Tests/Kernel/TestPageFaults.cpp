@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Random.h>
+#include <AK/Vector.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibTest/TestCase.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static constexpr size_t page_count = 16384;
+
+static u8* map_pages()
+{
+    auto* data = (u8*)mmap(nullptr, page_count * PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
+    VERIFY(data != MAP_FAILED);
+    return data;
+}
+
+TEST_CASE(touched_pages_are_zeroed)
+{
+    auto* data = map_pages();
+    for (size_t i = 0; i < page_count; i += 7) {
+        for (size_t j = 0; j < PAGE_SIZE; j += 64)
+            EXPECT_EQ(data[i * PAGE_SIZE + j], 0);
+        data[i * PAGE_SIZE] = 1;
+    }
+    // The pages after a sequentially touched one are mapped ahead of time, and have to be zeroed as well.
+    for (size_t i = 0; i < page_count; ++i) {
+        EXPECT_EQ(data[i * PAGE_SIZE + PAGE_SIZE / 2], 0);
+        data[i * PAGE_SIZE + PAGE_SIZE / 2] = 1;
+    }
+    EXPECT_EQ(munmap(data, page_count * PAGE_SIZE), 0);
+}
+
+static void benchmark_touch_pages(bool sequential)
+{
+    auto* data = map_pages();
+
+    Vector<size_t> order;
+    order.ensure_capacity(page_count);
+    for (size_t i = 0; i < page_count; ++i)
+        order.unchecked_append(i);
+    if (!sequential) {
+        for (size_t i = page_count - 1; i > 0; --i)
+            swap(order[i], order[get_random_uniform(i + 1)]);
+    }
+
+    Core::ElapsedTimer timer;
+    timer.start();
+    for (auto page_index : order)
+        data[page_index * PAGE_SIZE] = 1;
+    auto elapsed = timer.elapsed();
+    outln("Touched {} pages {}: {} ms, {} ns per page", page_count, sequential ? "in order" : "at random", elapsed, elapsed * 1'000'000 / page_count);
+    EXPECT_EQ(munmap(data, page_count * PAGE_SIZE), 0);
+}
+
+BENCHMARK_CASE(touch_pages_in_order)
+{
+    benchmark_touch_pages(true);
+}
+
+BENCHMARK_CASE(touch_pages_at_random)
+{
+    benchmark_touch_pages(false);
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/String.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <spawn.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static String spawn_and_read_output(char const* const arguments[], posix_spawn_file_actions_t& file_actions)
+{
+    int fds[2];
+    VERIFY(pipe(fds) == 0);
+    posix_spawn_file_actions_adddup2(&file_actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&file_actions, fds[0]);
+    posix_spawn_file_actions_addclose(&file_actions, fds[1]);
+
+    pid_t pid;
+    EXPECT_EQ(posix_spawn(&pid, arguments[0], &file_actions, nullptr, const_cast<char**>(arguments), environ), 0);
+    close(fds[1]);
+
+    char buffer[256];
+    size_t nread = 0;
+    while (nread < sizeof(buffer)) {
+        auto rc = read(fds[0], buffer + nread, sizeof(buffer) - nread);
+        if (rc <= 0)
+            break;
+        nread += rc;
+    }
+    close(fds[0]);
+
+    int status;
+    EXPECT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    return String(buffer, nread);
+}
+
+TEST_CASE(file_actions_are_applied_in_the_child)
+{
+    char const* arguments[] = { "/bin/echo", "well hello friends", nullptr };
+    posix_spawn_file_actions_t file_actions;
+    posix_spawn_file_actions_init(&file_actions);
+    EXPECT_EQ(spawn_and_read_output(arguments, file_actions), "well hello friends\n");
+    posix_spawn_file_actions_destroy(&file_actions);
+}
+
+TEST_CASE(child_can_change_directory)
+{
+    char const* arguments[] = { "/bin/pwd", nullptr };
+    posix_spawn_file_actions_t file_actions;
+    posix_spawn_file_actions_init(&file_actions);
+    posix_spawn_file_actions_addchdir(&file_actions, "/tmp");
+    EXPECT_EQ(spawn_and_read_output(arguments, file_actions), "/tmp\n");
+    posix_spawn_file_actions_destroy(&file_actions);
+
+    // Our own working directory stays the same.
+    char cwd[PATH_MAX];
+    EXPECT(getcwd(cwd, sizeof(cwd)));
+    EXPECT_NE(String(cwd), "/tmp");
+}
+
+TEST_CASE(child_can_open_files)
+{
+    constexpr char const* path = "/tmp/posix-spawn-test";
+    char const* arguments[] = { "/bin/echo", "written by the child", nullptr };
+    posix_spawn_file_actions_t file_actions;
+    posix_spawn_file_actions_init(&file_actions);
+    posix_spawn_file_actions_addopen(&file_actions, STDOUT_FILENO, path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+    pid_t pid;
+    EXPECT_EQ(posix_spawn(&pid, arguments[0], &file_actions, nullptr, const_cast<char**>(arguments), environ), 0);
+    posix_spawn_file_actions_destroy(&file_actions);
+    EXPECT_EQ(waitpid(pid, nullptr, 0), pid);
+
+    int fd = open(path, O_RDONLY);
+    EXPECT(fd >= 0);
+    char buffer[64];
+    auto nread = read(fd, buffer, sizeof(buffer));
+    EXPECT_EQ(String(buffer, max(nread, 0)), "written by the child\n");
+    close(fd);
+    unlink(path);
+}
+
+TEST_CASE(failures_are_reported_to_the_caller)
+{
+    char const* arguments[] = { "/bin/does-not-exist", nullptr };
+    pid_t pid;
+    EXPECT_EQ(posix_spawn(&pid, arguments[0], nullptr, nullptr, const_cast<char**>(arguments), environ), ENOENT);
+    EXPECT_EQ(posix_spawnp(&pid, "does-not-exist", nullptr, nullptr, const_cast<char**>(arguments), environ), ENOENT);
+
+    posix_spawn_file_actions_t file_actions;
+    posix_spawn_file_actions_init(&file_actions);
+    posix_spawn_file_actions_addclose(&file_actions, 1000);
+    char const* true_arguments[] = { "/bin/true", nullptr };
+    EXPECT_EQ(posix_spawn(&pid, true_arguments[0], &file_actions, nullptr, const_cast<char**>(true_arguments), environ), EBADF);
+    posix_spawn_file_actions_destroy(&file_actions);
+}
+
+TEST_CASE(child_can_get_its_own_process_group)
+{
+    char const* arguments[] = { "sleep", "10", nullptr };
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&attr, 0);
+
+    pid_t pid;
+    EXPECT_EQ(posix_spawnp(&pid, arguments[0], nullptr, &attr, const_cast<char**>(arguments), environ), 0);
+    EXPECT_EQ(getpgid(pid), pid);
+    EXPECT_NE(getpgid(pid), getpgrp());
+    posix_spawnattr_destroy(&attr);
+
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+}
+
+static pid_t spawn_with_fork_and_exec(char const* const arguments[])
+{
+    pid_t pid = fork();
+    if (pid == 0) {
+        execve(arguments[0], const_cast<char**>(arguments), environ);
+        _exit(127);
+    }
+    return pid;
+}
+
+static pid_t spawn_with_posix_spawn(char const* const arguments[])
+{
+    pid_t pid;
+    if (posix_spawn(&pid, arguments[0], nullptr, nullptr, const_cast<char**>(arguments), environ) != 0)
+        return -1;
+    return pid;
+}
+
+static void measure_spawn_latency(char const* description, pid_t (*spawn)(char const* const[]))
+{
+    constexpr size_t spawns = 50;
+    char const* arguments[] = { "/bin/true", nullptr };
+
+    Core::ElapsedTimer timer;
+    timer.start();
+    for (size_t i = 0; i < spawns; ++i) {
+        pid_t pid = spawn(arguments);
+        VERIFY(pid > 0);
+        waitpid(pid, nullptr, 0);
+    }
+    auto elapsed = timer.elapsed();
+    outln("{}: {} us per spawn", description, elapsed * 1000 / spawns);
+}
+
+BENCHMARK_CASE(spawn_from_large_address_space)
+{
+    measure_spawn_latency("fork + exec, small parent", spawn_with_fork_and_exec);
+    measure_spawn_latency("posix_spawn, small parent", spawn_with_posix_spawn);
+
+    // Something like a browser or a compiler that starts helper processes.
+    constexpr size_t mapping_size = 1 * GiB;
+    constexpr size_t touched_size = 64 * MiB;
+    auto* mapping = (u8*)mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    VERIFY(mapping != MAP_FAILED);
+    for (size_t offset = 0; offset < touched_size; offset += PAGE_SIZE)
+        mapping[offset] = 1;
+
+    measure_spawn_latency("fork + exec, 1 GiB parent", spawn_with_fork_and_exec);
+    measure_spawn_latency("posix_spawn, 1 GiB parent", spawn_with_posix_spawn);
+
+    munmap(mapping, mapping_size);
+}
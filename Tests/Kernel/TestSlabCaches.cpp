@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Vector.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibCore/File.h>
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// Every open() and close() allocates and frees a FileDescription and a few Custody objects, so this keeps the
+// kernel's slab caches busy.
+static void* open_and_close(void*)
+{
+    for (size_t i = 0; i < 20000; ++i) {
+        int fd = open("/dev/null", O_RDONLY);
+        VERIFY(fd >= 0);
+        close(fd);
+    }
+    return nullptr;
+}
+
+static i64 run_threads(size_t thread_count)
+{
+    Core::ElapsedTimer timer;
+    timer.start();
+    Vector<pthread_t> threads;
+    for (size_t i = 0; i < thread_count; ++i) {
+        pthread_t thread;
+        VERIFY(pthread_create(&thread, nullptr, open_and_close, nullptr) == 0);
+        threads.append(thread);
+    }
+    for (auto thread : threads)
+        pthread_join(thread, nullptr);
+    return timer.elapsed();
+}
+
+TEST_CASE(memstat_lists_slab_caches)
+{
+    auto file = Core::File::construct("/proc/memstat");
+    VERIFY(file->open(Core::OpenMode::ReadOnly));
+    auto contents = String::copy(file->read_all());
+    EXPECT(contents.contains("\"slab_caches\""));
+    EXPECT(contents.contains("\"FileDescription\""));
+    EXPECT(contents.contains("\"Thread\""));
+}
+
+BENCHMARK_CASE(open_close_scaling)
+{
+    size_t processor_count = max(1l, sysconf(_SC_NPROCESSORS_ONLN));
+    auto single_thread = run_threads(1);
+    outln("1 thread: {} ms", single_thread);
+    for (size_t thread_count = 2; thread_count <= processor_count; thread_count *= 2) {
+        auto elapsed = run_threads(thread_count);
+        // With perfect scaling, every thread count takes as long as a single thread does.
+        outln("{} threads: {} ms, {}% of perfect scaling", thread_count, elapsed, single_thread * 100 / max<i64>(elapsed, 1));
+    }
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static int make_file_with_pattern(size_t size)
+{
+    char path[] = "/tmp/splice.XXXXXX";
+    int fd = mkstemp(path);
+    VERIFY(fd >= 0);
+    unlink(path);
+    for (size_t i = 0; i < size; ++i) {
+        u8 byte = i % 251;
+        VERIFY(write(fd, &byte, 1) == 1);
+    }
+    return fd;
+}
+
+static bool has_pattern(u8 const* data, size_t size, size_t first_offset)
+{
+    for (size_t i = 0; i < size; ++i) {
+        if (data[i] != (first_offset + i) % 251)
+            return false;
+    }
+    return true;
+}
+
+TEST_CASE(pipe_capacity_can_be_changed)
+{
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+    EXPECT_EQ(fcntl(fds[1], F_GETPIPE_SZ), 64 * 1024);
+    EXPECT_EQ(fcntl(fds[1], F_SETPIPE_SZ, 256 * 1024), 256 * 1024);
+    EXPECT_EQ(fcntl(fds[0], F_GETPIPE_SZ), 256 * 1024);
+
+    // The whole thing fits now, without a reader having to come along.
+    static u8 buffer[200 * 1024];
+    EXPECT_EQ(fcntl(fds[1], F_SETFL, O_NONBLOCK), 0);
+    EXPECT_EQ(write(fds[1], buffer, sizeof(buffer)), (ssize_t)sizeof(buffer));
+
+    // What's in the pipe has to fit into the new size.
+    EXPECT_EQ(fcntl(fds[1], F_SETPIPE_SZ, 64 * 1024), -1);
+    EXPECT_EQ(errno, EBUSY);
+    EXPECT_EQ(fcntl(fds[1], F_SETPIPE_SZ, 16 * 1024 * 1024), -1);
+    EXPECT_EQ(errno, EPERM);
+
+    EXPECT_EQ(read(fds[0], buffer, sizeof(buffer)), (ssize_t)sizeof(buffer));
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST_CASE(pipe_capacity_only_for_pipes)
+{
+    int fd = make_file_with_pattern(16);
+    EXPECT_EQ(fcntl(fd, F_GETPIPE_SZ), -1);
+    EXPECT_EQ(errno, EBADF);
+    close(fd);
+}
+
+TEST_CASE(splice_from_file_through_pipes_to_file)
+{
+    constexpr size_t size = 100 * 1000;
+    int source = make_file_with_pattern(size);
+    char path[] = "/tmp/splice.XXXXXX";
+    int destination = mkstemp(path);
+    EXPECT(destination >= 0);
+    unlink(path);
+
+    int first_pipe[2];
+    int second_pipe[2];
+    EXPECT_EQ(pipe(first_pipe), 0);
+    EXPECT_EQ(pipe(second_pipe), 0);
+
+    // An offset of its own doesn't move the file's.
+    EXPECT_EQ(lseek(source, 0, SEEK_SET), 0);
+    off_t source_offset = 1000;
+    size_t moved = 0;
+    while (moved < size - 1000) {
+        auto nspliced = splice(source, &source_offset, first_pipe[1], nullptr, size - 1000 - moved, 0);
+        EXPECT(nspliced > 0);
+        EXPECT_EQ(splice(first_pipe[0], nullptr, second_pipe[1], nullptr, nspliced, 0), nspliced);
+        EXPECT_EQ(splice(second_pipe[0], nullptr, destination, nullptr, nspliced, 0), nspliced);
+        moved += nspliced;
+    }
+    EXPECT_EQ(source_offset, (off_t)size);
+    EXPECT_EQ(lseek(source, 0, SEEK_CUR), 0);
+
+    static u8 buffer[size];
+    EXPECT_EQ(pread(destination, buffer, sizeof(buffer), 0), (ssize_t)(size - 1000));
+    EXPECT(has_pattern(buffer, size - 1000, 1000));
+
+    close(source);
+    close(destination);
+    close(first_pipe[0]);
+    close(first_pipe[1]);
+    close(second_pipe[0]);
+    close(second_pipe[1]);
+}
+
+TEST_CASE(splice_needs_a_pipe)
+{
+    int first = make_file_with_pattern(16);
+    int second = make_file_with_pattern(16);
+    EXPECT_EQ(splice(first, nullptr, second, nullptr, 16, 0), -1);
+    EXPECT_EQ(errno, EINVAL);
+
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+    off_t offset = 0;
+    EXPECT_EQ(splice(first, nullptr, fds[1], &offset, 16, 0), -1);
+    EXPECT_EQ(errno, ESPIPE);
+    EXPECT_EQ(splice(fds[0], nullptr, fds[1], nullptr, 16, 0), -1);
+    EXPECT_EQ(errno, EINVAL);
+
+    // Nothing to read, and told not to wait for it.
+    EXPECT_EQ(splice(fds[0], nullptr, first, nullptr, 16, SPLICE_F_NONBLOCK), -1);
+    EXPECT_EQ(errno, EAGAIN);
+
+    // The end of the pipe reads as nothing.
+    close(fds[1]);
+    EXPECT_EQ(splice(fds[0], nullptr, first, nullptr, 16, 0), 0);
+
+    close(fds[0]);
+    close(first);
+    close(second);
+}
+
+TEST_CASE(splice_refuses_append_only_files)
+{
+    char path[] = "/tmp/splice.XXXXXX";
+    int fd = mkstemp(path);
+    EXPECT(fd >= 0);
+    EXPECT_EQ(write(fd, "keep", 4), 4);
+    int append_fd = open(path, O_WRONLY | O_APPEND);
+    EXPECT(append_fd >= 0);
+    unlink(path);
+
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+    EXPECT_EQ(write(fds[1], "data", 4), 4);
+    EXPECT_EQ(splice(fds[0], nullptr, append_fd, nullptr, 4, 0), -1);
+    EXPECT_EQ(errno, EINVAL);
+
+    // Nothing was overwritten, and the data is still in the pipe.
+    char buffer[8] {};
+    EXPECT_EQ(pread(fd, buffer, sizeof(buffer), 0), 4);
+    EXPECT_EQ(memcmp(buffer, "keep", 4), 0);
+    EXPECT_EQ(read(fds[0], buffer, sizeof(buffer)), 4);
+    EXPECT_EQ(memcmp(buffer, "data", 4), 0);
+
+    close(fds[0]);
+    close(fds[1]);
+    close(append_fd);
+    close(fd);
+}
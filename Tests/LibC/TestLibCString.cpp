@@ -16,3 +16,124 @@ TEST_CASE(strerror_r_basic)
     EXPECT_EQ(strerror_r(EFAULT, buf, sizeof(buf)), 0);
     EXPECT_EQ(strcmp(buf, "Bad address"), 0);
 }
+
+// The x86_64 versions of these handle different sizes and alignments in different ways,
+// so try all of the small ones, and a few around each boundary between them.
+static constexpr size_t sizes_to_check[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 80, 127, 128, 129, 255, 256, 1000, 2047, 2048, 2049, 5000 };
+static constexpr size_t buffer_size = 8192;
+
+static void fill_with_pattern(u8* buffer, size_t size, u8 seed)
+{
+    for (size_t i = 0; i < size; ++i)
+        buffer[i] = seed + i * 7;
+}
+
+TEST_CASE(memcpy_and_memset_sizes_and_alignments)
+{
+    static u8 source[buffer_size];
+    static u8 destination[buffer_size];
+    fill_with_pattern(source, buffer_size, 1);
+    for (auto size : sizes_to_check) {
+        for (size_t source_offset = 0; source_offset < 16; ++source_offset) {
+            for (size_t destination_offset = 0; destination_offset < 16; destination_offset += 3) {
+                fill_with_pattern(destination, buffer_size, 2);
+                EXPECT_EQ(memcpy(destination + destination_offset, source + source_offset, size), destination + destination_offset);
+                for (size_t i = 0; i < buffer_size; ++i) {
+                    u8 expected = i >= destination_offset && i < destination_offset + size ? source[i - destination_offset + source_offset] : (u8)(2 + i * 7);
+                    EXPECT_EQ(destination[i], expected);
+                }
+
+                EXPECT_EQ(memset(destination + destination_offset, 0xab, size), destination + destination_offset);
+                for (size_t i = 0; i < size; ++i)
+                    EXPECT_EQ(destination[destination_offset + i], 0xab);
+                EXPECT_EQ(destination[destination_offset + size], (u8)(2 + (destination_offset + size) * 7));
+            }
+        }
+    }
+}
+
+TEST_CASE(memmove_overlapping)
+{
+    static u8 buffer[buffer_size];
+    static u8 expected[buffer_size];
+    for (auto size : sizes_to_check) {
+        for (int distance : { -100, -17, -16, -1, 1, 5, 16, 33, 100 }) {
+            fill_with_pattern(buffer, buffer_size, 3);
+            fill_with_pattern(expected, buffer_size, 3);
+            size_t source_offset = 1500;
+            size_t destination_offset = source_offset + distance;
+            for (size_t i = 0; i < size; ++i)
+                expected[destination_offset + i] = buffer[source_offset + i];
+            memmove(buffer + destination_offset, buffer + source_offset, size);
+            EXPECT_EQ(__builtin_memcmp(buffer, expected, buffer_size), 0);
+        }
+    }
+}
+
+TEST_CASE(strlen_strchr_and_memchr)
+{
+    static char buffer[buffer_size];
+    for (auto size : sizes_to_check) {
+        for (size_t offset = 0; offset < 16; ++offset) {
+            __builtin_memset(buffer, 'a', buffer_size);
+            auto* string = buffer + offset;
+            string[size] = 0;
+            EXPECT_EQ(strlen(string), size);
+            EXPECT_EQ(strchr(string, 'b'), nullptr);
+            EXPECT_EQ(strchr(string, 0), string + size);
+            EXPECT_EQ(strchrnul(string, 'b'), string + size);
+            EXPECT_EQ(memchr(string, 0, size), nullptr);
+            EXPECT_EQ(memchr(string, 0, size + 1), string + size);
+            if (size == 0)
+                continue;
+            string[size - 1] = 'b';
+            EXPECT_EQ(strchr(string, 'b'), string + size - 1);
+            EXPECT_EQ(strchrnul(string, 'b'), string + size - 1);
+            EXPECT_EQ(memchr(string, 'b', size), string + size - 1);
+            EXPECT_EQ(memchr(string, 'b', size - 1), nullptr);
+        }
+    }
+}
+
+// Run these with "TestLibCString --bench" to compare implementations.
+static void benchmark_string_functions(size_t size, size_t iterations)
+{
+    auto* source = (char*)malloc(size + 1);
+    auto* destination = (char*)malloc(size + 1);
+    __builtin_memset(source, 'a', size);
+    source[size] = 0;
+    for (size_t i = 0; i < iterations; ++i) {
+        memcpy(destination, source, size);
+        memset(destination, i, size);
+        memmove(destination + size / 2, destination, size / 2);
+        EXPECT_EQ(strlen(source), size);
+        EXPECT_EQ(memchr(source, 'b', size), nullptr);
+    }
+    free(source);
+    free(destination);
+}
+
+BENCHMARK_CASE(string_functions_1b)
+{
+    benchmark_string_functions(1, 10'000'000);
+}
+
+BENCHMARK_CASE(string_functions_64b)
+{
+    benchmark_string_functions(64, 5'000'000);
+}
+
+BENCHMARK_CASE(string_functions_4kib)
+{
+    benchmark_string_functions(4 * KiB, 200'000);
+}
+
+BENCHMARK_CASE(string_functions_256kib)
+{
+    benchmark_string_functions(256 * KiB, 2000);
+}
+
+BENCHMARK_CASE(string_functions_16mib)
+{
+    benchmark_string_functions(16 * MiB, 20);
+}
@@ -35,6 +35,24 @@ static Crypto::SignedBigInteger bigint_signed_fibonacci(size_t n)
     return num1;
 }
 
+static Crypto::UnsignedBigInteger bigint_factorial(size_t n)
+{
+    Crypto::UnsignedBigInteger result(1);
+    for (size_t i = 2; i <= n; ++i)
+        result = result.multiplied_by(Crypto::UnsignedBigInteger { static_cast<u32>(i) });
+    return result;
+}
+
+static Crypto::UnsignedBigInteger random_bigint(size_t words)
+{
+    Vector<u32> result;
+    result.resize(words);
+    fill_with_random(result.data(), words * sizeof(u32));
+    // Keep the top word set, so that the number is as long as asked for.
+    result.last() |= 0x80000000;
+    return Crypto::UnsignedBigInteger(move(result));
+}
+
 TEST_CASE(test_bigint_fib500)
 {
     Vector<u32> result {
@@ -201,6 +219,48 @@ TEST_CASE(test_unsigned_bigint_multiplication_with_big_numbers2)
     EXPECT_EQ(result.words(), expected_result);
 }
 
+TEST_CASE(test_unsigned_bigint_multiplication_around_karatsuba_threshold)
+{
+    // Karatsuba kicks in at 48 words, and splits unbalanced numbers into pieces.
+    size_t lengths[] { 1, 2, 17, 32, 47, 48, 49, 64, 95, 96, 97, 128, 200 };
+    for (auto left_length : lengths) {
+        for (auto right_length : lengths) {
+            auto a = random_bigint(left_length);
+            auto b = random_bigint(right_length);
+            auto c = random_bigint(right_length);
+
+            auto product = a.multiplied_by(b);
+            EXPECT_EQ(product.trimmed_length(), product.length());
+            auto division = product.divided_by(b);
+            EXPECT_EQ(division.quotient, a);
+            EXPECT_EQ(division.remainder, Crypto::UnsignedBigInteger { 0 });
+            EXPECT_EQ(a.multiplied_by(b.plus(c)), product.plus(a.multiplied_by(c)));
+        }
+    }
+}
+
+TEST_CASE(test_unsigned_bigint_squaring)
+{
+    for (size_t length : { 1, 5, 47, 48, 49, 64, 100, 128, 257 }) {
+        auto a = random_bigint(length);
+        auto a_plus_one = a.plus(1);
+        // a * a takes the squaring path, a * (a + 1) - a doesn't.
+        EXPECT_EQ(a.multiplied_by(a), a.multiplied_by(a_plus_one).minus(a));
+        // An equal number in a different object is squared too.
+        auto copy = a;
+        EXPECT_EQ(a.multiplied_by(copy), a.multiplied_by(a_plus_one).minus(a));
+    }
+}
+
+TEST_CASE(test_unsigned_bigint_multiplication_of_factorials)
+{
+    // 700! built up one small factor at a time, and as 300! times the product of 301 to 700, which multiplies two big numbers.
+    Crypto::UnsignedBigInteger rest(1);
+    for (u32 i = 301; i <= 700; ++i)
+        rest = rest.multiplied_by(Crypto::UnsignedBigInteger { i });
+    EXPECT_EQ(bigint_factorial(300).multiplied_by(rest), bigint_factorial(700));
+}
+
 TEST_CASE(test_unsigned_bigint_simple_division)
 {
     Crypto::UnsignedBigInteger num1(27194);
@@ -330,6 +390,32 @@ TEST_CASE(test_bigint_modular_power_extra_tests)
     }
 }
 
+TEST_CASE(test_bigint_montgomery_modular_power_for_rsa_sizes)
+{
+    // The common sizes have their own kernels, the others use the generic ones.
+    for (size_t words : { 1, 7, 63, 64, 65, 96, 128 }) {
+        auto modulo = random_bigint(words);
+        modulo.set_bit_inplace(0);
+        auto base = random_bigint(words);
+        if (!(base < modulo))
+            base = base.minus(modulo);
+        auto exponent = random_bigint(2);
+
+        // Compare with the plain square-and-multiply.
+        Crypto::UnsignedBigInteger ep { exponent };
+        Crypto::UnsignedBigInteger base_copy { base };
+        Crypto::UnsignedBigInteger temp_1, temp_2, temp_3, temp_4, temp_multiply, temp_quotient, temp_remainder, expected;
+        Crypto::UnsignedBigIntegerAlgorithms::destructive_modular_power_without_allocation(ep, base_copy, modulo, temp_1, temp_2, temp_3, temp_4, temp_multiply, temp_quotient, temp_remainder, expected);
+        EXPECT_EQ(Crypto::NumberTheory::ModularPower(base, exponent, modulo), expected);
+
+        // Exponents as long as the modulo: x^a * x^b == x^(a + b).
+        auto a = random_bigint(words);
+        auto b = random_bigint(words);
+        auto product = Crypto::NumberTheory::ModularPower(base, a, modulo).multiplied_by(Crypto::NumberTheory::ModularPower(base, b, modulo)).divided_by(modulo).remainder;
+        EXPECT_EQ(product, Crypto::NumberTheory::ModularPower(base, a.plus(b), modulo));
+    }
+}
+
 TEST_CASE(test_bigint_primality_test)
 {
     struct {
@@ -603,3 +689,19 @@ TEST_CASE(test_signed_multiplication_with_two_big_numbers)
     EXPECT_EQ(result.unsigned_value().words(), expected_results);
     EXPECT(result.is_negative());
 }
+
+BENCHMARK_CASE(bigint_factorial)
+{
+    auto factorial = bigint_factorial(5000);
+    EXPECT_EQ(factorial.to_base(10).length(), 16326u);
+}
+
+BENCHMARK_CASE(bigint_modular_power_4096)
+{
+    auto modulo = random_bigint(128);
+    modulo.set_bit_inplace(0);
+    auto base = random_bigint(127);
+    auto exponent = random_bigint(128);
+    for (size_t i = 0; i < 5; ++i)
+        base = Crypto::NumberTheory::ModularPower(base, exponent, modulo);
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibCrypto/Curves/SECP256r1.h>
+#include <LibCrypto/Curves/X25519.h>
+#include <LibTest/TestCase.h>
+#include <cstring>
+
+// Test vectors from RFC 7748 section 6.1.
+TEST_CASE(test_x25519)
+{
+    u8 alice_private_key[] {
+        0x77, 0x07, 0x6d, 0x0a, 0x73, 0x18, 0xa5, 0x7d, 0x3c, 0x16, 0xc1, 0x72, 0x51, 0xb2, 0x66, 0x45,
+        0xdf, 0x4c, 0x2f, 0x87, 0xeb, 0xc0, 0x99, 0x2a, 0xb1, 0x77, 0xfb, 0xa5, 0x1d, 0xb9, 0x2c, 0x2a
+    };
+    u8 alice_public_key[] {
+        0x85, 0x20, 0xf0, 0x09, 0x89, 0x30, 0xa7, 0x54, 0x74, 0x8b, 0x7d, 0xdc, 0xb4, 0x3e, 0xf7, 0x5a,
+        0x0d, 0xbf, 0x3a, 0x0d, 0x26, 0x38, 0x1a, 0xf4, 0xeb, 0xa4, 0xa9, 0x8e, 0xaa, 0x9b, 0x4e, 0x6a
+    };
+    u8 bob_private_key[] {
+        0x5d, 0xab, 0x08, 0x7e, 0x62, 0x4a, 0x8a, 0x4b, 0x79, 0xe1, 0x7f, 0x8b, 0x83, 0x80, 0x0e, 0xe6,
+        0x6f, 0x3b, 0xb1, 0x29, 0x26, 0x18, 0xb6, 0xfd, 0x1c, 0x2f, 0x8b, 0x27, 0xff, 0x88, 0xe0, 0xeb
+    };
+    u8 bob_public_key[] {
+        0xde, 0x9e, 0xdb, 0x7d, 0x7b, 0x7d, 0xc1, 0xb4, 0xd3, 0x5b, 0x61, 0xc2, 0xec, 0xe4, 0x35, 0x37,
+        0x3f, 0x83, 0x43, 0xc8, 0x5b, 0x78, 0x67, 0x4d, 0xad, 0xfc, 0x7e, 0x14, 0x6f, 0x88, 0x2b, 0x4f
+    };
+    u8 shared_secret[] {
+        0x4a, 0x5d, 0x9d, 0x5b, 0xa4, 0xce, 0x2d, 0xe1, 0x72, 0x8e, 0x3b, 0xf4, 0x80, 0x35, 0x0f, 0x25,
+        0xe0, 0x7e, 0x21, 0xc9, 0x47, 0xd1, 0x9e, 0x33, 0x76, 0xf0, 0x9b, 0x3c, 0x1e, 0x16, 0x17, 0x42
+    };
+
+    Crypto::Curves::X25519 curve;
+    auto generated_alice_public_key = curve.generate_public_key({ alice_private_key, sizeof(alice_private_key) });
+    EXPECT(memcmp(generated_alice_public_key.data(), alice_public_key, sizeof(alice_public_key)) == 0);
+    auto generated_bob_public_key = curve.generate_public_key({ bob_private_key, sizeof(bob_private_key) });
+    EXPECT(memcmp(generated_bob_public_key.data(), bob_public_key, sizeof(bob_public_key)) == 0);
+
+    auto alice_shared_secret = curve.compute_shared_secret({ alice_private_key, sizeof(alice_private_key) }, { bob_public_key, sizeof(bob_public_key) });
+    EXPECT(alice_shared_secret.has_value());
+    EXPECT(memcmp(alice_shared_secret->data(), shared_secret, sizeof(shared_secret)) == 0);
+    auto bob_shared_secret = curve.compute_shared_secret({ bob_private_key, sizeof(bob_private_key) }, { alice_public_key, sizeof(alice_public_key) });
+    EXPECT(bob_shared_secret.has_value());
+    EXPECT(memcmp(bob_shared_secret->data(), shared_secret, sizeof(shared_secret)) == 0);
+}
+
+TEST_CASE(test_x25519_rejects_small_order_point)
+{
+    Crypto::Curves::X25519 curve;
+    auto private_key = curve.generate_private_key();
+    u8 zero_point[32] {};
+    EXPECT(!curve.compute_shared_secret(private_key, { zero_point, sizeof(zero_point) }).has_value());
+}
+
+TEST_CASE(test_secp256r1)
+{
+    u8 alice_private_key[] {
+        0x2b, 0x42, 0xe4, 0x13, 0x4b, 0xba, 0x85, 0x91, 0xce, 0x63, 0x47, 0xa1, 0x12, 0xe6, 0xff, 0x58,
+        0x02, 0x0a, 0x5f, 0x2d, 0x61, 0xdf, 0x35, 0x76, 0xa3, 0x69, 0x5c, 0x75, 0x6a, 0x74, 0xc9, 0xf0
+    };
+    u8 alice_public_key[] {
+        0x04, 0x72, 0x59, 0x2b, 0xaf, 0x99, 0xbd, 0x49, 0x4e, 0xc6, 0x52, 0x94, 0x03, 0x64, 0x57, 0x82,
+        0x29, 0x70, 0xa9, 0x79, 0x13, 0x35, 0xa8, 0x15, 0xcd, 0x4f, 0xe3, 0x11, 0xbf, 0xa1, 0x79, 0x35,
+        0xd1, 0x3f, 0xed, 0xf2, 0x7e, 0xbf, 0x87, 0xf0, 0x24, 0x02, 0xea, 0xd0, 0x62, 0x53, 0x12, 0xbf,
+        0xf6, 0x65, 0xb5, 0xc9, 0x92, 0xa1, 0x15, 0xf2, 0xa7, 0xe0, 0x4d, 0x18, 0xd1, 0x4b, 0x60, 0x9f,
+        0xbc
+    };
+    u8 bob_private_key[] {
+        0xde, 0x89, 0x40, 0xe8, 0x15, 0x1b, 0x8e, 0xa7, 0x8d, 0x27, 0xf9, 0x8a, 0x42, 0xb9, 0x6e, 0x41,
+        0xfb, 0x46, 0x2f, 0xb7, 0x2b, 0x73, 0x1a, 0xa7, 0x28, 0x41, 0xcd, 0xf9, 0x06, 0x93, 0x45, 0x0a
+    };
+    u8 bob_public_key[] {
+        0x04, 0x79, 0x96, 0x85, 0xba, 0x00, 0xf8, 0xd9, 0xde, 0xcc, 0xf0, 0x0c, 0xae, 0x46, 0x71, 0x27,
+        0xc4, 0xd3, 0x50, 0xf0, 0x51, 0x06, 0xde, 0xcf, 0x3f, 0x32, 0xd7, 0x05, 0xf0, 0x14, 0x4e, 0xf4,
+        0xa0, 0xc4, 0xc3, 0xe5, 0x85, 0xc3, 0x0b, 0x41, 0x84, 0x0e, 0xf2, 0xd0, 0xc2, 0xed, 0x36, 0x0d,
+        0x68, 0x74, 0x97, 0x4d, 0x11, 0x12, 0x2b, 0xf9, 0xd9, 0x93, 0xdb, 0xe9, 0x6c, 0x76, 0xaa, 0x21,
+        0xaf
+    };
+    u8 shared_secret[] {
+        0x0f, 0xed, 0x20, 0x04, 0x00, 0x69, 0x32, 0xbc, 0x60, 0x51, 0x1f, 0x06, 0xe5, 0xa1, 0xe9, 0x24,
+        0xb8, 0x43, 0x36, 0xcc, 0x25, 0x5d, 0x39, 0xa9, 0x3f, 0x41, 0x9a, 0x53, 0xaf, 0x31, 0x86, 0x6d
+    };
+
+    Crypto::Curves::SECP256r1 curve;
+    auto generated_alice_public_key = curve.generate_public_key({ alice_private_key, sizeof(alice_private_key) });
+    EXPECT(memcmp(generated_alice_public_key.data(), alice_public_key, sizeof(alice_public_key)) == 0);
+    auto generated_bob_public_key = curve.generate_public_key({ bob_private_key, sizeof(bob_private_key) });
+    EXPECT(memcmp(generated_bob_public_key.data(), bob_public_key, sizeof(bob_public_key)) == 0);
+
+    auto alice_shared_secret = curve.compute_shared_secret({ alice_private_key, sizeof(alice_private_key) }, { bob_public_key, sizeof(bob_public_key) });
+    EXPECT(alice_shared_secret.has_value());
+    EXPECT(memcmp(alice_shared_secret->data(), shared_secret, sizeof(shared_secret)) == 0);
+    auto bob_shared_secret = curve.compute_shared_secret({ bob_private_key, sizeof(bob_private_key) }, { alice_public_key, sizeof(alice_public_key) });
+    EXPECT(bob_shared_secret.has_value());
+    EXPECT(memcmp(bob_shared_secret->data(), shared_secret, sizeof(shared_secret)) == 0);
+}
+
+TEST_CASE(test_secp256r1_random_key_agreement)
+{
+    Crypto::Curves::SECP256r1 curve;
+    for (size_t i = 0; i < 4; ++i) {
+        auto alice_private_key = curve.generate_private_key();
+        auto bob_private_key = curve.generate_private_key();
+        auto alice_secret = curve.compute_shared_secret(alice_private_key, curve.generate_public_key(bob_private_key));
+        auto bob_secret = curve.compute_shared_secret(bob_private_key, curve.generate_public_key(alice_private_key));
+        EXPECT(alice_secret.has_value());
+        EXPECT(bob_secret.has_value());
+        EXPECT(alice_secret->bytes() == bob_secret->bytes());
+    }
+}
+
+TEST_CASE(test_secp256r1_rejects_invalid_points)
+{
+    Crypto::Curves::SECP256r1 curve;
+    auto private_key = curve.generate_private_key();
+    auto public_key = curve.generate_public_key(curve.generate_private_key());
+
+    // Not on the curve.
+    auto tampered = ByteBuffer::copy(public_key.bytes());
+    tampered[64] ^= 1;
+    EXPECT(!curve.compute_shared_secret(private_key, tampered).has_value());
+
+    // Compressed encodings are not supported.
+    EXPECT(!curve.compute_shared_secret(private_key, public_key.bytes().trim(33)).has_value());
+
+    // Coordinates must be below p.
+    auto out_of_range = ByteBuffer::copy(public_key.bytes());
+    memset(out_of_range.offset_pointer(1), 0xff, 32);
+    EXPECT(!curve.compute_shared_secret(private_key, out_of_range).has_value());
+}
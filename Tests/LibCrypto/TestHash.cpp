@@ -166,6 +166,35 @@ TEST_CASE(test_SHA256_hash_empty_string)
     EXPECT(memcmp(result, digest.data, Crypto::Hash::SHA256::digest_size()) == 0);
 }
 
+TEST_CASE(test_SHA256_hash_many)
+{
+    // Nothing to hash, and nothing to write.
+    Crypto::Hash::SHA256::hash_many({}, {});
+
+    // More messages than there are lanes, with lengths around the block and padding boundaries,
+    // so that the lanes finish at different times.
+    Vector<ByteBuffer> buffers;
+    for (size_t length : { 0, 1, 3, 55, 56, 57, 63, 64, 65, 100, 119, 120, 128, 200, 1000, 4096, 17, 0, 64, 333 }) {
+        auto buffer = ByteBuffer::create_uninitialized(length);
+        for (size_t i = 0; i < length; ++i)
+            buffer[i] = (u8)(i * 7 + length);
+        buffers.append(move(buffer));
+    }
+
+    for (size_t count : { (size_t)1, (size_t)2, (size_t)8, (size_t)9, buffers.size() }) {
+        Vector<ReadonlyBytes> messages;
+        for (size_t i = 0; i < count; ++i)
+            messages.append(buffers[i]);
+        Vector<Crypto::Hash::SHA256::DigestType> digests;
+        digests.resize(count);
+        Crypto::Hash::SHA256::hash_many(messages, digests);
+        for (size_t i = 0; i < count; ++i) {
+            auto digest = Crypto::Hash::SHA256::hash(messages[i].data(), messages[i].size());
+            EXPECT(memcmp(digest.data, digests[i].data, Crypto::Hash::SHA256::digest_size()) == 0);
+        }
+    }
+}
+
 TEST_CASE(test_SHA384_name)
 {
     Crypto::Hash::SHA384 sha;
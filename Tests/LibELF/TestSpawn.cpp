@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <LibCore/DirIterator.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static int spawn_and_wait(Vector<char const*> arguments, char** environment = environ)
+{
+    arguments.append(nullptr);
+
+    posix_spawn_file_actions_t file_actions;
+    posix_spawn_file_actions_init(&file_actions);
+    posix_spawn_file_actions_addopen(&file_actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&file_actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    pid_t pid;
+    int rc = posix_spawn(&pid, arguments[0], &file_actions, nullptr, const_cast<char**>(arguments.data()), environment);
+    posix_spawn_file_actions_destroy(&file_actions);
+    if (rc != 0)
+        return -1;
+
+    int status;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status))
+        return -1;
+    return WEXITSTATUS(status);
+}
+
+static void benchmark_spawn(Vector<char const*> const& arguments)
+{
+    constexpr size_t spawns = 200;
+
+    // The first start saves the symbol lookups for the ones after it.
+    EXPECT_EQ(spawn_and_wait(arguments), 0);
+
+    Core::ElapsedTimer timer;
+    timer.start();
+    for (size_t i = 0; i < spawns; ++i)
+        spawn_and_wait(arguments);
+    auto elapsed = timer.elapsed();
+    outln("{}: {} spawns in {} ms, {} us each", arguments[0], spawns, elapsed, elapsed * 1000 / spawns);
+}
+
+TEST_CASE(startup_cache_is_saved)
+{
+    EXPECT_EQ(spawn_and_wait({ "/bin/true" }), 0);
+
+    bool found = false;
+    Core::DirIterator iterator("/var/cache/ld", Core::DirIterator::SkipDots);
+    while (iterator.has_next()) {
+        if (iterator.next_path().starts_with("true-"))
+            found = true;
+    }
+    EXPECT(found);
+
+    // Starting from the cache has to work as well.
+    EXPECT_EQ(spawn_and_wait({ "/bin/true" }), 0);
+}
+
+TEST_CASE(bind_now_from_environment)
+{
+    char const* environment[] = { "LD_BIND_NOW=1", nullptr };
+    EXPECT_EQ(spawn_and_wait({ "/bin/ls", "/" }, const_cast<char**>(environment)), 0);
+}
+
+BENCHMARK_CASE(spawn_true)
+{
+    benchmark_spawn({ "/bin/true" });
+}
+
+BENCHMARK_CASE(spawn_ls)
+{
+    benchmark_spawn({ "/bin/ls", "/" });
+}
+
+BENCHMARK_CASE(spawn_gui_application)
+{
+    // Everything up to and including the argument parsing, which needs all of LibGUI to be loaded and initialized.
+    benchmark_spawn({ "/bin/TextEditor", "--help" });
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibTest/TestCase.h>
+
+#include <AK/Array.h>
+#include <AK/Random.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibGfx/DisjointRectSet.h>
+
+static constexpr int grid_size = 48;
+
+using Grid = Array<Array<bool, grid_size>, grid_size>;
+
+static Grid grid_of(Gfx::DisjointRectSet const& set)
+{
+    Grid grid {};
+    for (auto& rect : set.rects()) {
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            for (int x = rect.left(); x <= rect.right(); ++x) {
+                // No pixel may be covered twice.
+                EXPECT(!grid[y][x]);
+                grid[y][x] = true;
+            }
+        }
+    }
+    return grid;
+}
+
+static void expect_banded(Gfx::DisjointRectSet const& set)
+{
+    auto& rects = set.rects();
+    for (size_t i = 1; i < rects.size(); ++i) {
+        auto& previous = rects[i - 1];
+        auto& rect = rects[i];
+        if (rect.top() == previous.top()) {
+            EXPECT_EQ(rect.height(), previous.height());
+            // Rects in a band are sorted and don't touch.
+            EXPECT(rect.left() > previous.right() + 1);
+        } else {
+            EXPECT(rect.top() > previous.bottom());
+        }
+    }
+}
+
+static Gfx::IntRect random_rect()
+{
+    int x = get_random_uniform(grid_size);
+    int y = get_random_uniform(grid_size);
+    int width = 1 + get_random_uniform(grid_size - x);
+    int height = 1 + get_random_uniform(grid_size - y);
+    return { x, y, width, height };
+}
+
+static Gfx::DisjointRectSet random_set(Grid& grid)
+{
+    Gfx::DisjointRectSet set;
+    auto count = get_random_uniform(8);
+    for (u32 i = 0; i < count; ++i) {
+        auto rect = random_rect();
+        set.add(rect);
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            for (int x = rect.left(); x <= rect.right(); ++x)
+                grid[y][x] = true;
+        }
+    }
+    return set;
+}
+
+TEST_CASE(banded_form)
+{
+    Gfx::DisjointRectSet set;
+    set.add({ 0, 0, 10, 10 });
+    set.add({ 5, 5, 10, 10 });
+    EXPECT_EQ(set.size(), 3u);
+    expect_banded(set);
+
+    // Adding the missing corners makes it a single rect again.
+    set.add({ 10, 0, 5, 5 });
+    set.add({ 0, 10, 5, 5 });
+    EXPECT_EQ(set.size(), 1u);
+    EXPECT_EQ(set.rects()[0], Gfx::IntRect(0, 0, 15, 15));
+
+    auto hole = set.shatter(Gfx::IntRect { 5, 5, 5, 5 });
+    EXPECT_EQ(hole.size(), 4u);
+    expect_banded(hole);
+    EXPECT(hole.contains({ 0, 0, 15, 5 }));
+    EXPECT(!hole.contains({ 0, 0, 15, 6 }));
+    EXPECT(!hole.intersects(Gfx::IntRect { 5, 5, 5, 5 }));
+
+    Gfx::DisjointRectSet empty(Gfx::IntRect { 3, 3, 0, 10 });
+    EXPECT(empty.is_empty());
+}
+
+TEST_CASE(operations_match_pixels)
+{
+    for (size_t run = 0; run < 500; ++run) {
+        Grid a_pixels {};
+        Grid b_pixels {};
+        auto a = random_set(a_pixels);
+        auto b = random_set(b_pixels);
+        expect_banded(a);
+        EXPECT(grid_of(a) == a_pixels);
+
+        auto united = a.clone();
+        united.add(b);
+        auto intersected = a.intersected(b);
+        auto subtracted = a.shatter(b);
+        expect_banded(united);
+        expect_banded(intersected);
+        expect_banded(subtracted);
+
+        auto united_pixels = grid_of(united);
+        auto intersected_pixels = grid_of(intersected);
+        auto subtracted_pixels = grid_of(subtracted);
+        bool any_shared = false;
+        for (int y = 0; y < grid_size; ++y) {
+            for (int x = 0; x < grid_size; ++x) {
+                EXPECT_EQ(united_pixels[y][x], a_pixels[y][x] || b_pixels[y][x]);
+                EXPECT_EQ(intersected_pixels[y][x], a_pixels[y][x] && b_pixels[y][x]);
+                EXPECT_EQ(subtracted_pixels[y][x], a_pixels[y][x] && !b_pixels[y][x]);
+                any_shared |= a_pixels[y][x] && b_pixels[y][x];
+            }
+        }
+        EXPECT_EQ(a.intersects(b), any_shared);
+
+        auto rect = random_rect();
+        bool rect_is_covered = true;
+        bool rect_is_touched = false;
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            for (int x = rect.left(); x <= rect.right(); ++x) {
+                rect_is_covered &= a_pixels[y][x];
+                rect_is_touched |= a_pixels[y][x];
+            }
+        }
+        EXPECT_EQ(a.contains(rect), rect_is_covered);
+        EXPECT_EQ(a.intersects(rect), rect_is_touched);
+        size_t touched_pixels = 0;
+        a.for_each_intersected(rect, [&](auto& intersected_rect) {
+            EXPECT(rect.contains(intersected_rect));
+            touched_pixels += intersected_rect.width() * intersected_rect.height();
+            return IterationDecision::Continue;
+        });
+        size_t expected_pixels = 0;
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            for (int x = rect.left(); x <= rect.right(); ++x)
+                expected_pixels += a_pixels[y][x];
+        }
+        EXPECT_EQ(touched_pixels, expected_pixels);
+
+        // The same set always ends up with the same rects, no matter how it was put together.
+        Gfx::DisjointRectSet rebuilt;
+        rebuilt.add_many(subtracted.rects());
+        rebuilt.add(intersected);
+        EXPECT(rebuilt.rects() == a.rects());
+    }
+}
+
+BENCHMARK_CASE(occlusions_of_many_windows)
+{
+    // Roughly what Compositor::recompute_occlusions() and compose() do: 200 overlapping windows are walked
+    // from front to back, and the damage is spread out over the whole screen.
+    constexpr int window_count = 200;
+    Gfx::IntRect screen_rect { 0, 0, 1920, 1080 };
+    Vector<Gfx::IntRect> windows;
+    for (int i = 0; i < window_count; ++i) {
+        int width = 200 + get_random_uniform(600);
+        int height = 150 + get_random_uniform(450);
+        windows.append({ (int)get_random_uniform(screen_rect.width() - width), (int)get_random_uniform(screen_rect.height() - height), width, height });
+    }
+    Vector<Gfx::IntRect> damage;
+    for (int i = 0; i < 400; ++i)
+        damage.append({ (int)get_random_uniform(screen_rect.width() - 40), (int)get_random_uniform(screen_rect.height() - 20), 5 + (int)get_random_uniform(35), 5 + (int)get_random_uniform(15) });
+
+    Core::ElapsedTimer timer;
+    timer.start();
+    size_t visible_rect_count = 0;
+    size_t dirty_rect_count = 0;
+    for (int frame = 0; frame < 10; ++frame) {
+        Gfx::DisjointRectSet remaining(screen_rect);
+        Vector<Gfx::DisjointRectSet> visible_rects;
+        for (auto& window : windows) {
+            visible_rects.append(remaining.intersected(window));
+            remaining = remaining.shatter(window);
+        }
+
+        Gfx::DisjointRectSet dirty_rects;
+        for (auto& rect : damage)
+            dirty_rects.add(rect);
+        for (auto& visible : visible_rects) {
+            visible_rect_count += visible.size();
+            visible.for_each_intersected(dirty_rects, [&](auto&) {
+                ++dirty_rect_count;
+                return IterationDecision::Continue;
+            });
+        }
+    }
+    outln("10 frames in {} ms, {} visible rects, {} dirty rects", timer.elapsed(), visible_rect_count, dirty_rect_count);
+}
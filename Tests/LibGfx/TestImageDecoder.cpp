@@ -6,6 +6,7 @@
  */
 
 #include <AK/String.h>
+#include <LibGfx/Bitmap.h>
 #include <LibGfx/BMPLoader.h>
 #include <LibGfx/GIFLoader.h>
 #include <LibGfx/ICOLoader.h>
@@ -14,6 +15,7 @@
 #include <LibGfx/PBMLoader.h>
 #include <LibGfx/PGMLoader.h>
 #include <LibGfx/PNGLoader.h>
+#include <LibGfx/PNGWriter.h>
 #include <LibGfx/PPMLoader.h>
 #include <LibTest/TestCase.h>
 #include <stdio.h>
@@ -121,6 +123,112 @@ TEST_CASE(test_png)
     EXPECT(frame.duration == 0);
 }
 
+TEST_CASE(test_png_round_trip)
+{
+    // Large enough to span several stored deflate blocks, and thus several IDAT chunks.
+    auto bitmap = Gfx::Bitmap::try_create(Gfx::BitmapFormat::BGRA8888, { 173, 131 });
+    EXPECT(bitmap);
+    for (int y = 0; y < bitmap->height(); ++y) {
+        for (int x = 0; x < bitmap->width(); ++x)
+            bitmap->set_pixel(x, y, Gfx::Color(x, y, x ^ y, 255 - x));
+    }
+
+    auto encoded = Gfx::PNGWriter::encode(*bitmap);
+    auto decoded = Gfx::load_png_from_memory(encoded.data(), encoded.size());
+    EXPECT(decoded);
+    EXPECT_EQ(decoded->size(), bitmap->size());
+    for (int y = 0; y < bitmap->height(); ++y) {
+        for (int x = 0; x < bitmap->width(); ++x)
+            EXPECT_EQ(decoded->get_pixel(x, y), bitmap->get_pixel(x, y));
+    }
+}
+
+static u8 paeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc)
+        return a;
+    return pb <= pc ? b : c;
+}
+
+// Builds a 7x5 RGB or RGBA image where row N uses filter type N, stored uncompressed.
+static void test_png_filters_with_bytes_per_pixel(int bpp)
+{
+    constexpr int width = 7, height = 5;
+    const int row_size = width * bpp;
+    u8 raw[height][width * 4];
+    for (int y = 0; y < height; ++y) {
+        for (int i = 0; i < row_size; ++i)
+            raw[y][i] = (y * 71 + i * 37) ^ (i * 5);
+    }
+
+    ByteBuffer image_data;
+    for (int y = 0; y < height; ++y) {
+        u8 filter = y;
+        image_data.append(&filter, 1);
+        for (int i = 0; i < row_size; ++i) {
+            int a = i >= bpp ? raw[y][i - bpp] : 0;
+            int b = y > 0 ? raw[y - 1][i] : 0;
+            int c = i >= bpp && y > 0 ? raw[y - 1][i - bpp] : 0;
+            int predictor = 0;
+            if (filter == 1)
+                predictor = a;
+            else if (filter == 2)
+                predictor = b;
+            else if (filter == 3)
+                predictor = (a + b) / 2;
+            else if (filter == 4)
+                predictor = paeth(a, b, c);
+            u8 value = raw[y][i] - predictor;
+            image_data.append(&value, 1);
+        }
+    }
+
+    ByteBuffer png;
+    auto append_chunk = [&](const char* type, ReadonlyBytes data) {
+        u8 length[4] = { 0, 0, (u8)(data.size() >> 8), (u8)data.size() };
+        png.append(length, 4);
+        png.append(type, 4);
+        png.append(data.data(), data.size());
+        u8 crc[4] = {}; // Not verified by the decoder.
+        png.append(crc, 4);
+    };
+
+    const u8 header[8] = { 0x89, 'P', 'N', 'G', 13, 10, 26, 10 };
+    png.append(header, sizeof(header));
+    const u8 ihdr[13] = { 0, 0, 0, width, 0, 0, 0, height, 8, (u8)(bpp == 4 ? 6 : 2), 0, 0, 0 };
+    append_chunk("IHDR", { ihdr, sizeof(ihdr) });
+
+    // Split the zlib stream across two IDAT chunks to exercise the chunk boundaries.
+    ByteBuffer zlib_data;
+    u16 length = image_data.size();
+    u16 nlength = ~length;
+    const u8 zlib_header[7] = { 0x78, 0x01, 1, (u8)length, (u8)(length >> 8), (u8)nlength, (u8)(nlength >> 8) };
+    zlib_data.append(zlib_header, sizeof(zlib_header));
+    zlib_data.append(image_data.data(), image_data.size());
+    const u8 adler[4] = {}; // Not verified by the decoder.
+    zlib_data.append(adler, sizeof(adler));
+    append_chunk("IDAT", zlib_data.bytes().trim(20));
+    append_chunk("IDAT", zlib_data.bytes().slice(20));
+    append_chunk("IEND", {});
+
+    auto decoded = Gfx::load_png_from_memory(png.data(), png.size());
+    EXPECT(decoded);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            auto* pixel = &raw[y][x * bpp];
+            EXPECT_EQ(decoded->get_pixel(x, y), Gfx::Color(pixel[0], pixel[1], pixel[2], bpp == 4 ? pixel[3] : 255));
+        }
+    }
+}
+
+TEST_CASE(test_png_filters)
+{
+    test_png_filters_with_bytes_per_pixel(3);
+    test_png_filters_with_bytes_per_pixel(4);
+}
+
 TEST_CASE(test_ppm)
 {
     auto image = Gfx::load_ppm("/res/html/misc/ppmsuite_files/buggie-raw.ppm");
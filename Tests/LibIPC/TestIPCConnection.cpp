@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include "TestClientEndpoint.h"
+#include "TestServerEndpoint.h"
+#include <AK/String.h>
+#include <LibCore/EventLoop.h>
+#include <LibCore/LocalServer.h>
+#include <LibIPC/ClientConnection.h>
+#include <LibIPC/ServerConnection.h>
+#include <LibTest/TestCase.h>
+#include <unistd.h>
+
+// Both ends of a connection over the synthetic TestServer endpoint. Set LIBIPC_NO_SHARED_MEMORY
+// to compare the benchmarks against the plain socket transport.
+
+class ConnectionFromClient final : public IPC::ClientConnection<TestClientEndpoint, TestServerEndpoint> {
+    C_OBJECT(ConnectionFromClient);
+
+public:
+    virtual void die() override { Core::EventLoop::current().quit(0); }
+
+private:
+    explicit ConnectionFromClient(NonnullRefPtr<Core::LocalSocket> socket)
+        : IPC::ClientConnection<TestClientEndpoint, TestServerEndpoint>(*this, move(socket), 1)
+    {
+    }
+
+    virtual Messages::TestServer::PingResponse ping(i32 value) override { return value + 1; }
+
+    virtual void post_payload(ByteBuffer const& payload) override
+    {
+        ++m_payload_count;
+        m_payload_total_size += payload.size();
+    }
+
+    virtual Messages::TestServer::PayloadStatisticsResponse payload_statistics() override
+    {
+        return { m_payload_count, m_payload_total_size };
+    }
+
+    virtual void flood_client(u32 count, u32 size) override
+    {
+        auto payload = ByteBuffer::create_zeroed(size);
+        for (u32 i = 0; i < count; ++i)
+            async_receive_payload(payload);
+    }
+
+    u32 m_payload_count { 0 };
+    u64 m_payload_total_size { 0 };
+};
+
+class TestServerConnection final : public IPC::ServerConnection<TestClientEndpoint, TestServerEndpoint> {
+    C_OBJECT(TestServerConnection);
+
+public:
+    u32 received_payload_count() const { return m_received_payload_count; }
+
+private:
+    explicit TestServerConnection(String const& address)
+        : IPC::ServerConnection<TestClientEndpoint, TestServerEndpoint>(*this, address)
+    {
+    }
+
+    virtual void receive_payload(ByteBuffer const&) override { ++m_received_payload_count; }
+
+    u32 m_received_payload_count { 0 };
+};
+
+static void run_server(String const& address, int ready_fd)
+{
+    Core::EventLoop loop;
+    auto server = Core::LocalServer::construct();
+    VERIFY(server->listen(address));
+
+    RefPtr<ConnectionFromClient> client;
+    server->on_ready_to_accept = [&] {
+        client = ConnectionFromClient::construct(server->accept().release_nonnull());
+        unlink(address.characters());
+    };
+
+    char ready = 1;
+    VERIFY(write(ready_fd, &ready, 1) == 1);
+    close(ready_fd);
+    _exit(loop.exec());
+}
+
+static TestServerConnection& connection()
+{
+    static RefPtr<TestServerConnection> s_connection;
+    if (s_connection)
+        return *s_connection;
+
+    auto address = String::formatted("/tmp/TestIPCConnection.{}", getpid());
+    int ready_fds[2];
+    VERIFY(pipe(ready_fds) == 0);
+    if (fork() == 0) {
+        close(ready_fds[0]);
+        run_server(address, ready_fds[1]);
+    }
+    close(ready_fds[1]);
+    char ready = 0;
+    VERIFY(read(ready_fds[0], &ready, 1) == 1);
+    close(ready_fds[0]);
+
+    static Core::EventLoop* s_event_loop = new Core::EventLoop;
+    (void)s_event_loop;
+    s_connection = TestServerConnection::construct(address);
+    return *s_connection;
+}
+
+TEST_CASE(synchronous_round_trip)
+{
+    for (i32 i = 0; i < 1000; ++i)
+        EXPECT_EQ(connection().ping(i), i + 1);
+}
+
+TEST_CASE(asynchronous_messages_arrive_in_order)
+{
+    auto before = connection().payload_statistics();
+
+    // Large enough to wrap around the shared memory ring many times, with some messages that don't fit into it at all.
+    u64 total_size = 0;
+    for (size_t i = 0; i < 2000; ++i) {
+        size_t size = i % 100 == 0 ? 300 * KiB : i;
+        connection().async_post_payload(ByteBuffer::create_zeroed(size));
+        total_size += size;
+    }
+
+    auto after = connection().payload_statistics();
+    EXPECT_EQ(after.count() - before.count(), 2000u);
+    EXPECT_EQ(after.total_size() - before.total_size(), total_size);
+}
+
+TEST_CASE(both_sides_flooding_each_other)
+{
+    // Each side sends more than the high-water mark at the other, so the server stops reading from us
+    // while we wait for it to catch up. We have to keep reading what it sends, or neither side gets anywhere.
+    constexpr u32 count = 64;
+    constexpr u32 size = 64 * KiB;
+    static_assert(count * size > 2 * IPC::ConnectionBase::default_outgoing_high_water_mark);
+
+    auto received_before = connection().received_payload_count();
+    auto before = connection().payload_statistics();
+    connection().async_flood_client(count, size);
+    for (u32 i = 0; i < count; ++i)
+        connection().async_post_payload(ByteBuffer::create_zeroed(size));
+
+    auto after = connection().payload_statistics();
+    EXPECT_EQ(after.count() - before.count(), count);
+    EXPECT_EQ(after.total_size() - before.total_size(), (u64)count * size);
+
+    // What we received while waiting is handled from the event loop.
+    while (connection().received_payload_count() - received_before < count)
+        Core::EventLoop::current().pump();
+    EXPECT_EQ(connection().received_payload_count() - received_before, count);
+}
+
+BENCHMARK_CASE(round_trip_latency)
+{
+    for (i32 i = 0; i < 100000; ++i) {
+        EXPECT_EQ(connection().ping(i), i + 1);
+        // Like a real client would, so that deferred work doesn't pile up.
+        Core::EventLoop::current().pump(Core::EventLoop::WaitMode::PollForEvents);
+    }
+}
+
+BENCHMARK_CASE(message_throughput)
+{
+    auto payload = ByteBuffer::create_zeroed(64);
+    for (size_t i = 0; i < 1000000; ++i)
+        connection().async_post_payload(payload);
+    (void)connection().payload_statistics();
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibIPC/SharedMemoryTransport.h>
+#include <LibTest/TestCase.h>
+#include <string.h>
+
+static constexpr size_t small_capacity = 4 * KiB;
+
+static Vector<u8> make_pattern(size_t size, u8 seed)
+{
+    Vector<u8> bytes;
+    for (size_t i = 0; i < size; ++i)
+        bytes.append(static_cast<u8>(seed + i * 7));
+    return bytes;
+}
+
+TEST_CASE(round_trip_in_both_directions)
+{
+    auto client = IPC::SharedMemoryTransport::create(small_capacity);
+    EXPECT(client);
+    auto server = IPC::SharedMemoryTransport::adopt(client->buffer());
+    EXPECT(server);
+
+    auto request = make_pattern(100, 1);
+    EXPECT_EQ(client->write(request.span()), 100u);
+    Vector<u8> received;
+    EXPECT(server->read(received));
+    EXPECT(received == request);
+
+    auto reply = make_pattern(200, 2);
+    EXPECT_EQ(server->write(reply.span()), 200u);
+    received.clear();
+    EXPECT(client->read(received));
+    EXPECT(received == reply);
+
+    // Nothing was left behind in either ring.
+    received.clear();
+    EXPECT(client->read(received));
+    EXPECT(server->read(received));
+    EXPECT(received.is_empty());
+}
+
+TEST_CASE(wrap_around)
+{
+    auto client = IPC::SharedMemoryTransport::create(small_capacity);
+    auto server = IPC::SharedMemoryTransport::adopt(client->buffer());
+
+    for (size_t i = 0; i < 10; ++i) {
+        auto bytes = make_pattern(3000, i);
+        EXPECT_EQ(client->write(bytes.span()), 3000u);
+        Vector<u8> received;
+        EXPECT(server->read(received));
+        EXPECT(received == bytes);
+    }
+}
+
+TEST_CASE(full_ring)
+{
+    auto client = IPC::SharedMemoryTransport::create(small_capacity);
+    auto server = IPC::SharedMemoryTransport::adopt(client->buffer());
+
+    auto bytes = make_pattern(small_capacity + 100, 3);
+    EXPECT_EQ(client->write(bytes.span()), small_capacity);
+    EXPECT_EQ(client->write(bytes.span().slice(small_capacity)), 0u);
+    EXPECT(!client->wait_for_space(1));
+
+    Vector<u8> received;
+    EXPECT(server->read(received));
+    EXPECT(client->wait_for_space(1));
+    EXPECT_EQ(client->write(bytes.span().slice(small_capacity)), 100u);
+    EXPECT(server->read(received));
+    EXPECT(received == bytes);
+}
+
+TEST_CASE(wakeup_requests)
+{
+    auto client = IPC::SharedMemoryTransport::create(small_capacity);
+    auto server = IPC::SharedMemoryTransport::adopt(client->buffer());
+    auto bytes = make_pattern(16, 4);
+
+    // The server starts out asleep, but only needs to be woken up once.
+    client->write(bytes.span());
+    EXPECT(client->take_peer_wakeup_request());
+    client->write(bytes.span());
+    EXPECT(!client->take_peer_wakeup_request());
+
+    // It can't go to sleep while there is unread data.
+    EXPECT(!server->prepare_to_sleep());
+    Vector<u8> received;
+    EXPECT(server->read(received));
+    EXPECT(server->prepare_to_sleep());
+
+    client->write(bytes.span());
+    EXPECT(client->take_peer_wakeup_request());
+}
+
+TEST_CASE(reject_invalid_buffers)
+{
+    EXPECT(!IPC::SharedMemoryTransport::adopt({}));
+    EXPECT(!IPC::SharedMemoryTransport::adopt(Core::AnonymousBuffer::create_with_size(64 * KiB)));
+
+    auto client = IPC::SharedMemoryTransport::create(small_capacity);
+    auto buffer = client->buffer();
+    memset(buffer.data<u8>(), 0xff, sizeof(u32));
+    EXPECT(!IPC::SharedMemoryTransport::adopt(buffer));
+}
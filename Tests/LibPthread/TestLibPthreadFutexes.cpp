@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <AK/Vector.h>
+#include <LibPthread/pthread.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <limits.h>
+#include <serenity.h>
+#include <time.h>
+#include <unistd.h>
+
+TEST_CASE(private_futex_wait_checks_the_value)
+{
+    u32 value = 1;
+    EXPECT_EQ(futex_wait(&value, 2, nullptr, CLOCK_MONOTONIC), -1);
+    EXPECT_EQ(errno, EAGAIN);
+    EXPECT_EQ(futex_wake(&value, 1), 0);
+}
+
+TEST_CASE(private_futex_wait_times_out)
+{
+    u32 value = 1;
+    timespec timeout;
+    clock_gettime(CLOCK_MONOTONIC, &timeout);
+    timeout.tv_nsec += 10'000'000;
+    if (timeout.tv_nsec >= 1'000'000'000) {
+        timeout.tv_sec++;
+        timeout.tv_nsec -= 1'000'000'000;
+    }
+    EXPECT_EQ(futex_wait(&value, 1, &timeout, CLOCK_MONOTONIC), -1);
+    EXPECT_EQ(errno, ETIMEDOUT);
+}
+
+static void* wait_for_value_to_change(void* argument)
+{
+    auto* value = static_cast<u32*>(argument);
+    while (AK::atomic_load(value) == 0)
+        futex_wait(value, 0, nullptr, CLOCK_MONOTONIC);
+    return nullptr;
+}
+
+TEST_CASE(private_futex_requeue_moves_waiters)
+{
+    constexpr size_t thread_count = 4;
+    u32 first = 0;
+    u32 second = 0;
+    pthread_t threads[thread_count];
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_create(&thread, nullptr, wait_for_value_to_change, &first), 0);
+
+    // Give them a chance to go to sleep, any that don't will see the new value anyway.
+    usleep(100'000);
+
+    // Wake nobody, and move everyone over to the second futex. Waking the first one afterwards finds no one.
+    AK::atomic_store(&first, 1u);
+    int requeued = futex(&first, FUTEX_CMP_REQUEUE | FUTEX_PRIVATE_FLAG, 0, (const timespec*)(uintptr_t)INT_MAX, &second, 1);
+    EXPECT(requeued >= 0 && requeued <= (int)thread_count);
+    EXPECT_EQ(futex_wake(&first, INT_MAX), 0);
+
+    // They are all waiting on the second one now, and leave once they see the first one has changed.
+    EXPECT_EQ(futex_wake(&second, INT_MAX), requeued);
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_join(thread, nullptr), 0);
+}
+
+struct Counter {
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+    size_t increments_per_thread { 0 };
+    size_t value { 0 };
+    bool go { false };
+};
+
+static void* increment_counter(void* argument)
+{
+    auto& counter = *static_cast<Counter*>(argument);
+
+    pthread_mutex_lock(&counter.mutex);
+    while (!counter.go)
+        pthread_cond_wait(&counter.cond, &counter.mutex);
+    pthread_mutex_unlock(&counter.mutex);
+
+    for (size_t i = 0; i < counter.increments_per_thread; ++i) {
+        pthread_mutex_lock(&counter.mutex);
+        ++counter.value;
+        pthread_mutex_unlock(&counter.mutex);
+    }
+    return nullptr;
+}
+
+// Starts the threads, releases all of them at once with a broadcast and returns how long they took in microseconds.
+static u64 run_contended_counter(size_t thread_count, size_t increments_per_thread)
+{
+    Counter counter;
+    counter.increments_per_thread = increments_per_thread;
+
+    Vector<pthread_t> threads;
+    threads.resize(thread_count);
+    for (auto& thread : threads)
+        VERIFY(pthread_create(&thread, nullptr, increment_counter, &counter) == 0);
+
+    timespec start;
+    pthread_mutex_lock(&counter.mutex);
+    counter.go = true;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_cond_broadcast(&counter.cond);
+    pthread_mutex_unlock(&counter.mutex);
+
+    for (auto& thread : threads)
+        VERIFY(pthread_join(thread, nullptr) == 0);
+    timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    VERIFY(counter.value == thread_count * increments_per_thread);
+    return (end.tv_sec - start.tv_sec) * 1'000'000 + (end.tv_nsec - start.tv_nsec) / 1000;
+}
+
+TEST_CASE(contended_mutex_loses_no_increments)
+{
+    // run_contended_counter() checks the total.
+    run_contended_counter(8, 10'000);
+}
+
+BENCHMARK_CASE(contended_mutex_throughput)
+{
+    constexpr size_t increments_per_thread = 100'000;
+    for (size_t thread_count : { 1, 2, 4, 8, 16 }) {
+        auto elapsed = max(run_contended_counter(thread_count, increments_per_thread), (u64)1);
+        auto total = thread_count * increments_per_thread;
+        outln("{:>2} threads: {} lock/unlock pairs in {} us, {} per second", thread_count, total, elapsed, total * 1'000'000 / elapsed);
+    }
+}
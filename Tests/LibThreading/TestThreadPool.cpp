@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <AK/Atomic.h>
+#include <AK/String.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibCore/EventLoop.h>
+#include <LibTest/TestCase.h>
+#include <LibThreading/ThreadPool.h>
+
+TEST_CASE(parallel_for_visits_every_index_once)
+{
+    static Array<Atomic<u32>, 10000> visits;
+    Threading::ThreadPool::the().parallel_for(0, visits.size(), [&](size_t index) {
+        visits[index].fetch_add(1);
+    });
+    for (auto& count : visits)
+        EXPECT_EQ(count.load(), 1u);
+
+    // Empty and tiny ranges, and ranges that don't start at zero.
+    Atomic<u32> calls { 0 };
+    Threading::ThreadPool::the().parallel_for(5, 5, [&](size_t) { calls.fetch_add(1); });
+    EXPECT_EQ(calls.load(), 0u);
+    Threading::ThreadPool::the().parallel_for(7, 8, [&](size_t index) { EXPECT_EQ(index, 7u); calls.fetch_add(1); });
+    EXPECT_EQ(calls.load(), 1u);
+}
+
+TEST_CASE(nested_parallel_for)
+{
+    Atomic<u64> sum { 0 };
+    Threading::ThreadPool::the().parallel_for(0, 64, [&](size_t outer) {
+        Threading::ThreadPool::the().parallel_for(0, 64, [&](size_t inner) {
+            sum.fetch_add(outer * 64 + inner);
+        });
+    });
+    EXPECT_EQ(sum.load(), 4096u * 4095 / 2);
+}
+
+TEST_CASE(parallel_reduce_keeps_order)
+{
+    auto sum = Threading::ThreadPool::the().parallel_reduce(
+        0, 100000, (u64)0, [](size_t index) -> u64 { return index; }, [](u64 a, u64 b) { return a + b; });
+    EXPECT_EQ(sum, 100000ull * 99999 / 2);
+
+    // Concatenation isn't commutative, so this checks that the chunks are combined in order.
+    auto digits = Threading::ThreadPool::the().parallel_reduce(
+        0, 1000, String::empty(), [](size_t index) { return String::number(index % 10); }, [](String a, String b) { return String::formatted("{}{}", a, b); }, 7);
+    EXPECT_EQ(digits.length(), 1000u);
+    for (size_t i = 0; i < digits.length(); ++i)
+        EXPECT_EQ(digits[i], (char)('0' + i % 10));
+}
+
+TEST_CASE(futures)
+{
+    Core::EventLoop loop;
+    auto future = Threading::ThreadPool::the().async<int>(
+        [] { return 42; },
+        [&](int& result) {
+            EXPECT_EQ(result, 42);
+            loop.quit(0);
+        });
+    EXPECT_EQ(future->await(), 42);
+    EXPECT(future->is_resolved());
+    // Wait for the completion callback.
+    EXPECT_EQ(loop.exec(), 0);
+
+    auto without_callback = Threading::ThreadPool::the().async<String>([] { return String("done"); });
+    EXPECT_EQ(without_callback->await(), "done");
+}
+
+TEST_CASE(futures_dropped_before_they_resolve)
+{
+    // The worker ends up holding the last reference to these.
+    Atomic<u32> resolved { 0 };
+    for (int i = 0; i < 1000; ++i) {
+        (void)Threading::ThreadPool::the().async<int>([&resolved, i] {
+            resolved.fetch_add(1);
+            return i;
+        });
+    }
+    Threading::ThreadPool::the().help_until([&] { return resolved.load() == 1000; });
+}
+
+TEST_CASE(private_pool)
+{
+    Threading::ThreadPool pool(3);
+    EXPECT_EQ(pool.worker_count(), 3u);
+    Atomic<u32> count { 0 };
+    pool.parallel_for(0, 1000, [&](size_t) { count.fetch_add(1); });
+    EXPECT_EQ(count.load(), 1000u);
+}
+
+BENCHMARK_CASE(submit_latency)
+{
+    // How long it takes for a worker to pick up a task, one at a time.
+    constexpr size_t round_trips = 20000;
+    Core::ElapsedTimer timer;
+    timer.start();
+    for (size_t i = 0; i < round_trips; ++i) {
+        Atomic<bool> done { false };
+        Threading::ThreadPool::the().submit([&] { done.store(true); });
+        Threading::ThreadPool::the().help_until([&] { return done.load(); });
+    }
+    outln("{} submit round trips in {} ms", round_trips, timer.elapsed());
+}
+
+BENCHMARK_CASE(steal_throughput)
+{
+    // Lots of tiny tasks that all start out on a single worker, so that the others have to steal them.
+    constexpr size_t task_count = 200000;
+    auto steals_before = Threading::ThreadPool::the().steal_count();
+    Core::ElapsedTimer timer;
+    timer.start();
+    Atomic<size_t> remaining { task_count };
+    Threading::ThreadPool::the().submit([&] {
+        for (size_t i = 0; i < task_count; ++i)
+            Threading::ThreadPool::the().submit([&] { remaining.fetch_sub(1); });
+    });
+    Threading::ThreadPool::the().help_until([&] { return remaining.load() == 0; });
+    outln("{} tasks in {} ms, {} of them stolen", task_count, timer.elapsed(), Threading::ThreadPool::the().steal_count() - steals_before);
+}
+
+BENCHMARK_CASE(parallel_for_scaling)
+{
+    // The same amount of CPU bound work, on pools of different sizes.
+    constexpr size_t item_count = 4096;
+    auto work = [](size_t index) {
+        u32 value = index;
+        for (size_t i = 0; i < 20000; ++i)
+            value = value * 1103515245 + 12345;
+        return value;
+    };
+    for (size_t worker_count = 1; worker_count <= 8; worker_count *= 2) {
+        Threading::ThreadPool pool(worker_count);
+        Core::ElapsedTimer timer;
+        timer.start();
+        auto result = pool.parallel_reduce(0, item_count, (u32)0, work, [](u32 a, u32 b) { return a ^ b; });
+        outln("{} workers: {} ms (result {})", worker_count, timer.elapsed(), result);
+    }
+}
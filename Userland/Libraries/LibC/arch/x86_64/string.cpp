@@ -0,0 +1,405 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Types.h>
+#include <cpuid.h>
+#include <emmintrin.h>
+#include <string.h>
+
+// SSE2 versions of the string functions that show up the most in profiles. SSE2 is part of x86_64,
+// so they don't need to check for it. AVX2 would be faster still for long buffers, but the kernel
+// only saves the SSE part of the register state when switching between threads.
+
+#ifndef __clang__
+// Keep GCC from turning the loops below into calls to the very functions they implement.
+#    pragma GCC optimize("no-tree-loop-distribute-patterns")
+#endif
+
+// On CPUs with Enhanced REP MOVSB/STOSB, "rep movsb" and "rep stosb" beat the vector loops from about here on up.
+static constexpr size_t rep_string_threshold = 2048;
+
+ALWAYS_INLINE static __m128i load(const u8* source)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+}
+
+ALWAYS_INLINE static __m128i load_aligned(const u8* source)
+{
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(source));
+}
+
+ALWAYS_INLINE static void store(u8* destination, __m128i value)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), value);
+}
+
+ALWAYS_INLINE static void store_aligned(u8* destination, __m128i value)
+{
+    _mm_store_si128(reinterpret_cast<__m128i*>(destination), value);
+}
+
+template<typename T>
+ALWAYS_INLINE static T load_scalar(const u8* source)
+{
+    T value;
+    __builtin_memcpy(&value, source, sizeof(T));
+    return value;
+}
+
+template<typename T>
+ALWAYS_INLINE static void store_scalar(u8* destination, T value)
+{
+    __builtin_memcpy(destination, &value, sizeof(T));
+}
+
+// Copies up to 64 bytes with two loads and two stores of the largest size that fits, which overlap in the middle.
+// Everything is loaded before anything is stored, so the buffers may overlap.
+ALWAYS_INLINE static void copy_small(u8* dest, const u8* src, size_t n)
+{
+    if (n >= 32) {
+        auto head0 = load(src);
+        auto head1 = load(src + 16);
+        auto tail0 = load(src + n - 32);
+        auto tail1 = load(src + n - 16);
+        store(dest, head0);
+        store(dest + 16, head1);
+        store(dest + n - 32, tail0);
+        store(dest + n - 16, tail1);
+    } else if (n >= 16) {
+        auto head = load(src);
+        auto tail = load(src + n - 16);
+        store(dest, head);
+        store(dest + n - 16, tail);
+    } else if (n >= 8) {
+        auto head = load_scalar<u64>(src);
+        auto tail = load_scalar<u64>(src + n - 8);
+        store_scalar(dest, head);
+        store_scalar(dest + n - 8, tail);
+    } else if (n >= 4) {
+        auto head = load_scalar<u32>(src);
+        auto tail = load_scalar<u32>(src + n - 4);
+        store_scalar(dest, head);
+        store_scalar(dest + n - 4, tail);
+    } else if (n >= 2) {
+        auto head = load_scalar<u16>(src);
+        auto tail = load_scalar<u16>(src + n - 2);
+        store_scalar(dest, head);
+        store_scalar(dest + n - 2, tail);
+    } else if (n == 1) {
+        *dest = *src;
+    }
+}
+
+// For more than 64 bytes. The first and last 16 bytes are copied separately, so that everything in between
+// can use aligned stores. This also works if the destination starts before an overlapping source.
+ALWAYS_INLINE static void copy_forward(u8* dest, const u8* src, size_t n)
+{
+    auto head = load(src);
+    auto tail = load(src + n - 16);
+
+    auto* out = reinterpret_cast<u8*>((reinterpret_cast<FlatPtr>(dest) + 16) & ~(FlatPtr)15);
+    auto* in = src + (out - dest);
+    auto* out_end = dest + n - 16;
+    for (; out_end - out >= 64; in += 64, out += 64) {
+        auto a = load(in);
+        auto b = load(in + 16);
+        auto c = load(in + 32);
+        auto d = load(in + 48);
+        store_aligned(out, a);
+        store_aligned(out + 16, b);
+        store_aligned(out + 32, c);
+        store_aligned(out + 48, d);
+    }
+    for (; out < out_end; in += 16, out += 16)
+        store_aligned(out, load(in));
+
+    store(dest, head);
+    store(out_end, tail);
+}
+
+// Same as copy_forward(), but starting at the end, for when the destination starts inside the source.
+ALWAYS_INLINE static void copy_backward(u8* dest, const u8* src, size_t n)
+{
+    auto head = load(src);
+    auto tail = load(src + n - 16);
+
+    auto* out_end = reinterpret_cast<u8*>(reinterpret_cast<FlatPtr>(dest + n - 1) & ~(FlatPtr)15);
+    auto* in_end = src + (out_end - dest);
+    auto* out_start = dest + 16;
+    for (; out_end - out_start >= 64; in_end -= 64, out_end -= 64) {
+        auto a = load(in_end - 16);
+        auto b = load(in_end - 32);
+        auto c = load(in_end - 48);
+        auto d = load(in_end - 64);
+        store_aligned(out_end - 16, a);
+        store_aligned(out_end - 32, b);
+        store_aligned(out_end - 48, c);
+        store_aligned(out_end - 64, d);
+    }
+    for (; out_end > out_start; in_end -= 16, out_end -= 16)
+        store_aligned(out_end - 16, load(in_end - 16));
+
+    store(dest + n - 16, tail);
+    store(dest, head);
+}
+
+ALWAYS_INLINE static void copy_with_rep_movsb(u8* dest, const u8* src, size_t n)
+{
+    asm volatile(
+        "rep movsb"
+        : "+D"(dest), "+S"(src), "+c"(n)::"memory");
+}
+
+// Fills up to 64 bytes, the same way copy_small() copies them.
+ALWAYS_INLINE static void fill_small(u8* dest, __m128i value, size_t n)
+{
+    if (n >= 32) {
+        store(dest, value);
+        store(dest + 16, value);
+        store(dest + n - 32, value);
+        store(dest + n - 16, value);
+    } else if (n >= 16) {
+        store(dest, value);
+        store(dest + n - 16, value);
+    } else if (n >= 8) {
+        u64 scalar = _mm_cvtsi128_si64(value);
+        store_scalar(dest, scalar);
+        store_scalar(dest + n - 8, scalar);
+    } else if (n >= 4) {
+        u32 scalar = _mm_cvtsi128_si32(value);
+        store_scalar(dest, scalar);
+        store_scalar(dest + n - 4, scalar);
+    } else if (n >= 2) {
+        u16 scalar = _mm_cvtsi128_si32(value);
+        store_scalar(dest, scalar);
+        store_scalar(dest + n - 2, scalar);
+    } else if (n == 1) {
+        *dest = _mm_cvtsi128_si32(value);
+    }
+}
+
+// For more than 64 bytes, the same way copy_forward() copies them.
+ALWAYS_INLINE static void fill(u8* dest, __m128i value, size_t n)
+{
+    auto* out = reinterpret_cast<u8*>((reinterpret_cast<FlatPtr>(dest) + 16) & ~(FlatPtr)15);
+    auto* out_end = dest + n - 16;
+    for (; out_end - out >= 64; out += 64) {
+        store_aligned(out, value);
+        store_aligned(out + 16, value);
+        store_aligned(out + 32, value);
+        store_aligned(out + 48, value);
+    }
+    for (; out < out_end; out += 16)
+        store_aligned(out, value);
+
+    store(dest, value);
+    store(out_end, value);
+}
+
+ALWAYS_INLINE static void fill_with_rep_stosb(u8* dest, int c, size_t n)
+{
+    asm volatile(
+        "rep stosb"
+        : "+D"(dest), "+c"(n)
+        : "a"(c)
+        : "memory");
+}
+
+static void* memcpy_sse2(void* dest_ptr, const void* src_ptr, size_t n)
+{
+    auto* dest = static_cast<u8*>(dest_ptr);
+    auto* src = static_cast<const u8*>(src_ptr);
+    if (n <= 64)
+        copy_small(dest, src, n);
+    else
+        copy_forward(dest, src, n);
+    return dest_ptr;
+}
+
+static void* memset_sse2(void* dest_ptr, int c, size_t n)
+{
+    auto* dest = static_cast<u8*>(dest_ptr);
+    auto value = _mm_set1_epi8(static_cast<char>(c));
+    if (n <= 64)
+        fill_small(dest, value, n);
+    else
+        fill(dest, value, n);
+    return dest_ptr;
+}
+
+extern "C" {
+
+#ifndef NO_IFUNC
+// These run while the dynamic loader is still relocating LibC, so they can't call anything or touch any globals.
+static bool cpu_has_enhanced_rep_movsb()
+{
+    unsigned eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0, nullptr) < 7)
+        return false;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return ebx & (1 << 9);
+}
+
+static void* memcpy_sse2_erms(void* dest_ptr, const void* src_ptr, size_t n)
+{
+    auto* dest = static_cast<u8*>(dest_ptr);
+    auto* src = static_cast<const u8*>(src_ptr);
+    if (n <= 64)
+        copy_small(dest, src, n);
+    else if (n < rep_string_threshold)
+        copy_forward(dest, src, n);
+    else
+        copy_with_rep_movsb(dest, src, n);
+    return dest_ptr;
+}
+
+static void* memset_sse2_erms(void* dest_ptr, int c, size_t n)
+{
+    auto* dest = static_cast<u8*>(dest_ptr);
+    auto value = _mm_set1_epi8(static_cast<char>(c));
+    if (n <= 64)
+        fill_small(dest, value, n);
+    else if (n < rep_string_threshold)
+        fill(dest, value, n);
+    else
+        fill_with_rep_stosb(dest, c, n);
+    return dest_ptr;
+}
+
+static decltype(&memcpy) resolve_memcpy()
+{
+    return cpu_has_enhanced_rep_movsb() ? memcpy_sse2_erms : memcpy_sse2;
+}
+
+static decltype(&memset) resolve_memset()
+{
+    return cpu_has_enhanced_rep_movsb() ? memset_sse2_erms : memset_sse2;
+}
+
+[[gnu::ifunc("resolve_memcpy")]] void* memcpy(void*, const void*, size_t);
+[[gnu::ifunc("resolve_memset")]] void* memset(void*, int, size_t);
+#else
+// The dynamic loader and statically linked programs have nobody to resolve IFUNCs for them.
+void* memcpy(void* dest_ptr, const void* src_ptr, size_t n)
+{
+    return memcpy_sse2(dest_ptr, src_ptr, n);
+}
+
+void* memset(void* dest_ptr, int c, size_t n)
+{
+    return memset_sse2(dest_ptr, c, n);
+}
+#endif
+
+void* memmove(void* dest_ptr, const void* src_ptr, size_t n)
+{
+    auto* dest = static_cast<u8*>(dest_ptr);
+    auto* src = static_cast<const u8*>(src_ptr);
+    if (n <= 64)
+        copy_small(dest, src, n);
+    else if ((FlatPtr)dest - (FlatPtr)src >= n)
+        copy_forward(dest, src, n);
+    else
+        copy_backward(dest, src, n);
+    return dest_ptr;
+}
+
+// The string functions below read aligned 16-byte blocks, which never cross into the next page,
+// so it's fine that they look at bytes before the start and past the end of the string.
+
+size_t strlen(const char* str)
+{
+    auto zero = _mm_setzero_si128();
+    auto offset = reinterpret_cast<FlatPtr>(str) & 15;
+    auto* block = reinterpret_cast<const u8*>(str) - offset;
+    u32 mask = _mm_movemask_epi8(_mm_cmpeq_epi8(load_aligned(block), zero)) >> offset;
+    if (mask)
+        return __builtin_ctz(mask);
+
+    // Look at 64 bytes at a time once that doesn't risk reading from the next page.
+    for (;;) {
+        block += 16;
+        if (!(reinterpret_cast<FlatPtr>(block) & 63))
+            break;
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi8(load_aligned(block), zero));
+        if (mask)
+            return block + __builtin_ctz(mask) - reinterpret_cast<const u8*>(str);
+    }
+    for (;; block += 64) {
+        auto a = load_aligned(block);
+        auto b = load_aligned(block + 16);
+        auto c = load_aligned(block + 32);
+        auto d = load_aligned(block + 48);
+        // The minimum of the four is zero only if one of them contains a zero byte.
+        auto minimum = _mm_min_epu8(_mm_min_epu8(a, b), _mm_min_epu8(c, d));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(minimum, zero)))
+            break;
+    }
+    for (;; block += 16) {
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi8(load_aligned(block), zero));
+        if (mask)
+            return block + __builtin_ctz(mask) - reinterpret_cast<const u8*>(str);
+    }
+}
+
+// Returns the first byte that is either c or the null terminator.
+ALWAYS_INLINE static char* find_byte_or_null_terminator(const char* str, char c)
+{
+    auto zero = _mm_setzero_si128();
+    auto needle = _mm_set1_epi8(c);
+    auto matches = [&](const u8* block) -> u32 {
+        auto bytes = load_aligned(block);
+        return _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, zero), _mm_cmpeq_epi8(bytes, needle)));
+    };
+
+    auto offset = reinterpret_cast<FlatPtr>(str) & 15;
+    auto* block = reinterpret_cast<const u8*>(str) - offset;
+    u32 mask = matches(block) >> offset;
+    if (mask)
+        return const_cast<char*>(str) + __builtin_ctz(mask);
+    for (;;) {
+        block += 16;
+        mask = matches(block);
+        if (mask)
+            return reinterpret_cast<char*>(const_cast<u8*>(block)) + __builtin_ctz(mask);
+    }
+}
+
+char* strchr(const char* str, int c)
+{
+    auto* found = find_byte_or_null_terminator(str, c);
+    return *found == static_cast<char>(c) ? found : nullptr;
+}
+
+char* strchrnul(const char* str, int c)
+{
+    return find_byte_or_null_terminator(str, c);
+}
+
+void* memchr(const void* ptr, int c, size_t size)
+{
+    if (!size)
+        return nullptr;
+
+    auto needle = _mm_set1_epi8(static_cast<char>(c));
+    auto* start = static_cast<const u8*>(ptr);
+    auto offset = reinterpret_cast<FlatPtr>(start) & 15;
+    auto* block = start - offset;
+    u32 mask = _mm_movemask_epi8(_mm_cmpeq_epi8(load_aligned(block), needle)) >> offset;
+    if (mask)
+        return static_cast<size_t>(__builtin_ctz(mask)) < size ? const_cast<u8*>(start + __builtin_ctz(mask)) : nullptr;
+    for (;;) {
+        block += 16;
+        if (static_cast<size_t>(block - start) >= size)
+            return nullptr;
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi8(load_aligned(block), needle));
+        if (mask) {
+            size_t index = block - start + __builtin_ctz(mask);
+            return index < size ? const_cast<u8*>(start + index) : nullptr;
+        }
+    }
+}
+}
@@ -374,14 +374,15 @@ typedef struct {
 #define STB_HIPROC 15 /*  specific symbol bindings */
 
 /* Symbol type - ELF32_ST_TYPE - st_info */
-#define STT_NOTYPE 0  /* not specified */
-#define STT_OBJECT 1  /* data object */
-#define STT_FUNC 2    /* function */
-#define STT_SECTION 3 /* section */
-#define STT_FILE 4    /* file */
-#define STT_TLS 6     /* thread local storage */
-#define STT_LOPROC 13 /* reserved range for processor */
-#define STT_HIPROC 15 /*  specific symbol types */
+#define STT_NOTYPE 0     /* not specified */
+#define STT_OBJECT 1     /* data object */
+#define STT_FUNC 2       /* function */
+#define STT_SECTION 3    /* section */
+#define STT_FILE 4       /* file */
+#define STT_TLS 6        /* thread local storage */
+#define STT_GNU_IFUNC 10 /* indirect function, the value is that of a resolver function */
+#define STT_LOPROC 13    /* reserved range for processor */
+#define STT_HIPROC 15    /*  specific symbol types */
 
 /* Extract symbol visibility - st_other */
 #define ELF_ST_VISIBILITY(v) ((v)&0x3)
@@ -589,9 +590,9 @@ typedef struct {
 } Elf32_Nhdr;
 
 typedef struct {
-    Elf64_Half n_namesz;
-    Elf64_Half n_descsz;
-    Elf64_Half n_type;
+    Elf64_Word n_namesz;
+    Elf64_Word n_descsz;
+    Elf64_Word n_type;
 } Elf64_Nhdr;
 
 /*
@@ -604,9 +605,9 @@ typedef struct {
 } Elf32_Note;
 
 typedef struct {
-    Elf64_Half namesz;
-    Elf64_Half descsz;
-    Elf64_Half type;
+    Elf64_Word namesz;
+    Elf64_Word descsz;
+    Elf64_Word type;
 } Elf64_Note;
 
 /* Values for n_type. */
@@ -614,6 +615,9 @@ typedef struct {
 #define NT_FPREGSET 2 /* Floating point registers. */
 #define NT_PRPSINFO 3 /* Process state info. */
 
+/* Values for n_type in notes named "GNU". */
+#define NT_GNU_BUILD_ID 3 /* Unique build ID of the file. */
+
 /*
  * OpenBSD-specific core file information.
  *
@@ -798,6 +802,7 @@ struct elf_args {
 #define R_386_RELATIVE 8   /* Base address + Addned */
 #define R_386_TLS_TPOFF 14 /* Negative offset into the static TLS storage */
 #define R_386_TLS_TPOFF32 37
+#define R_386_IRELATIVE 42 /* Address returned by the resolver function at Base address + Addend */
 
 #define R_X86_64_NONE 0
 #define R_X86_64_64 1
@@ -805,3 +810,4 @@ struct elf_args {
 #define R_X86_64_JUMP_SLOT 7
 #define R_X86_64_RELATIVE 8
 #define R_X86_64_TPOFF64 18
+#define R_X86_64_IRELATIVE 37
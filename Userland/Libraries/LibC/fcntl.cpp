@@ -23,6 +23,13 @@ int fcntl(int fd, int cmd, ...)
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
+ssize_t splice(int fd_in, off_t* offset_in, int fd_out, off_t* offset_out, size_t length, unsigned flags)
+{
+    Syscall::SC_splice_params params { fd_in, offset_in, fd_out, offset_out, length, flags };
+    int rc = syscall(SC_splice, &params);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
 int create_inode_watcher(unsigned flags)
 {
     int rc = syscall(SC_create_inode_watcher, flags);
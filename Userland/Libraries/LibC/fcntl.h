@@ -21,6 +21,8 @@ __BEGIN_DECLS
 #define F_GETLK 6
 #define F_SETLK 7
 #define F_SETLKW 8
+#define F_SETPIPE_SZ 9
+#define F_GETPIPE_SZ 10
 
 #define FD_CLOEXEC 1
 
@@ -40,6 +42,10 @@ __BEGIN_DECLS
 #define O_CLOEXEC (1 << 11)
 #define O_DIRECT (1 << 12)
 
+#define SPLICE_F_MOVE 1
+#define SPLICE_F_NONBLOCK 2
+#define SPLICE_F_MORE 4
+
 int creat(const char* path, mode_t);
 int open(const char* path, int options, ...);
 #define AT_FDCWD -100
@@ -47,6 +53,7 @@ int open(const char* path, int options, ...);
 int openat(int dirfd, const char* path, int options, ...);
 
 int fcntl(int fd, int cmd, ...);
+ssize_t splice(int fd_in, off_t* offset_in, int fd_out, off_t* offset_out, size_t length, unsigned flags);
 int create_inode_watcher(unsigned flags);
 int inode_watcher_add_watch(int fd, const char* path, size_t path_length, unsigned event_mask);
 int inode_watcher_remove_watch(int fd, int wd);
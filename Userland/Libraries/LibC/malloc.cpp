@@ -37,6 +37,10 @@ private:
 
 #define RECYCLE_BIG_ALLOCATIONS
 
+#ifndef NO_TLS
+#    define USE_THREAD_CACHES
+#endif
+
 static pthread_mutex_t s_malloc_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 constexpr size_t number_of_hot_chunked_blocks_to_keep_around = 16;
@@ -48,6 +52,7 @@ static bool s_scrub_malloc = true;
 static bool s_scrub_free = true;
 static bool s_profiling = false;
 static bool s_in_userspace_emulator = false;
+static bool s_use_thread_caches = true;
 
 ALWAYS_INLINE static void ue_notify_malloc(const void* ptr, size_t size)
 {
@@ -95,6 +100,10 @@ struct MallocStats {
     size_t number_of_hot_keeps;
     size_t number_of_cold_keeps;
     size_t number_of_frees;
+
+    size_t number_of_thread_cache_hits;
+    size_t number_of_thread_cache_refills;
+    size_t number_of_thread_cache_flushes;
 };
 static MallocStats g_malloc_stats = {};
 
@@ -154,6 +163,43 @@ static BigAllocator* big_allocator_for_size(size_t size)
 }
 #endif
 
+#ifdef USE_THREAD_CACHES
+// Each thread keeps some free chunks of every size class to itself, so that most calls to malloc() and free()
+// don't need to take s_malloc_mutex. Chunks move between a thread and the shared blocks in batches.
+struct ThreadCache {
+    struct Bin {
+        FreelistEntry* chunks;
+        size_t count;
+    };
+    Bin bins[num_size_classes];
+
+    // Counted here rather than in g_malloc_stats, so that threads don't fight over its cache line.
+    // These are added to g_malloc_stats whenever the thread takes s_malloc_mutex anyway.
+    size_t number_of_malloc_calls;
+    size_t number_of_free_calls;
+    size_t number_of_hits;
+
+    // Set once the thread has flushed its cache on the way out, so nothing ends up in it again.
+    bool destroyed;
+};
+
+static __thread ThreadCache s_thread_cache;
+
+// Enough to make the locking cheap on average, without letting an idle thread sit on too much memory.
+static constexpr size_t thread_cache_bytes_per_size_class = 32 * KiB;
+static constexpr size_t max_thread_cache_chunks_per_size_class = 64;
+
+static size_t thread_cache_capacity(size_t chunk_size)
+{
+    return clamp(thread_cache_bytes_per_size_class / chunk_size, (size_t)1, max_thread_cache_chunks_per_size_class);
+}
+
+static size_t thread_cache_batch_size(size_t chunk_size)
+{
+    return max(thread_cache_capacity(chunk_size) / 2, (size_t)1);
+}
+#endif
+
 extern "C" {
 
 static void* os_alloc(size_t size, const char* name)
@@ -178,60 +224,13 @@ enum class CallerWillInitializeMemory {
     Yes,
 };
 
-static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_initialize_memory)
+// Must be called with s_malloc_mutex held.
+static void* allocate_chunk(Allocator& allocator)
 {
-    if (s_log_malloc)
-        dbgln("LibC: malloc({})", size);
-
-    if (!size) {
-        // Legally we could just return a null pointer here, but this is more
-        // compatible with existing software.
-        size = 1;
-    }
-
-    g_malloc_stats.number_of_malloc_calls++;
-
-    size_t good_size;
-    auto* allocator = allocator_for_size(size, good_size);
-
-    PthreadMutexLocker locker(s_malloc_mutex);
-
-    if (!allocator) {
-        size_t real_size = round_up_to_power_of_two(sizeof(BigAllocationBlock) + size, ChunkedBlock::block_size);
-#ifdef RECYCLE_BIG_ALLOCATIONS
-        if (auto* allocator = big_allocator_for_size(real_size)) {
-            if (!allocator->blocks.is_empty()) {
-                g_malloc_stats.number_of_big_allocator_hits++;
-                auto* block = allocator->blocks.take_last();
-                int rc = madvise(block, real_size, MADV_SET_NONVOLATILE);
-                bool this_block_was_purged = rc == 1;
-                if (rc < 0) {
-                    perror("madvise");
-                    VERIFY_NOT_REACHED();
-                }
-                if (mprotect(block, real_size, PROT_READ | PROT_WRITE) < 0) {
-                    perror("mprotect");
-                    VERIFY_NOT_REACHED();
-                }
-                if (this_block_was_purged) {
-                    g_malloc_stats.number_of_big_allocator_purge_hits++;
-                    new (block) BigAllocationBlock(real_size);
-                }
-
-                ue_notify_malloc(&block->m_slot[0], size);
-                return &block->m_slot[0];
-            }
-        }
-#endif
-        g_malloc_stats.number_of_big_allocs++;
-        auto* block = (BigAllocationBlock*)os_alloc(real_size, "malloc: BigAllocationBlock");
-        new (block) BigAllocationBlock(real_size);
-        ue_notify_malloc(&block->m_slot[0], size);
-        return &block->m_slot[0];
-    }
+    size_t good_size = allocator.size;
 
     ChunkedBlock* block = nullptr;
-    for (auto& current : allocator->usable_blocks) {
+    for (auto& current : allocator.usable_blocks) {
         if (current.free_chunks()) {
             block = &current;
             break;
@@ -248,7 +247,7 @@ static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_ini
             snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
             set_mmap_name(block, ChunkedBlock::block_size, buffer);
         }
-        allocator->usable_blocks.append(*block);
+        allocator.usable_blocks.append(*block);
     }
 
     if (!block && s_cold_empty_block_count) {
@@ -271,7 +270,7 @@ static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_ini
             new (block) ChunkedBlock(good_size);
             ue_notify_chunk_size_changed(block, good_size);
         }
-        allocator->usable_blocks.append(*block);
+        allocator.usable_blocks.append(*block);
     }
 
     if (!block) {
@@ -280,8 +279,8 @@ static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_ini
         snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
         block = (ChunkedBlock*)os_alloc(ChunkedBlock::block_size, buffer);
         new (block) ChunkedBlock(good_size);
-        allocator->usable_blocks.append(*block);
-        ++allocator->block_count;
+        allocator.usable_blocks.append(*block);
+        ++allocator.block_count;
     }
 
     --block->m_free_chunks;
@@ -296,13 +295,197 @@ static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_ini
     if (block->is_full()) {
         g_malloc_stats.number_of_blocks_full++;
         dbgln_if(MALLOC_DEBUG, "Block {:p} is now full in size class {}", block, good_size);
-        allocator->usable_blocks.remove(*block);
-        allocator->full_blocks.append(*block);
+        allocator.usable_blocks.remove(*block);
+        allocator.full_blocks.append(*block);
     }
     dbgln_if(MALLOC_DEBUG, "LibC: allocated {:p} (chunk in block {:p}, size {})", ptr, block, block->bytes_per_chunk());
+    return ptr;
+}
+
+// Must be called with s_malloc_mutex held.
+static void free_chunk(ChunkedBlock* block, void* ptr)
+{
+    auto* entry = (FreelistEntry*)ptr;
+    entry->next = block->m_freelist;
+    block->m_freelist = entry;
+
+    if (block->is_full()) {
+        size_t good_size;
+        auto* allocator = allocator_for_size(block->m_size, good_size);
+        dbgln_if(MALLOC_DEBUG, "Block {:p} no longer full in size class {}", block, good_size);
+        g_malloc_stats.number_of_freed_full_blocks++;
+        allocator->full_blocks.remove(*block);
+        allocator->usable_blocks.prepend(*block);
+    }
+
+    ++block->m_free_chunks;
+
+    if (!block->used_chunks()) {
+        size_t good_size;
+        auto* allocator = allocator_for_size(block->m_size, good_size);
+        if (s_hot_empty_block_count < number_of_hot_chunked_blocks_to_keep_around) {
+            dbgln_if(MALLOC_DEBUG, "Keeping hot block {:p} around", block);
+            g_malloc_stats.number_of_hot_keeps++;
+            allocator->usable_blocks.remove(*block);
+            s_hot_empty_blocks[s_hot_empty_block_count++] = block;
+            return;
+        }
+        if (s_cold_empty_block_count < number_of_cold_chunked_blocks_to_keep_around) {
+            dbgln_if(MALLOC_DEBUG, "Keeping cold block {:p} around", block);
+            g_malloc_stats.number_of_cold_keeps++;
+            allocator->usable_blocks.remove(*block);
+            s_cold_empty_blocks[s_cold_empty_block_count++] = block;
+            mprotect(block, ChunkedBlock::block_size, PROT_NONE);
+            madvise(block, ChunkedBlock::block_size, MADV_SET_VOLATILE);
+            return;
+        }
+        dbgln_if(MALLOC_DEBUG, "Releasing block {:p} for size class {}", block, good_size);
+        g_malloc_stats.number_of_frees++;
+        allocator->usable_blocks.remove(*block);
+        --allocator->block_count;
+        os_free(block, ChunkedBlock::block_size);
+    }
+}
+
+#ifdef USE_THREAD_CACHES
+// Must be called with s_malloc_mutex held.
+static void collect_thread_cache_stats(ThreadCache& cache)
+{
+    g_malloc_stats.number_of_malloc_calls += exchange(cache.number_of_malloc_calls, 0);
+    g_malloc_stats.number_of_free_calls += exchange(cache.number_of_free_calls, 0);
+    g_malloc_stats.number_of_thread_cache_hits += exchange(cache.number_of_hits, 0);
+}
+
+// Must be called with s_malloc_mutex held.
+static void flush_thread_cache_bin(ThreadCache::Bin& bin, size_t count)
+{
+    for (size_t i = 0; i < count && bin.chunks; ++i) {
+        auto* entry = bin.chunks;
+        bin.chunks = entry->next;
+        --bin.count;
+        auto* block = (ChunkedBlock*)((FlatPtr)entry & ChunkedBlock::block_mask);
+        free_chunk(block, entry);
+    }
+}
+
+static void* allocate_chunk_from_thread_cache(Allocator& allocator)
+{
+    auto& cache = s_thread_cache;
+    if (cache.destroyed)
+        return nullptr;
+
+    auto& bin = cache.bins[&allocator - allocators()];
+    ++cache.number_of_malloc_calls;
+    if (bin.chunks) {
+        ++cache.number_of_hits;
+    } else {
+        PthreadMutexLocker locker(s_malloc_mutex);
+        collect_thread_cache_stats(cache);
+        g_malloc_stats.number_of_thread_cache_refills++;
+        size_t batch_size = thread_cache_batch_size(allocator.size);
+        for (size_t i = 0; i < batch_size; ++i) {
+            auto* entry = (FreelistEntry*)allocate_chunk(allocator);
+            entry->next = bin.chunks;
+            bin.chunks = entry;
+        }
+        bin.count = batch_size;
+    }
+
+    auto* entry = bin.chunks;
+    bin.chunks = entry->next;
+    --bin.count;
+    return entry;
+}
+
+static bool free_chunk_to_thread_cache(ChunkedBlock* block, void* ptr)
+{
+    auto& cache = s_thread_cache;
+    if (cache.destroyed)
+        return false;
+
+    size_t good_size;
+    auto* allocator = allocator_for_size(block->m_size, good_size);
+    auto& bin = cache.bins[allocator - allocators()];
+    ++cache.number_of_free_calls;
+    if (bin.count >= thread_cache_capacity(good_size)) {
+        PthreadMutexLocker locker(s_malloc_mutex);
+        collect_thread_cache_stats(cache);
+        g_malloc_stats.number_of_thread_cache_flushes++;
+        flush_thread_cache_bin(bin, thread_cache_batch_size(good_size));
+    }
+
+    auto* entry = (FreelistEntry*)ptr;
+    entry->next = bin.chunks;
+    bin.chunks = entry;
+    ++bin.count;
+    return true;
+}
+#endif
+
+static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_initialize_memory)
+{
+    if (s_log_malloc)
+        dbgln("LibC: malloc({})", size);
+
+    if (!size) {
+        // Legally we could just return a null pointer here, but this is more
+        // compatible with existing software.
+        size = 1;
+    }
+
+    size_t good_size;
+    auto* allocator = allocator_for_size(size, good_size);
+
+    if (!allocator) {
+        PthreadMutexLocker locker(s_malloc_mutex);
+        g_malloc_stats.number_of_malloc_calls++;
+
+        size_t real_size = round_up_to_power_of_two(sizeof(BigAllocationBlock) + size, ChunkedBlock::block_size);
+#ifdef RECYCLE_BIG_ALLOCATIONS
+        if (auto* allocator = big_allocator_for_size(real_size)) {
+            if (!allocator->blocks.is_empty()) {
+                g_malloc_stats.number_of_big_allocator_hits++;
+                auto* block = allocator->blocks.take_last();
+                int rc = madvise(block, real_size, MADV_SET_NONVOLATILE);
+                bool this_block_was_purged = rc == 1;
+                if (rc < 0) {
+                    perror("madvise");
+                    VERIFY_NOT_REACHED();
+                }
+                if (mprotect(block, real_size, PROT_READ | PROT_WRITE) < 0) {
+                    perror("mprotect");
+                    VERIFY_NOT_REACHED();
+                }
+                if (this_block_was_purged) {
+                    g_malloc_stats.number_of_big_allocator_purge_hits++;
+                    new (block) BigAllocationBlock(real_size);
+                }
+
+                ue_notify_malloc(&block->m_slot[0], size);
+                return &block->m_slot[0];
+            }
+        }
+#endif
+        g_malloc_stats.number_of_big_allocs++;
+        auto* block = (BigAllocationBlock*)os_alloc(real_size, "malloc: BigAllocationBlock");
+        new (block) BigAllocationBlock(real_size);
+        ue_notify_malloc(&block->m_slot[0], size);
+        return &block->m_slot[0];
+    }
+
+    void* ptr = nullptr;
+#ifdef USE_THREAD_CACHES
+    if (s_use_thread_caches)
+        ptr = allocate_chunk_from_thread_cache(*allocator);
+#endif
+    if (!ptr) {
+        PthreadMutexLocker locker(s_malloc_mutex);
+        g_malloc_stats.number_of_malloc_calls++;
+        ptr = allocate_chunk(*allocator);
+    }
 
     if (s_scrub_malloc && caller_will_initialize_memory == CallerWillInitializeMemory::No)
-        memset(ptr, MALLOC_SCRUB_BYTE, block->m_size);
+        memset(ptr, MALLOC_SCRUB_BYTE, good_size);
 
     ue_notify_malloc(ptr, size);
     return ptr;
@@ -315,14 +498,13 @@ static void free_impl(void* ptr)
     if (!ptr)
         return;
 
-    g_malloc_stats.number_of_free_calls++;
-
     void* block_base = (void*)((FlatPtr)ptr & ChunkedBlock::ChunkedBlock::block_mask);
     size_t magic = *(size_t*)block_base;
 
-    PthreadMutexLocker locker(s_malloc_mutex);
-
     if (magic == MAGIC_BIGALLOC_HEADER) {
+        PthreadMutexLocker locker(s_malloc_mutex);
+        g_malloc_stats.number_of_free_calls++;
+
         auto* block = (BigAllocationBlock*)block_base;
 #ifdef RECYCLE_BIG_ALLOCATIONS
         if (auto* allocator = big_allocator_for_size(block->m_size)) {
@@ -355,46 +537,14 @@ static void free_impl(void* ptr)
     if (s_scrub_free)
         memset(ptr, FREE_SCRUB_BYTE, block->bytes_per_chunk());
 
-    auto* entry = (FreelistEntry*)ptr;
-    entry->next = block->m_freelist;
-    block->m_freelist = entry;
-
-    if (block->is_full()) {
-        size_t good_size;
-        auto* allocator = allocator_for_size(block->m_size, good_size);
-        dbgln_if(MALLOC_DEBUG, "Block {:p} no longer full in size class {}", block, good_size);
-        g_malloc_stats.number_of_freed_full_blocks++;
-        allocator->full_blocks.remove(*block);
-        allocator->usable_blocks.prepend(*block);
-    }
-
-    ++block->m_free_chunks;
+#ifdef USE_THREAD_CACHES
+    if (s_use_thread_caches && free_chunk_to_thread_cache(block, ptr))
+        return;
+#endif
 
-    if (!block->used_chunks()) {
-        size_t good_size;
-        auto* allocator = allocator_for_size(block->m_size, good_size);
-        if (s_hot_empty_block_count < number_of_hot_chunked_blocks_to_keep_around) {
-            dbgln_if(MALLOC_DEBUG, "Keeping hot block {:p} around", block);
-            g_malloc_stats.number_of_hot_keeps++;
-            allocator->usable_blocks.remove(*block);
-            s_hot_empty_blocks[s_hot_empty_block_count++] = block;
-            return;
-        }
-        if (s_cold_empty_block_count < number_of_cold_chunked_blocks_to_keep_around) {
-            dbgln_if(MALLOC_DEBUG, "Keeping cold block {:p} around", block);
-            g_malloc_stats.number_of_cold_keeps++;
-            allocator->usable_blocks.remove(*block);
-            s_cold_empty_blocks[s_cold_empty_block_count++] = block;
-            mprotect(block, ChunkedBlock::block_size, PROT_NONE);
-            madvise(block, ChunkedBlock::block_size, MADV_SET_VOLATILE);
-            return;
-        }
-        dbgln_if(MALLOC_DEBUG, "Releasing block {:p} for size class {}", block, good_size);
-        g_malloc_stats.number_of_frees++;
-        allocator->usable_blocks.remove(*block);
-        --allocator->block_count;
-        os_free(block, ChunkedBlock::block_size);
-    }
+    PthreadMutexLocker locker(s_malloc_mutex);
+    g_malloc_stats.number_of_free_calls++;
+    free_chunk(block, ptr);
 }
 
 [[gnu::flatten]] void* malloc(size_t size)
@@ -478,6 +628,9 @@ void __malloc_init()
         // keeps track of heap memory anyway.
         s_scrub_malloc = false;
         s_scrub_free = false;
+        // UE needs to see every chunk go back to its block, otherwise it can't tell a chunk
+        // sitting in a thread cache apart from one that is still in use.
+        s_use_thread_caches = false;
     }
 
     if (secure_getenv("LIBC_NOSCRUB_MALLOC"))
@@ -497,8 +650,27 @@ void __malloc_init()
     new (&big_allocators()[0])(BigAllocator);
 }
 
+void __malloc_destroy_thread_cache()
+{
+#ifdef USE_THREAD_CACHES
+    auto& cache = s_thread_cache;
+    PthreadMutexLocker locker(s_malloc_mutex);
+    collect_thread_cache_stats(cache);
+    for (auto& bin : cache.bins)
+        flush_thread_cache_bin(bin, bin.count);
+    cache.destroyed = true;
+#endif
+}
+
 void serenity_dump_malloc_stats()
 {
+#ifdef USE_THREAD_CACHES
+    {
+        // Other threads' numbers only show up once they take the lock again.
+        PthreadMutexLocker locker(s_malloc_mutex);
+        collect_thread_cache_stats(s_thread_cache);
+    }
+#endif
     dbgln("# malloc() calls: {}", g_malloc_stats.number_of_malloc_calls);
     dbgln();
     dbgln("big alloc hits: {}", g_malloc_stats.number_of_big_allocator_hits);
@@ -520,5 +692,9 @@ void serenity_dump_malloc_stats()
     dbgln("number of hot keeps: {}", g_malloc_stats.number_of_hot_keeps);
     dbgln("number of cold keeps: {}", g_malloc_stats.number_of_cold_keeps);
     dbgln("number of frees: {}", g_malloc_stats.number_of_frees);
+    dbgln();
+    dbgln("thread cache hits: {}", g_malloc_stats.number_of_thread_cache_hits);
+    dbgln("thread cache refills: {}", g_malloc_stats.number_of_thread_cache_refills);
+    dbgln("thread cache flushes: {}", g_malloc_stats.number_of_thread_cache_flushes);
 }
 }
@@ -32,8 +32,10 @@ void __pthread_fork_prepare(void)
         return;
 
     __pthread_mutex_lock(&g_atfork_list_mutex);
-    for (auto entry : g_atfork_prepare_list.get())
-        entry();
+    // POSIX wants these called in the opposite order of their registration.
+    auto& prepare_list = g_atfork_prepare_list.get();
+    for (size_t i = prepare_list.size(); i > 0; --i)
+        prepare_list[i - 1]();
     __pthread_mutex_unlock(&g_atfork_list_mutex);
 }
 
@@ -13,22 +13,56 @@
 
 #include <spawn.h>
 
-#include <AK/Function.h>
+#include <AK/String.h>
 #include <AK/Vector.h>
+#include <alloca.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <syscall.h>
 #include <unistd.h>
 
 struct posix_spawn_file_actions_state {
-    Vector<Function<int()>, 4> actions;
+    struct Action {
+        Syscall::SpawnFileActionType type;
+        int fd { -1 };
+        int new_fd { -1 };
+        int flags { 0 };
+        mode_t mode { 0 };
+        String path;
+    };
+    Vector<Action, 4> actions;
 };
 
 extern "C" {
 
+static int apply_file_action(const posix_spawn_file_actions_state::Action& action)
+{
+    switch (action.type) {
+    case Syscall::SpawnFileActionType::Open: {
+        int opened_fd = open(action.path.characters(), action.flags, action.mode);
+        if (opened_fd < 0 || opened_fd == action.fd)
+            return opened_fd;
+        if (int rc = dup2(opened_fd, action.fd); rc < 0)
+            return rc;
+        return close(opened_fd);
+    }
+    case Syscall::SpawnFileActionType::Close:
+        return close(action.fd);
+    case Syscall::SpawnFileActionType::Dup2:
+        return dup2(action.fd, action.new_fd);
+    case Syscall::SpawnFileActionType::Chdir:
+        return chdir(action.path.characters());
+    case Syscall::SpawnFileActionType::Fchdir:
+        return fchdir(action.fd);
+    }
+    VERIFY_NOT_REACHED();
+}
+
 [[noreturn]] static void posix_spawn_child(const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[], int (*exec)(const char*, char* const[], char* const[]))
 {
     if (attr) {
@@ -87,7 +121,7 @@ extern "C" {
 
     if (file_actions) {
         for (const auto& action : file_actions->state->actions) {
-            if (action() < 0) {
+            if (apply_file_action(action) < 0) {
                 perror("posix_spawn file action");
                 _exit(127);
             }
@@ -99,7 +133,7 @@ extern "C" {
     _exit(127);
 }
 
-int posix_spawn(pid_t* out_pid, const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[])
+static int posix_spawn_with_fork(pid_t* out_pid, const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[], int (*exec)(const char*, char* const[], char* const[]))
 {
     pid_t child_pid = fork();
     if (child_pid < 0)
@@ -110,57 +144,112 @@ int posix_spawn(pid_t* out_pid, const char* path, const posix_spawn_file_actions
         return 0;
     }
 
-    posix_spawn_child(path, file_actions, attr, argv, envp, execve);
+    posix_spawn_child(path, file_actions, attr, argv, envp, exec);
 }
 
-int posix_spawnp(pid_t* out_pid, const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[])
+// Has the kernel create the child, without making a copy of our address space first.
+// Returns ENOTSUP for the few cases that need an actual fork().
+static int posix_spawn_in_kernel(pid_t* out_pid, const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[])
 {
-    pid_t child_pid = fork();
-    if (child_pid < 0)
-        return errno;
+    size_t arg_count = 0;
+    for (size_t i = 0; argv[i]; ++i)
+        ++arg_count;
+
+    size_t env_count = 0;
+    for (size_t i = 0; envp[i]; ++i)
+        ++env_count;
+
+    auto copy_strings = [&](auto& vec, size_t count, auto& output) {
+        output.length = count;
+        for (size_t i = 0; vec[i]; ++i) {
+            output.strings[i].characters = vec[i];
+            output.strings[i].length = strlen(vec[i]);
+        }
+    };
 
-    if (child_pid != 0) {
-        *out_pid = child_pid;
-        return 0;
+    Syscall::SC_posix_spawn_params params {};
+    params.arguments.strings = (Syscall::StringArgument*)alloca(arg_count * sizeof(Syscall::StringArgument));
+    params.environment.strings = (Syscall::StringArgument*)alloca(env_count * sizeof(Syscall::StringArgument));
+
+    params.path = { path, strlen(path) };
+    copy_strings(argv, arg_count, params.arguments);
+    copy_strings(envp, env_count, params.environment);
+
+    Vector<Syscall::SC_spawn_file_action, 8> actions;
+    if (file_actions) {
+        for (auto& action : file_actions->state->actions)
+            actions.append({ action.type, action.fd, action.new_fd, action.flags, (u16)action.mode, { action.path.characters(), action.path.length() } });
     }
+    params.file_actions = actions.data();
+    params.file_action_count = actions.size();
+
+    if (attr) {
+        params.flags = attr->flags;
+        params.pgroup = attr->pgroup;
+        params.sched_priority = attr->schedparam.sched_priority;
+    }
+
+    int rc = syscall(SC_posix_spawn, &params);
+    if (rc < 0)
+        return -rc;
+    *out_pid = rc;
+    return 0;
+}
+
+int posix_spawn(pid_t* out_pid, const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[])
+{
+    int rc = posix_spawn_in_kernel(out_pid, path, file_actions, attr, argv, envp);
+    if (rc != ENOTSUP)
+        return rc;
+    return posix_spawn_with_fork(out_pid, path, file_actions, attr, argv, envp, execve);
+}
 
-    posix_spawn_child(path, file_actions, attr, argv, envp, execvpe);
+int posix_spawnp(pid_t* out_pid, const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[])
+{
+    if (strchr(path, '/'))
+        return posix_spawn(out_pid, path, file_actions, attr, argv, envp);
+
+    String search_path = getenv("PATH");
+    if (search_path.is_empty())
+        search_path = "/bin:/usr/bin";
+    for (auto& part : search_path.split(':')) {
+        auto candidate = String::formatted("{}/{}", part, path);
+        int rc = posix_spawn_in_kernel(out_pid, candidate.characters(), file_actions, attr, argv, envp);
+        if (rc == ENOTSUP)
+            return posix_spawn_with_fork(out_pid, path, file_actions, attr, argv, envp, execvpe);
+        if (rc != ENOENT)
+            return rc;
+    }
+    return ENOENT;
 }
 
 int posix_spawn_file_actions_addchdir(posix_spawn_file_actions_t* actions, const char* path)
 {
-    actions->state->actions.append([path]() { return chdir(path); });
+    actions->state->actions.append({ .type = Syscall::SpawnFileActionType::Chdir, .path = path });
     return 0;
 }
 
 int posix_spawn_file_actions_addfchdir(posix_spawn_file_actions_t* actions, int fd)
 {
-    actions->state->actions.append([fd]() { return fchdir(fd); });
+    actions->state->actions.append({ .type = Syscall::SpawnFileActionType::Fchdir, .fd = fd });
     return 0;
 }
 
 int posix_spawn_file_actions_addclose(posix_spawn_file_actions_t* actions, int fd)
 {
-    actions->state->actions.append([fd]() { return close(fd); });
+    actions->state->actions.append({ .type = Syscall::SpawnFileActionType::Close, .fd = fd });
     return 0;
 }
 
 int posix_spawn_file_actions_adddup2(posix_spawn_file_actions_t* actions, int old_fd, int new_fd)
 {
-    actions->state->actions.append([old_fd, new_fd]() { return dup2(old_fd, new_fd); });
+    actions->state->actions.append({ .type = Syscall::SpawnFileActionType::Dup2, .fd = old_fd, .new_fd = new_fd });
     return 0;
 }
 
 int posix_spawn_file_actions_addopen(posix_spawn_file_actions_t* actions, int want_fd, const char* path, int flags, mode_t mode)
 {
-    actions->state->actions.append([want_fd, path, flags, mode]() {
-        int opened_fd = open(path, flags, mode);
-        if (opened_fd < 0 || opened_fd == want_fd)
-            return opened_fd;
-        if (int rc = dup2(opened_fd, want_fd); rc < 0)
-            return rc;
-        return close(opened_fd);
-    });
+    actions->state->actions.append({ .type = Syscall::SpawnFileActionType::Open, .fd = want_fd, .flags = flags, .mode = mode, .path = path });
     return 0;
 }
 
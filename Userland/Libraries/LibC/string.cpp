@@ -45,6 +45,8 @@ size_t strcspn(const char* s, const char* reject)
     }
 }
 
+// x86_64 has a vectorized version of this in arch/x86_64/string.cpp.
+#if !ARCH(X86_64)
 size_t strlen(const char* str)
 {
     size_t len = 0;
@@ -52,6 +54,7 @@ size_t strlen(const char* str)
         ++len;
     return len;
 }
+#endif
 
 size_t strnlen(const char* str, size_t maxlen)
 {
@@ -111,6 +114,8 @@ int memcmp(const void* v1, const void* v2, size_t n)
     return 0;
 }
 
+// x86_64 has vectorized versions of these in arch/x86_64/string.cpp.
+#if !ARCH(X86_64)
 void* memcpy(void* dest_ptr, const void* src_ptr, size_t n)
 {
     void* original_dest = dest_ptr;
@@ -127,19 +132,11 @@ void* memset(void* dest_ptr, int c, size_t n)
     if (!(dest & 0x3) && n >= 12) {
         size_t size_ts = n / sizeof(size_t);
         size_t expanded_c = explode_byte((u8)c);
-#if ARCH(I386)
         asm volatile(
             "rep stosl\n"
             : "=D"(dest)
             : "D"(dest), "c"(size_ts), "a"(expanded_c)
             : "memory");
-#else
-        asm volatile(
-            "rep stosq\n"
-            : "=D"(dest)
-            : "D"(dest), "c"(size_ts), "a"(expanded_c)
-            : "memory");
-#endif
         n -= size_ts * sizeof(size_t);
         if (n == 0)
             return dest_ptr;
@@ -163,6 +160,7 @@ void* memmove(void* dest, const void* src, size_t n)
         *--pd = *--ps;
     return dest;
 }
+#endif
 
 const void* memmem(const void* haystack, size_t haystack_length, const void* needle, size_t needle_length)
 {
@@ -200,6 +198,8 @@ size_t strlcpy(char* dest, const char* src, size_t n)
     return i;
 }
 
+// x86_64 has vectorized versions of these in arch/x86_64/string.cpp.
+#if !ARCH(X86_64)
 char* strchr(const char* str, int c)
 {
     char ch = c;
@@ -230,6 +230,7 @@ void* memchr(const void* ptr, int c, size_t size)
     }
     return nullptr;
 }
+#endif
 
 char* strrchr(const char* str, int ch)
 {
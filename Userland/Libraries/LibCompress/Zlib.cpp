@@ -28,17 +28,29 @@ Optional<Zlib> Zlib::try_create(ReadonlyBytes data)
     zlib.m_has_dictionary = (flags >> 5) & 0x1;
     zlib.m_compression_level = (flags >> 6) & 0x3;
 
-    if (zlib.m_compression_method != 8 || zlib.m_compression_info > 7)
-        return {}; // non-deflate compression
+    if (!is_valid_header(compression_info, flags))
+        return {};
+
+    zlib.m_data_bytes = data.slice(2, data.size() - 2 - 4);
+    return zlib;
+}
 
-    if (zlib.m_has_dictionary)
-        return {}; // we dont support pre-defined dictionaries
+bool Zlib::is_valid_header(u8 compression_info, u8 flags)
+{
+    u8 compression_method = compression_info & 0xF;
+    u8 window_size = (compression_info >> 4) & 0xF;
+    bool has_dictionary = (flags >> 5) & 0x1;
+
+    if (compression_method != 8 || window_size > 7)
+        return false; // non-deflate compression
+
+    if (has_dictionary)
+        return false; // we dont support pre-defined dictionaries
 
     if ((compression_info * 256 + flags) % 31 != 0)
-        return {}; // error correction code doesn't match
+        return false; // error correction code doesn't match
 
-    zlib.m_data_bytes = data.slice(2, data.size() - 2 - 4);
-    return zlib;
+    return true;
 }
 
 Zlib::Zlib(const ReadonlyBytes& data)
@@ -21,6 +21,9 @@ public:
     static Optional<Zlib> try_create(ReadonlyBytes data);
     static Optional<ByteBuffer> decompress_all(ReadonlyBytes);
 
+    // Checks the two-byte CMF/FLG header, for callers that stream the deflate data themselves.
+    static bool is_valid_header(u8 compression_info, u8 flags);
+
 private:
     Zlib(const ReadonlyBytes& data);
 
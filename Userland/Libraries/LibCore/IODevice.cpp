@@ -116,15 +116,11 @@ bool IODevice::can_read_line() const
         // Populate buffer until a newline is found or we reach EOF.
 
         auto previous_buffer_size = m_buffered_data.size();
-        populate_read_buffer();
+        // NOTE: Don't look at m_error here, it may still be set from an earlier read that would have blocked.
+        if (!populate_read_buffer())
+            return m_eof && !m_buffered_data.is_empty();
         auto new_buffer_size = m_buffered_data.size();
 
-        if (m_error)
-            return false;
-
-        if (m_eof)
-            return !m_buffered_data.is_empty();
-
         if (m_buffered_data.contains_in_range('\n', previous_buffer_size, new_buffer_size - 1))
             return true;
     }
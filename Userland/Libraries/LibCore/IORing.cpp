@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <LibCore/IORing.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __serenity__
+#    include <serenity.h>
+#endif
+
+namespace Core {
+
+// Only supported in serenity mode because we use the io_ring syscalls
+#ifdef __serenity__
+
+Result<NonnullRefPtr<IORing>, String> IORing::create(unsigned entries)
+{
+    int fd = io_ring_create(entries);
+    if (fd < 0)
+        return String::formatted("IORing: Could not create I/O ring: {}", strerror(errno));
+
+    size_t mapping_size = io_ring_mapping_size(entries);
+    auto* mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        auto error = String::formatted("IORing: Could not map I/O ring: {}", strerror(errno));
+        close(fd);
+        return error;
+    }
+
+    auto notifier = Notifier::construct(fd, Notifier::Event::Read);
+    return adopt_ref(*new IORing(fd, (u8*)mapping, mapping_size, move(notifier)));
+}
+
+IORing::IORing(int fd, u8* mapping, size_t mapping_size, NonnullRefPtr<Notifier> notifier)
+    : m_mapping(mapping)
+    , m_mapping_size(mapping_size)
+    , m_notifier(move(notifier))
+{
+    VERIFY(m_notifier->fd() == fd);
+    m_submission_tail = header().submission_tail;
+    m_notifier->on_ready_to_read = [this] {
+        // The ring also becomes readable when a parked operation might be able to make progress,
+        // which only happens once we enter the kernel again.
+        if (!enter(0))
+            return;
+        dispatch_completions();
+        if (unsubmitted() > 0)
+            submit();
+    };
+}
+
+IORing::~IORing()
+{
+    m_notifier->on_ready_to_read = nullptr;
+    munmap(m_mapping, m_mapping_size);
+    close(m_notifier->fd());
+}
+
+u32 IORing::unsubmitted() const
+{
+    auto& header = *reinterpret_cast<IORingHeader const*>(m_mapping);
+    return m_submission_tail - AK::atomic_load(&header.submission_head, AK::MemoryOrder::memory_order_acquire);
+}
+
+bool IORing::enter(unsigned min_complete)
+{
+    ++m_enter_count;
+    for (;;) {
+        int rc = io_ring_enter(fd(), unsubmitted(), min_complete);
+        if (rc >= 0)
+            return true;
+        if (errno != EINTR)
+            return false;
+    }
+}
+
+void IORing::dispatch_completions()
+{
+    auto& header = this->header();
+    u32 mask = header.completion_entries - 1;
+    for (;;) {
+        u32 head = header.completion_head;
+        if (head == AK::atomic_load(&header.completion_tail, AK::MemoryOrder::memory_order_acquire))
+            return;
+        auto completion = completions()[head & mask];
+        AK::atomic_store(&header.completion_head, head + 1, AK::MemoryOrder::memory_order_release);
+
+        // The callback is taken out first, since it may well queue more operations, or even wait for them.
+        auto it = m_callbacks.find(completion.user_data);
+        VERIFY(it != m_callbacks.end());
+        auto callback = move(it->value);
+        m_callbacks.remove(it);
+        if (callback)
+            callback(completion.result);
+    }
+}
+
+bool IORing::submit()
+{
+    if (!enter(0))
+        return false;
+    dispatch_completions();
+    return true;
+}
+
+bool IORing::submit_and_wait(unsigned completions)
+{
+    if (!enter(completions))
+        return false;
+    dispatch_completions();
+    return true;
+}
+
+void IORing::queue(IORingSubmission& submission, Callback callback)
+{
+    // Make room by handing the queued submissions to the kernel. It only takes as many as it has
+    // completion entries left for, so if that's not enough, we have to wait for something to finish.
+    while (unsubmitted() == header().submission_entries) {
+        bool success = submit();
+        if (success && unsubmitted() == header().submission_entries)
+            success = submit_and_wait(1);
+        if (!success) {
+            callback(-errno);
+            return;
+        }
+    }
+
+    submission.user_data = m_next_user_data++;
+    m_callbacks.set(submission.user_data, move(callback));
+    submissions()[m_submission_tail & (header().submission_entries - 1)] = submission;
+    ++m_submission_tail;
+    AK::atomic_store(&header().submission_tail, m_submission_tail, AK::MemoryOrder::memory_order_release);
+}
+
+void IORing::nop(Callback callback)
+{
+    IORingSubmission submission {};
+    submission.opcode = IORingOpcode::Nop;
+    submission.fd = -1;
+    queue(submission, move(callback));
+}
+
+void IORing::read(int fd, Bytes buffer, Callback callback, u64 offset)
+{
+    IORingSubmission submission {};
+    submission.opcode = IORingOpcode::Read;
+    submission.fd = fd;
+    submission.buffer = (FlatPtr)buffer.data();
+    submission.length = buffer.size();
+    submission.offset = offset;
+    queue(submission, move(callback));
+}
+
+void IORing::write(int fd, ReadonlyBytes buffer, Callback callback, u64 offset)
+{
+    IORingSubmission submission {};
+    submission.opcode = IORingOpcode::Write;
+    submission.fd = fd;
+    submission.buffer = (FlatPtr)buffer.data();
+    submission.length = buffer.size();
+    submission.offset = offset;
+    queue(submission, move(callback));
+}
+
+void IORing::fsync(int fd, Callback callback)
+{
+    IORingSubmission submission {};
+    submission.opcode = IORingOpcode::Fsync;
+    submission.fd = fd;
+    queue(submission, move(callback));
+}
+
+void IORing::send(int fd, ReadonlyBytes buffer, int flags, Callback callback)
+{
+    IORingSubmission submission {};
+    submission.opcode = IORingOpcode::Send;
+    submission.fd = fd;
+    submission.buffer = (FlatPtr)buffer.data();
+    submission.length = buffer.size();
+    submission.flags = flags;
+    queue(submission, move(callback));
+}
+
+void IORing::recv(int fd, Bytes buffer, int flags, Callback callback)
+{
+    IORingSubmission submission {};
+    submission.opcode = IORingOpcode::Recv;
+    submission.fd = fd;
+    submission.buffer = (FlatPtr)buffer.data();
+    submission.length = buffer.size();
+    submission.flags = flags;
+    queue(submission, move(callback));
+}
+
+void IORing::accept(int fd, int flags, Callback callback)
+{
+    IORingSubmission submission {};
+    submission.opcode = IORingOpcode::Accept;
+    submission.fd = fd;
+    submission.flags = flags;
+    queue(submission, move(callback));
+}
+
+void IORing::poll(int fd, short events, Callback callback)
+{
+    IORingSubmission submission {};
+    submission.opcode = IORingOpcode::Poll;
+    submission.fd = fd;
+    submission.poll_events = events;
+    queue(submission, move(callback));
+}
+
+#endif
+
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Function.h>
+#include <AK/HashMap.h>
+#include <AK/Noncopyable.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/RefCounted.h>
+#include <AK/Result.h>
+#include <AK/Span.h>
+#include <AK/String.h>
+#include <Kernel/API/IORing.h>
+#include <LibCore/Notifier.h>
+
+namespace Core {
+
+// Queues file and socket operations on a kernel I/O ring, so that a whole batch of them costs a single syscall.
+//
+// Nothing is handed to the kernel until submit() is called, or until the submission queue fills up.
+// Each operation's callback gets what the equivalent syscall would have returned, or a negated errno.
+// The buffers have to stay alive until then.
+//
+// Completions are picked up from the event loop, like any other fd becoming readable, and callbacks
+// that queue more operations have them submitted right after. Without an event loop, use submit_and_wait().
+class IORing final : public RefCounted<IORing> {
+    AK_MAKE_NONCOPYABLE(IORing);
+
+public:
+    using Callback = Function<void(int result)>;
+
+    static Result<NonnullRefPtr<IORing>, String> create(unsigned entries = 64);
+    ~IORing();
+
+    int fd() const { return m_notifier->fd(); }
+
+    void nop(Callback);
+    void read(int fd, Bytes, Callback, u64 offset = IO_RING_CURRENT_OFFSET);
+    void write(int fd, ReadonlyBytes, Callback, u64 offset = IO_RING_CURRENT_OFFSET);
+    void fsync(int fd, Callback);
+    void send(int fd, ReadonlyBytes, int flags, Callback);
+    void recv(int fd, Bytes, int flags, Callback);
+    void accept(int fd, int flags, Callback);
+    void poll(int fd, short events, Callback);
+
+    // These return false and leave errno set if io_ring_enter() fails.
+    bool submit();
+    bool submit_and_wait(unsigned completions = 1);
+
+    size_t operations_in_flight() const { return m_callbacks.size(); }
+
+    // How many times io_ring_enter() has been called, to compare with the syscalls the operations would have taken.
+    size_t enter_count() const { return m_enter_count; }
+
+private:
+    IORing(int fd, u8* mapping, size_t mapping_size, NonnullRefPtr<Notifier>);
+
+    IORingHeader& header() { return *reinterpret_cast<IORingHeader*>(m_mapping); }
+    IORingSubmission* submissions() { return reinterpret_cast<IORingSubmission*>(m_mapping + header().submissions_offset); }
+    IORingCompletion* completions() { return reinterpret_cast<IORingCompletion*>(m_mapping + header().completions_offset); }
+
+    void queue(IORingSubmission&, Callback);
+    u32 unsubmitted() const;
+    bool enter(unsigned min_complete);
+    void dispatch_completions();
+
+    u8* m_mapping { nullptr };
+    size_t m_mapping_size { 0 };
+    NonnullRefPtr<Notifier> m_notifier;
+
+    u32 m_submission_tail { 0 };
+    u64 m_next_user_data { 1 };
+    HashMap<u64, Callback> m_callbacks;
+    size_t m_enter_count { 0 };
+};
+
+}
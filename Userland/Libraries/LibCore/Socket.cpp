@@ -191,6 +191,12 @@ void Socket::did_update_fd(int fd)
     }
 }
 
+void Socket::set_read_notifier_enabled(bool enabled)
+{
+    if (m_read_notifier)
+        m_read_notifier->set_enabled(enabled);
+}
+
 void Socket::ensure_read_notifier()
 {
     VERIFY(m_connected);
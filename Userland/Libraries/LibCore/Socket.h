@@ -36,6 +36,9 @@ public:
     bool is_connected() const { return m_connected; }
     void set_blocking(bool blocking);
 
+    // Stops on_ready_to_read from being called until re-enabled.
+    void set_read_notifier_enabled(bool);
+
     SocketAddress source_address() const { return m_source_address; }
     int source_port() const { return m_source_port; }
 
@@ -7,10 +7,16 @@
 #include <AK/ByteReader.h>
 #include <AK/Debug.h>
 #include <AK/MemoryStream.h>
+#include <AK/Platform.h>
 #include <AK/Types.h>
 #include <AK/Vector.h>
 #include <LibCrypto/Authentication/GHash.h>
 #include <LibCrypto/BigInt/UnsignedBigInteger.h>
+#include <LibCrypto/CPUFeatures.h>
+
+#if ARCH(I386) || ARCH(X86_64)
+#    include <immintrin.h>
+#endif
 
 namespace {
 
@@ -26,6 +32,100 @@ static void to_u8s(u8* b, const u32* w)
     }
 }
 
+#if ARCH(I386) || ARCH(X86_64)
+
+// Carry-less multiplication in GF(2^128), following Intel's "Carry-Less Multiplication
+// and its Usage for Computing the GCM Mode" (algorithms 1 and 5). All operands are
+// byte-reflected, so the 256-bit product has to be shifted left by one bit before reduction.
+#    define PCLMUL_TARGET __attribute__((target("pclmul,ssse3")))
+
+PCLMUL_TARGET static inline void clmul_unreduced(__m128i a, __m128i b, __m128i& low, __m128i& high)
+{
+    auto middle = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10), _mm_clmulepi64_si128(a, b, 0x01));
+    low = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x00), _mm_slli_si128(middle, 8));
+    high = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x11), _mm_srli_si128(middle, 8));
+}
+
+PCLMUL_TARGET static inline __m128i reduce(__m128i low, __m128i high)
+{
+    // Shift the 256-bit value high:low left by one bit.
+    auto low_carry = _mm_srli_epi32(low, 31);
+    auto high_carry = _mm_srli_epi32(high, 31);
+    low = _mm_slli_epi32(low, 1);
+    high = _mm_slli_epi32(high, 1);
+    auto carry_into_high = _mm_srli_si128(low_carry, 12);
+    high_carry = _mm_slli_si128(high_carry, 4);
+    low_carry = _mm_slli_si128(low_carry, 4);
+    low = _mm_or_si128(low, low_carry);
+    high = _mm_or_si128(_mm_or_si128(high, high_carry), carry_into_high);
+
+    // Reduce modulo x^128 + x^7 + x^2 + x + 1.
+    auto t = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(low, 31), _mm_slli_epi32(low, 30)), _mm_slli_epi32(low, 25));
+    auto t_high = _mm_srli_si128(t, 4);
+    low = _mm_xor_si128(low, _mm_slli_si128(t, 12));
+    auto u = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(low, 1), _mm_srli_epi32(low, 2)), _mm_srli_epi32(low, 7));
+    u = _mm_xor_si128(u, t_high);
+    low = _mm_xor_si128(low, u);
+    return _mm_xor_si128(high, low);
+}
+
+PCLMUL_TARGET static inline __m128i gf_multiply(__m128i a, __m128i b)
+{
+    __m128i low, high;
+    clmul_unreduced(a, b, low, high);
+    return reduce(low, high);
+}
+
+PCLMUL_TARGET static inline __m128i load_reflected(const u8* data)
+{
+    auto const reverse_bytes = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    return _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), reverse_bytes);
+}
+
+// Folds `data` (zero-padded to a whole block) into the tag, four blocks per reduction.
+PCLMUL_TARGET static __m128i ghash_blocks(__m128i tag, const __m128i (&key_powers)[4], ReadonlyBytes data)
+{
+    size_t offset = 0;
+    for (; offset + 64 <= data.size(); offset += 64) {
+        __m128i low, high, product_low, product_high;
+        clmul_unreduced(_mm_xor_si128(tag, load_reflected(data.offset(offset))), key_powers[3], low, high);
+        for (size_t i = 1; i < 4; ++i) {
+            clmul_unreduced(load_reflected(data.offset(offset + i * 16)), key_powers[3 - i], product_low, product_high);
+            low = _mm_xor_si128(low, product_low);
+            high = _mm_xor_si128(high, product_high);
+        }
+        tag = reduce(low, high);
+    }
+
+    for (; offset < data.size(); offset += 16) {
+        u8 block[16] {};
+        __builtin_memcpy(block, data.offset(offset), min<size_t>(16, data.size() - offset));
+        tag = gf_multiply(_mm_xor_si128(tag, load_reflected(block)), key_powers[0]);
+    }
+    return tag;
+}
+
+PCLMUL_TARGET static void ghash_process_pclmul(const u32 (&key)[4], ReadonlyBytes aad, ReadonlyBytes cipher, u8* digest)
+{
+    // The key words are big-endian values, so reversing their order yields the reflected key.
+    __m128i key_powers[4];
+    key_powers[0] = _mm_setr_epi32(key[3], key[2], key[1], key[0]);
+    for (size_t i = 1; i < 4; ++i)
+        key_powers[i] = gf_multiply(key_powers[i - 1], key_powers[0]);
+
+    auto tag = _mm_setzero_si128();
+    tag = ghash_blocks(tag, key_powers, aad);
+    tag = ghash_blocks(tag, key_powers, cipher);
+
+    auto lengths = _mm_set_epi64x(8 * (u64)aad.size(), 8 * (u64)cipher.size());
+    tag = gf_multiply(_mm_xor_si128(tag, lengths), key_powers[0]);
+
+    auto const reverse_bytes = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(digest), _mm_shuffle_epi8(tag, reverse_bytes));
+}
+
+#endif
+
 }
 
 namespace Crypto {
@@ -33,6 +133,14 @@ namespace Authentication {
 
 GHash::TagType GHash::process(ReadonlyBytes aad, ReadonlyBytes cipher)
 {
+#if ARCH(I386) || ARCH(X86_64)
+    if (cpu_features().pclmul && cpu_features().ssse3) {
+        TagType digest;
+        ghash_process_pclmul(m_key, aad, cipher, digest.data);
+        return digest;
+    }
+#endif
+
     u32 tag[4] { 0, 0, 0, 0 };
 
     auto transform_one = [&](auto& buf) {
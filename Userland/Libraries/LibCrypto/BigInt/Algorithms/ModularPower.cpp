@@ -70,112 +70,162 @@ ALWAYS_INLINE static u32 inverse_wrapped(u32 value)
     return static_cast<u32>(-k0);
 }
 
-/**
- * Computes z = x * y + c. z_carry contains the top bits, z contains the bottom bits.
- */
-ALWAYS_INLINE static void linear_multiplication_with_carry(u32 x, u32 y, u32 c, u32& z_carry, u32& z)
-{
-    u64 result = static_cast<u64>(x) * static_cast<u64>(y) + static_cast<u64>(c);
-    z_carry = static_cast<u32>(result >> 32);
-    z = static_cast<u32>(result);
-}
+using Word = UnsignedBigInteger::Word;
+using DoubleWord = u64;
 
 /**
- * Computes z = a + b. z_carry contains the top bit (1 or 0), z contains the bottom bits.
+ * Finishes an "almost montgomery" operation, whose num_words + 1 word result is in t and top_word.
+ * If the top word is set, the modulo is subtracted once, which always brings the result back into num_words.
  */
-ALWAYS_INLINE static void addition_with_carry(u32 a, u32 b, u32& z_carry, u32& z)
+ALWAYS_INLINE static void finish_almost_montgomery(Word const* t, Word top_word, Word const* modulo, size_t num_words, Word* result)
 {
-    u64 result = static_cast<u64>(a) + static_cast<u64>(b);
-    z_carry = static_cast<u32>(result >> 32);
-    z = static_cast<u32>(result);
-}
+    if (top_word == 0) {
+        __builtin_memcpy(result, t, num_words * sizeof(Word));
+        return;
+    }
 
-/**
- * Computes a montgomery "fragment" for y_i. This computes "z[i] += x[i] * y_i" for all words while rippling the carry, and returns the carry.
- * Algorithm from: Gueron, "Efficient Software Implementations of Modular Exponentiation". (https://eprint.iacr.org/2011/239.pdf)
- */
-UnsignedBigInteger::Word UnsignedBigIntegerAlgorithms::montgomery_fragment(UnsignedBigInteger& z, size_t offset_in_z, UnsignedBigInteger const& x, UnsignedBigInteger::Word y_digit, size_t num_words)
-{
-    UnsignedBigInteger::Word carry { 0 };
+    Word borrow = 0;
     for (size_t i = 0; i < num_words; ++i) {
-        UnsignedBigInteger::Word a_carry;
-        UnsignedBigInteger::Word a;
-        linear_multiplication_with_carry(x.m_words[i], y_digit, z.m_words[offset_in_z + i], a_carry, a);
-        UnsignedBigInteger::Word b_carry;
-        UnsignedBigInteger::Word b;
-        addition_with_carry(a, carry, b_carry, b);
-        z.m_words[offset_in_z + i] = b;
-        carry = a_carry + b_carry;
+        DoubleWord difference = static_cast<DoubleWord>(t[i]) - modulo[i] - borrow;
+        result[i] = static_cast<Word>(difference);
+        borrow = static_cast<Word>(difference >> UnsignedBigInteger::BITS_IN_WORD) & 1;
     }
-    return carry;
 }
 
 /**
  * Computes the "almost montgomery" product : x * y * 2 ^ (-num_words * BITS_IN_WORD) % modulo
  * [Note : that means that the result z satisfies z * 2^(num_words * BITS_IN_WORD) % modulo = x * y % modulo]
  * assuming :
- *  - x, y and modulo are all already padded to num_words
+ *  - x, y and modulo are all num_words long
  *  - k = inverse_wrapped(modulo) (optimization to not recompute K each time)
- * Algorithm from: Gueron, "Efficient Software Implementations of Modular Exponentiation". (https://eprint.iacr.org/2011/239.pdf)
+ *  - t has room for num_words + 2 words
+ * The multiplication and the reduction are interleaved word by word (the "CIOS" method), so t never grows past num_words + 2 words.
+ * When FixedWords isn't 0, it has to be num_words, and lets the compiler unroll the loops for that size.
+ * Algorithm from: Koç, Acar, Kaliski, "Analyzing and Comparing Montgomery Multiplication Algorithms".
  */
-void UnsignedBigIntegerAlgorithms::almost_montgomery_multiplication_without_allocation(
-    UnsignedBigInteger const& x,
-    UnsignedBigInteger const& y,
-    UnsignedBigInteger const& modulo,
-    UnsignedBigInteger& z,
-    UnsignedBigInteger::Word k,
-    size_t num_words,
-    UnsignedBigInteger& result)
+template<size_t FixedWords>
+static void almost_montgomery_multiply(Word const* x, Word const* y, Word const* modulo, Word k, size_t num_words, Word* t, Word* result)
 {
-    VERIFY(x.length() >= num_words);
-    VERIFY(y.length() >= num_words);
-    VERIFY(modulo.length() >= num_words);
+    size_t const n = FixedWords ? FixedWords : num_words;
+    __builtin_memset(t, 0, (n + 2) * sizeof(Word));
+
+    for (size_t i = 0; i < n; ++i) {
+        // t += x * y_i
+        DoubleWord carry = 0;
+        DoubleWord y_word = y[i];
+        for (size_t j = 0; j < n; ++j) {
+            carry += y_word * x[j] + t[j];
+            t[j] = static_cast<Word>(carry);
+            carry >>= UnsignedBigInteger::BITS_IN_WORD;
+        }
+        carry += t[n];
+        t[n] = static_cast<Word>(carry);
+        t[n + 1] = static_cast<Word>(carry >> UnsignedBigInteger::BITS_IN_WORD);
+
+        // t = (t + modulo * (t_0 * k)) / 2^BITS_IN_WORD, the low word being zero by construction.
+        DoubleWord m = static_cast<Word>(t[0] * k);
+        carry = (m * modulo[0] + t[0]) >> UnsignedBigInteger::BITS_IN_WORD;
+        for (size_t j = 1; j < n; ++j) {
+            carry += m * modulo[j] + t[j];
+            t[j - 1] = static_cast<Word>(carry);
+            carry >>= UnsignedBigInteger::BITS_IN_WORD;
+        }
+        carry += t[n];
+        t[n - 1] = static_cast<Word>(carry);
+        t[n] = t[n + 1] + static_cast<Word>(carry >> UnsignedBigInteger::BITS_IN_WORD);
+    }
 
-    z.set_to(0);
-    z.resize_with_leading_zeros(num_words * 2);
+    finish_almost_montgomery(t, t[n], modulo, n, result);
+}
 
-    UnsignedBigInteger::Word previous_double_carry { 0 };
-    for (size_t i = 0; i < num_words; ++i) {
-        // z[i->num_words+i] += x * y_i
-        UnsignedBigInteger::Word carry_1 = montgomery_fragment(z, i, x, y.m_words[i], num_words);
-        // z[i->num_words+i] += modulo * (z_i * k)
-        UnsignedBigInteger::Word t = z.m_words[i] * k;
-        UnsignedBigInteger::Word carry_2 = montgomery_fragment(z, i, modulo, t, num_words);
-
-        // Compute the carry by combining all of the carrys of the previous computations
-        // Put it "right after" the range that we computed above
-        UnsignedBigInteger::Word temp_carry = previous_double_carry + carry_1;
-        UnsignedBigInteger::Word overall_carry = temp_carry + carry_2;
-        z.m_words[num_words + i] = overall_carry;
-
-        // Detect if there was a "double carry" for this word by checking if our carry results are smaller than their components
-        previous_double_carry = (temp_carry < carry_1 || overall_carry < carry_2) ? 1 : 0;
+/**
+ * Same as almost_montgomery_multiply(x, x, ...), but squares x first, which only takes about half of the word multiplications,
+ * and then reduces the square one word at a time.
+ * t has to have room for 2 * num_words words.
+ */
+template<size_t FixedWords>
+static void almost_montgomery_square(Word const* x, Word const* modulo, Word k, size_t num_words, Word* t, Word* result)
+{
+    size_t const n = FixedWords ? FixedWords : num_words;
+    __builtin_memset(t, 0, 2 * n * sizeof(Word));
+
+    // The products of two different words, once.
+    for (size_t i = 0; i < n; ++i) {
+        DoubleWord carry = 0;
+        DoubleWord word = x[i];
+        for (size_t j = i + 1; j < n; ++j) {
+            carry += word * x[j] + t[i + j];
+            t[i + j] = static_cast<Word>(carry);
+            carry >>= UnsignedBigInteger::BITS_IN_WORD;
+        }
+        t[i + n] = static_cast<Word>(carry);
     }
 
-    if (previous_double_carry == 0) {
-        // Return the top num_words bytes of Z, which contains our result.
-        shift_right_by_n_words(z, num_words, result);
-        result.resize_with_leading_zeros(num_words);
-        return;
+    // Double them, and add the squares of the words themselves.
+    Word shifted_out = 0;
+    DoubleWord carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        DoubleWord square = static_cast<DoubleWord>(x[i]) * x[i];
+        Word low = t[2 * i];
+        Word high = t[2 * i + 1];
+        Word doubled_low = (low << 1) | shifted_out;
+        Word doubled_high = (high << 1) | (low >> (UnsignedBigInteger::BITS_IN_WORD - 1));
+        shifted_out = high >> (UnsignedBigInteger::BITS_IN_WORD - 1);
+
+        carry += static_cast<DoubleWord>(doubled_low) + static_cast<Word>(square);
+        t[2 * i] = static_cast<Word>(carry);
+        carry >>= UnsignedBigInteger::BITS_IN_WORD;
+        carry += static_cast<DoubleWord>(doubled_high) + (square >> UnsignedBigInteger::BITS_IN_WORD);
+        t[2 * i + 1] = static_cast<Word>(carry);
+        carry >>= UnsignedBigInteger::BITS_IN_WORD;
     }
 
-    // We have a carry, so we're "one bigger" than we need to be.
-    // Subtract the modulo from the result (the top half of z), and write it to the bottom half of Z since we have space.
-    // (With carry, of course.)
-    UnsignedBigInteger::Word c { 0 };
-    for (size_t i = 0; i < num_words; ++i) {
-        UnsignedBigInteger::Word z_digit = z.m_words[num_words + i];
-        UnsignedBigInteger::Word modulo_digit = modulo.m_words[i];
-        UnsignedBigInteger::Word new_z_digit = z_digit - modulo_digit - c;
-        z.m_words[i] = new_z_digit;
-        // Detect if the subtraction underflowed - from "Hacker's Delight"
-        c = ((modulo_digit & ~z_digit) | ((modulo_digit | ~z_digit) & new_z_digit)) >> (UnsignedBigInteger::BITS_IN_WORD - 1);
+    // Reduce it: t = (t + modulo * (t_i * k) * 2^(i * BITS_IN_WORD)) for every word, then keep the top half.
+    // The carry out of the top of each step belongs one word further up, which is exactly where the next step adds its own.
+    Word previous_carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        DoubleWord m = static_cast<Word>(t[i] * k);
+        carry = 0;
+        for (size_t j = 0; j < n; ++j) {
+            carry += m * modulo[j] + t[i + j];
+            t[i + j] = static_cast<Word>(carry);
+            carry >>= UnsignedBigInteger::BITS_IN_WORD;
+        }
+        carry += static_cast<DoubleWord>(t[i + n]) + previous_carry;
+        t[i + n] = static_cast<Word>(carry);
+        previous_carry = static_cast<Word>(carry >> UnsignedBigInteger::BITS_IN_WORD);
     }
 
-    // Return the bottom num_words bytes of Z (with the carry bit handled)
-    z.m_words.resize(num_words);
-    result.set_to(z);
-    result.resize_with_leading_zeros(num_words);
+    finish_almost_montgomery(t + n, previous_carry, modulo, n, result);
+}
+
+namespace {
+
+struct MontgomeryKernels {
+    void (*multiply)(Word const* x, Word const* y, Word const* modulo, Word k, size_t num_words, Word* t, Word* result);
+    void (*square)(Word const* x, Word const* modulo, Word k, size_t num_words, Word* t, Word* result);
+};
+
+}
+
+template<size_t FixedWords>
+static constexpr MontgomeryKernels montgomery_kernels { almost_montgomery_multiply<FixedWords>, almost_montgomery_square<FixedWords> };
+
+/**
+ * The common RSA and Diffie-Hellman sizes (2048, 3072 and 4096 bits) get kernels specialized for their size.
+ */
+static MontgomeryKernels montgomery_kernels_for(size_t num_words)
+{
+    switch (num_words) {
+    case 2048 / UnsignedBigInteger::BITS_IN_WORD:
+        return montgomery_kernels<2048 / UnsignedBigInteger::BITS_IN_WORD>;
+    case 3072 / UnsignedBigInteger::BITS_IN_WORD:
+        return montgomery_kernels<3072 / UnsignedBigInteger::BITS_IN_WORD>;
+    case 4096 / UnsignedBigInteger::BITS_IN_WORD:
+        return montgomery_kernels<4096 / UnsignedBigInteger::BITS_IN_WORD>;
+    default:
+        return montgomery_kernels<0>;
+    }
 }
 
 /**
@@ -203,6 +253,7 @@ void UnsignedBigIntegerAlgorithms::montgomery_modular_power_with_minimal_allocat
 
     size_t num_words = modulo.trimmed_length();
     UnsignedBigInteger::Word k = inverse_wrapped(modulo.m_words[0]);
+    auto kernels = montgomery_kernels_for(num_words);
 
     one.set_to(1);
 
@@ -220,17 +271,28 @@ void UnsignedBigIntegerAlgorithms::montgomery_modular_power_with_minimal_allocat
     one.set_to(1);
     one.resize_with_leading_zeros(num_words);
 
+    // The kernels work on plain words: t is their scratch space, and the running product bounces between z and zz.
+    temp_z.set_to_0();
+    temp_z.m_words.resize_and_keep_capacity(2 * num_words + 2);
+    auto* t = temp_z.m_words.data();
+    auto* modulo_words = modulo.m_words.data();
+
     // Compute the montgomery powers from 0 to 2^window_size. powers[i] = x^i
-    UnsignedBigInteger powers[1 << window_size];
-    almost_montgomery_multiplication_without_allocation(one, rr, modulo, temp_z, k, num_words, powers[0]);
-    almost_montgomery_multiplication_without_allocation(x, rr, modulo, temp_z, k, num_words, powers[1]);
+    Vector<Word> powers;
+    powers.resize((1 << window_size) * num_words);
+    auto power = [&](size_t i) { return powers.data() + i * num_words; };
+    kernels.multiply(one.m_words.data(), rr.m_words.data(), modulo_words, k, num_words, t, power(0));
+    kernels.multiply(x.m_words.data(), rr.m_words.data(), modulo_words, k, num_words, t, power(1));
     for (size_t i = 2; i < (1 << window_size); ++i)
-        almost_montgomery_multiplication_without_allocation(powers[i - 1], powers[1], modulo, temp_z, k, num_words, powers[i]);
+        kernels.multiply(power(i - 1), power(1), modulo_words, k, num_words, t, power(i));
 
-    z.set_to(powers[0]);
-    z.resize_with_leading_zeros(num_words);
-    zz.set_to(0);
-    zz.resize_with_leading_zeros(num_words);
+    z.set_to_0();
+    z.m_words.resize_and_keep_capacity(num_words);
+    zz.set_to_0();
+    zz.m_words.resize_and_keep_capacity(num_words);
+    auto* z_words = z.m_words.data();
+    auto* zz_words = zz.m_words.data();
+    __builtin_memcpy(z_words, power(0), num_words * sizeof(Word));
 
     ssize_t exponent_length = exponent.trimmed_length();
     for (ssize_t word_in_exponent = exponent_length - 1; word_in_exponent >= 0; --word_in_exponent) {
@@ -238,16 +300,15 @@ void UnsignedBigIntegerAlgorithms::montgomery_modular_power_with_minimal_allocat
         size_t bit_in_word = 0;
         while (bit_in_word < UnsignedBigInteger::BITS_IN_WORD) {
             if (word_in_exponent != exponent_length - 1 || bit_in_word != 0) {
-                almost_montgomery_multiplication_without_allocation(z, z, modulo, temp_z, k, num_words, zz);
-                almost_montgomery_multiplication_without_allocation(zz, zz, modulo, temp_z, k, num_words, z);
-                almost_montgomery_multiplication_without_allocation(z, z, modulo, temp_z, k, num_words, zz);
-                almost_montgomery_multiplication_without_allocation(zz, zz, modulo, temp_z, k, num_words, z);
+                kernels.square(z_words, modulo_words, k, num_words, t, zz_words);
+                kernels.square(zz_words, modulo_words, k, num_words, t, z_words);
+                kernels.square(z_words, modulo_words, k, num_words, t, zz_words);
+                kernels.square(zz_words, modulo_words, k, num_words, t, z_words);
             }
             auto power_index = exponent_word >> (UnsignedBigInteger::BITS_IN_WORD - window_size);
-            auto& power = powers[power_index];
-            almost_montgomery_multiplication_without_allocation(z, power, modulo, temp_z, k, num_words, zz);
+            kernels.multiply(z_words, power(power_index), modulo_words, k, num_words, t, zz_words);
 
-            swap(z, zz);
+            swap(z_words, zz_words);
 
             // Move to the next window
             exponent_word <<= window_size;
@@ -255,7 +316,12 @@ void UnsignedBigIntegerAlgorithms::montgomery_modular_power_with_minimal_allocat
         }
     }
 
-    almost_montgomery_multiplication_without_allocation(z, one, modulo, temp_z, k, num_words, zz);
+    kernels.multiply(z_words, one.m_words.data(), modulo_words, k, num_words, t, zz_words);
+
+    // The words were swapped around, so the result may have ended up in z.
+    if (zz_words != zz.m_words.data())
+        swap(z, zz);
+    temp_z.set_to_0();
 
     if (zz < modulo) {
         result.set_to(zz);
@@ -9,38 +9,246 @@
 
 namespace Crypto {
 
+using Word = UnsignedBigInteger::Word;
+using DoubleWord = u64;
+
+// Below this many words, the schoolbook method is faster than splitting the numbers up.
+static constexpr size_t karatsuba_threshold = 48;
+
+/**
+ * Adds source into destination, which has to be at least as long, and returns the carry out of it.
+ */
+static Word add_words(Word* destination, size_t destination_length, Word const* source, size_t source_length)
+{
+    DoubleWord carry = 0;
+    size_t i = 0;
+    for (; i < source_length; ++i) {
+        carry += static_cast<DoubleWord>(destination[i]) + source[i];
+        destination[i] = static_cast<Word>(carry);
+        carry >>= UnsignedBigInteger::BITS_IN_WORD;
+    }
+    for (; carry && i < destination_length; ++i) {
+        carry += destination[i];
+        destination[i] = static_cast<Word>(carry);
+        carry >>= UnsignedBigInteger::BITS_IN_WORD;
+    }
+    return static_cast<Word>(carry);
+}
+
+/**
+ * Subtracts source from destination, which has to be at least as large.
+ */
+static void subtract_words(Word* destination, size_t destination_length, Word const* source, size_t source_length)
+{
+    Word borrow = 0;
+    size_t i = 0;
+    for (; i < source_length; ++i) {
+        DoubleWord difference = static_cast<DoubleWord>(destination[i]) - source[i] - borrow;
+        destination[i] = static_cast<Word>(difference);
+        borrow = static_cast<Word>(difference >> UnsignedBigInteger::BITS_IN_WORD) & 1;
+    }
+    for (; borrow && i < destination_length; ++i) {
+        borrow = destination[i] == 0;
+        --destination[i];
+    }
+    VERIFY(borrow == 0);
+}
+
+/**
+ * Complexity: O(N*M)
+ * result has to have room for left_length + right_length words, and may not overlap with the inputs.
+ */
+static void schoolbook_multiply(Word const* left, size_t left_length, Word const* right, size_t right_length, Word* result)
+{
+    __builtin_memset(result, 0, (left_length + right_length) * sizeof(Word));
+    for (size_t i = 0; i < left_length; ++i) {
+        DoubleWord carry = 0;
+        DoubleWord left_word = left[i];
+        for (size_t j = 0; j < right_length; ++j) {
+            carry += left_word * right[j] + result[i + j];
+            result[i + j] = static_cast<Word>(carry);
+            carry >>= UnsignedBigInteger::BITS_IN_WORD;
+        }
+        result[i + right_length] = static_cast<Word>(carry);
+    }
+}
+
+/**
+ * Complexity: O(N^2), but only about half of the word multiplications of schoolbook_multiply(), since every
+ * product of two different words shows up twice in a square.
+ */
+static void schoolbook_square(Word const* value, size_t length, Word* result)
+{
+    __builtin_memset(result, 0, 2 * length * sizeof(Word));
+
+    // The products of two different words, once.
+    for (size_t i = 0; i < length; ++i) {
+        DoubleWord carry = 0;
+        DoubleWord word = value[i];
+        for (size_t j = i + 1; j < length; ++j) {
+            carry += word * value[j] + result[i + j];
+            result[i + j] = static_cast<Word>(carry);
+            carry >>= UnsignedBigInteger::BITS_IN_WORD;
+        }
+        result[i + length] = static_cast<Word>(carry);
+    }
+
+    // Double them, and add the squares of the words themselves.
+    Word shifted_out = 0;
+    DoubleWord carry = 0;
+    for (size_t i = 0; i < length; ++i) {
+        DoubleWord square = static_cast<DoubleWord>(value[i]) * value[i];
+        Word low = result[2 * i];
+        Word high = result[2 * i + 1];
+        Word doubled_low = (low << 1) | shifted_out;
+        Word doubled_high = (high << 1) | (low >> (UnsignedBigInteger::BITS_IN_WORD - 1));
+        shifted_out = high >> (UnsignedBigInteger::BITS_IN_WORD - 1);
+
+        carry += static_cast<DoubleWord>(doubled_low) + static_cast<Word>(square);
+        result[2 * i] = static_cast<Word>(carry);
+        carry >>= UnsignedBigInteger::BITS_IN_WORD;
+        carry += static_cast<DoubleWord>(doubled_high) + (square >> UnsignedBigInteger::BITS_IN_WORD);
+        result[2 * i + 1] = static_cast<Word>(carry);
+        carry >>= UnsignedBigInteger::BITS_IN_WORD;
+    }
+}
+
+/**
+ * How many words of scratch space multiply_words() may use for numbers of these lengths.
+ */
+static size_t multiplication_scratch_size(size_t left_length, size_t right_length)
+{
+    return 8 * (left_length + right_length) + 128;
+}
+
+static void multiply_words(Word const* left, size_t left_length, Word const* right, size_t right_length, Word* result, Word* scratch);
+
+/**
+ * Complexity: O(N^1.58)
+ * With left = left_high * B^half + left_low (and the same for right), the product is
+ *     left_high * right_high * B^(2 * half)
+ *   + ((left_low + left_high) * (right_low + right_high) - left_high * right_high - left_low * right_low) * B^half
+ *   + left_low * right_low
+ * which only needs three multiplications of numbers half as long.
+ */
+static void karatsuba_multiply(Word const* left, size_t left_length, Word const* right, size_t right_length, Word* result, Word* scratch)
+{
+    bool is_square = left == right && left_length == right_length;
+    size_t half = (left_length + 1) / 2;
+    VERIFY(right_length > half);
+
+    auto* left_low = left;
+    auto* left_high = left + half;
+    auto* right_low = right;
+    auto* right_high = right + half;
+    size_t left_high_length = left_length - half;
+    size_t right_high_length = right_length - half;
+    size_t result_length = left_length + right_length;
+
+    // The low and high products go straight into their places in the result, and don't overlap.
+    multiply_words(left_low, half, right_low, half, result, scratch);
+    multiply_words(left_high, left_high_length, right_high, right_high_length, result + 2 * half, scratch);
+
+    // The sums of the halves.
+    size_t sum_length = half + 1;
+    auto* left_sum = scratch;
+    auto* right_sum = is_square ? left_sum : scratch + sum_length;
+    auto* middle = scratch + 2 * sum_length;
+    size_t middle_length = 2 * sum_length;
+    auto* next_scratch = middle + middle_length;
+
+    __builtin_memcpy(left_sum, left_low, half * sizeof(Word));
+    left_sum[half] = add_words(left_sum, half, left_high, left_high_length);
+    if (!is_square) {
+        __builtin_memcpy(right_sum, right_low, half * sizeof(Word));
+        right_sum[half] = add_words(right_sum, half, right_high, right_high_length);
+    }
+
+    multiply_words(left_sum, sum_length, right_sum, sum_length, middle, next_scratch);
+    subtract_words(middle, middle_length, result, 2 * half);
+    subtract_words(middle, middle_length, result + 2 * half, result_length - 2 * half);
+
+    // The middle product can't be larger than the result, so its top words are zero when they don't fit.
+    size_t middle_length_in_result = min(middle_length, result_length - half);
+    for (size_t i = middle_length_in_result; i < middle_length; ++i)
+        VERIFY(middle[i] == 0);
+    auto carry = add_words(result + half, result_length - half, middle, middle_length_in_result);
+    VERIFY(carry == 0);
+}
+
 /**
- * Complexity: O(N^2) where N is the number of words in the larger number
- * Multiplication method:
- * An integer is equal to the sum of the powers of two
- * according to the indices of its 'on' bits.
- * So to multiple x*y, we go over each '1' bit in x (say the i'th bit),
- * and add y<<i to the result.
+ * result has to have room for left_length + right_length words, and may not overlap with the inputs.
+ */
+static void multiply_words(Word const* left, size_t left_length, Word const* right, size_t right_length, Word* result, Word* scratch)
+{
+    if (left_length < right_length) {
+        swap(left, right);
+        swap(left_length, right_length);
+    }
+    if (right_length == 0) {
+        __builtin_memset(result, 0, left_length * sizeof(Word));
+        return;
+    }
+
+    if (right_length < karatsuba_threshold) {
+        if (left == right && left_length == right_length)
+            schoolbook_square(left, left_length, result);
+        else
+            schoolbook_multiply(left, left_length, right, right_length, result);
+        return;
+    }
+
+    if (2 * right_length <= left_length + 1) {
+        // Karatsuba only pays off for numbers of about the same length, so split the longer one into pieces
+        // as long as the shorter one.
+        __builtin_memset(result, 0, (left_length + right_length) * sizeof(Word));
+        auto* product = scratch;
+        auto* next_scratch = scratch + 2 * right_length;
+        for (size_t offset = 0; offset < left_length; offset += right_length) {
+            size_t piece_length = min(right_length, left_length - offset);
+            multiply_words(left + offset, piece_length, right, right_length, product, next_scratch);
+            auto carry = add_words(result + offset, left_length + right_length - offset, product, piece_length + right_length);
+            VERIFY(carry == 0);
+        }
+        return;
+    }
+
+    karatsuba_multiply(left, left_length, right, right_length, result, scratch);
+}
+
+/**
+ * Complexity: O(N^2) for small numbers, O(N^1.58) with Karatsuba above karatsuba_threshold words.
+ * Squares are recognized and take a cheaper path.
+ * The temporaries are used as scratch space.
  */
 FLATTEN void UnsignedBigIntegerAlgorithms::multiply_without_allocation(
     UnsignedBigInteger const& left,
     UnsignedBigInteger const& right,
     UnsignedBigInteger& temp_shift_result,
-    UnsignedBigInteger& temp_shift_plus,
-    UnsignedBigInteger& temp_shift,
+    UnsignedBigInteger&,
+    UnsignedBigInteger&,
     UnsignedBigInteger& output)
 {
-    output.set_to_0();
+    VERIFY(&output != &left && &output != &right);
 
-    // iterate all bits
-    for (size_t word_index = 0; word_index < left.length(); ++word_index) {
-        for (size_t bit_index = 0; bit_index < UnsignedBigInteger::BITS_IN_WORD; ++bit_index) {
-            // If the bit is off - skip over it
-            if (!(left.m_words[word_index] & (1 << bit_index)))
-                continue;
+    auto left_length = left.trimmed_length();
+    auto right_length = right.trimmed_length();
 
-            size_t shift_amount = word_index * UnsignedBigInteger::BITS_IN_WORD + bit_index;
+    output.set_to_0();
+    if (left_length == 0 || right_length == 0)
+        return;
 
-            // output += (right << shift_amount);
-            shift_left_without_allocation(right, shift_amount, temp_shift_result, temp_shift_plus, temp_shift);
-            add_into_accumulator_without_allocation(output, temp_shift);
-        }
-    }
+    // Equal numbers are squared, even if they aren't the same object.
+    auto* left_words = left.m_words.data();
+    auto* right_words = right.m_words.data();
+    if (left_words != right_words && left_length == right_length && __builtin_memcmp(left_words, right_words, left_length * sizeof(Word)) == 0)
+        right_words = left_words;
+
+    temp_shift_result.m_words.resize_and_keep_capacity(multiplication_scratch_size(left_length, right_length));
+    output.m_words.resize_and_keep_capacity(left_length + right_length);
+    multiply_words(left_words, left_length, right_words, right_length, output.m_words.data(), temp_shift_result.m_words.data());
+    output.clamp_to_trimmed_length();
+    temp_shift_result.set_to_0();
 }
 
 }
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Platform.h>
+#include <AK/Types.h>
+#include <LibCrypto/CPUFeatures.h>
+#include <stdlib.h>
+
+#if ARCH(I386) || ARCH(X86_64)
+#    include <cpuid.h>
+#endif
+
+namespace Crypto {
+
+static CPUFeatures detect_cpu_features()
+{
+    CPUFeatures features;
+    if (getenv("LIBCRYPTO_NO_HARDWARE"))
+        return features;
+
+#if ARCH(I386) || ARCH(X86_64)
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return features;
+
+    features.ssse3 = ecx & bit_SSSE3;
+    features.sse4_1 = ecx & bit_SSE4_1;
+    features.aes = ecx & bit_AES;
+    features.pclmul = ecx & bit_PCLMUL;
+
+    // AVX2 is only usable if the kernel saves the upper halves of the YMM registers for us.
+    bool os_saves_ymm_state = false;
+    if ((ecx & bit_OSXSAVE) && (ecx & bit_AVX)) {
+        u32 xcr0_low, xcr0_high;
+        asm volatile("xgetbv"
+                     : "=a"(xcr0_low), "=d"(xcr0_high)
+                     : "c"(0));
+        os_saves_ymm_state = (xcr0_low & 0x6) == 0x6;
+    }
+
+    if (__get_cpuid_max(0, nullptr) >= 7) {
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        features.avx2 = os_saves_ymm_state && (ebx & bit_AVX2);
+        features.sha = ebx & bit_SHA;
+    }
+#endif
+
+    return features;
+}
+
+const CPUFeatures& cpu_features()
+{
+    static CPUFeatures features = detect_cpu_features();
+    return features;
+}
+
+}
@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+namespace Crypto {
+
+// Instruction set extensions that have accelerated code paths in LibCrypto.
+// Everything is false on non-x86 hosts, and when LIBCRYPTO_NO_HARDWARE is set in the environment,
+// which forces the portable implementations (handy for comparing the two).
+struct CPUFeatures {
+    bool ssse3 { false };
+    bool sse4_1 { false };
+    bool aes { false };
+    bool pclmul { false };
+    bool avx2 { false };
+    bool sha { false };
+};
+
+const CPUFeatures& cpu_features();
+
+}
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Endian.h>
 #include <AK/Span.h>
 #include <AK/Types.h>
 #include <LibCrypto/Checksum/CRC32.h>
@@ -12,9 +13,24 @@ namespace Crypto::Checksum {
 
 void CRC32::update(ReadonlyBytes data)
 {
-    for (size_t i = 0; i < data.size(); i++) {
-        m_state = table[(m_state ^ data.at(i)) & 0xFF] ^ (m_state >> 8);
+    auto* bytes = data.data();
+    auto size = data.size();
+
+    for (; size >= 8; bytes += 8, size -= 8) {
+        u32 low, high;
+        __builtin_memcpy(&low, bytes, sizeof(low));
+        __builtin_memcpy(&high, bytes + 4, sizeof(high));
+        low = AK::convert_between_host_and_little_endian(low) ^ m_state;
+        high = AK::convert_between_host_and_little_endian(high);
+
+        m_state = table.data[7][low & 0xFF] ^ table.data[6][(low >> 8) & 0xFF]
+            ^ table.data[5][(low >> 16) & 0xFF] ^ table.data[4][low >> 24]
+            ^ table.data[3][high & 0xFF] ^ table.data[2][(high >> 8) & 0xFF]
+            ^ table.data[1][(high >> 16) & 0xFF] ^ table.data[0][high >> 24];
     }
+
+    for (; size > 0; bytes++, size--)
+        m_state = table[(m_state ^ *bytes) & 0xFF] ^ (m_state >> 8);
 };
 
 u32 CRC32::digest()
@@ -12,8 +12,11 @@
 
 namespace Crypto::Checksum {
 
+// Lookup tables for "slice-by-8": data[0] is the classic byte-at-a-time table, and data[n]
+// gives the CRC contribution of a byte that is followed by n more bytes, so eight input bytes
+// can be folded in with eight independent lookups.
 struct Table {
-    u32 data[256];
+    u32 data[8][256];
 
     constexpr Table()
         : data()
@@ -29,13 +32,20 @@ struct Table {
                 }
             }
 
-            data[i] = value;
+            data[0][i] = value;
+        }
+
+        for (auto slice = 1; slice < 8; slice++) {
+            for (auto i = 0; i < 256; i++) {
+                u32 previous = data[slice - 1][i];
+                data[slice][i] = (previous >> 8) ^ data[0][previous & 0xFF];
+            }
         }
     }
 
     constexpr u32 operator[](int index) const
     {
-        return data[index];
+        return data[0][index];
     }
 };
 
@@ -7,6 +7,10 @@
 #include <AK/StringBuilder.h>
 #include <LibCrypto/Cipher/AES.h>
 
+#ifndef KERNEL
+#    include <LibCrypto/Cipher/AESNI.h>
+#endif
+
 namespace Crypto {
 namespace Cipher {
 
@@ -196,6 +200,14 @@ void AESCipherKey::expand_decrypt_key(ReadonlyBytes user_key, size_t bits)
 
 void AESCipher::encrypt_block(const AESCipherBlock& in, AESCipherBlock& out)
 {
+#ifndef KERNEL
+    if (AESNI::is_supported()) {
+        const auto& cipher_key = key();
+        AESNI::encrypt_blocks(cipher_key.round_keys(), cipher_key.rounds(), in.bytes(), out.bytes());
+        return;
+    }
+#endif
+
     u32 s0, s1, s2, s3, t0, t1, t2, t3;
     size_t r { 0 };
 
@@ -288,6 +300,14 @@ void AESCipher::encrypt_block(const AESCipherBlock& in, AESCipherBlock& out)
 
 void AESCipher::decrypt_block(const AESCipherBlock& in, AESCipherBlock& out)
 {
+#ifndef KERNEL
+    if (AESNI::is_supported()) {
+        const auto& cipher_key = key();
+        AESNI::decrypt_blocks(cipher_key.round_keys(), cipher_key.rounds(), in.bytes(), out.bytes());
+        return;
+    }
+#endif
+
     u32 s0, s1, s2, s3, t0, t1, t2, t3;
     size_t r { 0 };
 
@@ -375,6 +395,19 @@ void AESCipher::decrypt_block(const AESCipherBlock& in, AESCipherBlock& out)
     // clang-format on
 }
 
+void AESCipher::encrypt_blocks(ReadonlyBytes in, Bytes out)
+{
+#ifndef KERNEL
+    if (AESNI::is_supported()) {
+        const auto& cipher_key = key();
+        AESNI::encrypt_blocks(cipher_key.round_keys(), cipher_key.rounds(), in, out);
+        return;
+    }
+#endif
+
+    Cipher::encrypt_blocks(in, out);
+}
+
 void AESCipherBlock::overwrite(ReadonlyBytes bytes)
 {
     auto data = bytes.data();
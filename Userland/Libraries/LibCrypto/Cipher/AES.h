@@ -108,6 +108,7 @@ public:
 
     virtual void encrypt_block(const BlockType& in, BlockType& out) override;
     virtual void decrypt_block(const BlockType& in, BlockType& out) override;
+    virtual void encrypt_blocks(ReadonlyBytes in, Bytes out) override;
 
     virtual String class_name() const override { return "AES"; }
 
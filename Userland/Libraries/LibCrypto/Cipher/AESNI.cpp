@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Assertions.h>
+#include <AK/Platform.h>
+#include <LibCrypto/CPUFeatures.h>
+#include <LibCrypto/Cipher/AESNI.h>
+
+#if ARCH(I386) || ARCH(X86_64)
+#    include <immintrin.h>
+#endif
+
+namespace Crypto {
+namespace Cipher {
+namespace AESNI {
+
+static constexpr size_t block_size = 16;
+
+// Number of independent blocks kept in flight. AESENC has a latency of several cycles
+// but can issue every cycle, so working on this many blocks at once keeps the unit busy.
+static constexpr size_t interleaved_blocks = 8;
+
+bool is_supported()
+{
+    return cpu_features().aes && cpu_features().ssse3;
+}
+
+#if ARCH(I386) || ARCH(X86_64)
+
+#    define AESNI_TARGET __attribute__((target("aes,ssse3")))
+
+AESNI_TARGET static void load_round_keys(const u32* round_keys, size_t rounds, __m128i* keys)
+{
+    // AESCipherKey stores each word big-endian in a host u32.
+    auto const byte_swap_words = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (size_t i = 0; i <= rounds; ++i)
+        keys[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(round_keys + 4 * i)), byte_swap_words);
+}
+
+AESNI_TARGET void encrypt_blocks(const u32* round_keys, size_t rounds, ReadonlyBytes in, Bytes out)
+{
+    VERIFY(in.size() % block_size == 0);
+    VERIFY(out.size() >= in.size());
+
+    __m128i keys[15];
+    load_round_keys(round_keys, rounds, keys);
+
+    auto* input = reinterpret_cast<const __m128i*>(in.data());
+    auto* output = reinterpret_cast<__m128i*>(out.data());
+    size_t block_count = in.size() / block_size;
+    size_t i = 0;
+
+    for (; i + interleaved_blocks <= block_count; i += interleaved_blocks) {
+        __m128i blocks[interleaved_blocks];
+#    pragma GCC unroll 8
+        for (size_t j = 0; j < interleaved_blocks; ++j)
+            blocks[j] = _mm_xor_si128(_mm_loadu_si128(input + i + j), keys[0]);
+        for (size_t round = 1; round < rounds; ++round) {
+#    pragma GCC unroll 8
+            for (size_t j = 0; j < interleaved_blocks; ++j)
+                blocks[j] = _mm_aesenc_si128(blocks[j], keys[round]);
+        }
+#    pragma GCC unroll 8
+        for (size_t j = 0; j < interleaved_blocks; ++j)
+            _mm_storeu_si128(output + i + j, _mm_aesenclast_si128(blocks[j], keys[rounds]));
+    }
+
+    for (; i < block_count; ++i) {
+        auto block = _mm_xor_si128(_mm_loadu_si128(input + i), keys[0]);
+        for (size_t round = 1; round < rounds; ++round)
+            block = _mm_aesenc_si128(block, keys[round]);
+        _mm_storeu_si128(output + i, _mm_aesenclast_si128(block, keys[rounds]));
+    }
+}
+
+AESNI_TARGET void decrypt_blocks(const u32* round_keys, size_t rounds, ReadonlyBytes in, Bytes out)
+{
+    VERIFY(in.size() % block_size == 0);
+    VERIFY(out.size() >= in.size());
+
+    __m128i keys[15];
+    load_round_keys(round_keys, rounds, keys);
+
+    auto* input = reinterpret_cast<const __m128i*>(in.data());
+    auto* output = reinterpret_cast<__m128i*>(out.data());
+    size_t block_count = in.size() / block_size;
+    size_t i = 0;
+
+    for (; i + interleaved_blocks <= block_count; i += interleaved_blocks) {
+        __m128i blocks[interleaved_blocks];
+#    pragma GCC unroll 8
+        for (size_t j = 0; j < interleaved_blocks; ++j)
+            blocks[j] = _mm_xor_si128(_mm_loadu_si128(input + i + j), keys[0]);
+        for (size_t round = 1; round < rounds; ++round) {
+#    pragma GCC unroll 8
+            for (size_t j = 0; j < interleaved_blocks; ++j)
+                blocks[j] = _mm_aesdec_si128(blocks[j], keys[round]);
+        }
+#    pragma GCC unroll 8
+        for (size_t j = 0; j < interleaved_blocks; ++j)
+            _mm_storeu_si128(output + i + j, _mm_aesdeclast_si128(blocks[j], keys[rounds]));
+    }
+
+    for (; i < block_count; ++i) {
+        auto block = _mm_xor_si128(_mm_loadu_si128(input + i), keys[0]);
+        for (size_t round = 1; round < rounds; ++round)
+            block = _mm_aesdec_si128(block, keys[round]);
+        _mm_storeu_si128(output + i, _mm_aesdeclast_si128(block, keys[rounds]));
+    }
+}
+
+#else
+
+void encrypt_blocks(const u32*, size_t, ReadonlyBytes, Bytes)
+{
+    VERIFY_NOT_REACHED();
+}
+
+void decrypt_blocks(const u32*, size_t, ReadonlyBytes, Bytes)
+{
+    VERIFY_NOT_REACHED();
+}
+
+#endif
+
+}
+}
+}
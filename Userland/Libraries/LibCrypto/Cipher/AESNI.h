@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Span.h>
+#include <AK/Types.h>
+
+namespace Crypto {
+namespace Cipher {
+namespace AESNI {
+
+// AES-NI versions of the block functions. They take the round keys exactly as
+// AESCipherKey lays them out (big-endian words, with the decryption schedule already
+// in "equivalent inverse cipher" form), so no separate key expansion is needed.
+bool is_supported();
+void encrypt_blocks(const u32* round_keys, size_t rounds, ReadonlyBytes in, Bytes out);
+void decrypt_blocks(const u32* round_keys, size_t rounds, ReadonlyBytes in, Bytes out);
+
+}
+}
+}
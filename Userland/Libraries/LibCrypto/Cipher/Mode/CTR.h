@@ -130,8 +130,13 @@ public:
     }
 
 private:
+    // Counter blocks are encrypted a batch at a time, so ciphers with a multi-block
+    // implementation (such as AES-NI) can keep several blocks in flight.
+    static constexpr size_t blocks_per_batch = 8;
+
     u8 m_ivec_storage[IVSizeInBits / 8];
-    typename T::BlockType m_cipher_block {};
+    u8 m_counter_blocks[blocks_per_batch * T::block_size()];
+    u8 m_key_stream[blocks_per_batch * T::block_size()];
 
 protected:
     constexpr static IncrementFunctionType increment {};
@@ -155,27 +160,32 @@ protected:
         VERIFY(!ivec.is_empty());
         VERIFY(ivec.size() >= IV_length());
 
-        m_cipher_block.set_padding_mode(cipher.padding_mode());
-
         __builtin_memcpy(m_ivec_storage, ivec.data(), IV_length());
         Bytes iv { m_ivec_storage, IV_length() };
 
         size_t offset { 0 };
-        auto block_size = cipher.block_size();
+        constexpr auto block_size = T::block_size();
 
         while (length > 0) {
-            m_cipher_block.overwrite(iv.slice(0, block_size));
+            auto batch_block_count = min(blocks_per_batch, (length + block_size - 1) / block_size);
+            auto batch_size = batch_block_count * block_size;
 
-            cipher.encrypt_block(m_cipher_block, m_cipher_block);
-            if (in) {
-                m_cipher_block.apply_initialization_vector(in->slice(offset));
+            for (size_t i = 0; i < batch_block_count; ++i) {
+                __builtin_memcpy(m_counter_blocks + i * block_size, iv.data(), block_size);
+                increment(iv);
             }
-            auto write_size = min(block_size, length);
+            cipher.encrypt_blocks({ m_counter_blocks, batch_size }, { m_key_stream, batch_size });
+
+            auto write_size = min(batch_size, length);
 
             VERIFY(offset + write_size <= out.size());
-            __builtin_memcpy(out.offset(offset), m_cipher_block.bytes().data(), write_size);
+            if (in) {
+                for (size_t i = 0; i < write_size; ++i)
+                    out[offset + i] = (*in)[offset + i] ^ m_key_stream[i];
+            } else {
+                __builtin_memcpy(out.offset(offset), m_key_stream, write_size);
+            }
 
-            increment(iv);
             length -= write_size;
             offset += write_size;
         }
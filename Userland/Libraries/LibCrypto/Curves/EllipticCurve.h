@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/Optional.h>
+
+namespace Crypto {
+namespace Curves {
+
+// Elliptic curve Diffie-Hellman. Keys and points are passed around in the encoding
+// the curve uses on the wire in TLS (RFC 8422 and RFC 7748).
+class EllipticCurve {
+public:
+    virtual ~EllipticCurve() = default;
+
+    virtual size_t key_size() const = 0;
+
+    virtual ByteBuffer generate_private_key() = 0;
+    virtual ByteBuffer generate_public_key(ReadonlyBytes private_key) = 0;
+
+    // Returns an empty Optional if `peer_public_key` is malformed or not a usable point.
+    virtual Optional<ByteBuffer> compute_shared_secret(ReadonlyBytes private_key, ReadonlyBytes peer_public_key) = 0;
+};
+
+}
+}
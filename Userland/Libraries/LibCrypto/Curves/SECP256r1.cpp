@@ -0,0 +1,416 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Random.h>
+#include <LibCrypto/Curves/SECP256r1.h>
+#include <string.h>
+
+namespace Crypto {
+namespace Curves {
+
+// Field elements mod p are eight little-endian 32-bit words, kept in Montgomery form
+// (a * 2^256 mod p) while doing arithmetic. Nothing below branches on or indexes by
+// secret values; conditional steps are done by masking.
+using FieldElement = u32[8];
+
+// p = 2^256 - 2^224 + 2^192 + 2^96 - 1
+static constexpr FieldElement prime = { 0xffffffff, 0xffffffff, 0xffffffff, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0xffffffff };
+// 2^512 mod p, for converting into Montgomery form.
+static constexpr FieldElement r_squared = { 0x00000003, 0x00000000, 0xffffffff, 0xfffffffb, 0xfffffffe, 0xffffffff, 0xfffffffd, 0x00000004 };
+
+// The curve is y^2 = x^3 - 3x + b, with base point G and group order n (all big-endian).
+static constexpr u8 curve_b[32] = {
+    0x5a, 0xc6, 0x35, 0xd8, 0xaa, 0x3a, 0x93, 0xe7, 0xb3, 0xeb, 0xbd, 0x55, 0x76, 0x98, 0x86, 0xbc,
+    0x65, 0x1d, 0x06, 0xb0, 0xcc, 0x53, 0xb0, 0xf6, 0x3b, 0xce, 0x3c, 0x3e, 0x27, 0xd2, 0x60, 0x4b
+};
+static constexpr u8 generator_x[32] = {
+    0x6b, 0x17, 0xd1, 0xf2, 0xe1, 0x2c, 0x42, 0x47, 0xf8, 0xbc, 0xe6, 0xe5, 0x63, 0xa4, 0x40, 0xf2,
+    0x77, 0x03, 0x7d, 0x81, 0x2d, 0xeb, 0x33, 0xa0, 0xf4, 0xa1, 0x39, 0x45, 0xd8, 0x98, 0xc2, 0x96
+};
+static constexpr u8 generator_y[32] = {
+    0x4f, 0xe3, 0x42, 0xe2, 0xfe, 0x1a, 0x7f, 0x9b, 0x8e, 0xe7, 0xeb, 0x4a, 0x7c, 0x0f, 0x9e, 0x16,
+    0x2b, 0xce, 0x33, 0x57, 0x6b, 0x31, 0x5e, 0xce, 0xcb, 0xb6, 0x40, 0x68, 0x37, 0xbf, 0x51, 0xf5
+};
+static constexpr u8 group_order[32] = {
+    0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xbc, 0xe6, 0xfa, 0xad, 0xa7, 0x17, 0x9e, 0x84, 0xf3, 0xb9, 0xca, 0xc2, 0xfc, 0x63, 0x25, 0x51
+};
+
+static void copy(FieldElement output, const FieldElement a)
+{
+    for (size_t i = 0; i < 8; ++i)
+        output[i] = a[i];
+}
+
+// Sets output to a if `select` is 0, or to b if it is 1.
+static void select(FieldElement output, const FieldElement a, const FieldElement b, u32 select)
+{
+    u32 mask = 0 - select;
+    for (size_t i = 0; i < 8; ++i)
+        output[i] = a[i] ^ (mask & (a[i] ^ b[i]));
+}
+
+// output = a - b, returning the borrow out of the top word.
+static u32 subtract_words(FieldElement output, const FieldElement a, const FieldElement b)
+{
+    u64 borrow = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        u64 difference = (u64)a[i] - b[i] - borrow;
+        output[i] = (u32)difference;
+        borrow = (difference >> 32) & 1;
+    }
+    return borrow;
+}
+
+static void add(FieldElement output, const FieldElement a, const FieldElement b)
+{
+    u64 carry = 0;
+    FieldElement sum;
+    for (size_t i = 0; i < 8; ++i) {
+        carry += (u64)a[i] + b[i];
+        sum[i] = (u32)carry;
+        carry >>= 32;
+    }
+    // Both inputs are below p, so one subtraction of p is enough.
+    FieldElement reduced;
+    u32 borrow = subtract_words(reduced, sum, prime);
+    select(output, reduced, sum, borrow & (1 - (u32)carry));
+}
+
+static void subtract(FieldElement output, const FieldElement a, const FieldElement b)
+{
+    FieldElement difference;
+    u32 borrow = subtract_words(difference, a, b);
+    // If we went below zero, add p back.
+    u64 carry = 0;
+    FieldElement corrected;
+    for (size_t i = 0; i < 8; ++i) {
+        carry += (u64)difference[i] + prime[i];
+        corrected[i] = (u32)carry;
+        carry >>= 32;
+    }
+    select(output, difference, corrected, borrow);
+}
+
+// Montgomery multiplication: output = a * b / 2^256 (mod p).
+// Since p = -1 (mod 2^32), the per-word reduction factor is just the low word.
+static void multiply(FieldElement output, const FieldElement a, const FieldElement b)
+{
+    u32 t[10] {};
+    for (size_t i = 0; i < 8; ++i) {
+        u64 carry = 0;
+        for (size_t j = 0; j < 8; ++j) {
+            carry += t[j] + (u64)a[j] * b[i];
+            t[j] = (u32)carry;
+            carry >>= 32;
+        }
+        carry += t[8];
+        t[8] = (u32)carry;
+        t[9] = (u32)(carry >> 32);
+
+        u32 factor = t[0];
+        carry = (t[0] + (u64)factor * prime[0]) >> 32;
+        for (size_t j = 1; j < 8; ++j) {
+            carry += t[j] + (u64)factor * prime[j];
+            t[j - 1] = (u32)carry;
+            carry >>= 32;
+        }
+        carry += t[8];
+        t[7] = (u32)carry;
+        t[8] = t[9] + (u32)(carry >> 32);
+    }
+
+    // The result is below 2p; subtract p once if needed.
+    FieldElement reduced;
+    u32 borrow = subtract_words(reduced, t, prime);
+    select(output, reduced, t, borrow & (1 - t[8]));
+}
+
+static void square(FieldElement output, const FieldElement a)
+{
+    multiply(output, a, a);
+}
+
+static void to_montgomery(FieldElement output, const FieldElement a)
+{
+    multiply(output, a, r_squared);
+}
+
+static void from_montgomery(FieldElement output, const FieldElement a)
+{
+    static constexpr FieldElement one = { 1 };
+    multiply(output, a, one);
+}
+
+// a^(p - 2) = a^-1 (mod p). The exponent is public, so walking its bits is fine.
+static void invert(FieldElement output, const FieldElement a)
+{
+    FieldElement exponent;
+    static constexpr FieldElement two = { 2 };
+    subtract_words(exponent, prime, two);
+
+    FieldElement result;
+    copy(result, a);
+    for (int bit = 254; bit >= 0; --bit) {
+        square(result, result);
+        if ((exponent[bit / 32] >> (bit % 32)) & 1)
+            multiply(result, result, a);
+    }
+    copy(output, result);
+}
+
+static void decode(FieldElement output, const u8 input[32])
+{
+    for (size_t i = 0; i < 8; ++i) {
+        auto* word = input + 28 - 4 * i;
+        output[i] = ((u32)word[0] << 24) | ((u32)word[1] << 16) | ((u32)word[2] << 8) | word[3];
+    }
+}
+
+static void encode(u8 output[32], const FieldElement a)
+{
+    for (size_t i = 0; i < 8; ++i) {
+        auto* word = output + 28 - 4 * i;
+        word[0] = a[i] >> 24;
+        word[1] = a[i] >> 16;
+        word[2] = a[i] >> 8;
+        word[3] = a[i];
+    }
+}
+
+static bool is_below(const FieldElement a, const FieldElement bound)
+{
+    FieldElement unused;
+    return subtract_words(unused, a, bound);
+}
+
+static bool is_zero(const FieldElement a)
+{
+    u32 accumulator = 0;
+    for (size_t i = 0; i < 8; ++i)
+        accumulator |= a[i];
+    return accumulator == 0;
+}
+
+// A point in projective coordinates (X : Y : Z), representing (X/Z, Y/Z); Z = 0 is the
+// point at infinity. All coordinates are in Montgomery form.
+struct Point {
+    FieldElement x;
+    FieldElement y;
+    FieldElement z;
+};
+
+static void conditional_swap(Point& a, Point& b, u32 swap)
+{
+    u32 mask = 0 - swap;
+    for (size_t i = 0; i < 8; ++i) {
+        u32 t = mask & (a.x[i] ^ b.x[i]);
+        a.x[i] ^= t;
+        b.x[i] ^= t;
+        t = mask & (a.y[i] ^ b.y[i]);
+        a.y[i] ^= t;
+        b.y[i] ^= t;
+        t = mask & (a.z[i] ^ b.z[i]);
+        a.z[i] ^= t;
+        b.z[i] ^= t;
+    }
+}
+
+static void montgomery_b(FieldElement output)
+{
+    FieldElement b;
+    decode(b, curve_b);
+    to_montgomery(output, b);
+}
+
+// Complete addition for a = -3 (Renes, Costello, Batina: "Complete addition formulas for
+// prime order elliptic curves", algorithm 4). It has no exceptional cases, so it also
+// doubles, and handles the point at infinity as either input.
+static void point_add(Point& output, const Point& p1, const Point& p2, const FieldElement b)
+{
+    FieldElement t0, t1, t2, t3, t4, x3, y3, z3;
+
+    multiply(t0, p1.x, p2.x);
+    multiply(t1, p1.y, p2.y);
+    multiply(t2, p1.z, p2.z);
+    add(t3, p1.x, p1.y);
+    add(t4, p2.x, p2.y);
+    multiply(t3, t3, t4);
+    add(t4, t0, t1);
+    subtract(t3, t3, t4);
+    add(t4, p1.y, p1.z);
+    add(x3, p2.y, p2.z);
+    multiply(t4, t4, x3);
+    add(x3, t1, t2);
+    subtract(t4, t4, x3);
+    add(x3, p1.x, p1.z);
+    add(y3, p2.x, p2.z);
+    multiply(x3, x3, y3);
+    add(y3, t0, t2);
+    subtract(y3, x3, y3);
+    multiply(z3, b, t2);
+    subtract(x3, y3, z3);
+    add(z3, x3, x3);
+    add(x3, x3, z3);
+    subtract(z3, t1, x3);
+    add(x3, t1, x3);
+    multiply(y3, b, y3);
+    add(t1, t2, t2);
+    add(t2, t1, t2);
+    subtract(y3, y3, t2);
+    subtract(y3, y3, t0);
+    add(t1, y3, y3);
+    add(y3, t1, y3);
+    add(t1, t0, t0);
+    add(t0, t1, t0);
+    subtract(t0, t0, t2);
+    multiply(t1, t4, y3);
+    multiply(t2, t0, y3);
+    multiply(y3, x3, z3);
+    add(y3, y3, t2);
+    multiply(x3, t3, x3);
+    subtract(x3, x3, t1);
+    multiply(z3, t4, z3);
+    multiply(t1, t3, t0);
+    add(z3, z3, t1);
+
+    copy(output.x, x3);
+    copy(output.y, y3);
+    copy(output.z, z3);
+}
+
+// output = scalar * point, with a Montgomery ladder over all 256 scalar bits.
+static void point_multiply(Point& output, const u8 scalar[32], const Point& point)
+{
+    FieldElement b;
+    montgomery_b(b);
+
+    static constexpr FieldElement one = { 1 };
+    Point r0 {};
+    to_montgomery(r0.y, one);
+    Point r1 = point;
+
+    for (int bit = 255; bit >= 0; --bit) {
+        u32 swap = (scalar[31 - bit / 8] >> (bit % 8)) & 1;
+        conditional_swap(r0, r1, swap);
+        point_add(r1, r0, r1, b);
+        point_add(r0, r0, r0, b);
+        conditional_swap(r0, r1, swap);
+    }
+
+    output = r0;
+}
+
+// Returns false for the point at infinity, which has no affine encoding.
+static bool to_affine(u8 x_output[32], u8 y_output[32], const Point& point)
+{
+    if (is_zero(point.z))
+        return false;
+
+    FieldElement z_inverse, x, y;
+    invert(z_inverse, point.z);
+    multiply(x, point.x, z_inverse);
+    multiply(y, point.y, z_inverse);
+    from_montgomery(x, x);
+    from_montgomery(y, y);
+    encode(x_output, x);
+    if (y_output)
+        encode(y_output, y);
+    return true;
+}
+
+// Parses an uncompressed point, and checks that it is actually on the curve.
+static bool decode_point(Point& output, ReadonlyBytes input)
+{
+    if (input.size() != SECP256r1::PointSize || input[0] != 0x04)
+        return false;
+
+    FieldElement x, y;
+    decode(x, input.offset_pointer(1));
+    decode(y, input.offset_pointer(33));
+    if (!is_below(x, prime) || !is_below(y, prime))
+        return false;
+
+    to_montgomery(output.x, x);
+    to_montgomery(output.y, y);
+    static constexpr FieldElement one = { 1 };
+    to_montgomery(output.z, one);
+
+    // y^2 = x^3 - 3x + b
+    FieldElement left, right, t, b;
+    square(left, output.y);
+    square(right, output.x);
+    multiply(right, right, output.x);
+    add(t, output.x, output.x);
+    add(t, t, output.x);
+    subtract(right, right, t);
+    montgomery_b(b);
+    add(right, right, b);
+    subtract(t, left, right);
+    return is_zero(t);
+}
+
+static bool is_valid_scalar(ReadonlyBytes scalar)
+{
+    if (scalar.size() != SECP256r1::KeySize)
+        return false;
+    FieldElement value, order;
+    decode(value, scalar.data());
+    decode(order, group_order);
+    return !is_zero(value) && is_below(value, order);
+}
+
+ByteBuffer SECP256r1::generate_private_key()
+{
+    auto buffer = ByteBuffer::create_uninitialized(KeySize);
+    do {
+        fill_with_random(buffer.data(), buffer.size());
+    } while (!is_valid_scalar(buffer));
+    return buffer;
+}
+
+ByteBuffer SECP256r1::generate_public_key(ReadonlyBytes private_key)
+{
+    VERIFY(is_valid_scalar(private_key));
+
+    Point generator;
+    FieldElement x, y;
+    decode(x, generator_x);
+    decode(y, generator_y);
+    to_montgomery(generator.x, x);
+    to_montgomery(generator.y, y);
+    static constexpr FieldElement one = { 1 };
+    to_montgomery(generator.z, one);
+
+    Point result;
+    point_multiply(result, private_key.data(), generator);
+
+    auto buffer = ByteBuffer::create_uninitialized(PointSize);
+    buffer[0] = 0x04;
+    auto success = to_affine(buffer.offset_pointer(1), buffer.offset_pointer(33), result);
+    VERIFY(success);
+    return buffer;
+}
+
+Optional<ByteBuffer> SECP256r1::compute_shared_secret(ReadonlyBytes private_key, ReadonlyBytes peer_public_key)
+{
+    VERIFY(is_valid_scalar(private_key));
+
+    Point peer;
+    if (!decode_point(peer, peer_public_key))
+        return {};
+
+    Point result;
+    point_multiply(result, private_key.data(), peer);
+
+    auto buffer = ByteBuffer::create_uninitialized(KeySize);
+    if (!to_affine(buffer.data(), nullptr, result))
+        return {};
+    return buffer;
+}
+
+}
+}
@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <LibCrypto/Curves/EllipticCurve.h>
+
+namespace Crypto {
+namespace Curves {
+
+// ECDH over NIST P-256 (secp256r1). Public keys use the uncompressed SEC 1 encoding
+// (0x04 || X || Y), and the shared secret is the X coordinate of the shared point.
+// Runs in constant time with respect to the private key.
+class SECP256r1 final : public EllipticCurve {
+public:
+    static constexpr size_t KeySize = 32;
+    static constexpr size_t PointSize = 1 + 2 * KeySize;
+
+    virtual size_t key_size() const override { return KeySize; }
+
+    virtual ByteBuffer generate_private_key() override;
+    virtual ByteBuffer generate_public_key(ReadonlyBytes private_key) override;
+    virtual Optional<ByteBuffer> compute_shared_secret(ReadonlyBytes private_key, ReadonlyBytes peer_public_key) override;
+};
+
+}
+}
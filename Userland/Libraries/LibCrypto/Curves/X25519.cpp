@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Random.h>
+#include <LibCrypto/Curves/X25519.h>
+#include <string.h>
+
+namespace Crypto {
+namespace Curves {
+
+// Field elements mod 2^255 - 19, as sixteen signed 16-bit limbs held in i64s so that
+// additions and subtractions can be done without carrying. Every operation below runs
+// the same instructions regardless of the values involved.
+using FieldElement = i64[16];
+
+static void carry(FieldElement element)
+{
+    for (size_t i = 0; i < 16; ++i) {
+        element[i] += 1 << 16;
+        i64 carry = element[i] >> 16;
+        // 2^256 = 38 (mod p), so the carry out of the top limb wraps around into the bottom one.
+        if (i < 15)
+            element[i + 1] += carry - 1;
+        else
+            element[0] += 38 * (carry - 1);
+        element[i] -= carry << 16;
+    }
+}
+
+// Swaps a and b if `swap` is 1, and leaves them alone if it is 0.
+static void conditional_swap(FieldElement a, FieldElement b, i64 swap)
+{
+    i64 mask = ~(swap - 1);
+    for (size_t i = 0; i < 16; ++i) {
+        i64 t = mask & (a[i] ^ b[i]);
+        a[i] ^= t;
+        b[i] ^= t;
+    }
+}
+
+static void encode(u8 output[32], const FieldElement element)
+{
+    FieldElement t, m;
+    for (size_t i = 0; i < 16; ++i)
+        t[i] = element[i];
+    carry(t);
+    carry(t);
+    carry(t);
+
+    // Subtract p up to twice, keeping the result whenever it doesn't go negative.
+    for (size_t pass = 0; pass < 2; ++pass) {
+        m[0] = t[0] - 0xffed;
+        for (size_t i = 1; i < 15; ++i) {
+            m[i] = t[i] - 0xffff - ((m[i - 1] >> 16) & 1);
+            m[i - 1] &= 0xffff;
+        }
+        m[15] = t[15] - 0x7fff - ((m[14] >> 16) & 1);
+        i64 borrow = (m[15] >> 16) & 1;
+        m[14] &= 0xffff;
+        conditional_swap(t, m, 1 - borrow);
+    }
+
+    for (size_t i = 0; i < 16; ++i) {
+        output[2 * i] = t[i] & 0xff;
+        output[2 * i + 1] = t[i] >> 8;
+    }
+}
+
+static void decode(FieldElement output, const u8 input[32])
+{
+    for (size_t i = 0; i < 16; ++i)
+        output[i] = input[2 * i] + ((i64)input[2 * i + 1] << 8);
+    // RFC 7748 section 5: the most significant bit of the u-coordinate is ignored.
+    output[15] &= 0x7fff;
+}
+
+static void add(FieldElement output, const FieldElement a, const FieldElement b)
+{
+    for (size_t i = 0; i < 16; ++i)
+        output[i] = a[i] + b[i];
+}
+
+static void subtract(FieldElement output, const FieldElement a, const FieldElement b)
+{
+    for (size_t i = 0; i < 16; ++i)
+        output[i] = a[i] - b[i];
+}
+
+static void multiply(FieldElement output, const FieldElement a, const FieldElement b)
+{
+    i64 product[31] {};
+    for (size_t i = 0; i < 16; ++i) {
+        for (size_t j = 0; j < 16; ++j)
+            product[i + j] += a[i] * b[j];
+    }
+    for (size_t i = 0; i < 15; ++i)
+        product[i] += 38 * product[i + 16];
+    for (size_t i = 0; i < 16; ++i)
+        output[i] = product[i];
+    carry(output);
+    carry(output);
+}
+
+static void square(FieldElement output, const FieldElement a)
+{
+    multiply(output, a, a);
+}
+
+// a^(p - 2) = a^-1 (mod p).
+static void invert(FieldElement output, const FieldElement a)
+{
+    FieldElement c;
+    for (size_t i = 0; i < 16; ++i)
+        c[i] = a[i];
+    for (int bit = 253; bit >= 0; --bit) {
+        square(c, c);
+        if (bit != 2 && bit != 4)
+            multiply(c, c, a);
+    }
+    for (size_t i = 0; i < 16; ++i)
+        output[i] = c[i];
+}
+
+void X25519::scalar_multiply(u8 output[KeySize], const u8 scalar[KeySize], const u8 point[KeySize])
+{
+    // RFC 7748 section 5: clamp the scalar.
+    u8 clamped[KeySize];
+    __builtin_memcpy(clamped, scalar, KeySize);
+    clamped[0] &= 248;
+    clamped[31] &= 127;
+    clamped[31] |= 64;
+
+    static constexpr FieldElement a24 = { 0xdb41, 1 }; // (486662 - 2) / 4
+
+    FieldElement x1, x2 {}, z2 {}, x3, z3 {}, t0, t1;
+    decode(x1, point);
+    for (size_t i = 0; i < 16; ++i)
+        x3[i] = x1[i];
+    x2[0] = 1;
+    z3[0] = 1;
+
+    // The Montgomery ladder from RFC 7748 section 5.
+    for (int bit = 254; bit >= 0; --bit) {
+        i64 swap = (clamped[bit / 8] >> (bit % 8)) & 1;
+        conditional_swap(x2, x3, swap);
+        conditional_swap(z2, z3, swap);
+
+        add(t0, x2, z2);
+        subtract(x2, x2, z2);
+        add(z2, x3, z3);
+        subtract(x3, x3, z3);
+        square(z3, t0);
+        square(t1, x2);
+        multiply(x2, z2, x2);
+        multiply(z2, x3, t0);
+        add(t0, x2, z2);
+        subtract(x2, x2, z2);
+        square(x3, x2);
+        subtract(z2, z3, t1);
+        multiply(x2, z2, a24);
+        add(x2, x2, z3);
+        multiply(z2, z2, x2);
+        multiply(x2, z3, t1);
+        multiply(z3, x3, x1);
+        square(x3, t0);
+
+        conditional_swap(x2, x3, swap);
+        conditional_swap(z2, z3, swap);
+    }
+
+    invert(z2, z2);
+    multiply(x2, x2, z2);
+    encode(output, x2);
+
+    explicit_bzero(clamped, sizeof(clamped));
+}
+
+ByteBuffer X25519::generate_private_key()
+{
+    auto buffer = ByteBuffer::create_uninitialized(KeySize);
+    fill_with_random(buffer.data(), buffer.size());
+    return buffer;
+}
+
+ByteBuffer X25519::generate_public_key(ReadonlyBytes private_key)
+{
+    VERIFY(private_key.size() == KeySize);
+
+    static constexpr u8 base_point[KeySize] = { 9 };
+    auto buffer = ByteBuffer::create_uninitialized(KeySize);
+    scalar_multiply(buffer.data(), private_key.data(), base_point);
+    return buffer;
+}
+
+Optional<ByteBuffer> X25519::compute_shared_secret(ReadonlyBytes private_key, ReadonlyBytes peer_public_key)
+{
+    VERIFY(private_key.size() == KeySize);
+    if (peer_public_key.size() != KeySize)
+        return {};
+
+    auto buffer = ByteBuffer::create_uninitialized(KeySize);
+    scalar_multiply(buffer.data(), private_key.data(), peer_public_key.data());
+
+    // RFC 7748 section 6.1: an all-zero result means the peer sent a small-order point.
+    u8 accumulator = 0;
+    for (auto byte : buffer.bytes())
+        accumulator |= byte;
+    if (accumulator == 0)
+        return {};
+
+    return buffer;
+}
+
+}
+}
@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <LibCrypto/Curves/EllipticCurve.h>
+
+namespace Crypto {
+namespace Curves {
+
+// X25519 as defined in RFC 7748. Runs in constant time with respect to the private key.
+class X25519 final : public EllipticCurve {
+public:
+    static constexpr size_t KeySize = 32;
+
+    virtual size_t key_size() const override { return KeySize; }
+
+    virtual ByteBuffer generate_private_key() override;
+    virtual ByteBuffer generate_public_key(ReadonlyBytes private_key) override;
+    virtual Optional<ByteBuffer> compute_shared_secret(ReadonlyBytes private_key, ReadonlyBytes peer_public_key) override;
+
+    static void scalar_multiply(u8 output[KeySize], const u8 scalar[KeySize], const u8 point[KeySize]);
+};
+
+}
+}
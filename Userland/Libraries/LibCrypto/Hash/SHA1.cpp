@@ -7,6 +7,7 @@
 #include <AK/Endian.h>
 #include <AK/Types.h>
 #include <LibCrypto/Hash/SHA1.h>
+#include <LibCrypto/Hash/SHANI.h>
 
 namespace Crypto {
 namespace Hash {
@@ -66,15 +67,40 @@ inline void SHA1::transform(const u8* data)
     __builtin_memset(blocks, 0, 16 * sizeof(u32));
 }
 
+void SHA1::transform_blocks(const u8* data, size_t block_count)
+{
+    if (SHANI::is_supported()) {
+        SHANI::sha1_transform_blocks(m_state, data, block_count);
+        return;
+    }
+    for (size_t i = 0; i < block_count; ++i)
+        transform(data + i * BlockSize);
+}
+
 void SHA1::update(const u8* message, size_t length)
 {
-    for (size_t i = 0; i < length; ++i) {
+    while (length > 0) {
         if (m_data_length == BlockSize) {
-            transform(m_data_buffer);
+            transform_blocks(m_data_buffer, 1);
             m_bit_length += 512;
             m_data_length = 0;
         }
-        m_data_buffer[m_data_length++] = message[i];
+
+        // Whole blocks don't need to go through the buffer.
+        if (m_data_length == 0 && length >= BlockSize) {
+            auto block_count = length / BlockSize;
+            transform_blocks(message, block_count);
+            m_bit_length += block_count * 512;
+            message += block_count * BlockSize;
+            length -= block_count * BlockSize;
+            continue;
+        }
+
+        auto chunk_length = min(length, BlockSize - m_data_length);
+        __builtin_memcpy(m_data_buffer + m_data_length, message, chunk_length);
+        m_data_length += chunk_length;
+        message += chunk_length;
+        length -= chunk_length;
     }
 }
 
@@ -97,7 +123,7 @@ SHA1::DigestType SHA1::peek()
     __builtin_memcpy(state, m_state, 20);
 
     if (BlockSize == m_data_length) {
-        transform(m_data_buffer);
+        transform_blocks(m_data_buffer, 1);
         m_bit_length += BlockSize * 8;
         m_data_length = 0;
         i = 0;
@@ -113,7 +139,7 @@ SHA1::DigestType SHA1::peek()
         m_data_buffer[i++] = 0x80;
         while (i < BlockSize)
             m_data_buffer[i++] = 0x00;
-        transform(m_data_buffer);
+        transform_blocks(m_data_buffer, 1);
 
         // Then start another block with BlockSize - 8 bytes of zeros
         __builtin_memset(m_data_buffer, 0, FinalBlockDataSize);
@@ -130,7 +156,7 @@ SHA1::DigestType SHA1::peek()
     m_data_buffer[BlockSize - 7] = m_bit_length >> 48;
     m_data_buffer[BlockSize - 8] = m_bit_length >> 56;
 
-    transform(m_data_buffer);
+    transform_blocks(m_data_buffer, 1);
 
     for (size_t i = 0; i < 4; ++i) {
         digest.data[i + 0] = (m_state[0] >> (24 - i * 8)) & 0x000000ff;
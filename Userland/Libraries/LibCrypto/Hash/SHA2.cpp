@@ -7,6 +7,10 @@
 #include <AK/Types.h>
 #include <LibCrypto/Hash/SHA2.h>
 
+#ifndef KERNEL
+#    include <LibCrypto/Hash/SHANI.h>
+#endif
+
 namespace Crypto {
 namespace Hash {
 constexpr static auto ROTRIGHT(u32 a, size_t b) { return (a >> b) | (a << (32 - b)); }
@@ -66,15 +70,42 @@ inline void SHA256::transform(const u8* data)
     m_state[7] += h;
 }
 
+void SHA256::transform_blocks(const u8* data, size_t block_count)
+{
+#ifndef KERNEL
+    if (SHANI::is_supported()) {
+        SHANI::sha256_transform_blocks(m_state, data, block_count);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < block_count; ++i)
+        transform(data + i * BlockSize);
+}
+
 void SHA256::update(const u8* message, size_t length)
 {
-    for (size_t i = 0; i < length; ++i) {
+    while (length > 0) {
         if (m_data_length == BlockSize) {
-            transform(m_data_buffer);
+            transform_blocks(m_data_buffer, 1);
             m_bit_length += 512;
             m_data_length = 0;
         }
-        m_data_buffer[m_data_length++] = message[i];
+
+        // Whole blocks don't need to go through the buffer.
+        if (m_data_length == 0 && length >= BlockSize) {
+            auto block_count = length / BlockSize;
+            transform_blocks(message, block_count);
+            m_bit_length += block_count * 512;
+            message += block_count * BlockSize;
+            length -= block_count * BlockSize;
+            continue;
+        }
+
+        auto chunk_length = min(length, BlockSize - m_data_length);
+        __builtin_memcpy(m_data_buffer + m_data_length, message, chunk_length);
+        m_data_length += chunk_length;
+        message += chunk_length;
+        length -= chunk_length;
     }
 }
 
@@ -91,7 +122,7 @@ SHA256::DigestType SHA256::peek()
     size_t i = m_data_length;
 
     if (BlockSize == m_data_length) {
-        transform(m_data_buffer);
+        transform_blocks(m_data_buffer, 1);
         m_bit_length += BlockSize * 8;
         m_data_length = 0;
         i = 0;
@@ -107,7 +138,7 @@ SHA256::DigestType SHA256::peek()
         m_data_buffer[i++] = 0x80;
         while (i < BlockSize)
             m_data_buffer[i++] = 0x00;
-        transform(m_data_buffer);
+        transform_blocks(m_data_buffer, 1);
 
         // Then start another block with BlockSize - 8 bytes of zeros
         __builtin_memset(m_data_buffer, 0, FinalBlockDataSize);
@@ -124,7 +155,7 @@ SHA256::DigestType SHA256::peek()
     m_data_buffer[BlockSize - 7] = m_bit_length >> 48;
     m_data_buffer[BlockSize - 8] = m_bit_length >> 56;
 
-    transform(m_data_buffer);
+    transform_blocks(m_data_buffer, 1);
 
     // SHA uses big-endian and we assume little-endian
     // FIXME: looks like a thing for AK::NetworkOrdered,
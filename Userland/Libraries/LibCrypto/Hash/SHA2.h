@@ -105,6 +105,12 @@ public:
     inline static DigestType hash(const ByteBuffer& buffer) { return hash(buffer.data(), buffer.size()); }
     inline static DigestType hash(const StringView& buffer) { return hash((const u8*)buffer.characters_without_null_termination(), buffer.length()); }
 
+#ifndef KERNEL
+    // Hashes each of `messages` into the matching entry of `digests`. Without the SHA extensions,
+    // eight messages at a time are compressed in lockstep in the lanes of AVX2 registers.
+    static void hash_many(Span<const ReadonlyBytes> messages, Span<DigestType> digests);
+#endif
+
     virtual String class_name() const override
     {
         return String::formatted("SHA{}", DigestSize * 8);
@@ -120,6 +126,7 @@ public:
 
 private:
     inline void transform(const u8*);
+    void transform_blocks(const u8*, size_t block_count);
 
     u8 m_data_buffer[BlockSize] {};
     size_t m_data_length { 0 };
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Endian.h>
+#include <AK/Platform.h>
+#include <AK/SIMD.h>
+#include <LibCrypto/CPUFeatures.h>
+#include <LibCrypto/Hash/SHA2.h>
+#include <LibCrypto/Hash/SHANI.h>
+
+namespace Crypto {
+namespace Hash {
+
+#if ARCH(I386) || ARCH(X86_64)
+
+using AK::SIMD::u32x8;
+
+static constexpr size_t lane_count = 8;
+static constexpr size_t block_size = 64;
+
+#    define MULTI_BUFFER_TARGET __attribute__((target("avx2")))
+
+namespace {
+
+// One message being hashed in a lane. The message is compressed straight from its storage,
+// except for the last one or two blocks which are padded into `tail`.
+struct Lane {
+    size_t message_index { 0 };
+    const u8* data { nullptr };
+    size_t full_block_count { 0 };
+    size_t block_count { 0 };
+    size_t next_block { 0 };
+    bool active { false };
+    u8 tail[2 * block_size];
+
+    const u8* block(size_t index) const
+    {
+        if (index < full_block_count)
+            return data + index * block_size;
+        return tail + (index - full_block_count) * block_size;
+    }
+
+    void start(size_t index, ReadonlyBytes message)
+    {
+        message_index = index;
+        active = true;
+        data = message.data();
+        full_block_count = message.size() / block_size;
+
+        auto remaining = message.size() % block_size;
+        block_count = full_block_count + (remaining + 9 > block_size ? 2 : 1);
+        next_block = 0;
+
+        auto tail_size = (block_count - full_block_count) * block_size;
+        __builtin_memset(tail, 0, tail_size);
+        __builtin_memcpy(tail, message.offset_pointer(full_block_count * block_size), remaining);
+        tail[remaining] = 0x80;
+        u64 bit_length = (u64)message.size() * 8;
+        for (size_t i = 0; i < 8; ++i)
+            tail[tail_size - 1 - i] = bit_length >> (i * 8);
+    }
+};
+
+}
+
+MULTI_BUFFER_TARGET static inline u32x8 rotate_right(u32x8 value, u32 bits)
+{
+    return (value >> bits) | (value << (32 - bits));
+}
+
+// Runs one SHA256 compression in each lane; `state[i]` holds state word i for all eight lanes.
+MULTI_BUFFER_TARGET static void transform_lanes(u32x8* state, const u8* const* blocks)
+{
+    u32x8 w[64];
+    for (size_t i = 0; i < 16; ++i) {
+        for (size_t lane = 0; lane < lane_count; ++lane) {
+            u32 word;
+            __builtin_memcpy(&word, blocks[lane] + 4 * i, sizeof(word));
+            w[i][lane] = AK::convert_between_host_and_big_endian(word);
+        }
+    }
+    for (size_t i = 16; i < 64; ++i) {
+        auto s0 = rotate_right(w[i - 15], 7) ^ rotate_right(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        auto s1 = rotate_right(w[i - 2], 17) ^ rotate_right(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    auto a = state[0], b = state[1], c = state[2], d = state[3];
+    auto e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (size_t i = 0; i < 64; ++i) {
+        auto s1 = rotate_right(e, 6) ^ rotate_right(e, 11) ^ rotate_right(e, 25);
+        auto ch = (e & f) ^ (~e & g);
+        auto temp0 = h + s1 + ch + SHA256Constants::RoundConstants[i] + w[i];
+        auto s0 = rotate_right(a, 2) ^ rotate_right(a, 13) ^ rotate_right(a, 22);
+        auto maj = (a & b) ^ (a & c) ^ (b & c);
+        h = g;
+        g = f;
+        f = e;
+        e = d + temp0;
+        d = c;
+        c = b;
+        b = a;
+        a = temp0 + s0 + maj;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+MULTI_BUFFER_TARGET static void hash_many_avx2(Span<const ReadonlyBytes> messages, Span<SHA256::DigestType> digests)
+{
+    Lane lanes[lane_count];
+    u32x8 state[8];
+    size_t next_message = 0;
+
+    auto start_lane = [&](size_t lane) {
+        if (next_message == messages.size()) {
+            lanes[lane].active = false;
+            return;
+        }
+        lanes[lane].start(next_message, messages[next_message]);
+        ++next_message;
+        for (size_t i = 0; i < 8; ++i)
+            state[i][lane] = SHA256Constants::InitializationHashes[i];
+    };
+
+    for (size_t lane = 0; lane < lane_count; ++lane)
+        start_lane(lane);
+
+    for (;;) {
+        const u8* blocks[lane_count];
+        bool any_active = false;
+        for (size_t lane = 0; lane < lane_count; ++lane) {
+            // Idle lanes just recompress some other lane's block, and their result is never read.
+            if (lanes[lane].active) {
+                blocks[lane] = lanes[lane].block(lanes[lane].next_block);
+                any_active = true;
+            } else {
+                blocks[lane] = lanes[0].tail;
+            }
+        }
+        if (!any_active)
+            break;
+
+        transform_lanes(state, blocks);
+
+        for (size_t lane = 0; lane < lane_count; ++lane) {
+            auto& current = lanes[lane];
+            if (!current.active || ++current.next_block < current.block_count)
+                continue;
+            auto& digest = digests[current.message_index];
+            for (size_t i = 0; i < 8; ++i) {
+                u32 word = state[i][lane];
+                digest.data[4 * i + 0] = word >> 24;
+                digest.data[4 * i + 1] = word >> 16;
+                digest.data[4 * i + 2] = word >> 8;
+                digest.data[4 * i + 3] = word;
+            }
+            start_lane(lane);
+        }
+    }
+}
+
+#endif
+
+void SHA256::hash_many(Span<const ReadonlyBytes> messages, Span<DigestType> digests)
+{
+    VERIFY(digests.size() >= messages.size());
+
+#if ARCH(I386) || ARCH(X86_64)
+    if (!SHANI::is_supported() && cpu_features().avx2 && messages.size() > 1) {
+        hash_many_avx2(messages, digests);
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < messages.size(); ++i)
+        digests[i] = hash(messages[i].data(), messages[i].size());
+}
+
+}
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Assertions.h>
+#include <AK/Platform.h>
+#include <LibCrypto/CPUFeatures.h>
+#include <LibCrypto/Hash/SHA2.h>
+#include <LibCrypto/Hash/SHANI.h>
+
+#if ARCH(I386) || ARCH(X86_64)
+#    include <immintrin.h>
+#endif
+
+namespace Crypto {
+namespace Hash {
+namespace SHANI {
+
+static constexpr size_t block_size = 64;
+
+bool is_supported()
+{
+    return cpu_features().sha && cpu_features().sse4_1 && cpu_features().ssse3;
+}
+
+#if ARCH(I386) || ARCH(X86_64)
+
+#    define SHANI_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+
+SHANI_TARGET void sha1_transform_blocks(u32* state, const u8* data, size_t block_count)
+{
+    auto const byte_swap = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+    // SHA1RNDS4 wants A in the most significant word, and E on its own.
+    auto abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1b);
+    auto e0 = _mm_set_epi32(state[4], 0, 0, 0);
+
+    for (size_t block = 0; block < block_count; ++block, data += block_size) {
+        auto const saved_abcd = abcd;
+        auto const saved_e0 = e0;
+
+        __m128i w[20];
+        auto previous_abcd = abcd;
+        auto e = e0;
+
+        // Each iteration does four rounds; the schedule is extended four words at a time.
+#    pragma GCC unroll 20
+        for (size_t group = 0; group < 20; ++group) {
+            if (group < 4)
+                w[group] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * group)), byte_swap);
+            else
+                w[group] = _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(w[group - 4], w[group - 3]), w[group - 2]), w[group - 1]);
+
+            if (group == 0)
+                e = _mm_add_epi32(e, w[0]);
+            else
+                e = _mm_sha1nexte_epu32(previous_abcd, w[group]);
+            previous_abcd = abcd;
+
+            // The round function selector has to be an immediate.
+            switch (group / 5) {
+            case 0:
+                abcd = _mm_sha1rnds4_epu32(abcd, e, 0);
+                break;
+            case 1:
+                abcd = _mm_sha1rnds4_epu32(abcd, e, 1);
+                break;
+            case 2:
+                abcd = _mm_sha1rnds4_epu32(abcd, e, 2);
+                break;
+            default:
+                abcd = _mm_sha1rnds4_epu32(abcd, e, 3);
+                break;
+            }
+        }
+
+        e0 = _mm_sha1nexte_epu32(previous_abcd, saved_e0);
+        abcd = _mm_add_epi32(abcd, saved_abcd);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_shuffle_epi32(abcd, 0x1b));
+    state[4] = _mm_extract_epi32(e0, 3);
+}
+
+SHANI_TARGET void sha256_transform_blocks(u32* state, const u8* data, size_t block_count)
+{
+    auto const byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // SHA256RNDS2 works on the state split as ABEF and CDGH.
+    auto dcba = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state));
+    auto hgfe = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4));
+    auto cdab = _mm_shuffle_epi32(dcba, 0xb1);
+    auto efgh = _mm_shuffle_epi32(hgfe, 0x1b);
+    auto abef = _mm_alignr_epi8(cdab, efgh, 8);
+    auto cdgh = _mm_blend_epi16(efgh, cdab, 0xf0);
+
+    for (size_t block = 0; block < block_count; ++block, data += block_size) {
+        auto const saved_abef = abef;
+        auto const saved_cdgh = cdgh;
+
+        __m128i w[16];
+#    pragma GCC unroll 16
+        for (size_t group = 0; group < 16; ++group) {
+            if (group < 4) {
+                w[group] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * group)), byte_swap);
+            } else {
+                auto schedule = _mm_add_epi32(_mm_sha256msg1_epu32(w[group - 4], w[group - 3]), _mm_alignr_epi8(w[group - 1], w[group - 2], 4));
+                w[group] = _mm_sha256msg2_epu32(schedule, w[group - 1]);
+            }
+
+            auto message = _mm_add_epi32(w[group], _mm_loadu_si128(reinterpret_cast<const __m128i*>(SHA256Constants::RoundConstants + 4 * group)));
+            cdgh = _mm_sha256rnds2_epu32(cdgh, abef, message);
+            abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(message, 0x0e));
+        }
+
+        abef = _mm_add_epi32(abef, saved_abef);
+        cdgh = _mm_add_epi32(cdgh, saved_cdgh);
+    }
+
+    auto feba = _mm_shuffle_epi32(abef, 0x1b);
+    auto dchg = _mm_shuffle_epi32(cdgh, 0xb1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_blend_epi16(feba, dchg, 0xf0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), _mm_alignr_epi8(dchg, feba, 8));
+}
+
+#else
+
+void sha1_transform_blocks(u32*, const u8*, size_t)
+{
+    VERIFY_NOT_REACHED();
+}
+
+void sha256_transform_blocks(u32*, const u8*, size_t)
+{
+    VERIFY_NOT_REACHED();
+}
+
+#endif
+
+}
+}
+}
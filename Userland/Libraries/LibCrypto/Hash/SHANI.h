@@ -0,0 +1,23 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+namespace Crypto {
+namespace Hash {
+namespace SHANI {
+
+// SHA extension versions of the SHA1/SHA256 compression functions. Each call folds
+// `block_count` consecutive 64-byte blocks into the host-endian `state` words.
+bool is_supported();
+void sha1_transform_blocks(u32* state, const u8* data, size_t block_count);
+void sha256_transform_blocks(u32* state, const u8* data, size_t block_count);
+
+}
+}
+}
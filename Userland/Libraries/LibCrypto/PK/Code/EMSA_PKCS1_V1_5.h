@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/StdLibExtras.h>
+#include <LibCrypto/Hash/MD5.h>
+#include <LibCrypto/Hash/SHA1.h>
+#include <LibCrypto/Hash/SHA2.h>
+#include <LibCrypto/PK/Code/Code.h>
+
+namespace Crypto {
+namespace PK {
+
+// EMSA-PKCS1-v1_5 from RFC 8017 section 9.2.
+template<typename HashFunction>
+class EMSA_PKCS1_V1_5 : public Code<HashFunction> {
+public:
+    template<typename... Args>
+    EMSA_PKCS1_V1_5(Args... args)
+        : Code<HashFunction>(args...)
+    {
+    }
+
+    virtual void encode(ReadonlyBytes in, ByteBuffer& out, size_t em_bits) override
+    {
+        auto& hash_fn = this->hasher();
+        hash_fn.update(in);
+        auto message_digest = hash_fn.digest();
+        auto message_digest_size = message_digest.data_length();
+
+        auto digest_info = hash_function_digest_info();
+        auto encoded_message_length = digest_info.size() + message_digest_size;
+
+        auto em_bytes = (em_bits + 7) / 8;
+        // RFC 8017: If emLen < tLen + 11, output "intended encoded message length too short"
+        if (em_bytes < encoded_message_length + 11) {
+            dbgln("EMSA-PKCS1-V1_5-ENCODE: intended encoded message length too short");
+            return;
+        }
+
+        // EM = 0x00 || 0x01 || PS || 0x00 || T, where PS is at least eight 0xff bytes.
+        out.resize(em_bytes);
+        out[0] = 0x00;
+        out[1] = 0x01;
+        auto padding_length = em_bytes - encoded_message_length - 3;
+        __builtin_memset(out.offset_pointer(2), 0xff, padding_length);
+        out[2 + padding_length] = 0x00;
+        out.overwrite(3 + padding_length, digest_info.data(), digest_info.size());
+        out.overwrite(3 + padding_length + digest_info.size(), message_digest.immutable_data(), message_digest_size);
+    }
+
+    virtual VerificationConsistency verify(ReadonlyBytes msg, ReadonlyBytes emsg, size_t em_bits) override
+    {
+        auto expected = ByteBuffer::create_uninitialized(emsg.size());
+        encode(msg, expected, em_bits);
+        if (expected.bytes() == emsg)
+            return VerificationConsistency::Consistent;
+        return VerificationConsistency::Inconsistent;
+    }
+
+private:
+    // The DER encoding of the DigestInfo prefix for each hash (RFC 8017 section 9.2, note 1).
+    static ReadonlyBytes hash_function_digest_info()
+    {
+        if constexpr (IsSame<HashFunction, Hash::MD5>) {
+            static constexpr Array<u8, 18> digest_info { 0x30, 0x20, 0x30, 0x0c, 0x06, 0x08, 0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x02, 0x05, 0x05, 0x00, 0x04, 0x10 };
+            return digest_info.span();
+        } else if constexpr (IsSame<HashFunction, Hash::SHA1>) {
+            static constexpr Array<u8, 15> digest_info { 0x30, 0x21, 0x30, 0x09, 0x06, 0x05, 0x2b, 0x0e, 0x03, 0x02, 0x1a, 0x05, 0x00, 0x04, 0x14 };
+            return digest_info.span();
+        } else if constexpr (IsSame<HashFunction, Hash::SHA256>) {
+            static constexpr Array<u8, 19> digest_info { 0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20 };
+            return digest_info.span();
+        } else if constexpr (IsSame<HashFunction, Hash::SHA384>) {
+            static constexpr Array<u8, 19> digest_info { 0x30, 0x41, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x02, 0x05, 0x00, 0x04, 0x30 };
+            return digest_info.span();
+        } else if constexpr (IsSame<HashFunction, Hash::SHA512>) {
+            static constexpr Array<u8, 19> digest_info { 0x30, 0x51, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x03, 0x05, 0x00, 0x04, 0x40 };
+            return digest_info.span();
+        } else {
+            static_assert(IsSame<HashFunction, void>, "Unsupported hash function for EMSA-PKCS1-v1_5");
+        }
+    }
+};
+
+}
+}
@@ -10,6 +10,7 @@
 #include <AK/Vector.h>
 #include <LibCrypto/BigInt/UnsignedBigInteger.h>
 #include <LibCrypto/NumberTheory/ModularFunctions.h>
+#include <LibCrypto/PK/Code/EMSA_PKCS1_V1_5.h>
 #include <LibCrypto/PK/Code/EMSA_PSS.h>
 #include <LibCrypto/PK/PK.h>
 
@@ -190,6 +191,42 @@ private:
     RSA m_rsa;
 };
 
+// RSASSA-PKCS1-v1_5 signature verification (RFC 8017 section 8.2.2).
+template<typename HashFunction>
+class RSA_EMSA_PKCS1_V1_5 {
+public:
+    RSA_EMSA_PKCS1_V1_5(RSA& rsa)
+        : m_rsa(rsa)
+    {
+    }
+
+    VerificationConsistency verify(ReadonlyBytes message, ReadonlyBytes signature)
+    {
+        auto& public_key = m_rsa.public_key();
+        auto modulus_size = public_key.length();
+        if (signature.size() != modulus_size)
+            return VerificationConsistency::Inconsistent;
+
+        auto signature_integer = UnsignedBigInteger::import_data(signature.data(), signature.size());
+        if (!(signature_integer < public_key.modulus()))
+            return VerificationConsistency::Inconsistent;
+        auto encoded_integer = NumberTheory::ModularPower(signature_integer, public_key.public_exponent(), public_key.modulus());
+
+        // The encoded message starts with a zero byte, so put the leading zeroes back.
+        auto encoded_length = encoded_integer.trimmed_length() * sizeof(u32);
+        if (encoded_length > modulus_size)
+            return VerificationConsistency::Inconsistent;
+        auto encoded_message = ByteBuffer::create_zeroed(modulus_size);
+        encoded_integer.export_data(encoded_message.bytes().slice(modulus_size - encoded_length));
+
+        return m_emsa.verify(message, encoded_message, modulus_size * 8);
+    }
+
+private:
+    EMSA_PKCS1_V1_5<HashFunction> m_emsa;
+    RSA m_rsa;
+};
+
 class RSA_PKCS1_EME : public RSA {
 public:
     // forward all constructions to RSA
@@ -22,10 +22,12 @@
 #include <LibDl/dlfcn_integration.h>
 #include <LibELF/AuxiliaryVector.h>
 #include <LibELF/DynamicLinker.h>
+#include <LibELF/DynamicLinkerCache.h>
 #include <LibELF/DynamicLoader.h>
 #include <LibELF/DynamicObject.h>
 #include <LibELF/Hashes.h>
 #include <fcntl.h>
+#include <signal.h>
 #include <string.h>
 #include <sys/types.h>
 #include <syscall.h>
@@ -40,6 +42,7 @@ using EntryPointFunction = int (*)(int, char**, char**);
 using LibCExitFunction = void (*)(int);
 using DlIteratePhdrCallbackFunction = int (*)(struct dl_phdr_info*, size_t, void*);
 using DlIteratePhdrFunction = int (*)(DlIteratePhdrCallbackFunction, void*);
+using AtForkRegisterFunction = void (*)(void (*)(void));
 
 extern "C" [[noreturn]] void _invoke_entry(int argc, char** argv, char** envp, EntryPointFunction entry);
 
@@ -52,13 +55,27 @@ static __pthread_mutex_t s_loader_lock = __PTHREAD_MUTEX_INITIALIZER;
 
 static bool s_allowed_to_check_environment_variables { false };
 static bool s_do_breakpoint_trap_before_entry { false };
+static bool s_bind_now { false };
+
+// Every lookup of a global symbol is remembered, since many objects ask for the same ones. The names point into
+// the string tables of the objects, which are never unmapped.
+static DynamicLinkerCache::LookupResults s_global_symbol_lookups;
+static __pthread_mutex_t s_global_symbol_lock = __PTHREAD_MUTEX_INITIALIZER;
+// The signal mask of the thread that is forking, which holds on to the lock until the fork is done.
+static sigset_t s_signal_mask_before_fork;
+
+// Set while the program itself is being loaded, if the lookups may be taken from and saved to the cache.
+static String s_startup_cache_path;
+static bool s_startup_cache_was_loaded { false };
+static NonnullRefPtrVector<DynamicObject> s_startup_objects;
+static Vector<DynamicLinkerCache::ObjectIdentity> s_startup_identities;
 
 static Result<void, DlErrorMessage> __dlclose(void* handle);
 static Result<void*, DlErrorMessage> __dlopen(const char* filename, int flags);
 static Result<void*, DlErrorMessage> __dlsym(void* handle, const char* symbol_name);
 static Result<void, DlErrorMessage> __dladdr(void* addr, Dl_info* info);
 
-Optional<DynamicObject::SymbolLookupResult> DynamicLinker::lookup_global_symbol(const StringView& name)
+static Optional<DynamicObject::SymbolLookupResult> lookup_global_symbol_uncached(const StringView& name)
 {
     Optional<DynamicObject::SymbolLookupResult> weak_result;
 
@@ -77,6 +94,74 @@ Optional<DynamicObject::SymbolLookupResult> DynamicLinker::lookup_global_symbol(
     return weak_result;
 }
 
+// Lazy binding can get here from any thread, and from signal handlers too. Signals are blocked while the lock
+// is held, so that a handler can't interrupt the thread that holds it.
+static sigset_t lock_global_symbols()
+{
+    sigset_t all_signals;
+    sigset_t previous_mask;
+    sigfillset(&all_signals);
+    sigprocmask(SIG_BLOCK, &all_signals, &previous_mask);
+    __pthread_mutex_lock(&s_global_symbol_lock);
+    return previous_mask;
+}
+
+static void unlock_global_symbols(sigset_t const& previous_mask)
+{
+    __pthread_mutex_unlock(&s_global_symbol_lock);
+    sigprocmask(SIG_SETMASK, &previous_mask, nullptr);
+}
+
+// The child of a fork only has the thread that forked, so no one else may be in the middle of a lookup.
+static void lock_global_symbols_for_fork()
+{
+    auto previous_mask = lock_global_symbols();
+    s_signal_mask_before_fork = previous_mask;
+}
+
+static void unlock_global_symbols_in_parent()
+{
+    unlock_global_symbols(s_signal_mask_before_fork);
+}
+
+static void unlock_global_symbols_in_child()
+{
+    // The lock's wait state may refer to threads that only exist in the parent.
+    __pthread_mutex_init(&s_global_symbol_lock, nullptr);
+    sigprocmask(SIG_SETMASK, &s_signal_mask_before_fork, nullptr);
+}
+
+Optional<DynamicObject::SymbolLookupResult> DynamicLinker::lookup_global_symbol(const StringView& name)
+{
+    auto previous_mask = lock_global_symbols();
+    ScopeGuard unlock_guard = [&] { unlock_global_symbols(previous_mask); };
+
+    if (auto it = s_global_symbol_lookups.find(name); it != s_global_symbol_lookups.end())
+        return it->value;
+
+    auto result = lookup_global_symbol_uncached(name);
+    s_global_symbol_lookups.set(name, result);
+    return result;
+}
+
+static void add_global_object(String const& name, DynamicObject& object)
+{
+    auto previous_mask = lock_global_symbols();
+    ScopeGuard unlock_guard = [&] { unlock_global_symbols(previous_mask); };
+
+    s_global_objects.set(name, object);
+
+    // A new object can't change which global symbol is found first, but it may define one that used to be
+    // weak or missing.
+    Vector<StringView> stale_names;
+    for (auto& it : s_global_symbol_lookups) {
+        if (!it.value.has_value() || it.value.value().bind != STB_GLOBAL)
+            stale_names.append(it.key);
+    }
+    for (auto& name : stale_names)
+        s_global_symbol_lookups.remove(name);
+}
+
 static String get_library_name(String path)
 {
     return LexicalPath::basename(move(path));
@@ -244,6 +329,19 @@ static void initialize_libc(DynamicObject& libc)
     VERIFY(res.has_value());
     *((DlAddrFunction*)res.value().address.as_ptr()) = __dladdr;
 
+    // fork() is libc's, so it has to be told about our lock.
+    res = libc.lookup_symbol("__pthread_fork_atfork_register_prepare"sv);
+    VERIFY(res.has_value());
+    ((AtForkRegisterFunction)res.value().address.as_ptr())(lock_global_symbols_for_fork);
+
+    res = libc.lookup_symbol("__pthread_fork_atfork_register_parent"sv);
+    VERIFY(res.has_value());
+    ((AtForkRegisterFunction)res.value().address.as_ptr())(unlock_global_symbols_in_parent);
+
+    res = libc.lookup_symbol("__pthread_fork_atfork_register_child"sv);
+    VERIFY(res.has_value());
+    ((AtForkRegisterFunction)res.value().address.as_ptr())(unlock_global_symbols_in_child);
+
     res = libc.lookup_symbol("__libc_init"sv);
     VERIFY(res.has_value());
     typedef void libc_init_func();
@@ -280,16 +378,32 @@ static Result<NonnullRefPtr<DynamicLoader>, DlErrorMessage> load_main_library(co
 {
     auto main_library_loader = *s_loaders.get(name);
     auto main_library_object = main_library_loader->map();
-    s_global_objects.set(name, *main_library_object);
+    add_global_object(name, *main_library_object);
+
+    bool use_startup_cache = !s_startup_cache_path.is_null();
+    if (use_startup_cache) {
+        s_startup_objects.append(*main_library_object);
+        s_startup_identities.append(main_library_loader->identity());
+    }
 
     auto loaders = collect_loaders_for_library(name);
 
     for (auto& loader : loaders) {
         auto dynamic_object = loader.map();
-        if (dynamic_object)
-            s_global_objects.set(dynamic_object->filename(), *dynamic_object);
+        if (!dynamic_object)
+            continue;
+        add_global_object(dynamic_object->filename(), *dynamic_object);
+        if (use_startup_cache) {
+            s_startup_objects.append(*dynamic_object);
+            s_startup_identities.append(loader.identity());
+        }
     }
 
+    // The objects are all mapped now, so the saved lookups can be turned back into addresses before anything
+    // gets relocated.
+    if (use_startup_cache)
+        s_startup_cache_was_loaded = DynamicLinkerCache::load(s_startup_cache_path, s_startup_objects, s_startup_identities, s_global_symbol_lookups);
+
     for (auto& loader : loaders) {
         bool success = loader.link(flags);
         if (!success) {
@@ -297,10 +411,13 @@ static Result<NonnullRefPtr<DynamicLoader>, DlErrorMessage> load_main_library(co
         }
     }
 
+    RefPtr<DynamicObject> libc;
     for (auto& loader : loaders) {
         auto result = loader.load_stage_3(flags);
         VERIFY(!result.is_error());
-        auto& object = result.value();
+
+        if (loader.filename() == "libc.so"sv)
+            libc = result.value();
 
         if (loader.filename() == "libsystem.so"sv) {
             VERIFY(!loader.text_segments().is_empty());
@@ -310,14 +427,19 @@ static Result<NonnullRefPtr<DynamicLoader>, DlErrorMessage> load_main_library(co
                 }
             }
         }
+    }
 
-        if (loader.filename() == "libc.so"sv) {
-            initialize_libc(*object);
-        }
+    for (auto& loader : loaders) {
+        auto result = loader.load_stage_4();
+        VERIFY(!result.is_error());
     }
 
+    // This runs code from libc, which may call functions that are only resolved in stage 4.
+    if (libc)
+        initialize_libc(*libc);
+
     for (auto& loader : loaders) {
-        loader.load_stage_4();
+        loader.load_stage_5();
     }
 
     return NonnullRefPtr<DynamicLoader>(*main_library_loader);
@@ -437,6 +559,8 @@ static Result<void*, DlErrorMessage> __dlsym(void* handle, const char* symbol_na
     if (!symbol.has_value()) {
         return DlErrorMessage { String::formatted("Symbol {} not found", symbol_name) };
     }
+    if (symbol.value().type == STT_GNU_IFUNC)
+        return DynamicLoader::call_ifunc_resolver(symbol.value().address).as_ptr();
     return symbol.value().address.as_ptr();
 }
 
@@ -485,9 +609,13 @@ static Result<void, DlErrorMessage> __dladdr(void* addr, Dl_info* info)
 static void read_environment_variables()
 {
     for (char** env = s_envp; *env; ++env) {
-        if (StringView { *env } == "_LOADER_BREAKPOINT=1"sv) {
+        StringView env_string { *env };
+        if (env_string == "_LOADER_BREAKPOINT=1"sv) {
             s_do_breakpoint_trap_before_entry = true;
         }
+        if (env_string.starts_with("LD_BIND_NOW="sv) && env_string.length() > "LD_BIND_NOW="sv.length()) {
+            s_bind_now = true;
+        }
     }
 }
 
@@ -527,9 +655,13 @@ void ELF::DynamicLinker::linker_main(String&& main_program_name, int main_progra
 
     allocate_tls();
 
+    // Whoever can set the environment of a set-uid program shouldn't get to pick its symbols.
+    if (!is_secure)
+        s_startup_cache_path = DynamicLinkerCache::path_for(main_program_name);
+
     auto entry_point_function = [&main_program_name] {
         auto library_name = get_library_name(main_program_name);
-        auto result = load_main_library(library_name, RTLD_GLOBAL | RTLD_LAZY);
+        auto result = load_main_library(library_name, RTLD_GLOBAL | (s_bind_now ? RTLD_NOW : RTLD_LAZY));
         if (result.is_error()) {
             warnln("{}", result.error().text);
             _exit(1);
@@ -543,6 +675,17 @@ void ELF::DynamicLinker::linker_main(String&& main_program_name, int main_progra
 
     s_loaders.clear();
 
+    if (!s_startup_cache_path.is_null()) {
+        if (!s_startup_cache_was_loaded) {
+            auto previous_mask = lock_global_symbols();
+            DynamicLinkerCache::save(s_startup_cache_path, s_startup_objects, s_startup_identities, s_global_symbol_lookups);
+            unlock_global_symbols(previous_mask);
+        }
+        s_startup_cache_path = {};
+        s_startup_objects.clear();
+        s_startup_identities.clear();
+    }
+
     int rc = syscall(SC_msyscall, nullptr);
     if (rc < 0) {
         VERIFY_NOT_REACHED();
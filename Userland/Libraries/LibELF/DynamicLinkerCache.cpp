@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ByteBuffer.h>
+#include <AK/Debug.h>
+#include <AK/LexicalPath.h>
+#include <AK/NumericLimits.h>
+#include <AK/StringBuilder.h>
+#include <AK/StringHash.h>
+#include <LibELF/DynamicLinkerCache.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ELF {
+
+static constexpr StringView cache_directory = "/var/cache/ld"sv;
+static constexpr u32 cache_magic = 0x43444c53; // "SLDC"
+static constexpr u32 cache_version = 1;
+
+enum class IdentityKind : u8 {
+    BuildID = 1,
+    File = 2,
+};
+
+struct [[gnu::packed]] CacheHeader {
+    u32 magic;
+    u32 version;
+    u32 object_count;
+    u32 entry_count;
+    u32 strings_size;
+};
+
+struct [[gnu::packed]] CacheEntry {
+    u32 name_offset;
+    u32 name_length;
+    u32 object_index;
+    u16 bind;
+    u16 type;
+    u64 value;
+    u64 size;
+};
+
+// The entry of a symbol that wasn't found in any object.
+static constexpr u32 no_object = NumericLimits<u32>::max();
+
+DynamicLinkerCache::ObjectIdentity DynamicLinkerCache::identity_of(Image const& image, int fd)
+{
+    ObjectIdentity identity;
+
+    image.for_each_program_header([&](Image::ProgramHeader const& program_header) {
+        if (program_header.type() != PT_NOTE)
+            return IterationDecision::Continue;
+        if (program_header.offset() > image.size() || program_header.size_in_image() > image.size() - program_header.offset())
+            return IterationDecision::Continue;
+
+        auto* notes = reinterpret_cast<u8 const*>(program_header.raw_data());
+        size_t remaining = program_header.size_in_image();
+        while (remaining >= 3 * sizeof(u32)) {
+            u32 name_size;
+            u32 description_size;
+            u32 type;
+            memcpy(&name_size, notes, sizeof(u32));
+            memcpy(&description_size, notes + sizeof(u32), sizeof(u32));
+            memcpy(&type, notes + 2 * sizeof(u32), sizeof(u32));
+            size_t aligned_name_size = align_up_to(name_size, 4);
+            size_t aligned_description_size = align_up_to(description_size, 4);
+            size_t note_size = 3 * sizeof(u32) + aligned_name_size + aligned_description_size;
+            if (note_size > remaining)
+                break;
+
+            auto* name = notes + 3 * sizeof(u32);
+            auto* description = name + aligned_name_size;
+            if (type == NT_GNU_BUILD_ID && name_size == 4 && memcmp(name, "GNU", 4) == 0) {
+                auto length = min<size_t>(description_size, identity.bytes.size() - 2);
+                identity.bytes[0] = to_underlying(IdentityKind::BuildID);
+                identity.bytes[1] = length;
+                memcpy(identity.bytes.data() + 2, description, length);
+                return IterationDecision::Break;
+            }
+            notes += note_size;
+            remaining -= note_size;
+        }
+        return IterationDecision::Continue;
+    });
+
+    if (identity.bytes[0] != 0)
+        return identity;
+
+    // Without a build ID, the file has to be the very same one as last time.
+    struct stat stat;
+    if (fstat(fd, &stat) < 0)
+        return identity;
+    u64 file_identity[] { (u64)stat.st_ino, (u64)stat.st_size, (u64)stat.st_mtime };
+    u32 device = stat.st_dev;
+    identity.bytes[0] = to_underlying(IdentityKind::File);
+    identity.bytes[1] = sizeof(file_identity) + sizeof(device);
+    memcpy(identity.bytes.data() + 2, file_identity, sizeof(file_identity));
+    memcpy(identity.bytes.data() + 2 + sizeof(file_identity), &device, sizeof(device));
+    return identity;
+}
+
+String DynamicLinkerCache::path_for(StringView program_path)
+{
+    // Every user gets their own file, since only its owner can replace it in the shared directory.
+    return String::formatted("{}/{}-{}-{:08x}.cache", cache_directory, LexicalPath::basename(program_path), geteuid(), string_hash(program_path.characters_without_null_termination(), program_path.length()));
+}
+
+static size_t index_of(NonnullRefPtrVector<DynamicObject> const& objects, DynamicObject const* object)
+{
+    for (size_t i = 0; i < objects.size(); ++i) {
+        if (&objects[i] == object)
+            return i;
+    }
+    return no_object;
+}
+
+bool DynamicLinkerCache::load(String const& path, NonnullRefPtrVector<DynamicObject> const& objects, Vector<ObjectIdentity> const& identities, LookupResults& results)
+{
+    VERIFY(objects.size() == identities.size());
+
+    int fd = open(path.characters(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    // Anyone who can write the file can make us call any function in place of another, so it has to be
+    // ours or root's, and no one else's.
+    struct stat stat;
+    bool trusted = fstat(fd, &stat) == 0
+        && S_ISREG(stat.st_mode)
+        && (stat.st_uid == 0 || stat.st_uid == geteuid())
+        && !(stat.st_mode & (S_IWGRP | S_IWOTH));
+    size_t file_size = trusted ? stat.st_size : 0;
+    if (file_size < sizeof(CacheHeader)) {
+        close(fd);
+        return false;
+    }
+
+    auto* data = (u8 const*)mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    auto reject = [&](StringView reason) {
+        dbgln_if(DYNAMIC_LOAD_DEBUG, "Ignoring {}: {}", path, reason);
+        munmap(const_cast<u8*>(data), file_size);
+        return false;
+    };
+
+    CacheHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != cache_magic || header.version != cache_version)
+        return reject("wrong version");
+    if (header.object_count != objects.size())
+        return reject("different objects");
+
+    size_t identities_offset = sizeof(CacheHeader);
+    size_t entries_offset = identities_offset + (size_t)header.object_count * sizeof(ObjectIdentity);
+    size_t strings_offset = entries_offset + (size_t)header.entry_count * sizeof(CacheEntry);
+    if (strings_offset + header.strings_size != file_size)
+        return reject("truncated");
+
+    for (size_t i = 0; i < identities.size(); ++i) {
+        ObjectIdentity identity;
+        memcpy(identity.bytes.data(), data + identities_offset + i * sizeof(ObjectIdentity), sizeof(ObjectIdentity));
+        if (!(identity == identities[i]))
+            return reject("different objects");
+    }
+
+    // Nothing is handed out until the whole file checked out.
+    LookupResults loaded_results;
+    auto* strings = reinterpret_cast<char const*>(data + strings_offset);
+    for (size_t i = 0; i < header.entry_count; ++i) {
+        CacheEntry entry;
+        memcpy(&entry, data + entries_offset + i * sizeof(CacheEntry), sizeof(entry));
+        if (entry.name_offset > header.strings_size || entry.name_length > header.strings_size - entry.name_offset)
+            return reject("bad name");
+        StringView name { strings + entry.name_offset, entry.name_length };
+
+        if (entry.object_index == no_object) {
+            loaded_results.set(name, {});
+            continue;
+        }
+        if (entry.object_index >= objects.size())
+            return reject("bad object");
+        auto& object = objects[entry.object_index];
+        auto address = object.elf_is_dynamic() ? object.base_address().offset(entry.value) : VirtualAddress { (FlatPtr)entry.value };
+        loaded_results.set(name, DynamicObject::SymbolLookupResult { (FlatPtr)entry.value, (size_t)entry.size, address, entry.bind, entry.type, &object });
+    }
+
+    for (auto& it : loaded_results)
+        results.set(it.key, it.value);
+
+    dbgln_if(DYNAMIC_LOAD_DEBUG, "Loaded {} symbol lookups from {}", header.entry_count, path);
+    return true;
+}
+
+void DynamicLinkerCache::save(String const& path, NonnullRefPtrVector<DynamicObject> const& objects, Vector<ObjectIdentity> const& identities, LookupResults const& results)
+{
+    VERIFY(objects.size() == identities.size());
+
+    // Someone else's file can't be replaced, and we don't want to write one for nothing on every start.
+    struct stat stat;
+    if (lstat(path.characters(), &stat) == 0 && stat.st_uid != geteuid())
+        return;
+
+    Vector<CacheEntry> entries;
+    StringBuilder strings;
+    entries.ensure_capacity(results.size());
+    for (auto& it : results) {
+        CacheEntry entry {};
+        entry.name_offset = strings.length();
+        entry.name_length = it.key.length();
+        strings.append(it.key);
+        if (!it.value.has_value()) {
+            entry.object_index = no_object;
+        } else {
+            auto& result = it.value.value();
+            entry.object_index = index_of(objects, result.dynamic_object);
+            // A symbol from an object that isn't part of the program's start can't be saved.
+            if (entry.object_index == no_object)
+                return;
+            entry.bind = result.bind;
+            entry.type = result.type;
+            entry.value = result.value;
+            entry.size = result.size;
+        }
+        entries.append(entry);
+    }
+
+    CacheHeader header { cache_magic, cache_version, (u32)objects.size(), (u32)entries.size(), (u32)strings.length() };
+
+    // Write it next to the final file, and move it into place in one go, so that no one ever sees half of it.
+    auto temporary_path = String::formatted("{}.{}", path, getpid());
+    int fd = open(temporary_path.characters(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return;
+
+    auto write_all = [&](void const* data, size_t size) {
+        auto* bytes = (u8 const*)data;
+        while (size > 0) {
+            auto nwritten = write(fd, bytes, size);
+            if (nwritten <= 0)
+                return false;
+            bytes += nwritten;
+            size -= nwritten;
+        }
+        return true;
+    };
+
+    auto string_data = strings.to_byte_buffer();
+    bool success = write_all(&header, sizeof(header))
+        && write_all(identities.data(), identities.size() * sizeof(ObjectIdentity))
+        && write_all(entries.data(), entries.size() * sizeof(CacheEntry))
+        && write_all(string_data.data(), string_data.size());
+    close(fd);
+
+    if (!success || rename(temporary_path.characters(), path.characters()) < 0) {
+        unlink(temporary_path.characters());
+        return;
+    }
+    dbgln_if(DYNAMIC_LOAD_DEBUG, "Saved {} symbol lookups to {}", entries.size(), path);
+}
+
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/HashMap.h>
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/Optional.h>
+#include <AK/String.h>
+#include <LibELF/DynamicObject.h>
+#include <LibELF/Image.h>
+
+namespace ELF {
+
+// The results of the global symbol lookups that starting a program took, saved to disk so that the next start of the
+// same program with the same libraries can skip them. The objects are identified by their build IDs, and the results
+// refer to them by their place in the load order, so they stay valid no matter where ASLR puts the objects.
+class DynamicLinkerCache {
+public:
+    // A build ID if the object has one, or else where the file is and when it was last changed.
+    struct ObjectIdentity {
+        Array<u8, 32> bytes {};
+
+        bool operator==(ObjectIdentity const& other) const { return bytes == other.bytes; }
+    };
+
+    using LookupResults = HashMap<StringView, Optional<DynamicObject::SymbolLookupResult>>;
+
+    static ObjectIdentity identity_of(Image const&, int fd);
+    static String path_for(StringView program_path);
+
+    // Adds the saved lookups to results, if the file at path was made for exactly these objects, in this order.
+    // The names point into the file, which stays mapped for as long as the process lives.
+    static bool load(String const& path, NonnullRefPtrVector<DynamicObject> const& objects, Vector<ObjectIdentity> const& identities, LookupResults& results);
+    static void save(String const& path, NonnullRefPtrVector<DynamicObject> const& objects, Vector<ObjectIdentity> const& identities, LookupResults const& results);
+
+private:
+    DynamicLinkerCache() = delete;
+};
+
+}
@@ -158,6 +158,7 @@ bool DynamicLoader::link(unsigned flags)
 bool DynamicLoader::load_stage_2(unsigned flags)
 {
     VERIFY(flags & RTLD_GLOBAL);
+    m_bind_now = !(flags & RTLD_LAZY);
 
     if (m_dynamic_object->has_text_relocations()) {
         for (auto& text_segment : m_text_segments) {
@@ -184,13 +185,16 @@ bool DynamicLoader::load_stage_2(unsigned flags)
 void DynamicLoader::do_main_relocations()
 {
     auto do_single_relocation = [&](const ELF::DynamicObject::Relocation& relocation) {
-        switch (do_relocation(relocation, ShouldInitializeWeak::No)) {
+        switch (do_relocation(relocation, ShouldInitializeWeak::No, ShouldCallIfuncResolver::No)) {
         case RelocationResult::Failed:
             dbgln("Loader.so: {} unresolved symbol '{}'", m_filename, relocation.symbol().name());
             VERIFY_NOT_REACHED();
         case RelocationResult::ResolveLater:
             m_unresolved_relocations.append(relocation);
             break;
+        case RelocationResult::CallIfuncResolverLater:
+            m_ifunc_relocations.append(relocation);
+            break;
         case RelocationResult::Success:
             break;
         }
@@ -213,6 +217,13 @@ Result<NonnullRefPtr<DynamicObject>, DlErrorMessage> DynamicLoader::load_stage_3
         }
     }
 
+    return NonnullRefPtr<DynamicObject> { *m_dynamic_object };
+}
+
+Result<void, DlErrorMessage> DynamicLoader::load_stage_4()
+{
+    do_ifunc_relocations();
+
     if (m_relro_segment_size) {
         if (mprotect(m_relro_segment_address.as_ptr(), m_relro_segment_size, PROT_READ) < 0) {
             return DlErrorMessage { String::formatted("mprotect .relro: PROT_READ: {}", strerror(errno)) };
@@ -225,10 +236,10 @@ Result<NonnullRefPtr<DynamicObject>, DlErrorMessage> DynamicLoader::load_stage_3
 #endif
     }
 
-    return NonnullRefPtr<DynamicObject> { *m_dynamic_object };
+    return {};
 }
 
-void DynamicLoader::load_stage_4()
+void DynamicLoader::load_stage_5()
 {
     call_object_init_functions();
 }
@@ -236,11 +247,33 @@ void DynamicLoader::load_stage_4()
 void DynamicLoader::do_lazy_relocations()
 {
     for (const auto& relocation : m_unresolved_relocations) {
-        if (auto res = do_relocation(relocation, ShouldInitializeWeak::Yes); res != RelocationResult::Success) {
+        auto res = do_relocation(relocation, ShouldInitializeWeak::Yes, ShouldCallIfuncResolver::No);
+        if (res == RelocationResult::CallIfuncResolverLater) {
+            m_ifunc_relocations.append(relocation);
+            continue;
+        }
+        if (res != RelocationResult::Success) {
+            dbgln("Loader.so: {} unresolved symbol '{}'", m_filename, relocation.symbol().name());
+            VERIFY_NOT_REACHED();
+        }
+    }
+}
+
+void DynamicLoader::do_ifunc_relocations()
+{
+    for (const auto& relocation : m_ifunc_relocations) {
+        if (auto res = do_relocation(relocation, ShouldInitializeWeak::Yes, ShouldCallIfuncResolver::Yes); res != RelocationResult::Success) {
             dbgln("Loader.so: {} unresolved symbol '{}'", m_filename, relocation.symbol().name());
             VERIFY_NOT_REACHED();
         }
     }
+    m_ifunc_relocations.clear();
+}
+
+VirtualAddress DynamicLoader::call_ifunc_resolver(VirtualAddress resolver)
+{
+    using IfuncResolver = FlatPtr (*)();
+    return VirtualAddress { reinterpret_cast<IfuncResolver>(resolver.get())() };
 }
 
 void DynamicLoader::load_program_headers()
@@ -389,7 +422,7 @@ void DynamicLoader::load_program_headers()
     // FIXME: Initialize the values in the TLS section. Currently, it is zeroed.
 }
 
-DynamicLoader::RelocationResult DynamicLoader::do_relocation(const ELF::DynamicObject::Relocation& relocation, ShouldInitializeWeak should_initialize_weak)
+DynamicLoader::RelocationResult DynamicLoader::do_relocation(const ELF::DynamicObject::Relocation& relocation, ShouldInitializeWeak should_initialize_weak, ShouldCallIfuncResolver should_call_ifunc_resolver)
 {
     FlatPtr* patch_ptr = nullptr;
     if (is_dynamic())
@@ -420,6 +453,11 @@ DynamicLoader::RelocationResult DynamicLoader::do_relocation(const ELF::DynamicO
             return RelocationResult::Failed;
         }
         auto symbol_address = res.value().address;
+        if (res.value().type == STT_GNU_IFUNC) {
+            if (should_call_ifunc_resolver == ShouldCallIfuncResolver::No)
+                return RelocationResult::CallIfuncResolverLater;
+            symbol_address = call_ifunc_resolver(symbol_address);
+        }
         if (relocation.addend_used())
             *patch_ptr = symbol_address.get() + relocation.addend();
         else
@@ -453,8 +491,13 @@ DynamicLoader::RelocationResult DynamicLoader::do_relocation(const ELF::DynamicO
             }
 
             symbol_location = VirtualAddress { (FlatPtr)0 };
-        } else
+        } else if (res.value().type == STT_GNU_IFUNC) {
+            if (should_call_ifunc_resolver == ShouldCallIfuncResolver::No)
+                return RelocationResult::CallIfuncResolverLater;
+            symbol_location = call_ifunc_resolver(res.value().address);
+        } else {
             symbol_location = res.value().address;
+        }
         VERIFY(symbol_location != m_dynamic_object->base_address());
         *patch_ptr = symbol_location.get();
         break;
@@ -502,8 +545,13 @@ DynamicLoader::RelocationResult DynamicLoader::do_relocation(const ELF::DynamicO
 #else
     case R_X86_64_JUMP_SLOT: {
 #endif
-        // FIXME: Or BIND_NOW flag passed in?
-        if (m_dynamic_object->must_bind_now()) {
+        // Unless asked to bind everything now, the PLT entries are resolved the first time they're called.
+        if (m_bind_now || m_dynamic_object->must_bind_now()) {
+            if (should_call_ifunc_resolver == ShouldCallIfuncResolver::No) {
+                auto res = lookup_symbol(relocation.symbol());
+                if (res.has_value() && res.value().type == STT_GNU_IFUNC)
+                    return RelocationResult::CallIfuncResolverLater;
+            }
             // Eagerly BIND_NOW the PLT entries, doing all the symbol looking goodness
             // The patch method returns the address for the LAZY fixup path, but we don't need it here
             m_dynamic_object->patch_plt_entry(relocation.offset_in_section());
@@ -515,6 +563,21 @@ DynamicLoader::RelocationResult DynamicLoader::do_relocation(const ELF::DynamicO
         }
         break;
     }
+#if ARCH(I386)
+    case R_386_IRELATIVE: {
+#else
+    case R_X86_64_IRELATIVE: {
+#endif
+        if (should_call_ifunc_resolver == ShouldCallIfuncResolver::No)
+            return RelocationResult::CallIfuncResolverLater;
+        VirtualAddress resolver;
+        if (relocation.addend_used())
+            resolver = m_dynamic_object->base_address().offset(relocation.addend());
+        else
+            resolver = m_dynamic_object->base_address().offset(*patch_ptr);
+        *patch_ptr = call_ifunc_resolver(resolver).get();
+        break;
+    }
     default:
         // Raise the alarm! Someone needs to implement this relocation type
         dbgln("Found a new exciting relocation type {}", relocation.type());
@@ -613,7 +676,7 @@ Optional<DynamicObject::SymbolLookupResult> DynamicLoader::lookup_symbol(const E
     if (symbol.is_undefined() || symbol.bind() == STB_WEAK)
         return DynamicLinker::lookup_global_symbol(symbol.name());
 
-    return DynamicObject::SymbolLookupResult { symbol.value(), symbol.size(), symbol.address(), symbol.bind(), &symbol.object() };
+    return DynamicObject::SymbolLookupResult { symbol.value(), symbol.size(), symbol.address(), symbol.bind(), symbol.type(), &symbol.object() };
 }
 
 } // end namespace ELF
@@ -13,6 +13,7 @@
 #include <AK/String.h>
 #include <LibC/elf.h>
 #include <LibDl/dlfcn_integration.h>
+#include <LibELF/DynamicLinkerCache.h>
 #include <LibELF/DynamicObject.h>
 #include <LibELF/Image.h>
 #include <sys/mman.h>
@@ -40,6 +41,11 @@ enum class ShouldInitializeWeak {
     No
 };
 
+enum class ShouldCallIfuncResolver {
+    Yes,
+    No
+};
+
 class DynamicLoader : public RefCounted<DynamicLoader> {
 public:
     static Result<NonnullRefPtr<DynamicLoader>, DlErrorMessage> try_create(int fd, String filename);
@@ -62,13 +68,18 @@ public:
     // Stage 3 of loading: lazy relocations
     Result<NonnullRefPtr<DynamicObject>, DlErrorMessage> load_stage_3(unsigned flags);
 
-    // Stage 4 of loading: initializers
-    void load_stage_4();
+    // Stage 4 of loading: relocations against IFUNC symbols, and making RELRO read-only.
+    // Their resolvers can be in any of the loaded objects, so this has to wait until stage 3 made all of them executable.
+    Result<void, DlErrorMessage> load_stage_4();
+
+    // Stage 5 of loading: initializers
+    void load_stage_5();
 
     void set_tls_offset(size_t offset) { m_tls_offset = offset; };
     size_t tls_size_of_current_object() const { return m_tls_size_of_current_object; }
     size_t tls_offset() const { return m_tls_offset; }
     const ELF::Image& image() const { return m_elf_image; }
+    DynamicLinkerCache::ObjectIdentity identity() const { return DynamicLinkerCache::identity_of(m_elf_image, m_image_fd); }
 
     template<typename F>
     void for_each_needed_library(F) const;
@@ -78,6 +89,8 @@ public:
     bool is_dynamic() const { return m_elf_image.is_dynamic(); }
 
     static Optional<DynamicObject::SymbolLookupResult> lookup_symbol(const ELF::DynamicObject::Symbol&);
+    // Returns the address of the implementation that the IFUNC resolver at the given address picked.
+    static VirtualAddress call_ifunc_resolver(VirtualAddress resolver);
     void copy_initial_tls_data_into(ByteBuffer& buffer) const;
 
 private:
@@ -120,6 +133,9 @@ private:
     void setup_plt_trampoline();
 
     // Stage 4
+    void do_ifunc_relocations();
+
+    // Stage 5
     void call_object_init_functions();
 
     bool validate();
@@ -128,8 +144,9 @@ private:
         Failed = 0,
         Success = 1,
         ResolveLater = 2,
+        CallIfuncResolverLater = 3,
     };
-    RelocationResult do_relocation(const DynamicObject::Relocation&, ShouldInitializeWeak should_initialize_weak);
+    RelocationResult do_relocation(const DynamicObject::Relocation&, ShouldInitializeWeak should_initialize_weak, ShouldCallIfuncResolver should_call_ifunc_resolver);
     size_t calculate_tls_size() const;
     ssize_t negative_offset_from_tls_block_end(ssize_t tls_offset, size_t value_of_symbol) const;
 
@@ -140,6 +157,7 @@ private:
     void* m_file_data { nullptr };
     ELF::Image m_elf_image;
     bool m_valid { true };
+    bool m_bind_now { false };
 
     RefPtr<DynamicObject> m_dynamic_object;
 
@@ -155,6 +173,7 @@ private:
     size_t m_tls_size_of_current_object { 0 };
 
     Vector<DynamicObject::Relocation> m_unresolved_relocations;
+    Vector<DynamicObject::Relocation> m_ifunc_relocations;
 
     mutable RefPtr<DynamicObject> m_cached_dynamic_object;
 };
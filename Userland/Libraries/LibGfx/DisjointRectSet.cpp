@@ -4,53 +4,264 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/NumericLimits.h>
 #include <LibGfx/DisjointRectSet.h>
 
 namespace Gfx {
 
-bool DisjointRectSet::add_no_shatter(const IntRect& new_rect)
+namespace {
+
+// The columns [start, end) of a rect in a band.
+struct Interval {
+    int start { 0 };
+    int end { 0 };
+};
+
+}
+
+static void append_intervals(Vector<IntRect, 32> const& rects, size_t band_start, size_t band_end, Vector<Interval, 32>& intervals)
 {
-    if (new_rect.is_empty())
-        return false;
-    for (auto& rect : m_rects) {
-        if (rect.contains(new_rect))
-            return false;
+    intervals.clear_with_capacity();
+    for (size_t i = band_start; i < band_end; ++i)
+        intervals.append({ rects[i].left(), rects[i].right() + 1 });
+}
+
+static void unite_intervals(Vector<Interval, 32> const& a, Vector<Interval, 32> const& b, Vector<Interval, 32>& result)
+{
+    size_t i = 0;
+    size_t j = 0;
+    auto append = [&](Interval const& interval) {
+        // Touching intervals are merged, so that the result is the same no matter how it was put together.
+        if (!result.is_empty() && interval.start <= result.last().end)
+            result.last().end = max(result.last().end, interval.end);
+        else
+            result.append(interval);
+    };
+    while (i < a.size() || j < b.size()) {
+        if (j == b.size() || (i < a.size() && a[i].start < b[j].start))
+            append(a[i++]);
+        else
+            append(b[j++]);
     }
+}
+
+static void intersect_intervals(Vector<Interval, 32> const& a, Vector<Interval, 32> const& b, Vector<Interval, 32>& result)
+{
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.size() && j < b.size()) {
+        int start = max(a[i].start, b[j].start);
+        int end = min(a[i].end, b[j].end);
+        if (start < end)
+            result.append({ start, end });
+        if (a[i].end < b[j].end)
+            ++i;
+        else
+            ++j;
+    }
+}
+
+static void subtract_intervals(Vector<Interval, 32> const& a, Vector<Interval, 32> const& b, Vector<Interval, 32>& result)
+{
+    size_t j = 0;
+    for (auto& interval : a) {
+        int start = interval.start;
+        while (j < b.size() && b[j].end <= start)
+            ++j;
+        for (size_t k = j; k < b.size() && b[k].start < interval.end; ++k) {
+            if (b[k].start > start)
+                result.append({ start, b[k].start });
+            start = max(start, b[k].end);
+            if (start >= interval.end)
+                break;
+        }
+        if (start < interval.end)
+            result.append({ start, interval.end });
+    }
+}
 
-    m_rects.append(new_rect);
-    return true;
-}
-
-void DisjointRectSet::shatter()
-{
-    Vector<IntRect, 32> output;
-    output.ensure_capacity(m_rects.size());
-    bool pass_had_intersections = false;
-    do {
-        pass_had_intersections = false;
-        output.clear_with_capacity();
-        for (size_t i = 0; i < m_rects.size(); ++i) {
-            auto& r1 = m_rects[i];
-            for (size_t j = 0; j < m_rects.size(); ++j) {
-                if (i == j)
-                    continue;
-                auto& r2 = m_rects[j];
-                if (!r1.intersects(r2))
-                    continue;
-                pass_had_intersections = true;
-                auto pieces = r1.shatter(r2);
-                for (auto& piece : pieces)
-                    output.append(piece);
-                m_rects.remove(i);
-                for (; i < m_rects.size(); ++i)
-                    output.append(m_rects[i]);
-                goto next_pass;
+static size_t band_end_in(Vector<IntRect, 32> const& rects, size_t band_start)
+{
+    size_t end = band_start + 1;
+    while (end < rects.size() && rects[end].top() == rects[band_start].top())
+        ++end;
+    return end;
+}
+
+Vector<IntRect, 32> DisjointRectSet::combine(Vector<IntRect, 32> const& a, Vector<IntRect, 32> const& b, Operation operation)
+{
+    Vector<IntRect, 32> result;
+    Vector<Interval, 32> a_intervals;
+    Vector<Interval, 32> b_intervals;
+    Vector<Interval, 32> intervals;
+
+    // The band that was added last, so that the next one can be merged into it if it continues it.
+    size_t previous_band_start = 0;
+    int previous_band_bottom = NumericLimits<int>::min();
+
+    auto append_band = [&](int top, int bottom) {
+        if (intervals.is_empty())
+            return;
+        if (previous_band_bottom == top && result.size() - previous_band_start == intervals.size()) {
+            bool same_columns = true;
+            for (size_t i = 0; i < intervals.size() && same_columns; ++i) {
+                auto& rect = result[previous_band_start + i];
+                same_columns = rect.left() == intervals[i].start && rect.right() + 1 == intervals[i].end;
+            }
+            if (same_columns) {
+                for (size_t i = previous_band_start; i < result.size(); ++i)
+                    result[i].set_height(bottom - result[i].top());
+                previous_band_bottom = bottom;
+                return;
+            }
+        }
+        previous_band_start = result.size();
+        previous_band_bottom = bottom;
+        for (auto& interval : intervals)
+            result.append({ interval.start, top, interval.end - interval.start, bottom - top });
+    };
+
+    size_t a_band = 0;
+    size_t b_band = 0;
+    size_t a_band_end = a.is_empty() ? 0 : band_end_in(a, 0);
+    size_t b_band_end = b.is_empty() ? 0 : band_end_in(b, 0);
+    int y = min(a.is_empty() ? NumericLimits<int>::max() : a.first().top(), b.is_empty() ? NumericLimits<int>::max() : b.first().top());
+
+    for (;;) {
+        // Skip the bands that end above y.
+        while (a_band < a.size() && a[a_band].bottom() < y) {
+            a_band = a_band_end;
+            if (a_band < a.size())
+                a_band_end = band_end_in(a, a_band);
+        }
+        while (b_band < b.size() && b[b_band].bottom() < y) {
+            b_band = b_band_end;
+            if (b_band < b.size())
+                b_band_end = band_end_in(b, b_band);
+        }
+
+        bool a_done = a_band == a.size();
+        bool b_done = b_band == b.size();
+        if (a_done && b_done)
+            break;
+        if (a_done && operation != Operation::Union)
+            break;
+        if (b_done && operation == Operation::Intersection)
+            break;
+
+        bool in_a = !a_done && a[a_band].top() <= y;
+        bool in_b = !b_done && b[b_band].top() <= y;
+
+        // The next row at which one of the two changes.
+        int next_y = NumericLimits<int>::max();
+        if (!a_done)
+            next_y = min(next_y, in_a ? a[a_band].bottom() + 1 : a[a_band].top());
+        if (!b_done)
+            next_y = min(next_y, in_b ? b[b_band].bottom() + 1 : b[b_band].top());
+
+        if (in_a || in_b) {
+            intervals.clear_with_capacity();
+            switch (operation) {
+            case Operation::Union:
+                if (in_a && in_b) {
+                    append_intervals(a, a_band, a_band_end, a_intervals);
+                    append_intervals(b, b_band, b_band_end, b_intervals);
+                    unite_intervals(a_intervals, b_intervals, intervals);
+                } else if (in_a) {
+                    append_intervals(a, a_band, a_band_end, intervals);
+                } else {
+                    append_intervals(b, b_band, b_band_end, intervals);
+                }
+                break;
+            case Operation::Intersection:
+                if (in_a && in_b) {
+                    append_intervals(a, a_band, a_band_end, a_intervals);
+                    append_intervals(b, b_band, b_band_end, b_intervals);
+                    intersect_intervals(a_intervals, b_intervals, intervals);
+                }
+                break;
+            case Operation::Difference:
+                if (in_a && in_b) {
+                    append_intervals(a, a_band, a_band_end, a_intervals);
+                    append_intervals(b, b_band, b_band_end, b_intervals);
+                    subtract_intervals(a_intervals, b_intervals, intervals);
+                } else if (in_a) {
+                    append_intervals(a, a_band, a_band_end, intervals);
+                }
+                break;
             }
-            output.append(r1);
+            append_band(y, next_y);
         }
-    next_pass:
-        swap(output, m_rects);
-    } while (pass_had_intersections);
+        y = next_y;
+    }
+    return result;
+}
+
+DisjointRectSet DisjointRectSet::union_of(Span<IntRect const> rects)
+{
+    // Uniting them pairwise keeps the sets that are combined about the same size.
+    if (rects.size() == 1)
+        return DisjointRectSet(rects[0]);
+    auto half = rects.size() / 2;
+    auto first_half = union_of(rects.slice(0, half));
+    auto second_half = union_of(rects.slice(half));
+    DisjointRectSet result;
+    result.m_rects = combine(first_half.m_rects, second_half.m_rects, Operation::Union);
+    return result;
+}
+
+void DisjointRectSet::add(const IntRect& rect)
+{
+    if (rect.is_empty())
+        return;
+    if (m_rects.is_empty()) {
+        m_rects.append(rect);
+        return;
+    }
+    if (contains(rect))
+        return;
+    m_rects = combine(m_rects, DisjointRectSet(rect).m_rects, Operation::Union);
+}
+
+void DisjointRectSet::add_rects(Span<IntRect const> rects)
+{
+    if (rects.is_empty())
+        return;
+    auto new_rects = union_of(rects);
+    if (m_rects.is_empty())
+        m_rects = move(new_rects.m_rects);
+    else
+        m_rects = combine(m_rects, new_rects.m_rects, Operation::Union);
+}
+
+void DisjointRectSet::add(const DisjointRectSet& rect_set)
+{
+    if (this == &rect_set || rect_set.is_empty())
+        return;
+    if (m_rects.is_empty())
+        m_rects = rect_set.m_rects;
+    else
+        m_rects = combine(m_rects, rect_set.m_rects, Operation::Union);
+}
+
+size_t DisjointRectSet::first_rect_not_above(int y) const
+{
+    // Both the tops and the bottoms of the rects only ever go up, so this can be a binary search.
+    size_t low = 0;
+    size_t high = m_rects.size();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (m_rects[middle].bottom() < y)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+size_t DisjointRectSet::band_end(size_t band_start) const
+{
+    return band_end_in(m_rects, band_start);
 }
 
 void DisjointRectSet::move_by(int dx, int dy)
@@ -64,20 +275,32 @@ bool DisjointRectSet::contains(const IntRect& rect) const
     if (is_empty() || rect.is_empty())
         return false;
 
-    // TODO: This could use some optimization
-    DisjointRectSet remainder(rect);
-    for (auto& r : m_rects) {
-        auto shards = remainder.shatter(r);
-        if (shards.is_empty())
-            return true;
-        remainder = move(shards);
+    // Every row of the rect has to be in a band, in which a single rect covers all of its columns, since the
+    // rects in a band never touch.
+    int y = rect.top();
+    for (size_t band_start = first_rect_not_above(y); band_start < m_rects.size() && y <= rect.bottom();) {
+        if (m_rects[band_start].top() > y)
+            return false;
+        auto end = band_end(band_start);
+        bool covered = false;
+        for (size_t i = band_start; i < end && !covered; ++i)
+            covered = m_rects[i].left() <= rect.left() && m_rects[i].right() >= rect.right();
+        if (!covered)
+            return false;
+        y = m_rects[band_start].bottom() + 1;
+        band_start = end;
     }
-    return false;
+    return y > rect.bottom();
 }
 
 bool DisjointRectSet::intersects(const IntRect& rect) const
 {
-    for (auto& r : m_rects) {
+    if (rect.is_empty())
+        return false;
+    for (size_t i = first_rect_not_above(rect.top()); i < m_rects.size(); ++i) {
+        auto& r = m_rects[i];
+        if (r.top() > rect.bottom())
+            break;
         if (r.intersects(rect))
             return true;
     }
@@ -87,13 +310,13 @@ bool DisjointRectSet::intersects(const IntRect& rect) const
 bool DisjointRectSet::intersects(const DisjointRectSet& rects) const
 {
     if (this == &rects)
-        return true;
+        return !is_empty();
 
-    for (auto& r : m_rects) {
-        for (auto& r2 : rects.m_rects) {
-            if (r.intersects(r2))
-                return true;
-        }
+    auto& smaller = size() < rects.size() ? *this : rects;
+    auto& larger = size() < rects.size() ? rects : *this;
+    for (auto& r : smaller.m_rects) {
+        if (larger.intersects(r))
+            return true;
     }
     return false;
 }
@@ -101,13 +324,9 @@ bool DisjointRectSet::intersects(const DisjointRectSet& rects) const
 DisjointRectSet DisjointRectSet::intersected(const IntRect& rect) const
 {
     DisjointRectSet intersected_rects;
-    intersected_rects.m_rects.ensure_capacity(m_rects.capacity());
-    for (auto& r : m_rects) {
-        auto intersected_rect = r.intersected(rect);
-        if (!intersected_rect.is_empty())
-            intersected_rects.m_rects.append(intersected_rect);
-    }
-    // Since there should be no overlaps, we don't need to call shatter()
+    if (is_empty() || rect.is_empty())
+        return intersected_rects;
+    intersected_rects.m_rects = combine(m_rects, DisjointRectSet(rect).m_rects, Operation::Intersection);
     return intersected_rects;
 }
 
@@ -119,29 +338,17 @@ DisjointRectSet DisjointRectSet::intersected(const DisjointRectSet& rects) const
         return {};
 
     DisjointRectSet intersected_rects;
-    intersected_rects.m_rects.ensure_capacity(m_rects.capacity());
-    for (auto& r : m_rects) {
-        for (auto& r2 : rects.m_rects) {
-            auto intersected_rect = r.intersected(r2);
-            if (!intersected_rect.is_empty())
-                intersected_rects.m_rects.append(intersected_rect);
-        }
-    }
-    // Since there should be no overlaps, we don't need to call shatter()
+    intersected_rects.m_rects = combine(m_rects, rects.m_rects, Operation::Intersection);
     return intersected_rects;
 }
 
 DisjointRectSet DisjointRectSet::shatter(const IntRect& hammer) const
 {
-    if (hammer.is_empty())
+    if (hammer.is_empty() || !intersects(hammer))
         return clone();
 
     DisjointRectSet shards;
-    for (auto& rect : m_rects) {
-        for (auto& shard : rect.shatter(hammer))
-            shards.add_no_shatter(shard);
-    }
-    // Since there should be no overlaps, we don't need to call shatter()
+    shards.m_rects = combine(m_rects, DisjointRectSet(hammer).m_rects, Operation::Difference);
     return shards;
 }
 
@@ -152,16 +359,8 @@ DisjointRectSet DisjointRectSet::shatter(const DisjointRectSet& hammer) const
     if (hammer.is_empty() || !intersects(hammer))
         return clone();
 
-    // TODO: This could use some optimization
-    DisjointRectSet shards = shatter(hammer.m_rects[0]);
-    auto rects_count = hammer.m_rects.size();
-    for (size_t i = 1; i < rects_count && !shards.is_empty(); i++) {
-        if (hammer.m_rects[i].intersects(shards.m_rects)) {
-            auto shattered = shards.shatter(hammer.m_rects[i]);
-            shards = move(shattered);
-        }
-    }
-    // Since there should be no overlaps, we don't need to call shatter()
+    DisjointRectSet shards;
+    shards.m_rects = combine(m_rects, hammer.m_rects, Operation::Difference);
     return shards;
 }
 
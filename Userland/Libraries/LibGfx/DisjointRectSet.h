@@ -12,6 +12,11 @@
 
 namespace Gfx {
 
+// A set of pixels, stored as rects that don't overlap. The rects are kept in y-x banded form: the set is split
+// into horizontal bands, in which all rects have the same top and height, sorted from top to bottom and then from
+// left to right. Rects in a band never touch, and neighbouring bands are merged when they span the same columns.
+// This way every set has exactly one representation, and adding, subtracting and intersecting sets is done
+// with a single sweep over both of them, instead of comparing every rect with every other one.
 class DisjointRectSet {
 public:
     DisjointRectSet(const DisjointRectSet&) = delete;
@@ -22,7 +27,8 @@ public:
 
     DisjointRectSet(const IntRect& rect)
     {
-        m_rects.append(rect);
+        if (!rect.is_empty())
+            m_rects.append(rect);
     }
 
     DisjointRectSet(DisjointRectSet&&) = default;
@@ -41,34 +47,20 @@ public:
         move_by(delta.x(), delta.y());
     }
 
-    void add(const IntRect& rect)
-    {
-        if (add_no_shatter(rect) && m_rects.size() > 1)
-            shatter();
-    }
+    void add(const IntRect&);
 
     template<typename Container>
     void add_many(const Container& rects)
     {
-        bool added = false;
+        Vector<IntRect, 32> new_rects;
         for (const auto& rect : rects) {
-            if (add_no_shatter(rect))
-                added = true;
+            if (!rect.is_empty())
+                new_rects.append(rect);
         }
-        if (added && m_rects.size() > 1)
-            shatter();
+        add_rects(new_rects.span());
     }
 
-    void add(const DisjointRectSet& rect_set)
-    {
-        if (this == &rect_set)
-            return;
-        if (m_rects.is_empty()) {
-            m_rects = rect_set.m_rects;
-        } else {
-            add_many(rect_set.rects());
-        }
-    }
+    void add(const DisjointRectSet&);
 
     DisjointRectSet shatter(const IntRect&) const;
     DisjointRectSet shatter(const DisjointRectSet& hammer) const;
@@ -84,7 +76,10 @@ public:
     {
         if (is_empty() || rect.is_empty())
             return IterationDecision::Continue;
-        for (auto& r : m_rects) {
+        for (size_t i = first_rect_not_above(rect.top()); i < m_rects.size(); ++i) {
+            auto& r = m_rects[i];
+            if (r.top() > rect.bottom())
+                break;
             auto intersected_rect = r.intersected(rect);
             if (intersected_rect.is_empty())
                 continue;
@@ -106,17 +101,13 @@ public:
                 if (decision != IterationDecision::Continue)
                     return decision;
             }
-        } else {
-            for (auto& r : m_rects) {
-                for (auto& r2 : rects.m_rects) {
-                    auto intersected_rect = r.intersected(r2);
-                    if (intersected_rect.is_empty())
-                        continue;
-                    IterationDecision decision = f(intersected_rect);
-                    if (decision != IterationDecision::Continue)
-                        return decision;
-                }
-            }
+            return IterationDecision::Continue;
+        }
+        auto intersected_rects = intersected(rects);
+        for (auto& r : intersected_rects.m_rects) {
+            IterationDecision decision = f(r);
+            if (decision != IterationDecision::Continue)
+                return decision;
         }
         return IterationDecision::Continue;
     }
@@ -141,8 +132,18 @@ public:
     }
 
 private:
-    bool add_no_shatter(const IntRect&);
-    void shatter();
+    enum class Operation {
+        Union,
+        Intersection,
+        Difference,
+    };
+
+    static Vector<IntRect, 32> combine(Vector<IntRect, 32> const&, Vector<IntRect, 32> const&, Operation);
+    static DisjointRectSet union_of(Span<IntRect const>);
+
+    void add_rects(Span<IntRect const>);
+    size_t first_rect_not_above(int y) const;
+    size_t band_end(size_t band_start) const;
 
     Vector<IntRect, 32> m_rects;
 };
@@ -8,6 +8,9 @@
 #include <AK/Endian.h>
 #include <AK/LexicalPath.h>
 #include <AK/MappedFile.h>
+#include <AK/SIMD.h>
+#include <AK/Stream.h>
+#include <LibCompress/Deflate.h>
 #include <LibCompress/Zlib.h>
 #include <LibGfx/PNGLoader.h>
 #include <fcntl.h>
@@ -18,12 +21,15 @@
 #include <unistd.h>
 
 #ifdef __serenity__
-#    include <LibCompress/Deflate.h>
 #    include <serenity.h>
 #endif
 
 namespace Gfx {
 
+using AK::SIMD::i16x4;
+using AK::SIMD::u8x16;
+using AK::SIMD::u8x4;
+
 static const u8 png_header[8] = { 0x89, 'P', 'N', 'G', 13, 10, 26, 10 };
 
 struct PNG_IHDR {
@@ -38,11 +44,6 @@ struct PNG_IHDR {
 
 static_assert(sizeof(PNG_IHDR) == 13);
 
-struct Scanline {
-    u8 filter { 0 };
-    ReadonlyBytes data {};
-};
-
 struct [[gnu::packed]] PaletteEntry {
     u8 r;
     u8 g;
@@ -98,10 +99,8 @@ struct PNGLoadingContext {
     u8 channels { 0 };
     bool has_seen_zlib_header { false };
     bool has_alpha() const { return color_type & 4 || palette_transparency_data.size() > 0; }
-    Vector<Scanline> scanlines;
     RefPtr<Gfx::Bitmap> bitmap;
-    ByteBuffer* decompression_buffer { nullptr };
-    Vector<u8> compressed_data;
+    Vector<ReadonlyBytes> idat_chunks;
     Vector<PaletteEntry> palette_data;
     Vector<u8> palette_transparency_data;
 
@@ -166,6 +165,63 @@ private:
     size_t m_size_remaining { 0 };
 };
 
+// Presents the IDAT chunks as one contiguous stream without copying them together first.
+class IDATInputStream final : public InputStream {
+public:
+    explicit IDATInputStream(Vector<ReadonlyBytes> const& chunks)
+        : m_chunks(chunks)
+    {
+    }
+
+    size_t read(Bytes bytes) override
+    {
+        if (has_any_error())
+            return 0;
+
+        size_t nread = 0;
+        while (nread < bytes.size() && m_chunk_index < m_chunks.size()) {
+            auto chunk = m_chunks[m_chunk_index].slice(m_offset_in_chunk);
+            auto count = min(chunk.size(), bytes.size() - nread);
+            __builtin_memcpy(bytes.data() + nread, chunk.data(), count);
+            nread += count;
+            m_offset_in_chunk += count;
+            if (m_offset_in_chunk == m_chunks[m_chunk_index].size()) {
+                ++m_chunk_index;
+                m_offset_in_chunk = 0;
+            }
+        }
+        return nread;
+    }
+
+    bool read_or_error(Bytes bytes) override
+    {
+        if (read(bytes) < bytes.size()) {
+            set_fatal_error();
+            return false;
+        }
+        return true;
+    }
+
+    bool discard_or_error(size_t count) override
+    {
+        u8 buffer[4096];
+        while (count > 0) {
+            auto chunk_size = min(count, sizeof(buffer));
+            if (!read_or_error({ buffer, chunk_size }))
+                return false;
+            count -= chunk_size;
+        }
+        return true;
+    }
+
+    bool unreliable_eof() const override { return m_chunk_index >= m_chunks.size(); }
+
+private:
+    Vector<ReadonlyBytes> const& m_chunks;
+    size_t m_chunk_index { 0 };
+    size_t m_offset_in_chunk { 0 };
+};
+
 static RefPtr<Gfx::Bitmap> load_png_impl(const u8*, size_t);
 static bool process_chunk(Streamer&, PNGLoadingContext& context);
 
@@ -201,169 +257,181 @@ ALWAYS_INLINE static u8 paeth_predictor(int a, int b, int c)
     return c;
 }
 
-union [[gnu::packed]] Pixel {
-    RGBA32 rgba { 0 };
-    u8 v[4];
-    struct {
-        u8 r;
-        u8 g;
-        u8 b;
-        u8 a;
-    };
-};
-static_assert(sizeof(Pixel) == 4);
+// The vectorized filters below work on one whole pixel at a time, with each channel in its own lane.
+// Only the lanes covered by bytes_per_pixel are loaded and stored, so 3-byte RGB pixels work too.
+template<size_t bytes_per_pixel>
+ALWAYS_INLINE static u8x4 load_pixel(const u8* data)
+{
+    static_assert(bytes_per_pixel <= sizeof(u8x4));
+    u8x4 pixel {};
+    __builtin_memcpy(&pixel, data, bytes_per_pixel);
+    return pixel;
+}
 
-template<bool has_alpha, u8 filter_type>
-ALWAYS_INLINE static void unfilter_impl(Gfx::Bitmap& bitmap, int y, const void* dummy_scanline_data)
+template<size_t bytes_per_pixel>
+ALWAYS_INLINE static void store_pixel(u8* data, u8x4 pixel)
 {
-    auto* dummy_scanline = (const Pixel*)dummy_scanline_data;
-    if constexpr (filter_type == 0) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-        }
+    __builtin_memcpy(data, &pixel, bytes_per_pixel);
+}
+
+ALWAYS_INLINE static i16x4 abs_vector(i16x4 value)
+{
+    auto sign = value >> 15;
+    return (value ^ sign) - sign;
+}
+
+template<size_t bytes_per_pixel>
+ALWAYS_INLINE static void unfilter_sub(Bytes scanline)
+{
+    u8x4 a {};
+    for (size_t i = 0; i < scanline.size(); i += bytes_per_pixel) {
+        a += load_pixel<bytes_per_pixel>(&scanline[i]);
+        store_pixel<bytes_per_pixel>(&scanline[i], a);
     }
+}
 
-    if constexpr (filter_type == 1) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        swap(pixels[0].r, pixels[0].b);
-        for (int i = 1; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            auto& a = (const Pixel&)pixels[i - 1];
-            x.v[0] += a.v[0];
-            x.v[1] += a.v[1];
-            x.v[2] += a.v[2];
-            if constexpr (has_alpha)
-                x.v[3] += a.v[3];
-        }
-        return;
+ALWAYS_INLINE static void unfilter_up(Bytes scanline, ReadonlyBytes previous_scanline)
+{
+    size_t i = 0;
+    for (; i + sizeof(u8x16) <= scanline.size(); i += sizeof(u8x16)) {
+        u8x16 x;
+        u8x16 b;
+        __builtin_memcpy(&x, &scanline[i], sizeof(x));
+        __builtin_memcpy(&b, &previous_scanline[i], sizeof(b));
+        x += b;
+        __builtin_memcpy(&scanline[i], &x, sizeof(x));
     }
-    if constexpr (filter_type == 2) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (const Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            const Pixel& b = pixels_y_minus_1[i];
-            x.v[0] += b.v[0];
-            x.v[1] += b.v[1];
-            x.v[2] += b.v[2];
-            if constexpr (has_alpha)
-                x.v[3] += b.v[3];
-        }
-        return;
+    for (; i < scanline.size(); ++i)
+        scanline[i] += previous_scanline[i];
+}
+
+template<size_t bytes_per_pixel>
+ALWAYS_INLINE static void unfilter_average(Bytes scanline, ReadonlyBytes previous_scanline)
+{
+    u8x4 a {};
+    for (size_t i = 0; i < scanline.size(); i += bytes_per_pixel) {
+        auto b = load_pixel<bytes_per_pixel>(&previous_scanline[i]);
+        // This is floor((a + b) / 2), computed without widening the lanes.
+        a = load_pixel<bytes_per_pixel>(&scanline[i]) + ((a & b) + ((a ^ b) >> 1));
+        store_pixel<bytes_per_pixel>(&scanline[i], a);
+    }
+}
+
+template<size_t bytes_per_pixel>
+ALWAYS_INLINE static void unfilter_paeth(Bytes scanline, ReadonlyBytes previous_scanline)
+{
+    i16x4 a {};
+    i16x4 c {};
+    for (size_t i = 0; i < scanline.size(); i += bytes_per_pixel) {
+        auto b = __builtin_convertvector(load_pixel<bytes_per_pixel>(&previous_scanline[i]), i16x4);
+        auto pa = abs_vector(b - c);
+        auto pb = abs_vector(a - c);
+        auto pc = abs_vector(a + b - c - c);
+        i16x4 use_a = (pa <= pb) & (pa <= pc);
+        i16x4 use_b = ~use_a & (pb <= pc);
+        i16x4 use_c = ~(use_a | use_b);
+        auto predictor = (use_a & a) | (use_b & b) | (use_c & c);
+        auto x = load_pixel<bytes_per_pixel>(&scanline[i]) + __builtin_convertvector(predictor, u8x4);
+        store_pixel<bytes_per_pixel>(&scanline[i], x);
+        a = __builtin_convertvector(x, i16x4);
+        c = b;
     }
-    if constexpr (filter_type == 3) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (const Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            Pixel a;
-            if (i != 0)
-                a = pixels[i - 1];
-            const Pixel& b = pixels_y_minus_1[i];
-            x.v[0] = x.v[0] + ((a.v[0] + b.v[0]) / 2);
-            x.v[1] = x.v[1] + ((a.v[1] + b.v[1]) / 2);
-            x.v[2] = x.v[2] + ((a.v[2] + b.v[2]) / 2);
-            if constexpr (has_alpha)
-                x.v[3] = x.v[3] + ((a.v[3] + b.v[3]) / 2);
+}
+
+NEVER_INLINE FLATTEN static void unfilter_scanline(u8 filter, Bytes scanline, ReadonlyBytes previous_scanline, size_t bytes_per_pixel)
+{
+    switch (filter) {
+    case 0:
+        return;
+    case 1:
+        if (bytes_per_pixel == 4)
+            return unfilter_sub<4>(scanline);
+        if (bytes_per_pixel == 3)
+            return unfilter_sub<3>(scanline);
+        for (size_t i = bytes_per_pixel; i < scanline.size(); ++i)
+            scanline[i] += scanline[i - bytes_per_pixel];
+        return;
+    case 2:
+        return unfilter_up(scanline, previous_scanline);
+    case 3:
+        if (bytes_per_pixel == 4)
+            return unfilter_average<4>(scanline, previous_scanline);
+        if (bytes_per_pixel == 3)
+            return unfilter_average<3>(scanline, previous_scanline);
+        for (size_t i = 0; i < scanline.size(); ++i) {
+            u8 a = i >= bytes_per_pixel ? scanline[i - bytes_per_pixel] : 0;
+            scanline[i] += (a + previous_scanline[i]) / 2;
         }
         return;
-    }
-    if constexpr (filter_type == 4) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            Pixel a;
-            const Pixel& b = pixels_y_minus_1[i];
-            Pixel c;
-            if (i != 0) {
-                a = pixels[i - 1];
-                c = pixels_y_minus_1[i - 1];
-            }
-            x.v[0] += paeth_predictor(a.v[0], b.v[0], c.v[0]);
-            x.v[1] += paeth_predictor(a.v[1], b.v[1], c.v[1]);
-            x.v[2] += paeth_predictor(a.v[2], b.v[2], c.v[2]);
-            if constexpr (has_alpha)
-                x.v[3] += paeth_predictor(a.v[3], b.v[3], c.v[3]);
+    case 4:
+        if (bytes_per_pixel == 4)
+            return unfilter_paeth<4>(scanline, previous_scanline);
+        if (bytes_per_pixel == 3)
+            return unfilter_paeth<3>(scanline, previous_scanline);
+        for (size_t i = 0; i < scanline.size(); ++i) {
+            u8 a = i >= bytes_per_pixel ? scanline[i - bytes_per_pixel] : 0;
+            u8 c = i >= bytes_per_pixel ? previous_scanline[i - bytes_per_pixel] : 0;
+            scanline[i] += paeth_predictor(a, previous_scanline[i], c);
         }
+        return;
     }
+    VERIFY_NOT_REACHED();
 }
 
 template<typename T>
-ALWAYS_INLINE static void unpack_grayscale_without_alpha(PNGLoadingContext& context)
-{
-    for (int y = 0; y < context.height; ++y) {
-        auto* gray_values = reinterpret_cast<const T*>(context.scanlines[y].data.data());
-        for (int i = 0; i < context.width; ++i) {
-            auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-            pixel.r = gray_values[i];
-            pixel.g = gray_values[i];
-            pixel.b = gray_values[i];
-            pixel.a = 0xff;
-        }
+ALWAYS_INLINE static void unpack_grayscale_without_alpha(ReadonlyBytes scanline, RGBA32* pixels, int width)
+{
+    auto* gray_values = reinterpret_cast<const T*>(scanline.data());
+    for (int i = 0; i < width; ++i) {
+        u8 gray = gray_values[i];
+        pixels[i] = Color(gray, gray, gray).value();
     }
 }
 
 template<typename T>
-ALWAYS_INLINE static void unpack_grayscale_with_alpha(PNGLoadingContext& context)
-{
-    for (int y = 0; y < context.height; ++y) {
-        auto* tuples = reinterpret_cast<const Tuple<T>*>(context.scanlines[y].data.data());
-        for (int i = 0; i < context.width; ++i) {
-            auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-            pixel.r = tuples[i].gray;
-            pixel.g = tuples[i].gray;
-            pixel.b = tuples[i].gray;
-            pixel.a = tuples[i].a;
-        }
+ALWAYS_INLINE static void unpack_grayscale_with_alpha(ReadonlyBytes scanline, RGBA32* pixels, int width)
+{
+    auto* tuples = reinterpret_cast<const Tuple<T>*>(scanline.data());
+    for (int i = 0; i < width; ++i) {
+        u8 gray = tuples[i].gray;
+        pixels[i] = Color(gray, gray, gray, tuples[i].a).value();
     }
 }
 
 template<typename T>
-ALWAYS_INLINE static void unpack_triplets_without_alpha(PNGLoadingContext& context)
-{
-    for (int y = 0; y < context.height; ++y) {
-        auto* triplets = reinterpret_cast<const Triplet<T>*>(context.scanlines[y].data.data());
-        for (int i = 0; i < context.width; ++i) {
-            auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-            pixel.r = triplets[i].r;
-            pixel.g = triplets[i].g;
-            pixel.b = triplets[i].b;
-            pixel.a = 0xff;
-        }
-    }
+ALWAYS_INLINE static void unpack_triplets_without_alpha(ReadonlyBytes scanline, RGBA32* pixels, int width)
+{
+    auto* triplets = reinterpret_cast<const Triplet<T>*>(scanline.data());
+    for (int i = 0; i < width; ++i)
+        pixels[i] = Color(triplets[i].r, triplets[i].g, triplets[i].b).value();
 }
 
-NEVER_INLINE FLATTEN static bool unfilter(PNGLoadingContext& context)
+template<typename T>
+ALWAYS_INLINE static void unpack_quads(ReadonlyBytes scanline, RGBA32* pixels, int width)
+{
+    auto* quads = reinterpret_cast<const Quad<T>*>(scanline.data());
+    for (int i = 0; i < width; ++i)
+        pixels[i] = Color(quads[i].r & 0xFF, quads[i].g & 0xFF, quads[i].b & 0xFF, quads[i].a & 0xFF).value();
+}
+
+// Converts one unfiltered scanline of `width` pixels to BGRA.
+NEVER_INLINE FLATTEN static bool unpack_scanline(PNGLoadingContext& context, ReadonlyBytes scanline, RGBA32* pixels, int width)
 {
-    // First unpack the scanlines to RGBA:
     switch (context.color_type) {
     case 0:
         if (context.bit_depth == 8) {
-            unpack_grayscale_without_alpha<u8>(context);
+            unpack_grayscale_without_alpha<u8>(scanline, pixels, width);
         } else if (context.bit_depth == 16) {
-            unpack_grayscale_without_alpha<u16>(context);
+            unpack_grayscale_without_alpha<u16>(scanline, pixels, width);
         } else if (context.bit_depth == 1 || context.bit_depth == 2 || context.bit_depth == 4) {
             auto bit_depth_squared = context.bit_depth * context.bit_depth;
             auto pixels_per_byte = 8 / context.bit_depth;
             auto mask = (1 << context.bit_depth) - 1;
-            for (int y = 0; y < context.height; ++y) {
-                auto* gray_values = context.scanlines[y].data.data();
-                for (int x = 0; x < context.width; ++x) {
-                    auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (x % pixels_per_byte));
-                    auto value = (gray_values[x / pixels_per_byte] >> bit_offset) & mask;
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[x];
-                    pixel.r = value * (0xff / bit_depth_squared);
-                    pixel.g = value * (0xff / bit_depth_squared);
-                    pixel.b = value * (0xff / bit_depth_squared);
-                    pixel.a = 0xff;
-                }
+            for (int x = 0; x < width; ++x) {
+                auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (x % pixels_per_byte));
+                auto value = (scanline[x / pixels_per_byte] >> bit_offset) & mask;
+                u8 gray = value * (0xff / bit_depth_squared);
+                pixels[x] = Color(gray, gray, gray).value();
             }
         } else {
             VERIFY_NOT_REACHED();
@@ -371,80 +439,57 @@ NEVER_INLINE FLATTEN static bool unfilter(PNGLoadingContext& context)
         break;
     case 4:
         if (context.bit_depth == 8) {
-            unpack_grayscale_with_alpha<u8>(context);
+            unpack_grayscale_with_alpha<u8>(scanline, pixels, width);
         } else if (context.bit_depth == 16) {
-            unpack_grayscale_with_alpha<u16>(context);
+            unpack_grayscale_with_alpha<u16>(scanline, pixels, width);
         } else {
             VERIFY_NOT_REACHED();
         }
         break;
     case 2:
         if (context.bit_depth == 8) {
-            unpack_triplets_without_alpha<u8>(context);
+            unpack_triplets_without_alpha<u8>(scanline, pixels, width);
         } else if (context.bit_depth == 16) {
-            unpack_triplets_without_alpha<u16>(context);
+            unpack_triplets_without_alpha<u16>(scanline, pixels, width);
         } else {
             VERIFY_NOT_REACHED();
         }
         break;
     case 6:
         if (context.bit_depth == 8) {
-            for (int y = 0; y < context.height; ++y) {
-                memcpy(context.bitmap->scanline(y), context.scanlines[y].data.data(), context.scanlines[y].data.size());
-            }
+            unpack_quads<u8>(scanline, pixels, width);
         } else if (context.bit_depth == 16) {
-            for (int y = 0; y < context.height; ++y) {
-                auto* triplets = reinterpret_cast<const Quad<u16>*>(context.scanlines[y].data.data());
-                for (int i = 0; i < context.width; ++i) {
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    pixel.r = triplets[i].r & 0xFF;
-                    pixel.g = triplets[i].g & 0xFF;
-                    pixel.b = triplets[i].b & 0xFF;
-                    pixel.a = triplets[i].a & 0xFF;
-                }
-            }
+            unpack_quads<u16>(scanline, pixels, width);
         } else {
             VERIFY_NOT_REACHED();
         }
         break;
     case 3:
         if (context.bit_depth == 8) {
-            for (int y = 0; y < context.height; ++y) {
-                auto* palette_index = context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    if (palette_index[i] >= context.palette_data.size())
-                        return false;
-                    auto& color = context.palette_data.at((int)palette_index[i]);
-                    auto transparency = context.palette_transparency_data.size() >= palette_index[i] + 1u
-                        ? context.palette_transparency_data.data()[palette_index[i]]
-                        : 0xff;
-                    pixel.r = color.r;
-                    pixel.g = color.g;
-                    pixel.b = color.b;
-                    pixel.a = transparency;
-                }
+            auto* palette_index = scanline.data();
+            for (int i = 0; i < width; ++i) {
+                if (palette_index[i] >= context.palette_data.size())
+                    return false;
+                auto& color = context.palette_data.at((int)palette_index[i]);
+                auto transparency = context.palette_transparency_data.size() >= palette_index[i] + 1u
+                    ? context.palette_transparency_data.data()[palette_index[i]]
+                    : 0xff;
+                pixels[i] = Color(color.r, color.g, color.b, transparency).value();
             }
         } else if (context.bit_depth == 1 || context.bit_depth == 2 || context.bit_depth == 4) {
             auto pixels_per_byte = 8 / context.bit_depth;
             auto mask = (1 << context.bit_depth) - 1;
-            for (int y = 0; y < context.height; ++y) {
-                auto* palette_indices = context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (i % pixels_per_byte));
-                    auto palette_index = (palette_indices[i / pixels_per_byte] >> bit_offset) & mask;
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    if ((size_t)palette_index >= context.palette_data.size())
-                        return false;
-                    auto& color = context.palette_data.at(palette_index);
-                    auto transparency = context.palette_transparency_data.size() >= palette_index + 1u
-                        ? context.palette_transparency_data.data()[palette_index]
-                        : 0xff;
-                    pixel.r = color.r;
-                    pixel.g = color.g;
-                    pixel.b = color.b;
-                    pixel.a = transparency;
-                }
+            auto* palette_indices = scanline.data();
+            for (int i = 0; i < width; ++i) {
+                auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (i % pixels_per_byte));
+                auto palette_index = (palette_indices[i / pixels_per_byte] >> bit_offset) & mask;
+                if ((size_t)palette_index >= context.palette_data.size())
+                    return false;
+                auto& color = context.palette_data.at(palette_index);
+                auto transparency = context.palette_transparency_data.size() >= palette_index + 1u
+                    ? context.palette_transparency_data.data()[palette_index]
+                    : 0xff;
+                pixels[i] = Color(color.r, color.g, color.b, transparency).value();
             }
         } else {
             VERIFY_NOT_REACHED();
@@ -455,48 +500,6 @@ NEVER_INLINE FLATTEN static bool unfilter(PNGLoadingContext& context)
         break;
     }
 
-    u8 dummy_scanline[context.width * sizeof(RGBA32)];
-    memset(dummy_scanline, 0, sizeof(dummy_scanline));
-
-    for (int y = 0; y < context.height; ++y) {
-        auto filter = context.scanlines[y].filter;
-        if (filter == 0) {
-            if (context.has_alpha())
-                unfilter_impl<true, 0>(*context.bitmap, y, dummy_scanline);
-            else
-                unfilter_impl<false, 0>(*context.bitmap, y, dummy_scanline);
-            continue;
-        }
-        if (filter == 1) {
-            if (context.has_alpha())
-                unfilter_impl<true, 1>(*context.bitmap, y, dummy_scanline);
-            else
-                unfilter_impl<false, 1>(*context.bitmap, y, dummy_scanline);
-            continue;
-        }
-        if (filter == 2) {
-            if (context.has_alpha())
-                unfilter_impl<true, 2>(*context.bitmap, y, dummy_scanline);
-            else
-                unfilter_impl<false, 2>(*context.bitmap, y, dummy_scanline);
-            continue;
-        }
-        if (filter == 3) {
-            if (context.has_alpha())
-                unfilter_impl<true, 3>(*context.bitmap, y, dummy_scanline);
-            else
-                unfilter_impl<false, 3>(*context.bitmap, y, dummy_scanline);
-            continue;
-        }
-        if (filter == 4) {
-            if (context.has_alpha())
-                unfilter_impl<true, 4>(*context.bitmap, y, dummy_scanline);
-            else
-                unfilter_impl<false, 4>(*context.bitmap, y, dummy_scanline);
-            continue;
-        }
-    }
-
     return true;
 }
 
@@ -562,8 +565,6 @@ static bool decode_png_chunks(PNGLoadingContext& context)
     const u8* data_ptr = context.data + sizeof(png_header);
     int data_remaining = context.data_size - sizeof(png_header);
 
-    context.compressed_data.ensure_capacity(context.data_size);
-
     Streamer streamer(data_ptr, data_remaining);
     while (!streamer.at_end()) {
         if (!process_chunk(streamer, context)) {
@@ -577,13 +578,22 @@ static bool decode_png_chunks(PNGLoadingContext& context)
     return true;
 }
 
-static bool decode_png_bitmap_simple(PNGLoadingContext& context)
+// Inflates a (sub)image one scanline at a time, straight out of the IDAT stream.
+// Since the filters only ever look at the scanline above, a two-row window is all we keep around.
+template<typename Callback>
+static bool decode_png_scanlines(PNGLoadingContext& context, InputStream& stream, int width, int height, Callback callback)
 {
-    Streamer streamer(context.decompression_buffer->data(), context.decompression_buffer->size());
+    auto row_size = context.compute_row_size_for_width(width);
+    if (row_size.has_overflow())
+        return false;
+
+    size_t bytes_per_pixel = max(1, context.channels * context.bit_depth / 8);
+    auto scanline = ByteBuffer::create_uninitialized(row_size.value());
+    auto previous_scanline = ByteBuffer::create_zeroed(row_size.value());
 
-    for (int y = 0; y < context.height; ++y) {
+    for (int y = 0; y < height; ++y) {
         u8 filter;
-        if (!streamer.read(filter)) {
+        if (!stream.read_or_error({ &filter, sizeof(filter) })) {
             context.state = PNGLoadingContext::State::Error;
             return false;
         }
@@ -594,18 +604,22 @@ static bool decode_png_bitmap_simple(PNGLoadingContext& context)
             return false;
         }
 
-        context.scanlines.append({ filter });
-        auto& scanline_buffer = context.scanlines.last().data;
-        auto row_size = context.compute_row_size_for_width(context.width);
-        if (row_size.has_overflow())
-            return false;
-
-        if (!streamer.wrap_bytes(scanline_buffer, row_size.value())) {
+        if (!stream.read_or_error(scanline.bytes())) {
             context.state = PNGLoadingContext::State::Error;
             return false;
         }
+
+        unfilter_scanline(filter, scanline.bytes(), previous_scanline.bytes(), bytes_per_pixel);
+        if (!callback(y, scanline.bytes()))
+            return false;
+
+        swap(scanline, previous_scanline);
     }
+    return true;
+}
 
+static bool decode_png_bitmap_simple(PNGLoadingContext& context, InputStream& stream)
+{
     context.bitmap = Bitmap::try_create(context.has_alpha() ? BitmapFormat::BGRA8888 : BitmapFormat::BGRx8888, { context.width, context.height });
 
     if (!context.bitmap) {
@@ -613,7 +627,9 @@ static bool decode_png_bitmap_simple(PNGLoadingContext& context)
         return false;
     }
 
-    return unfilter(context);
+    return decode_png_scanlines(context, stream, context.width, context.height, [&](int y, ReadonlyBytes scanline) {
+        return unpack_scanline(context, scanline, context.bitmap->scanline(y), context.width);
+    });
 }
 
 static int adam7_height(PNGLoadingContext& context, int pass)
@@ -666,72 +682,39 @@ static int adam7_startx[8] = { 0, 0, 4, 0, 2, 0, 1, 0 };
 static int adam7_stepy[8] = { 1, 8, 8, 8, 4, 4, 2, 2 };
 static int adam7_stepx[8] = { 1, 8, 8, 4, 4, 2, 2, 1 };
 
-static bool decode_adam7_pass(PNGLoadingContext& context, Streamer& streamer, int pass)
+static bool decode_adam7_pass(PNGLoadingContext& context, InputStream& stream, int pass)
 {
-    PNGLoadingContext subimage_context;
-    subimage_context.width = adam7_width(context, pass);
-    subimage_context.height = adam7_height(context, pass);
-    subimage_context.channels = context.channels;
-    subimage_context.color_type = context.color_type;
-    subimage_context.palette_data = context.palette_data;
-    subimage_context.palette_transparency_data = context.palette_transparency_data;
-    subimage_context.bit_depth = context.bit_depth;
-    subimage_context.filter_method = context.filter_method;
+    auto width = adam7_width(context, pass);
+    auto height = adam7_height(context, pass);
 
     // For small images, some passes might be empty
-    if (!subimage_context.width || !subimage_context.height)
+    if (!width || !height)
         return true;
 
-    subimage_context.scanlines.clear_with_capacity();
-    for (int y = 0; y < subimage_context.height; ++y) {
-        u8 filter;
-        if (!streamer.read(filter)) {
-            context.state = PNGLoadingContext::State::Error;
+    // Unpack each subimage scanline into a single row and scatter it into the main image according to the pass pattern.
+    Vector<RGBA32> pixels;
+    pixels.resize(width);
+    return decode_png_scanlines(context, stream, width, height, [&](int y, ReadonlyBytes scanline) {
+        if (!unpack_scanline(context, scanline, pixels.data(), width))
             return false;
-        }
-
-        if (filter > 4) {
-            dbgln_if(PNG_DEBUG, "Invalid PNG filter: {}", filter);
-            context.state = PNGLoadingContext::State::Error;
-            return false;
-        }
-
-        subimage_context.scanlines.append({ filter });
-        auto& scanline_buffer = subimage_context.scanlines.last().data;
-
-        auto row_size = context.compute_row_size_for_width(subimage_context.width);
-        if (row_size.has_overflow())
-            return false;
-        if (!streamer.wrap_bytes(scanline_buffer, row_size.value())) {
-            context.state = PNGLoadingContext::State::Error;
-            return false;
-        }
-    }
-
-    subimage_context.bitmap = Bitmap::try_create(context.bitmap->format(), { subimage_context.width, subimage_context.height });
-    if (!unfilter(subimage_context)) {
-        subimage_context.bitmap = nullptr;
-        return false;
-    }
-
-    // Copy the subimage data into the main image according to the pass pattern
-    for (int y = 0, dy = adam7_starty[pass]; y < subimage_context.height && dy < context.height; ++y, dy += adam7_stepy[pass]) {
-        for (int x = 0, dx = adam7_startx[pass]; x < subimage_context.width && dy < context.width; ++x, dx += adam7_stepx[pass]) {
-            context.bitmap->set_pixel(dx, dy, subimage_context.bitmap->get_pixel(x, y));
-        }
-    }
-    return true;
+        int dy = adam7_starty[pass] + y * adam7_stepy[pass];
+        if (dy >= context.height)
+            return true;
+        auto* destination = context.bitmap->scanline(dy);
+        for (int x = 0, dx = adam7_startx[pass]; x < width && dx < context.width; ++x, dx += adam7_stepx[pass])
+            destination[dx] = pixels[x];
+        return true;
+    });
 }
 
-static bool decode_png_adam7(PNGLoadingContext& context)
+static bool decode_png_adam7(PNGLoadingContext& context, InputStream& stream)
 {
-    Streamer streamer(context.decompression_buffer->data(), context.decompression_buffer->size());
     context.bitmap = Bitmap::try_create(context.has_alpha() ? BitmapFormat::BGRA8888 : BitmapFormat::BGRx8888, { context.width, context.height });
     if (!context.bitmap)
         return false;
 
     for (int pass = 1; pass <= 7; ++pass) {
-        if (!decode_adam7_pass(context, streamer, pass))
+        if (!decode_adam7_pass(context, stream, pass))
             return false;
     }
     return true;
@@ -753,31 +736,37 @@ static bool decode_png_bitmap(PNGLoadingContext& context)
     if (context.color_type == 3 && context.palette_data.is_empty())
         return false; // Didn't see a PLTE chunk for a palettized image, or it was empty.
 
-    auto result = Compress::Zlib::decompress_all(context.compressed_data.span());
-    if (!result.has_value()) {
+    IDATInputStream idat_stream { context.idat_chunks };
+
+    u8 zlib_header[2];
+    if (!idat_stream.read_or_error({ zlib_header, sizeof(zlib_header) }) || !Compress::Zlib::is_valid_header(zlib_header[0], zlib_header[1])) {
+        idat_stream.handle_any_error();
         context.state = PNGLoadingContext::State::Error;
         return false;
     }
-    context.decompression_buffer = &result.value();
-    context.compressed_data.clear();
 
-    context.scanlines.ensure_capacity(context.height);
+    Compress::DeflateDecompressor deflate_stream { idat_stream };
+
+    bool success = false;
     switch (context.interlace_method) {
     case PngInterlaceMethod::Null:
-        if (!decode_png_bitmap_simple(context))
-            return false;
+        success = decode_png_bitmap_simple(context, deflate_stream);
         break;
     case PngInterlaceMethod::Adam7:
-        if (!decode_png_adam7(context))
-            return false;
+        success = decode_png_adam7(context, deflate_stream);
         break;
     default:
+        break;
+    }
+
+    deflate_stream.handle_any_error();
+    context.idat_chunks.clear();
+
+    if (!success) {
         context.state = PNGLoadingContext::State::Error;
         return false;
     }
 
-    context.decompression_buffer = nullptr;
-
     context.state = PNGLoadingContext::State::BitmapDecoded;
     return true;
 }
@@ -881,7 +870,8 @@ static bool process_IHDR(ReadonlyBytes data, PNGLoadingContext& context)
 
 static bool process_IDAT(ReadonlyBytes data, PNGLoadingContext& context)
 {
-    context.compressed_data.append(data.data(), data.size());
+    if (!data.is_empty())
+        context.idat_chunks.append(data);
     return true;
 }
 
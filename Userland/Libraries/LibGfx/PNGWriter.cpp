@@ -48,19 +48,20 @@ private:
 
 class NonCompressibleBlock {
 public:
-    void finalize(PNGChunk&);
-    void add_byte_to_block(u8 data, PNGChunk&);
+    static constexpr size_t max_block_size = 65535;
 
-    u32 adler_s1() const { return m_adler_s1; }
-    u32 adler_s2() const { return m_adler_s2; }
+    // Returns how many bytes were taken; the caller has to flush once the block is full.
+    size_t add_bytes_to_block(ReadonlyBytes);
+    void add_block_to_chunk(PNGChunk&, bool last);
+
+    bool full() const { return m_non_compressible_data.size() == max_block_size; }
+    u32 adler32() const { return (m_adler_s2 << 16) | m_adler_s1; }
 
 private:
-    void add_block_to_chunk(PNGChunk&, bool);
-    void update_adler(u8);
-    bool full() { return m_non_compressible_data.size() == 65535; }
+    void update_adler(ReadonlyBytes);
     Vector<u8> m_non_compressible_data;
-    u16 m_adler_s1 { 1 };
-    u16 m_adler_s2 { 0 };
+    u32 m_adler_s1 { 1 };
+    u32 m_adler_s2 { 0 };
 };
 
 PNGChunk::PNGChunk(String type)
@@ -120,14 +121,13 @@ void PNGChunk::add_u8(u8 data)
     add(data);
 }
 
-void NonCompressibleBlock::add_byte_to_block(u8 data, PNGChunk& chunk)
+size_t NonCompressibleBlock::add_bytes_to_block(ReadonlyBytes data)
 {
-    m_non_compressible_data.append(data);
-    update_adler(data);
-    if (full()) {
-        add_block_to_chunk(chunk, false);
-        m_non_compressible_data.clear_with_capacity();
-    }
+    auto count = min(data.size(), max_block_size - m_non_compressible_data.size());
+    auto bytes = data.trim(count);
+    m_non_compressible_data.append(bytes.data(), bytes.size());
+    update_adler(bytes);
+    return count;
 }
 
 void NonCompressibleBlock::add_block_to_chunk(PNGChunk& png_chunk, bool last)
@@ -141,17 +141,23 @@ void NonCompressibleBlock::add_block_to_chunk(PNGChunk& png_chunk, bool last)
     png_chunk.add_as_little_endian(nlen);
 
     png_chunk.add(m_non_compressible_data.data(), m_non_compressible_data.size());
+    m_non_compressible_data.clear_with_capacity();
 }
 
-void NonCompressibleBlock::finalize(PNGChunk& chunk)
-{
-    add_block_to_chunk(chunk, true);
-}
-
-void NonCompressibleBlock::update_adler(u8 data)
+void NonCompressibleBlock::update_adler(ReadonlyBytes data)
 {
-    m_adler_s1 = (m_adler_s1 + data) % 65521;
-    m_adler_s2 = (m_adler_s2 + m_adler_s1) % 65521;
+    // 5552 is the largest n such that 255n(n+1)/2 + (n+1)(65521-1) still fits in 32 bits,
+    // so we only need to reduce once per run of that many bytes.
+    while (!data.is_empty()) {
+        auto run = data.trim(5552);
+        for (auto byte : run) {
+            m_adler_s1 += byte;
+            m_adler_s2 += m_adler_s1;
+        }
+        m_adler_s1 %= 65521;
+        m_adler_s2 %= 65521;
+        data = data.slice(run.size());
+    }
 }
 
 void PNGWriter::add_chunk(PNGChunk& png_chunk)
@@ -187,31 +193,45 @@ void PNGWriter::add_IEND_chunk()
     add_chunk(png_chunk);
 }
 
-void PNGWriter::add_IDAT_chunk(Gfx::Bitmap const& bitmap)
+void PNGWriter::add_IDAT_chunks(Gfx::Bitmap const& bitmap)
 {
+    // Every stored block goes out in its own IDAT chunk as soon as it is full,
+    // so apart from the encoded output only one block and one scanline are ever buffered.
     PNGChunk png_chunk { "IDAT" };
-    png_chunk.reserve(bitmap.size_in_bytes());
 
     u16 CMF_FLG = 0x81d;
     png_chunk.add_as_big_endian(CMF_FLG);
 
     NonCompressibleBlock non_compressible_block;
+    auto add_bytes = [&](ReadonlyBytes bytes) {
+        while (!bytes.is_empty()) {
+            bytes = bytes.slice(non_compressible_block.add_bytes_to_block(bytes));
+            if (non_compressible_block.full()) {
+                non_compressible_block.add_block_to_chunk(png_chunk, false);
+                add_chunk(png_chunk);
+                png_chunk = PNGChunk { "IDAT" };
+            }
+        }
+    };
+
+    Vector<u8> scanline;
+    scanline.resize(1 + bitmap.width() * 4);
 
     for (int y = 0; y < bitmap.height(); ++y) {
-        non_compressible_block.add_byte_to_block(0, png_chunk);
+        scanline[0] = 0; // Filter type: None
 
         for (int x = 0; x < bitmap.width(); ++x) {
             auto pixel = bitmap.get_pixel(x, y);
-            non_compressible_block.add_byte_to_block(pixel.red(), png_chunk);
-            non_compressible_block.add_byte_to_block(pixel.green(), png_chunk);
-            non_compressible_block.add_byte_to_block(pixel.blue(), png_chunk);
-            non_compressible_block.add_byte_to_block(pixel.alpha(), png_chunk);
+            scanline[1 + x * 4 + 0] = pixel.red();
+            scanline[1 + x * 4 + 1] = pixel.green();
+            scanline[1 + x * 4 + 2] = pixel.blue();
+            scanline[1 + x * 4 + 3] = pixel.alpha();
         }
+        add_bytes(scanline.span());
     }
-    non_compressible_block.finalize(png_chunk);
+    non_compressible_block.add_block_to_chunk(png_chunk, true);
 
-    png_chunk.add_as_big_endian(non_compressible_block.adler_s2());
-    png_chunk.add_as_big_endian(non_compressible_block.adler_s1());
+    png_chunk.add_as_big_endian(non_compressible_block.adler32());
 
     add_chunk(png_chunk);
 }
@@ -221,9 +241,9 @@ ByteBuffer PNGWriter::encode(Gfx::Bitmap const& bitmap)
     PNGWriter writer;
     writer.add_png_header();
     writer.add_IHDR_chunk(bitmap.width(), bitmap.height(), 8, 6, 0, 0, 0);
-    writer.add_IDAT_chunk(bitmap);
+    writer.add_IDAT_chunks(bitmap);
     writer.add_IEND_chunk();
-    return ByteBuffer::copy(writer.m_data);
+    return move(writer.m_data);
 }
 
 }
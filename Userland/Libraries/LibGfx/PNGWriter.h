@@ -7,7 +7,7 @@
 
 #pragma once
 
-#include <AK/Vector.h>
+#include <AK/ByteBuffer.h>
 #include <LibGfx/Forward.h>
 
 namespace Gfx {
@@ -21,11 +21,11 @@ public:
 private:
     PNGWriter() { }
 
-    Vector<u8> m_data;
+    ByteBuffer m_data;
     void add_chunk(PNGChunk&);
     void add_png_header();
     void add_IHDR_chunk(u32 width, u32 height, u8 bit_depth, u8 color_type, u8 compression_method, u8 filter_method, u8 interlace_method);
-    void add_IDAT_chunk(Gfx::Bitmap const&);
+    void add_IDAT_chunks(Gfx::Bitmap const&);
     void add_IEND_chunk();
 };
 
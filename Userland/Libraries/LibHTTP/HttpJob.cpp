@@ -15,6 +15,13 @@ namespace HTTP {
 void HttpJob::start()
 {
     VERIFY(!m_socket);
+    if (m_socket_to_reuse) {
+        m_socket = move(m_socket_to_reuse);
+        add_child(*m_socket);
+        m_connection_was_reused = true;
+        on_socket_connected();
+        return;
+    }
     m_socket = Core::TCPSocket::construct(this);
     m_socket->on_connected = [this] {
         dbgln_if(CHTTPJOB_DEBUG, "HttpJob: on_connected callback");
@@ -32,10 +39,35 @@ void HttpJob::shutdown()
 {
     if (!m_socket)
         return;
+    bool reusable = can_reuse_connection();
+    auto socket = detach_socket();
+    if (auto on_released = move(on_connection_released))
+        on_released(reusable ? move(socket) : nullptr);
+}
+
+RefPtr<Core::Socket> HttpJob::detach_socket()
+{
     m_socket->on_ready_to_read = nullptr;
     m_socket->on_connected = nullptr;
     remove_child(*m_socket);
-    m_socket = nullptr;
+    return move(m_socket);
+}
+
+void HttpJob::retry_on_new_connection()
+{
+    dbgln_if(CHTTPJOB_DEBUG, "HttpJob: Reused connection was closed, retrying on a new one");
+    detach_socket();
+    reset_for_retry();
+    start();
+}
+
+void HttpJob::read_while_data_available(Function<IterationDecision()> read)
+{
+    // The socket only tells us about new data, not about what's still buffered from the last read.
+    while (m_socket && m_socket->can_read()) {
+        if (read() == IterationDecision::Break)
+            break;
+    }
 }
 
 void HttpJob::register_on_ready_to_read(Function<void()> callback)
@@ -30,6 +30,13 @@ public:
     virtual void start() override;
     virtual void shutdown() override;
 
+    // Sends the request over a connection that an earlier job to the same server left open, instead of connecting again.
+    void set_socket_to_reuse(NonnullRefPtr<Core::Socket> socket) { m_socket_to_reuse = move(socket); }
+
+    // Called once when the job is done with its connection. The socket is only passed along
+    // if the response was read completely and the server lets us send another request over it.
+    Function<void(RefPtr<Core::Socket>)> on_connection_released;
+
 protected:
     virtual bool should_fail_on_empty_payload() const override { return false; }
     virtual void register_on_ready_to_read(Function<void()>) override;
@@ -41,9 +48,14 @@ protected:
     virtual bool eof() const override;
     virtual bool write(ReadonlyBytes) override;
     virtual bool is_established() const override { return true; }
+    virtual void read_while_data_available(Function<IterationDecision()>) override;
+    virtual void retry_on_new_connection() override;
 
 private:
+    RefPtr<Core::Socket> detach_socket();
+
     RefPtr<Core::Socket> m_socket;
+    RefPtr<Core::Socket> m_socket_to_reuse;
 };
 
 }
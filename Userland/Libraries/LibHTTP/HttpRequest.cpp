@@ -55,7 +55,9 @@ ByteBuffer HttpRequest::to_raw_request() const
         builder.append(header.value);
         builder.append("\r\n");
     }
-    builder.append("Connection: close\r\n");
+    // HTTP/1.1 connections are persistent by default, this is for the benefit of HTTP/1.0 servers.
+    // Whoever runs the job decides whether the connection actually gets reused afterwards.
+    builder.append("Connection: keep-alive\r\n");
     if (!m_body.is_empty()) {
         builder.appendff("Content-Length: {}\r\n\r\n", m_body.size());
         builder.append((char const*)m_body.data(), m_body.size());
@@ -17,14 +17,37 @@ namespace HTTP {
 void HttpsJob::start()
 {
     VERIFY(!m_socket);
+    if (m_socket_to_reuse) {
+        m_socket = move(m_socket_to_reuse);
+        add_child(*m_socket);
+        m_connection_was_reused = true;
+        install_socket_callbacks();
+        on_socket_connected();
+        return;
+    }
     m_socket = TLS::TLSv12::construct(this);
     m_socket->set_root_certificates(m_override_ca_certificates ? *m_override_ca_certificates : DefaultRootCACertificates::the().certificates());
     m_socket->on_tls_connected = [this] {
         dbgln_if(HTTPSJOB_DEBUG, "HttpsJob: on_connected callback");
         on_socket_connected();
     };
+    install_socket_callbacks();
+    if (m_tls_session_to_resume.has_value())
+        m_socket->set_session_to_resume(m_tls_session_to_resume.release_value());
+    bool success = ((TLS::TLSv12&)*m_socket).connect(m_request.url().host(), m_request.url().port());
+    if (!success) {
+        deferred_invoke([this](auto&) {
+            return did_fail(Core::NetworkJob::Error::ConnectionFailed);
+        });
+    }
+}
+
+void HttpsJob::install_socket_callbacks()
+{
     m_socket->on_tls_error = [&](TLS::AlertDescription error) {
-        if (error == TLS::AlertDescription::HandshakeFailure) {
+        if (m_connection_was_reused && m_state == State::InStatus) {
+            deferred_invoke([this](auto&) { retry_on_new_connection(); });
+        } else if (error == TLS::AlertDescription::HandshakeFailure) {
             deferred_invoke([this](auto&) {
                 return did_fail(Core::NetworkJob::Error::ProtocolFailed);
             });
@@ -39,29 +62,51 @@ void HttpsJob::start()
         }
     };
     m_socket->on_tls_finished = [this] {
-        if (!m_has_scheduled_finish)
+        // Servers close idle connections whenever they like, so a reused one may already be gone.
+        if (m_connection_was_reused && m_state == State::InStatus)
+            deferred_invoke([this](auto&) { retry_on_new_connection(); });
+        else if (!m_has_scheduled_finish)
             finish_up();
     };
     m_socket->on_tls_certificate_request = [this](auto&) {
         if (on_certificate_requested)
             on_certificate_requested(*this);
     };
-    bool success = ((TLS::TLSv12&)*m_socket).connect(m_request.url().host(), m_request.url().port());
-    if (!success) {
-        deferred_invoke([this](auto&) {
-            return did_fail(Core::NetworkJob::Error::ConnectionFailed);
-        });
-    }
+    m_socket->on_tls_session_established = [this](auto& session) {
+        if (on_tls_session_established)
+            on_tls_session_established(session);
+    };
 }
 
 void HttpsJob::shutdown()
 {
     if (!m_socket)
         return;
+    bool reusable = can_reuse_connection();
+    auto socket = detach_socket();
+    if (auto on_released = move(on_connection_released))
+        on_released(reusable ? move(socket) : nullptr);
+}
+
+RefPtr<TLS::TLSv12> HttpsJob::detach_socket()
+{
     m_socket->on_tls_ready_to_read = nullptr;
+    m_socket->on_tls_ready_to_write = nullptr;
     m_socket->on_tls_connected = nullptr;
+    m_socket->on_tls_error = nullptr;
+    m_socket->on_tls_finished = nullptr;
+    m_socket->on_tls_certificate_request = nullptr;
+    m_socket->on_tls_session_established = nullptr;
     remove_child(*m_socket);
-    m_socket = nullptr;
+    return move(m_socket);
+}
+
+void HttpsJob::retry_on_new_connection()
+{
+    dbgln_if(HTTPSJOB_DEBUG, "HttpsJob: Reused connection was closed, retrying on a new one");
+    detach_socket();
+    reset_for_retry();
+    start();
 }
 
 void HttpsJob::set_certificate(String certificate, String private_key)
@@ -90,6 +135,11 @@ void HttpsJob::register_on_ready_to_read(Function<void()> callback)
 
 void HttpsJob::register_on_ready_to_write(Function<void()> callback)
 {
+    if (m_connection_was_reused) {
+        // There is no need to wait, the connection is already established
+        callback();
+        return;
+    }
     m_socket->on_tls_ready_to_write = [callback = move(callback)](auto&) {
         callback();
     };
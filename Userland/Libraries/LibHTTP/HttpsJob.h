@@ -31,8 +31,15 @@ public:
     virtual void start() override;
     virtual void shutdown() override;
     void set_certificate(String certificate, String key);
+    void set_tls_session_to_resume(TLS::Session session) { m_tls_session_to_resume = move(session); }
+    // Sends the request over a connection that an earlier job to the same server left open, instead of connecting again.
+    void set_socket_to_reuse(NonnullRefPtr<TLS::TLSv12> socket) { m_socket_to_reuse = move(socket); }
 
     Function<void(HttpsJob&)> on_certificate_requested;
+    Function<void(const TLS::Session&)> on_tls_session_established;
+    // Called once when the job is done with its connection. The socket is only passed along
+    // if the response was read completely and the server lets us send another request over it.
+    Function<void(RefPtr<TLS::TLSv12>)> on_connection_released;
 
 protected:
     virtual void register_on_ready_to_read(Function<void()>) override;
@@ -46,10 +53,16 @@ protected:
     virtual bool is_established() const override { return m_socket->is_established(); }
     virtual bool should_fail_on_empty_payload() const override { return false; }
     virtual void read_while_data_available(Function<IterationDecision()>) override;
+    virtual void retry_on_new_connection() override;
 
 private:
+    void install_socket_callbacks();
+    RefPtr<TLS::TLSv12> detach_socket();
+
     RefPtr<TLS::TLSv12> m_socket;
+    RefPtr<TLS::TLSv12> m_socket_to_reuse;
     const Vector<Certificate>* m_override_ca_certificates { nullptr };
+    Optional<TLS::Session> m_tls_session_to_resume;
 };
 
 }
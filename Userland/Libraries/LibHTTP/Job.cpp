@@ -117,8 +117,12 @@ void Job::on_socket_connected()
         }
 
         bool success = write(raw_request);
-        if (!success)
-            deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::TransmissionFailed); });
+        if (!success) {
+            if (m_connection_was_reused)
+                deferred_invoke([this](auto&) { retry_on_new_connection(); });
+            else
+                deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::TransmissionFailed); });
+        }
     });
     register_on_ready_to_read([&] {
         if (is_cancelled())
@@ -132,8 +136,16 @@ void Job::on_socket_connected()
         }
 
         if (m_state == State::InStatus) {
-            if (!can_read_line())
+            if (!can_read_line()) {
+                if (eof()) {
+                    // Servers close idle connections whenever they like, so a reused one may already be gone.
+                    if (m_connection_was_reused)
+                        return deferred_invoke([this](auto&) { retry_on_new_connection(); });
+                    warnln("Job: Connection closed before the HTTP status");
+                    return deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::TransmissionFailed); });
+                }
                 return;
+            }
             auto line = read_line(PAGE_SIZE);
             if (line.is_null()) {
                 warnln("Job: Expected HTTP status");
@@ -150,10 +162,12 @@ void Job::on_socket_connected()
                 return deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::ProtocolFailed); });
             }
             m_code = code.value();
+            // HTTP/1.1 connections are persistent unless the server says otherwise, see https://tools.ietf.org/html/rfc7230#section-6.3
+            m_server_allows_keep_alive = parts[0] == "HTTP/1.1";
             m_state = State::InHeaders;
-            return;
         }
-        if (m_state == State::InHeaders || m_state == State::Trailers) {
+        // The whole response head usually arrives at once, so don't wait for the socket to become readable again between lines.
+        while (m_state == State::InHeaders || m_state == State::Trailers) {
             if (!can_read_line())
                 return;
             auto line = read_line(PAGE_SIZE);
@@ -169,13 +183,24 @@ void Job::on_socket_connected()
             }
             if (line.is_empty()) {
                 if (m_state == State::Trailers) {
+                    m_response_was_delimited = true;
                     return finish_up();
                 } else {
                     if (on_headers_received)
                         on_headers_received(m_headers, m_code > 0 ? m_code : Optional<u32> {});
                     m_state = State::InBody;
+                    if (auto connection = m_headers.get("Connection"); connection.has_value()) {
+                        if (connection->contains("close", CaseSensitivity::CaseInsensitive))
+                            m_server_allows_keep_alive = false;
+                        else if (connection->contains("keep-alive", CaseSensitivity::CaseInsensitive))
+                            m_server_allows_keep_alive = true;
+                    }
+                    if (!response_has_body()) {
+                        m_response_was_delimited = true;
+                        return finish_up();
+                    }
                 }
-                return;
+                break;
             }
             auto parts = line.split_view(':');
             if (parts.is_empty()) {
@@ -207,10 +232,10 @@ void Job::on_socket_connected()
                 m_can_stream_response = false;
             }
             dbgln_if(JOB_DEBUG, "Job: [{}] = '{}'", name, value);
-            return;
         }
         VERIFY(m_state == State::InBody);
-        VERIFY(can_read());
+        if (!can_read())
+            return;
 
         read_while_data_available([&] {
             auto read_size = 64 * KiB;
@@ -219,6 +244,10 @@ void Job::on_socket_connected()
                 auto remaining = m_current_chunk_remaining_size.value();
                 if (remaining == -1) {
                     // read size
+                    if (!can_read_line()) {
+                        // Wait for the rest of the line.
+                        return IterationDecision::Break;
+                    }
                     auto size_data = read_line(PAGE_SIZE);
                     if (m_should_read_chunk_ending_line) {
                         VERIFY(size_data.is_empty());
@@ -279,6 +308,11 @@ void Job::on_socket_connected()
                 }
             }
 
+            auto content_length = this->content_length();
+            // Don't read into whatever comes after the body, if the connection is going to be reused.
+            if (content_length.has_value() && !m_current_chunk_remaining_size.has_value() && content_length.value() > m_received_size)
+                read_size = min<size_t>(read_size, content_length.value() - m_received_size);
+
             auto payload = receive(read_size);
             if (payload.is_empty()) {
                 if (eof()) {
@@ -321,21 +355,13 @@ void Job::on_socket_connected()
                 m_current_chunk_remaining_size = size;
             }
 
-            auto content_length_header = m_headers.get("Content-Length");
-            Optional<u32> content_length {};
-
-            if (content_length_header.has_value()) {
-                auto length = content_length_header.value().to_uint();
-                if (length.has_value())
-                    content_length = length.value();
-            }
-
             deferred_invoke([this, content_length](auto&) { did_progress(content_length, m_received_size); });
 
             if (content_length.has_value()) {
                 auto length = content_length.value();
                 if (m_received_size >= length) {
                     m_received_size = length;
+                    m_response_was_delimited = !m_current_chunk_remaining_size.has_value();
                     finish_up();
                     return IterationDecision::Break;
                 }
@@ -343,13 +369,61 @@ void Job::on_socket_connected()
             return IterationDecision::Continue;
         });
 
-        if (!is_established()) {
+        // The terminating chunk usually arrives together with the end of the trailers,
+        // and nothing else is going to make the socket readable again on a persistent connection.
+        while (m_state == State::Trailers && can_read_line()) {
+            auto line = read_line(PAGE_SIZE);
+            if (line.is_empty()) {
+                m_response_was_delimited = !line.is_null();
+                return finish_up();
+            }
+            dbgln_if(JOB_DEBUG, "Job: Ignoring trailer '{}'", line);
+        }
+
+        if (!is_established() && !m_has_scheduled_finish) {
             dbgln_if(JOB_DEBUG, "Connection appears to have closed, finishing up");
             finish_up();
         }
     });
 }
 
+void Job::reset_for_retry()
+{
+    // Nothing has been received at this point, so there's no response state to throw away.
+    VERIFY(m_state == State::InStatus);
+    m_sent_data = false;
+    m_connection_was_reused = false;
+}
+
+Optional<u32> Job::content_length() const
+{
+    auto content_length_header = m_headers.get("Content-Length");
+    if (!content_length_header.has_value())
+        return {};
+    return content_length_header.value().to_uint();
+}
+
+bool Job::response_has_body() const
+{
+    // https://tools.ietf.org/html/rfc7230#section-3.3.3
+    if (m_request.method() == HttpRequest::Method::HEAD)
+        return false;
+    if ((m_code >= 100 && m_code < 200) || m_code == 204 || m_code == 304)
+        return false;
+    if (m_headers.contains("Transfer-Encoding"))
+        return true;
+    auto content_length = this->content_length();
+    return !content_length.has_value() || content_length.value() != 0;
+}
+
+bool Job::can_reuse_connection() const
+{
+    if (m_state != State::Finished || !m_response_was_delimited || !m_server_allows_keep_alive)
+        return false;
+    // Anything left over at this point means the server doesn't agree with us on where the response ended.
+    return is_established() && !eof() && !can_read();
+}
+
 void Job::timer_event(Core::TimerEvent& event)
 {
     event.accept();
@@ -27,6 +27,9 @@ public:
     HttpResponse* response() { return static_cast<HttpResponse*>(Core::NetworkJob::response()); }
     const HttpResponse* response() const { return static_cast<const HttpResponse*>(Core::NetworkJob::response()); }
 
+    // Whether another request can be sent over this job's connection now that it has finished.
+    bool can_reuse_connection() const;
+
 protected:
     void finish_up();
     void on_socket_connected();
@@ -43,6 +46,12 @@ protected:
     virtual bool should_fail_on_empty_payload() const { return true; }
     virtual void read_while_data_available(Function<IterationDecision()> read) { read(); };
     virtual void timer_event(Core::TimerEvent&) override;
+    // Sends the request again over a new connection, after the server closed a reused one without responding.
+    virtual void retry_on_new_connection() = 0;
+    void reset_for_retry();
+
+    Optional<u32> content_length() const;
+    bool response_has_body() const;
 
     enum class State {
         InStatus,
@@ -65,6 +74,10 @@ protected:
     bool m_can_stream_response { true };
     bool m_should_read_chunk_ending_line { false };
     bool m_has_scheduled_finish { false };
+    bool m_connection_was_reused { false };
+    bool m_server_allows_keep_alive { false };
+    // Whether we know where the response ended without the server having to close the connection.
+    bool m_response_was_delimited { false };
 };
 
 }
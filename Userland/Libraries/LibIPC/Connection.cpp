@@ -0,0 +1,650 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/HashTable.h>
+#include <AK/TemporaryChange.h>
+#include <LibIPC/Connection.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace IPC {
+
+static constexpr size_t control_frame_size = 3 * sizeof(u32);
+static constexpr int max_iovecs_per_write = 64;
+
+// Messages are only written out at the end of an event loop turn, so a program that posts something
+// and exits right away would lose it. Flush everything that's still queued up when that happens.
+static HashTable<ConnectionBase*>& all_connections()
+{
+    // Leaked on purpose, connections held by other static objects may be destroyed after this would be.
+    static auto* s_connections = new HashTable<ConnectionBase*>;
+    return *s_connections;
+}
+
+static pid_t s_pid_that_registered_exit_handler { -1 };
+
+static void flush_all_connections_at_exit()
+{
+    // Children that exit() after a fork() must not send their parent's messages a second time.
+    if (getpid() != s_pid_that_registered_exit_handler)
+        return;
+    for (auto* connection : all_connections())
+        connection->flush_outgoing_messages();
+}
+
+ConnectionBase::ConnectionBase(Stub& local_stub, NonnullRefPtr<Core::LocalSocket> socket)
+    : m_local_stub(local_stub)
+    , m_socket(move(socket))
+    , m_notifier(Core::Notifier::construct(m_socket->fd(), Core::Notifier::Read, this))
+{
+    m_responsiveness_timer = Core::Timer::create_single_shot(3000, [this] { may_have_become_unresponsive(); });
+    m_notifier->on_ready_to_read = [this] {
+        NonnullRefPtr protect = *this;
+        drain_messages_from_peer();
+        handle_messages();
+    };
+
+    register_property("messages_sent", [this] { return m_statistics.messages_sent; });
+    register_property("messages_received", [this] { return m_statistics.messages_received; });
+    register_property("batches_sent", [this] { return m_statistics.batches_sent; });
+    register_property("send_syscalls", [this] { return m_statistics.send_syscalls; });
+    register_property("receive_syscalls", [this] { return m_statistics.receive_syscalls; });
+    register_property("back_pressure_events", [this] { return m_statistics.back_pressure_events; });
+    register_property("queued_bytes", [this] { return m_outgoing_size; });
+    register_property("shared_memory", [this] { return m_shared_memory_accepted; });
+
+    if (s_pid_that_registered_exit_handler != getpid()) {
+        s_pid_that_registered_exit_handler = getpid();
+        atexit(flush_all_connections_at_exit);
+    }
+    all_connections().set(this);
+}
+
+ConnectionBase::~ConnectionBase()
+{
+    all_connections().remove(this);
+    m_destroying = true;
+    // Clients can't have anything left over after this, since they wait for the server to catch up.
+    if (m_socket->is_open() && m_waits_for_peer_to_catch_up)
+        flush_outgoing_messages();
+}
+
+void ConnectionBase::post_message(const Message& message)
+{
+    post_message(message.encode());
+}
+
+void ConnectionBase::post_message(MessageBuffer buffer)
+{
+    // NOTE: If this connection is being shut down, but has not yet been destroyed,
+    //       the socket will be closed. Don't try to send more messages.
+    if (!m_socket->is_open())
+        return;
+
+    // Prepend the message size.
+    uint32_t message_size = buffer.data.size();
+    buffer.data.prepend(reinterpret_cast<const u8*>(&message_size), sizeof(message_size));
+
+#ifdef __serenity__
+    for (auto& fd : buffer.fds) {
+        ++m_statistics.send_syscalls;
+        auto rc = sendfd(m_socket->fd(), fd->value());
+        if (rc < 0) {
+            perror("sendfd");
+            shutdown();
+        }
+    }
+#else
+    if (!buffer.fds.is_empty())
+        warnln("fd passing is not supported on this platform, sorry :(");
+#endif
+
+    ++m_statistics.messages_sent;
+    ReadonlyBytes bytes = buffer.data.span();
+    if (m_shared_memory_accepted && !has_outgoing_bytes()) {
+        // Writing into the ring doesn't take a syscall, so only the doorbell has to wait for the end of the batch.
+        bytes = bytes.slice(m_shared_memory->write(bytes));
+        schedule_flush();
+    }
+    if (!bytes.is_empty())
+        enqueue(bytes, !m_shared_memory_accepted);
+
+    if (m_outgoing_size >= m_outgoing_high_water_mark) {
+        ++m_statistics.back_pressure_events;
+        if (!flush_outgoing_messages())
+            return;
+    }
+
+    m_responsiveness_timer->start();
+}
+
+void ConnectionBase::enqueue(ReadonlyBytes bytes, bool over_socket)
+{
+    m_outgoing_bytes.append({ ByteBuffer::copy(bytes), 0, over_socket });
+    m_outgoing_size += bytes.size();
+    schedule_flush();
+}
+
+void ConnectionBase::schedule_flush()
+{
+    if (m_flush_scheduled)
+        return;
+    m_flush_scheduled = true;
+    deferred_invoke([this](auto&) {
+        m_flush_scheduled = false;
+        flush_outgoing_messages();
+    });
+}
+
+void ConnectionBase::enqueue_control_frame(ControlFrame kind, u32 argument)
+{
+    u32 control_frame[3] { 0, static_cast<u32>(kind), argument };
+    enqueue({ control_frame, sizeof(control_frame) }, true);
+}
+
+bool ConnectionBase::has_pending_socket_bytes() const
+{
+    for (size_t i = m_first_outgoing_bytes; i < m_outgoing_bytes.size(); ++i) {
+        if (m_outgoing_bytes[i].over_socket)
+            return true;
+    }
+    return false;
+}
+
+// Clients wait for the server when it falls behind, instead of queueing up ever more messages for it.
+// The server may have stopped reading from us until we read what it sent, so keep reading while waiting,
+// or neither side would ever get anywhere. Returns false if the connection was shut down.
+bool ConnectionBase::wait_for_peer_to_catch_up()
+{
+    VERIFY(!m_waiting_for_peer_to_catch_up);
+    TemporaryChange waiting_change { m_waiting_for_peer_to_catch_up, true };
+
+    bool waiting_to_write = has_pending_socket_bytes();
+
+    // Messages can't be decoded anymore once we're being destroyed, so all that's left is to wait for room.
+    bool waiting_to_read = !m_destroying;
+    if (!waiting_to_read && !waiting_to_write) {
+        ++m_statistics.send_syscalls;
+        // Ring the doorbell every now and then, both in case the peer missed it and to notice if it went away.
+        return m_shared_memory->wait_for_space(100) || ring_doorbell();
+    }
+
+    // Make sure the peer tells us over the socket when it writes something into our ring.
+    if (waiting_to_read && m_shared_memory && !m_shared_memory->prepare_to_sleep())
+        return drain_messages_from_peer();
+
+    fd_set rfds;
+    FD_ZERO(&rfds);
+    if (waiting_to_read)
+        FD_SET(m_socket->fd(), &rfds);
+    fd_set wfds;
+    FD_ZERO(&wfds);
+    if (waiting_to_write)
+        FD_SET(m_socket->fd(), &wfds);
+
+    auto rc = select(m_socket->fd() + 1, waiting_to_read ? &rfds : nullptr, waiting_to_write ? &wfds : nullptr, nullptr, nullptr);
+    if (rc < 0) {
+        if (errno == EINTR)
+            return true;
+        perror("Connection::wait_for_peer_to_catch_up select");
+        shutdown();
+        return false;
+    }
+    if (FD_ISSET(m_socket->fd(), &rfds))
+        return drain_messages_from_peer();
+    return true;
+}
+
+bool ConnectionBase::flush_outgoing_messages()
+{
+    if (!m_socket->is_open())
+        return !has_outgoing_bytes();
+
+    if (m_messages_sent_at_last_flush != m_statistics.messages_sent) {
+        m_messages_sent_at_last_flush = m_statistics.messages_sent;
+        ++m_statistics.batches_sent;
+    }
+
+    while (has_outgoing_bytes()) {
+        bool over_socket = first_outgoing_bytes().over_socket;
+        if (!(over_socket ? flush_to_socket() : flush_to_shared_memory()))
+            return false;
+        if (!has_outgoing_bytes() || first_outgoing_bytes().over_socket != over_socket)
+            continue;
+        // We have to wait for the peer to make room, unless it just did.
+        if (over_socket || !m_shared_memory->request_space_notification())
+            break;
+    }
+
+    // Only wake the peer up once for everything we just put into the ring.
+    if (m_shared_memory_accepted && m_shared_memory->take_peer_wakeup_request() && !ring_doorbell())
+        return false;
+
+    update_back_pressure();
+    return true;
+}
+
+void ConnectionBase::did_send_outgoing_bytes(size_t size)
+{
+    m_outgoing_size -= size;
+    while (size > 0) {
+        auto& first = first_outgoing_bytes();
+        size_t remaining_in_first = first.bytes.size() - first.offset;
+        if (size < remaining_in_first) {
+            first.offset += size;
+            return;
+        }
+        size -= remaining_in_first;
+        first.bytes.clear();
+        ++m_first_outgoing_bytes;
+    }
+
+    // Don't shift the whole queue down after every write, only once it's mostly made of sent entries.
+    if (m_first_outgoing_bytes == m_outgoing_bytes.size()) {
+        m_outgoing_bytes.clear_with_capacity();
+        m_first_outgoing_bytes = 0;
+    } else if (m_first_outgoing_bytes >= 64 && m_first_outgoing_bytes >= m_outgoing_bytes.size() / 2) {
+        m_outgoing_bytes.remove(0, m_first_outgoing_bytes);
+        m_first_outgoing_bytes = 0;
+    }
+}
+
+bool ConnectionBase::flush_to_socket()
+{
+    while (has_outgoing_bytes() && first_outgoing_bytes().over_socket) {
+        iovec iovecs[max_iovecs_per_write];
+        int iovec_count = 0;
+        for (size_t i = m_first_outgoing_bytes; i < m_outgoing_bytes.size() && iovec_count < max_iovecs_per_write; ++i) {
+            auto& outgoing = m_outgoing_bytes[i];
+            if (!outgoing.over_socket)
+                break;
+            iovecs[iovec_count++] = { outgoing.bytes.data() + outgoing.offset, outgoing.bytes.size() - outgoing.offset };
+        }
+
+        ++m_statistics.send_syscalls;
+        auto nwritten = writev(m_socket->fd(), iovecs, iovec_count);
+        if (nwritten < 0) {
+            switch (errno) {
+            case EINTR:
+                continue;
+            case EAGAIN:
+                if (m_waits_for_peer_to_catch_up && !m_waiting_for_peer_to_catch_up) {
+                    if (!wait_for_peer_to_catch_up())
+                        return false;
+                    continue;
+                }
+                // The peer isn't keeping up, try again once the socket becomes writable.
+                if (!m_write_notifier) {
+                    m_write_notifier = Core::Notifier::construct(m_socket->fd(), Core::Notifier::Write, this);
+                    m_write_notifier->on_ready_to_write = [this] { flush_outgoing_messages(); };
+                }
+                m_write_notifier->set_enabled(true);
+                return true;
+            case EPIPE:
+                dbgln("{}::post_message: Disconnected from peer", *this);
+                shutdown();
+                return false;
+            default:
+                perror("Connection::post_message writev");
+                shutdown();
+                return false;
+            }
+        }
+        did_send_outgoing_bytes(nwritten);
+    }
+
+    if (m_write_notifier)
+        m_write_notifier->set_enabled(false);
+    return true;
+}
+
+bool ConnectionBase::flush_to_shared_memory()
+{
+    while (has_outgoing_bytes() && !first_outgoing_bytes().over_socket) {
+        auto& outgoing = first_outgoing_bytes();
+        size_t nwritten = m_shared_memory->write(outgoing.bytes.bytes().slice(outgoing.offset));
+        if (nwritten > 0) {
+            did_send_outgoing_bytes(nwritten);
+            continue;
+        }
+
+        // The ring is full. Servers come back once the client tells them it made room,
+        // but clients wait for the server to catch up.
+        if (!m_waits_for_peer_to_catch_up || m_waiting_for_peer_to_catch_up)
+            return true;
+        if (m_shared_memory->take_peer_wakeup_request() && !ring_doorbell())
+            return false;
+        if (!m_destroying && m_shared_memory->request_space_notification())
+            continue;
+        if (!wait_for_peer_to_catch_up())
+            return false;
+    }
+    return true;
+}
+
+bool ConnectionBase::ring_doorbell()
+{
+    // Anything that's still waiting to go out over the socket will wake up the peer anyway.
+    if (has_pending_socket_bytes())
+        return true;
+
+    u32 control_frame[3] { 0, static_cast<u32>(ControlFrame::Doorbell), 0 };
+    for (;;) {
+        ++m_statistics.send_syscalls;
+        auto nwritten = write(m_socket->fd(), control_frame, sizeof(control_frame));
+        if (nwritten == sizeof(control_frame))
+            return true;
+        if (nwritten >= 0) {
+            // Make sure nothing else goes out over the socket before the rest of this frame.
+            OutgoingBytes rest_of_frame { ByteBuffer::copy(control_frame, sizeof(control_frame)), static_cast<size_t>(nwritten), true };
+            if (m_first_outgoing_bytes > 0)
+                m_outgoing_bytes[--m_first_outgoing_bytes] = move(rest_of_frame);
+            else
+                m_outgoing_bytes.prepend(move(rest_of_frame));
+            m_outgoing_size += sizeof(control_frame) - nwritten;
+            return flush_to_socket();
+        }
+        switch (errno) {
+        case EINTR:
+            continue;
+        case EAGAIN:
+            // The peer has yet to read what's already in the socket, so it will look at the ring soon enough.
+            return true;
+        case EPIPE:
+            dbgln("{}::post_message: Disconnected from peer", *this);
+            shutdown();
+            return false;
+        default:
+            perror("Connection::post_message write");
+            shutdown();
+            return false;
+        }
+    }
+}
+
+void ConnectionBase::update_back_pressure()
+{
+    // Clients wait for the server instead, and keep reading from it while they do.
+    if (m_waits_for_peer_to_catch_up)
+        return;
+
+    if (!m_reading_paused && m_outgoing_size >= m_outgoing_high_water_mark) {
+        // Stop reading, so that the peer eventually blocks instead of piling up more work for us.
+        m_reading_paused = true;
+        if (!m_shared_memory_accepted) {
+            m_notifier->set_enabled(false);
+            m_socket->set_read_notifier_enabled(false);
+        }
+    } else if (m_reading_paused && m_outgoing_size <= m_outgoing_high_water_mark / 2) {
+        m_reading_paused = false;
+        m_notifier->set_enabled(true);
+        m_socket->set_read_notifier_enabled(true);
+        // We may have ignored a doorbell while the ring was paused.
+        deferred_invoke([this](auto&) {
+            drain_messages_from_peer();
+            handle_messages();
+        });
+    }
+}
+
+void ConnectionBase::shutdown()
+{
+    m_outgoing_bytes.clear();
+    m_first_outgoing_bytes = 0;
+    m_outgoing_size = 0;
+    if (m_write_notifier)
+        m_write_notifier->close();
+    m_notifier->close();
+    m_socket->close();
+    die();
+}
+
+void ConnectionBase::offer_shared_memory_transport()
+{
+    // Without fd passing, there is no way to get the buffer to the other side.
+#ifdef __serenity__
+    if (getenv("LIBIPC_NO_SHARED_MEMORY"))
+        return;
+    auto transport = SharedMemoryTransport::create();
+    if (!transport)
+        return;
+    ++m_statistics.send_syscalls;
+    if (sendfd(m_socket->fd(), transport->buffer().fd()) < 0) {
+        perror("sendfd");
+        return;
+    }
+    enqueue_control_frame(ControlFrame::OfferSharedMemory, transport->buffer().size());
+    // We may already receive from the ring, but keep sending over the socket until the server accepts.
+    m_shared_memory = move(transport);
+#endif
+}
+
+bool ConnectionBase::wait_for_socket_to_become_readable()
+{
+    for (;;) {
+        if (!flush_outgoing_messages())
+            return false;
+        // We can't read the reply before the peer has read the request.
+        bool waiting_to_write = has_pending_socket_bytes();
+
+        fd_set rfds;
+        FD_ZERO(&rfds);
+        FD_SET(m_socket->fd(), &rfds);
+        fd_set wfds;
+        FD_ZERO(&wfds);
+        if (waiting_to_write)
+            FD_SET(m_socket->fd(), &wfds);
+
+        auto rc = select(m_socket->fd() + 1, &rfds, waiting_to_write ? &wfds : nullptr, nullptr, nullptr);
+        if (rc < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("wait_for_specific_endpoint_message: select");
+            VERIFY_NOT_REACHED();
+        }
+        VERIFY(rc > 0);
+        if (FD_ISSET(m_socket->fd(), &rfds))
+            return true;
+    }
+}
+
+bool ConnectionBase::drain_messages_from_peer()
+{
+    Vector<u8> bytes;
+    bool peer_closed = false;
+
+    while (m_socket->is_open()) {
+        u8 buffer[4096];
+        ++m_statistics.receive_syscalls;
+        ssize_t nread = recv(m_socket->fd(), buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (nread < 0) {
+            if (errno == EAGAIN)
+                break;
+            perror("recv");
+            exit(1);
+            return false;
+        }
+        if (nread == 0) {
+            peer_closed = bytes.is_empty();
+            break;
+        }
+        bytes.append(buffer, nread);
+    }
+
+    bool received_anything = !bytes.is_empty();
+    size_t message_count_before = m_unprocessed_messages.size();
+
+    // The socket goes first, since it carries the control frames that set up the shared memory rings,
+    // and anything that was sent before switching over to them.
+    if (!parse_messages(bytes, m_unprocessed_bytes, true))
+        return false;
+
+    // While the ring is paused, it fills up and the peer stops sending.
+    while (m_shared_memory && !m_reading_paused) {
+        Vector<u8> shared_memory_bytes;
+        if (!m_shared_memory->read(shared_memory_bytes)) {
+            shutdown();
+            return false;
+        }
+        if (!shared_memory_bytes.is_empty()) {
+            received_anything = true;
+            if (!parse_messages(shared_memory_bytes, m_unprocessed_shared_memory_bytes, false))
+                return false;
+        }
+        if (m_shared_memory->take_peer_space_request() && !ring_doorbell())
+            return false;
+        // The peer will ring the doorbell on the socket once we're asleep, unless something came in just now.
+        if (m_shared_memory->prepare_to_sleep())
+            break;
+    }
+
+    m_statistics.messages_received += m_unprocessed_messages.size() - message_count_before;
+
+    if (peer_closed && !received_anything) {
+        deferred_invoke([this](auto&) { shutdown(); });
+        return false;
+    }
+
+    if (received_anything) {
+        m_responsiveness_timer->stop();
+        did_become_responsive();
+    }
+
+    // A doorbell may have told us that there is room in the ring again.
+    // If we're in the middle of flushing already, it will take care of that itself.
+    if (has_outgoing_bytes() && !m_flush_scheduled && !m_waiting_for_peer_to_catch_up && !flush_outgoing_messages())
+        return false;
+
+    if (!m_unprocessed_messages.is_empty()) {
+        deferred_invoke([this](auto&) {
+            handle_messages();
+        });
+    }
+    return true;
+}
+
+// Decodes as many messages as possible from `bytes`, and stashes away the rest in `unprocessed_bytes`.
+// Returns false if the connection was shut down.
+bool ConnectionBase::parse_messages(Vector<u8>& bytes, ByteBuffer& unprocessed_bytes, bool allow_control_frames)
+{
+    if (!unprocessed_bytes.is_empty()) {
+        bytes.prepend(unprocessed_bytes.data(), unprocessed_bytes.size());
+        unprocessed_bytes.clear();
+    }
+
+    size_t index = 0;
+    u32 message_size = 0;
+    for (; index + sizeof(message_size) < bytes.size(); index += message_size) {
+        memcpy(&message_size, bytes.data() + index, sizeof(message_size));
+        if (message_size == 0 && allow_control_frames) {
+            u32 control_frame[3];
+            if (bytes.size() - index < control_frame_size)
+                break;
+            memcpy(control_frame, bytes.data() + index, control_frame_size);
+            if (!handle_control_frame(control_frame[1], control_frame[2]))
+                return false;
+            index += control_frame_size;
+            continue;
+        }
+        if (message_size == 0 || bytes.size() - index - sizeof(uint32_t) < message_size)
+            break;
+        index += sizeof(message_size);
+        auto remaining_bytes = ReadonlyBytes { bytes.data() + index, message_size };
+        if (auto message = decode_message(remaining_bytes)) {
+            m_unprocessed_messages.append(message.release_nonnull());
+        } else {
+            dbgln("Failed to parse a message");
+            break;
+        }
+    }
+
+    if (index < bytes.size()) {
+        // Sometimes we might receive a partial message. That's okay, just stash away
+        // the unprocessed bytes and we'll prepend them to the next incoming message
+        // in the next run of this function.
+        unprocessed_bytes = ByteBuffer::copy(bytes.data() + index, bytes.size() - index);
+    }
+    return true;
+}
+
+bool ConnectionBase::handle_control_frame(u32 kind, u32 argument)
+{
+    switch (static_cast<ControlFrame>(kind)) {
+    case ControlFrame::OfferSharedMemory:
+        return accept_shared_memory_transport(argument);
+    case ControlFrame::AcceptSharedMemory:
+        if (!m_shared_memory || m_shared_memory_accepted)
+            break;
+        // Anything that's already queued up still goes out over the socket first.
+        m_shared_memory_accepted = true;
+        return true;
+    case ControlFrame::Doorbell:
+        // Nothing to do here, the ring is always read right after the socket.
+        return true;
+    }
+    dbgln("{}::handle_control_frame: Unexpected control frame {}", *this, kind);
+    shutdown();
+    return false;
+}
+
+bool ConnectionBase::accept_shared_memory_transport([[maybe_unused]] u32 size)
+{
+    if (m_shared_memory) {
+        dbgln("{}::accept_shared_memory_transport: Already have a shared memory transport", *this);
+        shutdown();
+        return false;
+    }
+#ifdef __serenity__
+    ++m_statistics.receive_syscalls;
+    int fd = recvfd(m_socket->fd(), O_CLOEXEC);
+    if (fd < 0) {
+        perror("recvfd");
+        shutdown();
+        return false;
+    }
+    if (getenv("LIBIPC_NO_SHARED_MEMORY")) {
+        close(fd);
+        return true;
+    }
+    // If we don't like the buffer we just don't reply, and the client keeps using the socket.
+    auto transport = SharedMemoryTransport::adopt(Core::AnonymousBuffer::create_from_anon_fd(fd, size));
+    if (!transport) {
+        dbgln("{}::accept_shared_memory_transport: Peer offered an invalid buffer", *this);
+        return true;
+    }
+    enqueue_control_frame(ControlFrame::AcceptSharedMemory);
+    m_shared_memory = move(transport);
+    m_shared_memory_accepted = true;
+    return true;
+#else
+    dbgln("{}::accept_shared_memory_transport: Can't receive the buffer without fd passing", *this);
+    shutdown();
+    return false;
+#endif
+}
+
+void ConnectionBase::handle_messages()
+{
+    auto messages = move(m_unprocessed_messages);
+    for (auto& message : messages) {
+        if (message.endpoint_magic() == m_local_stub.magic())
+            if (auto response = m_local_stub.handle(message))
+                post_message(*response);
+    }
+
+    // The peer may be blocked waiting for one of these responses, so send them all off together right away.
+    if (!messages.is_empty())
+        flush_outgoing_messages();
+}
+
+}
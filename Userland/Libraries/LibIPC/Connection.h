@@ -14,33 +14,143 @@
 #include <LibCore/Notifier.h>
 #include <LibCore/Timer.h>
 #include <LibIPC/Message.h>
-#include <errno.h>
-#include <stdint.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <sys/select.h>
-#include <sys/socket.h>
-#include <sys/types.h>
-#include <unistd.h>
+#include <LibIPC/SharedMemoryTransport.h>
+#include <LibIPC/Stub.h>
 
 namespace IPC {
 
+// Control frames share the socket with messages, and are told apart from them by a message size of zero.
+// Each one is followed by its kind and a single argument.
+enum class ControlFrame : u32 {
+    // Sent by the client right after the fd of a SharedMemoryTransport buffer, the argument is its size.
+    OfferSharedMemory = 1,
+    // From now on, the server sends messages through the shared memory rings, and so can the client.
+    AcceptSharedMemory = 2,
+    // There is new data in the shared memory ring and the peer said it was going to sleep,
+    // or the peer asked to be told when there is room in its ring again.
+    Doorbell = 3,
+};
+
+// Everything about a connection that doesn't depend on its endpoints.
+class ConnectionBase : public Core::Object {
+    C_OBJECT_ABSTRACT(ConnectionBase);
+
+public:
+    // Once this many bytes are waiting to be sent, clients wait for the server to catch up while still reading
+    // from it, and servers stop reading from the client until they are down to half of it.
+    static constexpr size_t default_outgoing_high_water_mark = 1 * MiB;
+
+    struct Statistics {
+        u64 messages_sent { 0 };
+        u64 messages_received { 0 };
+        // Each batch is the set of messages posted during one turn of the event loop.
+        u64 batches_sent { 0 };
+        u64 send_syscalls { 0 };
+        u64 receive_syscalls { 0 };
+        u64 back_pressure_events { 0 };
+    };
+
+    virtual ~ConnectionBase() override;
+
+    void post_message(const Message&);
+    // FIXME: unnecessary copy
+    void post_message(MessageBuffer);
+
+    // Messages are sent in one go at the end of the current event loop turn, or before waiting for a reply.
+    // This sends them right away instead. Returns false if the connection was shut down.
+    bool flush_outgoing_messages();
+
+    size_t outgoing_high_water_mark() const { return m_outgoing_high_water_mark; }
+    void set_outgoing_high_water_mark(size_t size) { m_outgoing_high_water_mark = size; }
+
+    const Statistics& statistics() const { return m_statistics; }
+
+    virtual void may_have_become_unresponsive() { }
+    virtual void did_become_responsive() { }
+
+    void shutdown();
+    virtual void die() { }
+
+    bool is_open() const { return m_socket->is_open(); }
+
+protected:
+    ConnectionBase(Stub& local_stub, NonnullRefPtr<Core::LocalSocket>);
+
+    Core::LocalSocket& socket() { return *m_socket; }
+
+    // Instead of queueing up messages without bound, wait for the peer to catch up once it falls behind.
+    // The socket itself stays non-blocking, so that we can keep reading from the peer in the meantime.
+    void set_waits_for_peer_to_catch_up(bool waits) { m_waits_for_peer_to_catch_up = waits; }
+
+    void offer_shared_memory_transport();
+
+    // Returns false if the socket was closed.
+    bool wait_for_socket_to_become_readable();
+    bool drain_messages_from_peer();
+    void handle_messages();
+
+    virtual OwnPtr<Message> decode_message(ReadonlyBytes) = 0;
+
+    Stub& m_local_stub;
+    NonnullRefPtr<Core::LocalSocket> m_socket;
+    RefPtr<Core::Timer> m_responsiveness_timer;
+
+    RefPtr<Core::Notifier> m_notifier;
+    NonnullOwnPtrVector<Message> m_unprocessed_messages;
+    ByteBuffer m_unprocessed_bytes;
+
+private:
+    struct OutgoingBytes {
+        ByteBuffer bytes;
+        size_t offset { 0 };
+        bool over_socket { true };
+    };
+
+    bool parse_messages(Vector<u8>& bytes, ByteBuffer& unprocessed_bytes, bool allow_control_frames);
+    bool handle_control_frame(u32 kind, u32 argument);
+    bool accept_shared_memory_transport(u32 size);
+
+    void enqueue(ReadonlyBytes, bool over_socket);
+    void enqueue_control_frame(ControlFrame, u32 argument = 0);
+    void schedule_flush();
+    bool ring_doorbell();
+    bool flush_to_socket();
+    bool flush_to_shared_memory();
+    void did_send_outgoing_bytes(size_t);
+    bool has_outgoing_bytes() const { return m_first_outgoing_bytes < m_outgoing_bytes.size(); }
+    OutgoingBytes& first_outgoing_bytes() { return m_outgoing_bytes[m_first_outgoing_bytes]; }
+    bool has_pending_socket_bytes() const;
+    bool wait_for_peer_to_catch_up();
+    void update_back_pressure();
+
+    OwnPtr<SharedMemoryTransport> m_shared_memory;
+    bool m_shared_memory_accepted { false };
+    ByteBuffer m_unprocessed_shared_memory_bytes;
+
+    // Entries before m_first_outgoing_bytes have already been sent.
+    Vector<OutgoingBytes> m_outgoing_bytes;
+    size_t m_first_outgoing_bytes { 0 };
+    size_t m_outgoing_size { 0 };
+    size_t m_outgoing_high_water_mark { default_outgoing_high_water_mark };
+    bool m_flush_scheduled { false };
+    u64 m_messages_sent_at_last_flush { 0 };
+    bool m_reading_paused { false };
+    bool m_waits_for_peer_to_catch_up { false };
+    bool m_waiting_for_peer_to_catch_up { false };
+    bool m_destroying { false };
+    RefPtr<Core::Notifier> m_write_notifier;
+
+    Statistics m_statistics;
+};
+
 template<typename LocalEndpoint, typename PeerEndpoint>
-class Connection : public Core::Object {
+class Connection : public ConnectionBase {
 public:
     using LocalStub = typename LocalEndpoint::Stub;
 
     Connection(LocalStub& local_stub, NonnullRefPtr<Core::LocalSocket> socket)
-        : m_local_stub(local_stub)
-        , m_socket(move(socket))
-        , m_notifier(Core::Notifier::construct(m_socket->fd(), Core::Notifier::Read, this))
+        : ConnectionBase(local_stub, move(socket))
     {
-        m_responsiveness_timer = Core::Timer::create_single_shot(3000, [this] { may_have_become_unresponsive(); });
-        m_notifier->on_ready_to_read = [this] {
-            NonnullRefPtr protect = *this;
-            drain_messages_from_peer();
-            handle_messages();
-        };
     }
 
     template<typename MessageType>
@@ -49,61 +159,6 @@ public:
         return wait_for_specific_endpoint_message<MessageType, LocalEndpoint>();
     }
 
-    void post_message(const Message& message)
-    {
-        post_message(message.encode());
-    }
-
-    // FIXME: unnecessary copy
-    void post_message(MessageBuffer buffer)
-    {
-        // NOTE: If this connection is being shut down, but has not yet been destroyed,
-        //       the socket will be closed. Don't try to send more messages.
-        if (!m_socket->is_open())
-            return;
-
-        // Prepend the message size.
-        uint32_t message_size = buffer.data.size();
-        buffer.data.prepend(reinterpret_cast<const u8*>(&message_size), sizeof(message_size));
-
-#ifdef __serenity__
-        for (auto& fd : buffer.fds) {
-            auto rc = sendfd(m_socket->fd(), fd->value());
-            if (rc < 0) {
-                perror("sendfd");
-                shutdown();
-            }
-        }
-#else
-        if (!buffer.fds.is_empty())
-            warnln("fd passing is not supported on this platform, sorry :(");
-#endif
-
-        size_t total_nwritten = 0;
-        while (total_nwritten < buffer.data.size()) {
-            auto nwritten = write(m_socket->fd(), buffer.data.data() + total_nwritten, buffer.data.size() - total_nwritten);
-            if (nwritten < 0) {
-                switch (errno) {
-                case EPIPE:
-                    dbgln("{}::post_message: Disconnected from peer", *this);
-                    shutdown();
-                    return;
-                case EAGAIN:
-                    dbgln("{}::post_message: Peer buffer overflowed", *this);
-                    shutdown();
-                    return;
-                default:
-                    perror("Connection::post_message write");
-                    shutdown();
-                    return;
-                }
-            }
-            total_nwritten += nwritten;
-        }
-
-        m_responsiveness_timer->start();
-    }
-
     template<typename RequestType, typename... Args>
     NonnullOwnPtr<typename RequestType::ResponseType> send_sync(Args&&... args)
     {
@@ -120,23 +175,7 @@ public:
         return wait_for_specific_endpoint_message<typename RequestType::ResponseType, PeerEndpoint>();
     }
 
-    virtual void may_have_become_unresponsive() { }
-    virtual void did_become_responsive() { }
-
-    void shutdown()
-    {
-        m_notifier->close();
-        m_socket->close();
-        die();
-    }
-
-    virtual void die() { }
-
-    bool is_open() const { return m_socket->is_open(); }
-
 protected:
-    Core::LocalSocket& socket() { return *m_socket; }
-
     template<typename MessageType, typename Endpoint>
     OwnPtr<MessageType> wait_for_specific_endpoint_message()
     {
@@ -153,123 +192,29 @@ protected:
 
             if (!m_socket->is_open())
                 break;
-            fd_set rfds;
-            FD_ZERO(&rfds);
-            FD_SET(m_socket->fd(), &rfds);
-            for (;;) {
-                if (auto rc = select(m_socket->fd() + 1, &rfds, nullptr, nullptr, nullptr); rc < 0) {
-                    if (errno == EINTR)
-                        continue;
-                    perror("wait_for_specific_endpoint_message: select");
-                    VERIFY_NOT_REACHED();
-                } else {
-                    VERIFY(rc > 0);
-                    VERIFY(FD_ISSET(m_socket->fd(), &rfds));
-                    break;
-                }
-            }
-
+            if (!wait_for_socket_to_become_readable())
+                break;
             if (!drain_messages_from_peer())
                 break;
         }
         return {};
     }
 
-    bool drain_messages_from_peer()
-    {
-        Vector<u8> bytes;
-
-        if (!m_unprocessed_bytes.is_empty()) {
-            bytes.append(m_unprocessed_bytes.data(), m_unprocessed_bytes.size());
-            m_unprocessed_bytes.clear();
-        }
-
-        while (m_socket->is_open()) {
-            u8 buffer[4096];
-            ssize_t nread = recv(m_socket->fd(), buffer, sizeof(buffer), MSG_DONTWAIT);
-            if (nread < 0) {
-                if (errno == EAGAIN)
-                    break;
-                perror("recv");
-                exit(1);
-                return false;
-            }
-            if (nread == 0) {
-                if (bytes.is_empty()) {
-                    deferred_invoke([this](auto&) { shutdown(); });
-                    return false;
-                }
-                break;
-            }
-            bytes.append(buffer, nread);
-        }
-
-        if (!bytes.is_empty()) {
-            m_responsiveness_timer->stop();
-            did_become_responsive();
-        }
-
-        size_t index = 0;
-        u32 message_size = 0;
-        for (; index + sizeof(message_size) < bytes.size(); index += message_size) {
-            memcpy(&message_size, bytes.data() + index, sizeof(message_size));
-            if (message_size == 0 || bytes.size() - index - sizeof(uint32_t) < message_size)
-                break;
-            index += sizeof(message_size);
-            auto remaining_bytes = ReadonlyBytes { bytes.data() + index, message_size };
-            if (auto message = LocalEndpoint::decode_message(remaining_bytes, m_socket->fd())) {
-                m_unprocessed_messages.append(message.release_nonnull());
-            } else if (auto message = PeerEndpoint::decode_message(remaining_bytes, m_socket->fd())) {
-                m_unprocessed_messages.append(message.release_nonnull());
-            } else {
-                dbgln("Failed to parse a message");
-                break;
-            }
-        }
-
-        if (index < bytes.size()) {
-            // Sometimes we might receive a partial message. That's okay, just stash away
-            // the unprocessed bytes and we'll prepend them to the next incoming message
-            // in the next run of this function.
-            auto remaining_bytes = ByteBuffer::copy(bytes.data() + index, bytes.size() - index);
-            if (!m_unprocessed_bytes.is_empty()) {
-                dbgln("{}::drain_messages_from_peer: Already have unprocessed bytes", *this);
-                shutdown();
-                return false;
-            }
-            m_unprocessed_bytes = remaining_bytes;
-        }
-
-        if (!m_unprocessed_messages.is_empty()) {
-            deferred_invoke([this](auto&) {
-                handle_messages();
-            });
-        }
-        return true;
-    }
-
-    void handle_messages()
+private:
+    virtual OwnPtr<Message> decode_message(ReadonlyBytes bytes) override
     {
-        auto messages = move(m_unprocessed_messages);
-        for (auto& message : messages) {
-            if (message.endpoint_magic() == LocalEndpoint::static_magic())
-                if (auto response = m_local_stub.handle(message))
-                    post_message(*response);
-        }
+        if (auto message = LocalEndpoint::decode_message(bytes, m_socket->fd()))
+            return message;
+        return PeerEndpoint::decode_message(bytes, m_socket->fd());
     }
-
-protected:
-    LocalStub& m_local_stub;
-    NonnullRefPtr<Core::LocalSocket> m_socket;
-    RefPtr<Core::Timer> m_responsiveness_timer;
-
-    RefPtr<Core::Notifier> m_notifier;
-    NonnullOwnPtrVector<Message> m_unprocessed_messages;
-    ByteBuffer m_unprocessed_bytes;
 };
 
 }
 
+template<>
+struct AK::Formatter<IPC::ConnectionBase> : Formatter<Core::Object> {
+};
+
 template<typename LocalEndpoint, typename PeerEndpoint>
 struct AK::Formatter<IPC::Connection<LocalEndpoint, PeerEndpoint>> : Formatter<Core::Object> {
 };
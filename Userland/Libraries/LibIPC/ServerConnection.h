@@ -22,7 +22,6 @@ public:
         : Connection<ClientEndpoint, ServerEndpoint>(local_endpoint, Core::LocalSocket::construct())
         , ServerEndpoint::template Proxy<ClientEndpoint>(*this, {})
     {
-        // We want to rate-limit our clients
         this->socket().set_blocking(true);
 
         if (!this->socket().connect(Core::SocketAddress::local(address))) {
@@ -31,6 +30,12 @@ public:
         }
 
         VERIFY(this->socket().is_connected());
+
+        // We want to rate-limit our clients, but they have to keep reading while they wait.
+        this->socket().set_blocking(false);
+        this->set_waits_for_peer_to_catch_up(true);
+
+        this->offer_shared_memory_transport();
     }
 
     virtual void die() override
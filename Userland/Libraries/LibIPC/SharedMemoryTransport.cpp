@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Debug.h>
+#include <AK/StdLibExtras.h>
+#include <LibIPC/SharedMemoryTransport.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__serenity__)
+#    include <serenity.h>
+#elif defined(__linux__)
+#    include <linux/futex.h>
+#    include <sys/syscall.h>
+#endif
+
+namespace IPC {
+
+static constexpr u32 shared_memory_magic = 0x53484d52; // "SHMR"
+
+// How the producer wants to be told that there is space in the ring again.
+static constexpr u32 producer_waiting_on_futex = 1;
+static constexpr u32 producer_waiting_on_socket = 2;
+
+// Positions are free-running byte counts, so head - tail is the number of unread bytes
+// even after they wrap around. The capacity has to be a power of two for that to work.
+struct SharedMemoryTransport::Ring {
+    // Only advanced by the producer.
+    alignas(64) Atomic<u32> head;
+    // Only advanced by the consumer. A producer waiting for space sleeps on this as a futex.
+    alignas(64) Atomic<u32> tail;
+    // Set by the consumer before it goes back to waiting on the socket.
+    Atomic<u32> consumer_sleeping;
+    // Set by the producer before it waits for the consumer to make room, to one of the values below.
+    Atomic<u32> producer_waiting;
+};
+
+struct SharedMemoryTransport::Header {
+    u32 magic;
+    u32 ring_capacity;
+    // rings[0] carries messages from the client to the server, rings[1] the replies.
+    Ring rings[2];
+};
+
+static constexpr bool is_power_of_two(size_t value)
+{
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+static void wait_on_shared_futex(volatile u32* address, u32 value, int timeout_ms)
+{
+    timespec timeout { timeout_ms / 1000, (timeout_ms % 1000) * 1'000'000 };
+#if defined(__serenity__)
+    // Not FUTEX_PRIVATE_FLAG, the other end of the connection is in a different process.
+    futex(const_cast<u32*>(address), FUTEX_WAIT, value, &timeout, nullptr, 0);
+#elif defined(__linux__)
+    syscall(SYS_futex, address, FUTEX_WAIT, value, &timeout, nullptr, 0);
+#else
+    (void)address;
+    (void)value;
+    nanosleep(&timeout, nullptr);
+#endif
+}
+
+static void wake_shared_futex(volatile u32* address)
+{
+#if defined(__serenity__)
+    futex(const_cast<u32*>(address), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#elif defined(__linux__)
+    syscall(SYS_futex, address, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#else
+    (void)address;
+#endif
+}
+
+OwnPtr<SharedMemoryTransport> SharedMemoryTransport::create(size_t ring_capacity)
+{
+    VERIFY(is_power_of_two(ring_capacity));
+
+    auto buffer = Core::AnonymousBuffer::create_with_size(sizeof(Header) + 2 * ring_capacity);
+    if (!buffer.is_valid())
+        return {};
+
+    auto* header = new (buffer.data<void>()) Header;
+    header->magic = shared_memory_magic;
+    header->ring_capacity = ring_capacity;
+    for (auto& ring : header->rings) {
+        // Both readers start out asleep, so that the first message wakes them up.
+        ring.consumer_sleeping = 1;
+    }
+
+    return adopt_own(*new SharedMemoryTransport(move(buffer), Side::Client));
+}
+
+OwnPtr<SharedMemoryTransport> SharedMemoryTransport::adopt(Core::AnonymousBuffer buffer)
+{
+    if (!buffer.is_valid() || buffer.size() < sizeof(Header))
+        return {};
+
+    auto& header = *reinterpret_cast<const Header*>(buffer.data<void>());
+    if (header.magic != shared_memory_magic)
+        return {};
+
+    size_t capacity = header.ring_capacity;
+    if (capacity < 4 * KiB || capacity > 16 * MiB || !is_power_of_two(capacity))
+        return {};
+    if (buffer.size() < sizeof(Header) + 2 * capacity)
+        return {};
+
+    return adopt_own(*new SharedMemoryTransport(move(buffer), Side::Server));
+}
+
+SharedMemoryTransport::SharedMemoryTransport(Core::AnonymousBuffer buffer, Side side)
+    : m_buffer(move(buffer))
+{
+    // Read the capacity once, the peer can scribble over the header whenever it wants.
+    m_capacity = header().ring_capacity;
+
+    auto* data = m_buffer.data<u8>() + sizeof(Header);
+    size_t outgoing_index = side == Side::Client ? 0 : 1;
+    size_t incoming_index = 1 - outgoing_index;
+    m_outgoing = &header().rings[outgoing_index];
+    m_incoming = &header().rings[incoming_index];
+    m_outgoing_data = data + outgoing_index * m_capacity;
+    m_incoming_data = data + incoming_index * m_capacity;
+}
+
+SharedMemoryTransport::Header& SharedMemoryTransport::header()
+{
+    return *reinterpret_cast<Header*>(m_buffer.data<void>());
+}
+
+size_t SharedMemoryTransport::write(ReadonlyBytes bytes)
+{
+    u32 head = m_outgoing->head.load(AK::memory_order_relaxed);
+    u32 tail = m_outgoing->tail.load(AK::memory_order_acquire);
+    u32 used = head - tail;
+    if (used > m_capacity)
+        return 0;
+
+    size_t size = min<size_t>(bytes.size(), m_capacity - used);
+    if (size == 0)
+        return 0;
+
+    u32 offset = head & (m_capacity - 1);
+    size_t first_chunk_size = min<size_t>(size, m_capacity - offset);
+    memcpy(m_outgoing_data + offset, bytes.data(), first_chunk_size);
+    memcpy(m_outgoing_data, bytes.data() + first_chunk_size, size - first_chunk_size);
+
+    // Sequentially consistent, so that the check of consumer_sleeping in take_peer_wakeup_request()
+    // can't be reordered before it. Otherwise both sides could decide the other one will do the work.
+    m_outgoing->head.store(head + size);
+    return size;
+}
+
+bool SharedMemoryTransport::wait_for_space(int timeout_ms)
+{
+    u32 head = m_outgoing->head.load(AK::memory_order_relaxed);
+    m_outgoing->producer_waiting.store(producer_waiting_on_futex);
+    u32 tail = m_outgoing->tail.load();
+    if (head - tail < m_capacity)
+        return true;
+    wait_on_shared_futex(m_outgoing->tail.ptr(), tail, timeout_ms);
+    return head - m_outgoing->tail.load() < m_capacity;
+}
+
+bool SharedMemoryTransport::request_space_notification()
+{
+    u32 head = m_outgoing->head.load(AK::memory_order_relaxed);
+    m_outgoing->producer_waiting.store(producer_waiting_on_socket);
+    return head - m_outgoing->tail.load() < m_capacity;
+}
+
+bool SharedMemoryTransport::take_peer_space_request()
+{
+    return exchange(m_peer_requested_space, false);
+}
+
+bool SharedMemoryTransport::take_peer_wakeup_request()
+{
+    if (m_outgoing->consumer_sleeping.load() == 0)
+        return false;
+    return m_outgoing->consumer_sleeping.exchange(0) != 0;
+}
+
+bool SharedMemoryTransport::read(Vector<u8>& bytes)
+{
+    u32 tail = m_incoming->tail.load(AK::memory_order_relaxed);
+    u32 head = m_incoming->head.load(AK::memory_order_acquire);
+    u32 available = head - tail;
+    if (available > m_capacity) {
+        dbgln("SharedMemoryTransport: Peer corrupted the ring (head={}, tail={})", head, tail);
+        return false;
+    }
+    if (available == 0)
+        return true;
+
+    // Copy the bytes out before decoding, the peer could change them under our feet otherwise.
+    u32 offset = tail & (m_capacity - 1);
+    size_t first_chunk_size = min<size_t>(available, m_capacity - offset);
+    bytes.append(m_incoming_data + offset, first_chunk_size);
+    bytes.append(m_incoming_data, available - first_chunk_size);
+
+    m_incoming->tail.store(tail + available);
+    if (m_incoming->producer_waiting.load() != 0) {
+        auto waiting = m_incoming->producer_waiting.exchange(0);
+        if (waiting == producer_waiting_on_futex)
+            wake_shared_futex(m_incoming->tail.ptr());
+        else if (waiting == producer_waiting_on_socket)
+            m_peer_requested_space = true;
+    }
+    return true;
+}
+
+bool SharedMemoryTransport::prepare_to_sleep()
+{
+    m_incoming->consumer_sleeping.store(1);
+    if (m_incoming->head.load() == m_incoming->tail.load(AK::memory_order_relaxed))
+        return true;
+    m_incoming->consumer_sleeping.store(0);
+    return false;
+}
+
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/OwnPtr.h>
+#include <AK/Span.h>
+#include <AK/Vector.h>
+#include <LibCore/AnonymousBuffer.h>
+
+namespace IPC {
+
+// A pair of single-producer, single-consumer byte rings in a buffer shared by both ends of a connection.
+// Each end writes into one ring and reads from the other, so messages can be exchanged without any
+// system calls while the reader is awake. The socket is still used to pass file descriptors, and to
+// wake up a reader that has gone back to waiting in its event loop.
+class SharedMemoryTransport {
+public:
+    enum class Side {
+        Client,
+        Server,
+    };
+
+    static constexpr size_t default_ring_capacity = 256 * KiB;
+
+    // The connecting side allocates the buffer and offers it to the other side over the socket.
+    static OwnPtr<SharedMemoryTransport> create(size_t ring_capacity = default_ring_capacity);
+    // Returns null if the buffer the peer sent us doesn't look like one made by create().
+    static OwnPtr<SharedMemoryTransport> adopt(Core::AnonymousBuffer);
+
+    const Core::AnonymousBuffer& buffer() const { return m_buffer; }
+
+    // Copies as much of `bytes` as fits into the outgoing ring, and returns how many bytes that was.
+    size_t write(ReadonlyBytes bytes);
+
+    // Blocks until the peer frees up space in the outgoing ring, or until the timeout expires.
+    // Returns false if the ring is still full.
+    bool wait_for_space(int timeout_ms);
+
+    // Like wait_for_space(), but doesn't block. If the ring is still full, the peer will take a space request,
+    // and should tell us over the socket once it has made room. Returns true if there is space already.
+    bool request_space_notification();
+
+    // Returns true if the peer went to sleep since the last time this returned true,
+    // which means it needs to be woken up over the socket to notice what we wrote.
+    bool take_peer_wakeup_request();
+
+    // Moves everything from the incoming ring to the end of `bytes`.
+    // Returns false if the peer corrupted the ring.
+    bool read(Vector<u8>& bytes);
+
+    // Returns true if the peer asked to be told over the socket when there is room in its ring again.
+    bool take_peer_space_request();
+
+    // Tells the peer that we are about to wait for the socket. Returns false if more data
+    // showed up in the meantime, in which case we should read again instead.
+    bool prepare_to_sleep();
+
+private:
+    struct Ring;
+    struct Header;
+
+    SharedMemoryTransport(Core::AnonymousBuffer, Side);
+
+    Header& header();
+
+    Core::AnonymousBuffer m_buffer;
+    Ring* m_outgoing { nullptr };
+    Ring* m_incoming { nullptr };
+    u8* m_outgoing_data { nullptr };
+    u8* m_incoming_data { nullptr };
+    u32 m_capacity { 0 };
+    bool m_peer_requested_space { false };
+};
+
+}
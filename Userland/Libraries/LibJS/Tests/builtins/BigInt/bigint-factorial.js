@@ -0,0 +1,34 @@
+function factorial(n) {
+    let result = 1n;
+    for (let i = 2n; i <= n; ++i) result *= i;
+    return result;
+}
+
+describe("correct behavior", () => {
+    test("factorial of 1000", () => {
+        const string = factorial(1000n).toString();
+        expect(string).toHaveLength(2568);
+        expect(string.substring(0, 30)).toBe("402387260077093773543702433923");
+        let digitSum = 0;
+        for (const digit of string) digitSum += Number(digit);
+        expect(digitSum).toBe(10539);
+    });
+
+    test("factorial of 2000", () => {
+        const string = factorial(2000n).toString();
+        expect(string).toHaveLength(5736);
+        expect(string.substring(0, 20)).toBe("33162750924506332411");
+        const trailingZeros = string.length - string.replace(/0+$/, "").length;
+        expect(trailingZeros).toBe(499);
+        expect(string.substring(5736 - 499 - 20, 5736 - 499)).toBe("41149846950807339008");
+    });
+
+    test("product of two big factorials", () => {
+        // Both operands are long enough for the multiplication to split them up.
+        const a = factorial(1500n);
+        const b = factorial(1200n);
+        expect((a * b) / b).toBe(a);
+        expect((a * a) / a).toBe(a);
+        expect(a * b - b * a).toBe(0n);
+    });
+});
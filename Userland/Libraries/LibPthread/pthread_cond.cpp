@@ -127,7 +127,9 @@ int pthread_cond_broadcast(pthread_cond_t* cond)
     pthread_mutex_t* mutex = AK::atomic_load(&cond->mutex, AK::memory_order_relaxed);
     VERIFY(mutex);
 
-    int rc = futex(&cond->value, FUTEX_REQUEUE | FUTEX_PRIVATE_FLAG, 1, nullptr, &mutex->lock, INT_MAX);
+    // Wake one of the waiters and move the rest over to the mutex, so that they don't all wake up just to
+    // fight over it. The one we wake takes the pessimistic path, so its unlock wakes the next one, and so on.
+    int rc = futex(&cond->value, FUTEX_REQUEUE | FUTEX_PRIVATE_FLAG, 1, (const struct timespec*)(uintptr_t)INT_MAX, &mutex->lock, 0);
     VERIFY(rc >= 0);
     return 0;
 }
@@ -30,6 +30,8 @@ enum class CipherSuite {
     // RFC 5289 - ECDHE for AES-GCM
     ECDHE_ECDSA_WITH_AES_128_GCM_SHA256 = 0xC02B,
     ECDHE_ECDSA_WITH_AES_256_GCM_SHA384 = 0xC02C,
+    ECDHE_RSA_WITH_AES_128_GCM_SHA256 = 0xC02F,
+    ECDHE_RSA_WITH_AES_256_GCM_SHA384 = 0xC030,
 
     // RFC 5487 - Pre-shared keys
     DHE_PSK_WITH_AES_128_GCM_SHA256 = 0x00AA,
@@ -105,6 +107,22 @@ struct SignatureAndHashAlgorithm {
     SignatureAlgorithm signature;
 };
 
+// Defined in RFC 8422 section 5.1.1
+enum class NamedCurve : u16 {
+    secp256r1 = 23,
+    x25519 = 29,
+};
+
+// Defined in RFC 8422 section 5.1.2
+enum class ECPointFormat : u8 {
+    Uncompressed = 0,
+};
+
+// Defined in RFC 8422 section 5.4
+enum class ECCurveType : u8 {
+    NamedCurve = 3,
+};
+
 enum class KeyExchangeAlgorithm {
     Invalid,
     // Defined in RFC 5246 section 7.4.2 / RFC 4279 section 4
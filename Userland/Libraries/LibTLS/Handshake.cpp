@@ -34,6 +34,21 @@ ByteBuffer TLSv12::build_hello()
     builder.append(version);
     builder.append(m_context.local_random, sizeof(m_context.local_random));
 
+    // Offer to resume an earlier session (RFC 5246 section 7.4.1.2). When resuming with a ticket,
+    // we make up a session ID, and the server echoes it back if it accepts the ticket (RFC 5077 section 3.4).
+    ReadonlyBytes session_ticket;
+    if (m_context.session_to_resume.has_value()) {
+        auto& session = m_context.session_to_resume.value();
+        if (!session.session_id.is_empty()) {
+            memcpy(m_context.session_id, session.session_id.data(), session.session_id.size());
+            m_context.session_id_size = session.session_id.size();
+        } else {
+            fill_with_random(m_context.session_id, sizeof(m_context.session_id));
+            m_context.session_id_size = sizeof(m_context.session_id);
+        }
+        session_ticket = session.ticket;
+    }
+
     builder.append(m_context.session_id_size);
     if (m_context.session_id_size)
         builder.append(m_context.session_id, m_context.session_id_size);
@@ -74,6 +89,16 @@ ByteBuffer TLSv12::build_hello()
     // signature_algorithms: 2b extension ID, 2b extension length, 2b vector length, 2xN signatures and hashes
     extension_length += 2 + 2 + 2 + 2 * m_context.options.supported_signature_algorithms.size();
 
+    // supported_groups: 2b extension ID, 2b extension length, 2b vector length, 2xN named curves
+    // ec_point_formats: 2b extension ID, 2b extension length, 1b vector length, 1b point format
+    auto curve_count = m_context.options.elliptic_curves.size();
+    if (curve_count)
+        extension_length += 2 + 2 + 2 + 2 * curve_count + 2 + 2 + 1 + 1;
+
+    // session_ticket: 2b extension ID, 2b extension length, the ticket (empty if we don't have one yet)
+    if (m_context.options.use_session_tickets)
+        extension_length += 2 + 2 + session_ticket.size();
+
     if (sni_length)
         extension_length += sni_length + 9;
 
@@ -105,6 +130,27 @@ ByteBuffer TLSv12::build_hello()
         builder.append((u8)entry.signature);
     }
 
+    if (curve_count) {
+        // supported_groups extension
+        builder.append((u16)HandshakeExtension::SupportedGroups);
+        builder.append((u16)(2 + 2 * curve_count));
+        builder.append((u16)(2 * curve_count));
+        for (auto curve : m_context.options.elliptic_curves)
+            builder.append((u16)curve);
+
+        // ec_point_formats extension, we only handle uncompressed points
+        builder.append((u16)HandshakeExtension::ECPointFormats);
+        builder.append((u16)2);
+        builder.append((u8)1);
+        builder.append((u8)ECPointFormat::Uncompressed);
+    }
+
+    if (m_context.options.use_session_tickets) {
+        builder.append((u16)HandshakeExtension::SessionTicket);
+        builder.append((u16)session_ticket.size());
+        builder.append(session_ticket);
+    }
+
     if (alpn_length) {
         // TODO
         VERIFY_NOT_REACHED();
@@ -193,6 +239,14 @@ ssize_t TLSv12::handle_handshake_finished(ReadonlyBytes buffer, WritePacketStage
 
     // TODO: Compare Hashes
     dbgln_if(TLS_DEBUG, "FIXME: handle_handshake_finished :: Check message validity");
+
+    if (m_context.session_resumed) {
+        // In an abbreviated handshake the server finishes first, our ChangeCipherSpec and Finished
+        // have to go out before any application data does.
+        write_packets = WritePacketStage::Finished;
+        return index + size;
+    }
+
     m_context.connection_status = ConnectionStatus::Established;
 
     if (m_handshake_timeout_timer) {
@@ -202,12 +256,36 @@ ssize_t TLSv12::handle_handshake_finished(ReadonlyBytes buffer, WritePacketStage
         m_handshake_timeout_timer = nullptr;
     }
 
+    did_establish_session();
+
     if (on_tls_ready_to_write)
         on_tls_ready_to_write(*this);
 
     return index + size;
 }
 
+void TLSv12::did_establish_session()
+{
+    if (!on_tls_session_established)
+        return;
+
+    Session session;
+    session.session_id = ByteBuffer::copy(m_context.session_id, m_context.session_id_size);
+    session.ticket = m_context.session_ticket;
+    session.ticket_lifetime_hint = m_context.session_ticket_lifetime_hint;
+    // A resumed session keeps its ticket unless the server replaced it (RFC 5077 section 3.3).
+    if (session.ticket.is_empty() && m_context.session_resumed) {
+        session.ticket = m_context.session_to_resume->ticket;
+        session.ticket_lifetime_hint = m_context.session_to_resume->ticket_lifetime_hint;
+    }
+    if (session.session_id.is_empty() && session.ticket.is_empty())
+        return;
+
+    session.cipher = m_context.cipher;
+    session.master_key = m_context.master_key;
+    on_tls_session_established(session);
+}
+
 ssize_t TLSv12::handle_handshake_payload(ReadonlyBytes vbuffer)
 {
     if (m_context.connection_status == ConnectionStatus::Established) {
@@ -274,6 +352,23 @@ ssize_t TLSv12::handle_handshake_payload(ReadonlyBytes vbuffer)
             dbgln("unsupported: DTLS");
             payload_res = (i8)Error::UnexpectedMessage;
             break;
+        case NewSessionTicket:
+            if (m_context.handshake_messages[11] >= 1) {
+                dbgln("unexpected new session ticket message");
+                payload_res = (i8)Error::UnexpectedMessage;
+                break;
+            }
+            ++m_context.handshake_messages[11];
+            dbgln_if(TLS_DEBUG, "new session ticket");
+            if (m_context.is_server) {
+                dbgln("unsupported: server mode");
+                VERIFY_NOT_REACHED();
+            } else if (m_context.connection_status != ConnectionStatus::KeyExchange || !m_context.options.use_session_tickets) {
+                payload_res = (i8)Error::UnexpectedMessage;
+            } else {
+                payload_res = handle_new_session_ticket(buffer.slice(1, payload_size));
+            }
+            break;
         case CertificateMessage:
             if (m_context.handshake_messages[4] >= 1) {
                 dbgln("unexpected certificate message");
@@ -523,6 +618,14 @@ ssize_t TLSv12::handle_handshake_payload(ReadonlyBytes vbuffer)
                 write_packet(packet);
             }
             m_context.connection_status = ConnectionStatus::Established;
+            if (m_handshake_timeout_timer) {
+                m_handshake_timeout_timer->stop();
+                m_handshake_timeout_timer->remove_from_parent();
+                m_handshake_timeout_timer = nullptr;
+            }
+            did_establish_session();
+            if (on_tls_ready_to_write)
+                on_tls_ready_to_write(*this);
             break;
         }
         payload_size++;
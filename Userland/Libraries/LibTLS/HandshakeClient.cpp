@@ -7,6 +7,8 @@
 #include <AK/Debug.h>
 #include <AK/Random.h>
 #include <LibCrypto/ASN1/DER.h>
+#include <LibCrypto/Curves/SECP256r1.h>
+#include <LibCrypto/Curves/X25519.h>
 #include <LibCrypto/PK/Code/EMSA_PSS.h>
 #include <LibTLS/TLSv12.h>
 
@@ -224,6 +226,46 @@ void TLSv12::build_rsa_pre_master_secret(PacketBuilder& builder)
     builder.append(outbuf);
 }
 
+void TLSv12::build_ecdhe_rsa_pre_master_secret(PacketBuilder& builder)
+{
+    OwnPtr<Crypto::Curves::EllipticCurve> curve;
+    switch (m_context.server_key_exchange_curve) {
+    case NamedCurve::x25519:
+        curve = make<Crypto::Curves::X25519>();
+        break;
+    case NamedCurve::secp256r1:
+        curve = make<Crypto::Curves::SECP256r1>();
+        break;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+
+    auto private_key = curve->generate_private_key();
+    auto public_key = curve->generate_public_key(private_key);
+    auto shared_secret = curve->compute_shared_secret(private_key, m_context.server_key_exchange_public_key);
+    if (!shared_secret.has_value()) {
+        dbgln("Server sent an invalid ECDHE public key");
+        alert(AlertLevel::Critical, AlertDescription::IllegalParameter);
+        return;
+    }
+
+    m_context.premaster_key = shared_secret.release_value();
+    if constexpr (TLS_DEBUG) {
+        dbgln("PreMaster secret");
+        print_buffer(m_context.premaster_key);
+    }
+
+    // The master secret is always 48 bytes long, whatever the size of the ECDH shared secret (RFC 8422 section 5.10).
+    if (!compute_master_secret_from_pre_master_secret(48)) {
+        dbgln("oh noes we could not derive a master key :(");
+        return;
+    }
+
+    builder.append_u24(public_key.size() + 1);
+    builder.append((u8)public_key.size());
+    builder.append(public_key.bytes());
+}
+
 ByteBuffer TLSv12::build_certificate()
 {
     PacketBuilder builder { MessageType::Handshake, m_context.options.version };
@@ -304,11 +346,13 @@ ByteBuffer TLSv12::build_client_key_exchange()
         TODO();
         break;
     case KeyExchangeAlgorithm::ECDHE_RSA:
+        build_ecdhe_rsa_pre_master_secret(builder);
+        break;
     case KeyExchangeAlgorithm::ECDH_ECDSA:
     case KeyExchangeAlgorithm::ECDH_RSA:
     case KeyExchangeAlgorithm::ECDHE_ECDSA:
     case KeyExchangeAlgorithm::ECDH_anon:
-        dbgln("Client key exchange for ECDHE algorithms is not implemented");
+        dbgln("Client key exchange for ECDH/ECDSA algorithms is not implemented");
         TODO();
         break;
     default:
@@ -55,6 +55,10 @@ ssize_t TLSv12::handle_server_hello(ReadonlyBytes buffer, WritePacketStage& writ
         return (i8)Error::NeedMoreData;
     }
 
+    // The server accepts our offer to resume a session by echoing the session ID we sent.
+    bool resuming = m_context.session_to_resume.has_value() && session_length && session_length == m_context.session_id_size
+        && !memcmp(m_context.session_id, buffer.offset_pointer(res), session_length);
+
     if (session_length && session_length <= 32) {
         memcpy(m_context.session_id, buffer.offset_pointer(res), session_length);
         m_context.session_id_size = session_length;
@@ -78,6 +82,10 @@ ssize_t TLSv12::handle_server_hello(ReadonlyBytes buffer, WritePacketStage& writ
         dbgln("No supported cipher could be agreed upon");
         return (i8)Error::NoCommonCipher;
     }
+    if (resuming && cipher != m_context.session_to_resume->cipher) {
+        dbgln("Server resumed a session with a different cipher");
+        return (i8)Error::NoCommonCipher;
+    }
     m_context.cipher = cipher;
     dbgln_if(TLS_DEBUG, "Cipher: {}", (u16)cipher);
 
@@ -166,6 +174,12 @@ ssize_t TLSv12::handle_server_hello(ReadonlyBytes buffer, WritePacketStage& writ
                 }
             }
             res += extension_length;
+        } else if (extension_type == HandshakeExtension::SessionTicket) {
+            // An empty acknowledgement, the ticket itself comes in a NewSessionTicket message.
+            res += extension_length;
+        } else if (extension_type == HandshakeExtension::ECPointFormats) {
+            // We only ever offer uncompressed points, which every server has to accept (RFC 8422 section 5.1.2).
+            res += extension_length;
         } else if (extension_type == HandshakeExtension::SignatureAlgorithms) {
             dbgln("supported signatures: ");
             print_buffer(buffer.slice(res, extension_length));
@@ -177,6 +191,16 @@ ssize_t TLSv12::handle_server_hello(ReadonlyBytes buffer, WritePacketStage& writ
         }
     }
 
+    if (resuming) {
+        // RFC 5246 section 7.3: In an abbreviated handshake the keys are derived from the resumed master secret,
+        // and the server's ChangeCipherSpec and Finished follow right away.
+        dbgln_if(TLS_DEBUG, "Resuming session");
+        m_context.session_resumed = true;
+        m_context.master_key = m_context.session_to_resume->master_key;
+        expand_key();
+        m_context.connection_status = ConnectionStatus::KeyExchange;
+    }
+
     return res;
 }
 
@@ -193,13 +217,38 @@ ssize_t TLSv12::handle_server_hello_done(ReadonlyBytes buffer)
     return size + 3;
 }
 
+ssize_t TLSv12::handle_new_session_ticket(ReadonlyBytes buffer)
+{
+    // RFC 5077 section 3.3
+    if (buffer.size() < 3)
+        return (i8)Error::NeedMoreData;
+
+    size_t size = buffer[0] * 0x10000 + buffer[1] * 0x100 + buffer[2];
+    if (buffer.size() - 3 < size)
+        return (i8)Error::NeedMoreData;
+    if (size < 6)
+        return (i8)Error::BrokenPacket;
+
+    auto lifetime_hint = AK::convert_between_host_and_network_endian(ByteReader::load32(buffer.offset_pointer(3)));
+    size_t ticket_length = AK::convert_between_host_and_network_endian(ByteReader::load16(buffer.offset_pointer(7)));
+    if (size < 6 + ticket_length)
+        return (i8)Error::BrokenPacket;
+
+    // An empty ticket means the server changed its mind about giving us one.
+    m_context.session_ticket = ByteBuffer::copy(buffer.offset_pointer(9), ticket_length);
+    m_context.session_ticket_lifetime_hint = lifetime_hint;
+    dbgln_if(TLS_DEBUG, "New session ticket of {} bytes, lifetime hint {}s", ticket_length, lifetime_hint);
+
+    return size + 3;
+}
+
 ByteBuffer TLSv12::build_server_key_exchange()
 {
     dbgln("FIXME: build_server_key_exchange");
     return {};
 }
 
-ssize_t TLSv12::handle_server_key_exchange(ReadonlyBytes)
+ssize_t TLSv12::handle_server_key_exchange(ReadonlyBytes buffer)
 {
     switch (get_key_exchange_algorithm(m_context.cipher)) {
     case KeyExchangeAlgorithm::RSA:
@@ -222,11 +271,12 @@ ssize_t TLSv12::handle_server_key_exchange(ReadonlyBytes)
         TODO();
         break;
     case KeyExchangeAlgorithm::ECDHE_RSA:
+        return handle_ecdhe_rsa_server_key_exchange(buffer);
     case KeyExchangeAlgorithm::ECDH_ECDSA:
     case KeyExchangeAlgorithm::ECDH_RSA:
     case KeyExchangeAlgorithm::ECDHE_ECDSA:
     case KeyExchangeAlgorithm::ECDH_anon:
-        dbgln("Server key exchange for ECDHE algorithms is not implemented");
+        dbgln("Server key exchange for ECDH/ECDSA algorithms is not implemented");
         TODO();
         break;
     default:
@@ -237,4 +287,93 @@ ssize_t TLSv12::handle_server_key_exchange(ReadonlyBytes)
     return 0;
 }
 
+ssize_t TLSv12::handle_ecdhe_rsa_server_key_exchange(ReadonlyBytes buffer)
+{
+    // RFC 8422 section 5.4: ServerECDHParams followed by a digitally-signed struct.
+    if (buffer.size() < 3)
+        return (i8)Error::NeedMoreData;
+
+    size_t size = buffer[0] * 0x10000 + buffer[1] * 0x100 + buffer[2];
+    if (buffer.size() - 3 < size)
+        return (i8)Error::NeedMoreData;
+
+    auto payload = buffer.slice(3, size);
+    if (payload.size() < 4)
+        return (i8)Error::BrokenPacket;
+
+    if ((ECCurveType)payload[0] != ECCurveType::NamedCurve) {
+        dbgln("Server key exchange uses an unsupported curve type {}", payload[0]);
+        return (i8)Error::NotUnderstood;
+    }
+
+    auto curve = (NamedCurve)AK::convert_between_host_and_network_endian(ByteReader::load16(payload.offset_pointer(1)));
+    if (!m_context.options.elliptic_curves.contains_slow(curve)) {
+        dbgln("Server key exchange uses a curve we did not offer: {}", (u16)curve);
+        return (i8)Error::NotUnderstood;
+    }
+
+    size_t public_key_length = payload[3];
+    size_t params_length = 4 + public_key_length;
+    if (payload.size() < params_length + 4)
+        return (i8)Error::BrokenPacket;
+
+    auto params = payload.slice(0, params_length);
+    auto public_key = payload.slice(4, public_key_length);
+
+    auto hash = (HashAlgorithm)payload[params_length];
+    auto signature_algorithm = (SignatureAlgorithm)payload[params_length + 1];
+    size_t signature_length = AK::convert_between_host_and_network_endian(ByteReader::load16(payload.offset_pointer(params_length + 2)));
+    if (payload.size() < params_length + 4 + signature_length)
+        return (i8)Error::BrokenPacket;
+    auto signature = payload.slice(params_length + 4, signature_length);
+
+    if (signature_algorithm != SignatureAlgorithm::RSA) {
+        dbgln("Server key exchange is signed with an unsupported algorithm {}", (u8)signature_algorithm);
+        return (i8)Error::NotUnderstood;
+    }
+
+    const auto& certificate_option = verify_chain_and_get_matching_certificate(m_context.extensions.SNI);
+    if (!certificate_option.has_value()) {
+        dbgln("certificate verification failed :(");
+        return (i8)Error::BadCertificate;
+    }
+    auto& certificate = m_context.certificates[certificate_option.value()];
+
+    // The signature covers client_random + server_random + ServerECDHParams.
+    auto signed_data = ByteBuffer::create_uninitialized(sizeof(m_context.local_random) + sizeof(m_context.remote_random) + params.size());
+    signed_data.overwrite(0, m_context.local_random, sizeof(m_context.local_random));
+    signed_data.overwrite(sizeof(m_context.local_random), m_context.remote_random, sizeof(m_context.remote_random));
+    signed_data.overwrite(sizeof(m_context.local_random) + sizeof(m_context.remote_random), params.data(), params.size());
+
+    Crypto::PK::RSA rsa(certificate.public_key.modulus(), 0, certificate.public_key.public_exponent());
+    auto verification = Crypto::VerificationConsistency::Inconsistent;
+    switch (hash) {
+    case HashAlgorithm::SHA1:
+        verification = Crypto::PK::RSA_EMSA_PKCS1_V1_5<Crypto::Hash::SHA1>(rsa).verify(signed_data, signature);
+        break;
+    case HashAlgorithm::SHA256:
+        verification = Crypto::PK::RSA_EMSA_PKCS1_V1_5<Crypto::Hash::SHA256>(rsa).verify(signed_data, signature);
+        break;
+    case HashAlgorithm::SHA384:
+        verification = Crypto::PK::RSA_EMSA_PKCS1_V1_5<Crypto::Hash::SHA384>(rsa).verify(signed_data, signature);
+        break;
+    case HashAlgorithm::SHA512:
+        verification = Crypto::PK::RSA_EMSA_PKCS1_V1_5<Crypto::Hash::SHA512>(rsa).verify(signed_data, signature);
+        break;
+    default:
+        dbgln("Server key exchange is signed with an unsupported hash {}", (u8)hash);
+        return (i8)Error::NotUnderstood;
+    }
+
+    if (verification != Crypto::VerificationConsistency::Consistent) {
+        dbgln("Server key exchange signature verification failed");
+        return (i8)Error::NotVerified;
+    }
+
+    m_context.server_key_exchange_curve = curve;
+    m_context.server_key_exchange_public_key = ByteBuffer::copy(public_key.data(), public_key.size());
+
+    return size + 3;
+}
+
 }
@@ -182,6 +182,25 @@ void TLSv12::set_root_certificates(Vector<Certificate> certificates)
     m_context.root_ceritificates = move(certificates);
 }
 
+void TLSv12::set_session_to_resume(Session session)
+{
+    if (m_context.is_server || m_context.connection_status != ConnectionStatus::Disconnected) {
+        dbgln("invalid state for set_session_to_resume");
+        return;
+    }
+
+    if (session.master_key.size() != 48 || !m_context.options.usable_cipher_suites.contains_slow(session.cipher))
+        return;
+    if (!m_context.options.use_session_tickets)
+        session.ticket.clear();
+    if (session.session_id.is_empty() && session.ticket.is_empty())
+        return;
+    if (session.session_id.size() > sizeof(m_context.session_id))
+        return;
+
+    m_context.session_to_resume = move(session);
+}
+
 bool Context::verify_chain() const
 {
     if (!options.validate_certificates)
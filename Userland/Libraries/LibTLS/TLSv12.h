@@ -121,6 +121,7 @@ enum HandshakeType {
     ClientHello = 0x01,
     ServerHello = 0x02,
     HelloVerifyRequest = 0x03,
+    NewSessionTicket = 0x04,
     CertificateMessage = 0x0b,
     ServerKeyExchange = 0x0c,
     CertificateRequest = 0x0d,
@@ -132,8 +133,11 @@ enum HandshakeType {
 
 enum class HandshakeExtension : u16 {
     ServerName = 0x00,
+    SupportedGroups = 0x0a,
+    ECPointFormats = 0x0b,
     ApplicationLayerProtocolNegotiation = 0x10,
     SignatureAlgorithms = 0x0d,
+    SessionTicket = 0x23,
 };
 
 enum class NameType : u8 {
@@ -164,12 +168,16 @@ enum ClientVerificationStaus {
 // 4 bytes of fixed IV, 8 random (nonce) bytes, 4 bytes for counter
 // GCM specifically asks us to transmit only the nonce, the counter is zero
 // and the fixed IV is derived from the premaster key.
-#define ENUMERATE_CIPHERS(C)                                                                                                                    \
-    C(true, CipherSuite::RSA_WITH_AES_128_CBC_SHA, KeyExchangeAlgorithm::RSA, CipherAlgorithm::AES_128_CBC, Crypto::Hash::SHA1, 16, false)      \
-    C(true, CipherSuite::RSA_WITH_AES_256_CBC_SHA, KeyExchangeAlgorithm::RSA, CipherAlgorithm::AES_256_CBC, Crypto::Hash::SHA1, 16, false)      \
-    C(true, CipherSuite::RSA_WITH_AES_128_CBC_SHA256, KeyExchangeAlgorithm::RSA, CipherAlgorithm::AES_128_CBC, Crypto::Hash::SHA256, 16, false) \
-    C(true, CipherSuite::RSA_WITH_AES_256_CBC_SHA256, KeyExchangeAlgorithm::RSA, CipherAlgorithm::AES_256_CBC, Crypto::Hash::SHA256, 16, false) \
-    C(true, CipherSuite::RSA_WITH_AES_128_GCM_SHA256, KeyExchangeAlgorithm::RSA, CipherAlgorithm::AES_128_GCM, Crypto::Hash::SHA256, 8, true)   \
+#define ENUMERATE_CIPHERS(C)                                                                                                                                   \
+    C(true, CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256, KeyExchangeAlgorithm::ECDHE_RSA, CipherAlgorithm::AES_128_GCM, Crypto::Hash::SHA256, 8, true)      \
+    C(true, CipherSuite::ECDHE_RSA_WITH_AES_256_GCM_SHA384, KeyExchangeAlgorithm::ECDHE_RSA, CipherAlgorithm::AES_256_GCM, Crypto::Hash::SHA384, 8, true)      \
+    C(false, CipherSuite::ECDHE_ECDSA_WITH_AES_128_GCM_SHA256, KeyExchangeAlgorithm::ECDHE_ECDSA, CipherAlgorithm::AES_128_GCM, Crypto::Hash::SHA256, 8, true) \
+    C(false, CipherSuite::ECDHE_ECDSA_WITH_AES_256_GCM_SHA384, KeyExchangeAlgorithm::ECDHE_ECDSA, CipherAlgorithm::AES_256_GCM, Crypto::Hash::SHA384, 8, true) \
+    C(true, CipherSuite::RSA_WITH_AES_128_CBC_SHA, KeyExchangeAlgorithm::RSA, CipherAlgorithm::AES_128_CBC, Crypto::Hash::SHA1, 16, false)                     \
+    C(true, CipherSuite::RSA_WITH_AES_256_CBC_SHA, KeyExchangeAlgorithm::RSA, CipherAlgorithm::AES_256_CBC, Crypto::Hash::SHA1, 16, false)                     \
+    C(true, CipherSuite::RSA_WITH_AES_128_CBC_SHA256, KeyExchangeAlgorithm::RSA, CipherAlgorithm::AES_128_CBC, Crypto::Hash::SHA256, 16, false)                \
+    C(true, CipherSuite::RSA_WITH_AES_256_CBC_SHA256, KeyExchangeAlgorithm::RSA, CipherAlgorithm::AES_256_CBC, Crypto::Hash::SHA256, 16, false)                \
+    C(true, CipherSuite::RSA_WITH_AES_128_GCM_SHA256, KeyExchangeAlgorithm::RSA, CipherAlgorithm::AES_128_GCM, Crypto::Hash::SHA256, 8, true)                  \
     C(true, CipherSuite::RSA_WITH_AES_256_GCM_SHA384, KeyExchangeAlgorithm::RSA, CipherAlgorithm::AES_256_GCM, Crypto::Hash::SHA384, 8, true)
 
 constexpr KeyExchangeAlgorithm get_key_exchange_algorithm(CipherSuite suite)
@@ -222,13 +230,28 @@ struct Options {
         { HashAlgorithm::SHA256, SignatureAlgorithm::RSA },
         { HashAlgorithm::SHA1, SignatureAlgorithm::RSA });
 
+    OPTION_WITH_DEFAULTS(Vector<NamedCurve>, elliptic_curves,
+        NamedCurve::x25519,
+        NamedCurve::secp256r1);
+
     OPTION_WITH_DEFAULTS(bool, use_sni, true)
+    OPTION_WITH_DEFAULTS(bool, use_session_tickets, true)
     OPTION_WITH_DEFAULTS(bool, use_compression, false)
     OPTION_WITH_DEFAULTS(bool, validate_certificates, true)
 
 #undef OPTION_WITH_DEFAULTS
 };
 
+// What a client needs to remember to resume a session with an abbreviated handshake,
+// either by session ID (RFC 5246 section 7.3) or with a session ticket (RFC 5077).
+struct Session {
+    ByteBuffer session_id;
+    ByteBuffer ticket;
+    u32 ticket_lifetime_hint { 0 };
+    CipherSuite cipher { CipherSuite::Invalid };
+    ByteBuffer master_key;
+};
+
 struct Context {
     String to_string() const;
     bool verify() const;
@@ -242,6 +265,10 @@ struct Context {
     u8 local_random[32];
     u8 session_id[32];
     u8 session_id_size { 0 };
+    ByteBuffer session_ticket;
+    u32 session_ticket_lifetime_hint { 0 };
+    Optional<Session> session_to_resume;
+    bool session_resumed { false };
     CipherSuite cipher;
     bool is_server { false };
     Vector<Certificate> certificates;
@@ -249,6 +276,8 @@ struct Context {
     Vector<Certificate> client_certificates;
     ByteBuffer master_key;
     ByteBuffer premaster_key;
+    NamedCurve server_key_exchange_curve { NamedCurve::x25519 };
+    ByteBuffer server_key_exchange_public_key;
     u8 cipher_spec_set { 0 };
     struct {
         int created { 0 };
@@ -290,7 +319,7 @@ struct Context {
     bool connection_finished { false };
 
     // message flags
-    u8 handshake_messages[11] { 0 };
+    u8 handshake_messages[12] { 0 };
     ByteBuffer user_data;
     Vector<Certificate> root_ceritificates;
 
@@ -332,6 +361,10 @@ public:
 
     ByteBuffer finish_build();
 
+    // Must be called before connect(); the server may still decline and do a full handshake.
+    void set_session_to_resume(Session);
+    bool is_session_resumed() const { return m_context.session_resumed; }
+
     const StringView& alpn() const { return m_context.negotiated_alpn; }
     void add_alpn(const StringView& alpn);
     bool has_alpn(const StringView& alpn) const;
@@ -370,6 +403,7 @@ public:
     Function<void()> on_tls_connected;
     Function<void()> on_tls_finished;
     Function<void(TLSv12&)> on_tls_certificate_request;
+    Function<void(const Session&)> on_tls_session_established;
 
 private:
     explicit TLSv12(Core::Object* parent, Options = {});
@@ -397,6 +431,7 @@ private:
     ByteBuffer build_change_cipher_spec();
     ByteBuffer build_verify_request();
     void build_rsa_pre_master_secret(PacketBuilder&);
+    void build_ecdhe_rsa_pre_master_secret(PacketBuilder&);
 
     bool flush();
     void write_into_socket();
@@ -408,7 +443,9 @@ private:
     ssize_t handle_handshake_finished(ReadonlyBytes, WritePacketStage&);
     ssize_t handle_certificate(ReadonlyBytes);
     ssize_t handle_server_key_exchange(ReadonlyBytes);
+    ssize_t handle_ecdhe_rsa_server_key_exchange(ReadonlyBytes);
     ssize_t handle_server_hello_done(ReadonlyBytes);
+    ssize_t handle_new_session_ticket(ReadonlyBytes);
     ssize_t handle_certificate_verify(ReadonlyBytes);
     ssize_t handle_handshake_payload(ReadonlyBytes);
     ssize_t handle_message(ReadonlyBytes);
@@ -487,6 +524,7 @@ private:
     bool expand_key();
 
     bool compute_master_secret_from_pre_master_secret(size_t length);
+    void did_establish_session();
 
     Optional<size_t> verify_chain_and_get_matching_certificate(const StringView& host) const;
 
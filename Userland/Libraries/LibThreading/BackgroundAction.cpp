@@ -7,59 +7,55 @@
 
 #include <AK/Queue.h>
 #include <LibThreading/BackgroundAction.h>
-#include <LibThreading/Mutex.h>
-#include <LibThreading/Thread.h>
-#include <unistd.h>
+#include <LibThreading/ThreadPool.h>
 
 static pthread_mutex_t s_mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t s_condition = PTHREAD_COND_INITIALIZER;
 static Queue<Function<void()>>* s_all_actions;
-static Threading::Thread* s_background_thread;
+// Whether one of the pool's workers is busy running the actions.
+static bool s_running_actions;
 
-static intptr_t background_thread_func()
-{
-    Vector<Function<void()>> actions;
-    while (true) {
-
-        pthread_mutex_lock(&s_mutex);
+namespace Threading {
 
-        while (s_all_actions->is_empty())
-            pthread_cond_wait(&s_condition, &s_mutex);
+// BackgroundActions are children of this until they are done, which keeps them alive.
+class BackgroundActionOwner final : public Core::Object {
+    C_OBJECT(BackgroundActionOwner);
+};
 
-        while (!s_all_actions->is_empty())
-            actions.append(s_all_actions->dequeue());
+}
 
+// The actions run one after the other, since some of them expect the ones that were started before them to be done.
+static void run_actions()
+{
+    while (true) {
+        pthread_mutex_lock(&s_mutex);
+        if (s_all_actions->is_empty()) {
+            s_running_actions = false;
+            pthread_mutex_unlock(&s_mutex);
+            return;
+        }
+        auto action = s_all_actions->dequeue();
         pthread_mutex_unlock(&s_mutex);
 
-        for (auto& action : actions)
-            action();
-
-        actions.clear();
+        action();
     }
 }
 
-static void init()
-{
-    s_all_actions = new Queue<Function<void()>>;
-    s_background_thread = &Threading::Thread::construct(background_thread_func).leak_ref();
-    s_background_thread->set_name("Background thread");
-    s_background_thread->start();
-}
-
-Threading::Thread& Threading::BackgroundActionBase::background_thread()
+Core::Object& Threading::BackgroundActionBase::background_action_owner()
 {
-    if (s_background_thread == nullptr)
-        init();
-    return *s_background_thread;
+    static auto& s_owner = BackgroundActionOwner::construct().leak_ref();
+    return s_owner;
 }
 
 void Threading::BackgroundActionBase::enqueue_work(Function<void()> work)
 {
-    if (s_all_actions == nullptr)
-        init();
-
     pthread_mutex_lock(&s_mutex);
+    if (s_all_actions == nullptr)
+        s_all_actions = new Queue<Function<void()>>;
     s_all_actions->enqueue(move(work));
-    pthread_cond_broadcast(&s_condition);
+    bool should_start_running = !s_running_actions;
+    s_running_actions = true;
     pthread_mutex_unlock(&s_mutex);
+
+    if (should_start_running)
+        ThreadPool::the().submit(run_actions);
 }
@@ -14,7 +14,6 @@
 #include <LibCore/Event.h>
 #include <LibCore/EventLoop.h>
 #include <LibCore/Object.h>
-#include <LibThreading/Thread.h>
 
 namespace Threading {
 
@@ -29,7 +28,7 @@ private:
     BackgroundActionBase() { }
 
     static void enqueue_work(Function<void()>);
-    static Thread& background_thread();
+    static Core::Object& background_action_owner();
 };
 
 template<typename Result>
@@ -59,7 +58,7 @@ public:
 
 private:
     BackgroundAction(Function<Result(BackgroundAction&)> action, Function<void(Result)> on_complete)
-        : Core::Object(&background_thread())
+        : Core::Object(&background_action_owner())
         , m_action(move(action))
         , m_on_complete(move(on_complete))
     {
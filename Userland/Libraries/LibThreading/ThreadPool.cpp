@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/String.h>
+#include <LibThreading/ThreadPool.h>
+#include <unistd.h>
+
+namespace Threading {
+
+// The worker that the current thread is, if any.
+static __thread void* s_current_worker;
+
+ThreadPool& ThreadPool::the()
+{
+    static ThreadPool* s_the = new ThreadPool(max(sysconf(_SC_NPROCESSORS_ONLN), 1l));
+    return *s_the;
+}
+
+class FutureCompletionReceiver final : public Core::Object {
+    C_OBJECT(FutureCompletionReceiver);
+};
+
+Core::Object& ThreadPool::completion_receiver()
+{
+    // This is never destroyed, so it doesn't matter which thread posts to it.
+    static auto& s_receiver = FutureCompletionReceiver::construct().leak_ref();
+    return s_receiver;
+}
+
+ThreadPool::ThreadPool(size_t worker_count)
+{
+    VERIFY(worker_count > 0);
+    for (size_t i = 0; i < worker_count; ++i)
+        m_workers.append(make<Worker>(*this, i));
+
+    for (auto& worker : m_workers) {
+        worker.thread = Thread::construct([this, &worker] { return run_worker(worker); }, String::formatted("Pool worker {}", worker.index));
+        worker.thread->start();
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    pthread_mutex_lock(&m_sleep_mutex);
+    m_exiting = true;
+    pthread_cond_broadcast(&m_wake_condition);
+    pthread_mutex_unlock(&m_sleep_mutex);
+
+    for (auto& worker : m_workers)
+        (void)worker.thread->join();
+}
+
+void ThreadPool::submit(Task task)
+{
+    auto* worker = current_worker();
+    if (!worker)
+        worker = &m_workers[m_next_worker_for_submission.fetch_add(1, AK::MemoryOrder::memory_order_relaxed) % m_workers.size()];
+    // Pairs with the check in run_worker(): either it sees the new task, or we see that it went to sleep.
+    m_queued_task_count.fetch_add(1);
+    push_task(*worker, move(task));
+    if (m_sleeping_worker_count.load() == 0)
+        return;
+    pthread_mutex_lock(&m_sleep_mutex);
+    pthread_cond_signal(&m_wake_condition);
+    pthread_mutex_unlock(&m_sleep_mutex);
+}
+
+void ThreadPool::push_task(Worker& worker, Task task)
+{
+    MutexLocker locker(worker.mutex);
+    worker.tasks.append(move(task));
+}
+
+Optional<ThreadPool::Task> ThreadPool::take_newest_task(Worker& worker)
+{
+    MutexLocker locker(worker.mutex);
+    if (worker.first_task == worker.tasks.size())
+        return {};
+    auto task = worker.tasks.take_last();
+    if (worker.first_task == worker.tasks.size()) {
+        worker.tasks.clear_with_capacity();
+        worker.first_task = 0;
+    }
+    return task;
+}
+
+Optional<ThreadPool::Task> ThreadPool::take_oldest_task(Worker& worker)
+{
+    MutexLocker locker(worker.mutex);
+    if (worker.first_task == worker.tasks.size())
+        return {};
+    auto task = move(worker.tasks[worker.first_task++]);
+    if (worker.first_task == worker.tasks.size()) {
+        worker.tasks.clear_with_capacity();
+        worker.first_task = 0;
+    }
+    return task;
+}
+
+ThreadPool::Worker* ThreadPool::current_worker() const
+{
+    auto* worker = static_cast<Worker*>(s_current_worker);
+    if (!worker || &worker->pool != this)
+        return nullptr;
+    return worker;
+}
+
+Optional<ThreadPool::Task> ThreadPool::find_task(Worker* worker)
+{
+    if (m_queued_task_count.load(AK::MemoryOrder::memory_order_relaxed) == 0)
+        return {};
+
+    if (worker) {
+        if (auto task = take_newest_task(*worker); task.has_value()) {
+            m_queued_task_count.fetch_sub(1, AK::MemoryOrder::memory_order_relaxed);
+            return task;
+        }
+    }
+
+    // Start looking at a different worker every time, so that the thieves don't all gang up on the same one.
+    size_t start = worker ? worker->index + 1 : m_next_worker_for_submission.load(AK::MemoryOrder::memory_order_relaxed);
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        auto& victim = m_workers[(start + i) % m_workers.size()];
+        if (&victim == worker)
+            continue;
+        if (auto task = take_oldest_task(victim); task.has_value()) {
+            m_queued_task_count.fetch_sub(1, AK::MemoryOrder::memory_order_relaxed);
+            m_steal_count.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+            return task;
+        }
+    }
+    return {};
+}
+
+bool ThreadPool::run_one_task()
+{
+    auto task = find_task(current_worker());
+    if (!task.has_value())
+        return false;
+    (*task)();
+    return true;
+}
+
+intptr_t ThreadPool::run_worker(Worker& worker)
+{
+    s_current_worker = &worker;
+    for (;;) {
+        if (auto task = find_task(&worker); task.has_value()) {
+            (*task)();
+            continue;
+        }
+
+        pthread_mutex_lock(&m_sleep_mutex);
+        m_sleeping_worker_count.fetch_add(1);
+        while (m_queued_task_count.load() == 0 && !m_exiting)
+            pthread_cond_wait(&m_wake_condition, &m_sleep_mutex);
+        m_sleeping_worker_count.fetch_sub(1);
+        bool exiting = m_exiting;
+        pthread_mutex_unlock(&m_sleep_mutex);
+        if (exiting)
+            return 0;
+    }
+}
+
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Function.h>
+#include <AK/NonnullOwnPtrVector.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/Optional.h>
+#include <AK/RefCounted.h>
+#include <AK/StdLibExtras.h>
+#include <AK/Vector.h>
+#include <LibCore/Event.h>
+#include <LibCore/EventLoop.h>
+#include <LibCore/Object.h>
+#include <LibThreading/Mutex.h>
+#include <LibThreading/Thread.h>
+#include <pthread.h>
+#include <sched.h>
+
+namespace Threading {
+
+template<typename Result>
+class Future;
+
+// Runs small tasks on a fixed set of worker threads. Every worker has a queue of its own, and takes the most
+// recently added task from it, since its data is most likely still in the cache. Workers that run out of work
+// steal the oldest tasks from the others. Tasks submitted from a worker go to its own queue, the ones submitted
+// from other threads are spread over all of them.
+class ThreadPool {
+    AK_MAKE_NONCOPYABLE(ThreadPool);
+    AK_MAKE_NONMOVABLE(ThreadPool);
+
+public:
+    using Task = Function<void()>;
+
+    // Shared by the whole process, with one worker per CPU.
+    static ThreadPool& the();
+
+    explicit ThreadPool(size_t worker_count);
+    ~ThreadPool();
+
+    size_t worker_count() const { return m_workers.size(); }
+
+    // How many tasks were taken from another worker's queue so far.
+    u64 steal_count() const { return m_steal_count.load(AK::MemoryOrder::memory_order_relaxed); }
+
+    void submit(Task);
+
+    // Calls callback(index) for every index in [begin, end). The range is split into a few chunks per worker,
+    // which are at least grain_size indices long. The calling thread works on them too, so this can be used
+    // from inside of another task.
+    template<typename Callback>
+    void parallel_for(size_t begin, size_t end, Callback callback, size_t grain_size = 1);
+
+    // Folds the values of map(index) for every index in [begin, end) with combine(), starting from identity.
+    // Each chunk is folded separately, and then the results of the chunks in order, so combine() has to be
+    // associative, but not commutative.
+    template<typename Result, typename MapCallback, typename CombineCallback>
+    Result parallel_reduce(size_t begin, size_t end, Result identity, MapCallback map, CombineCallback combine, size_t grain_size = 1);
+
+    // Runs work() on the pool. If there is an on_complete() callback, it is called with the result
+    // on the event loop of the calling thread.
+    template<typename Result>
+    NonnullRefPtr<Future<Result>> async(Function<Result()> work, Function<void(Result&)> on_complete = nullptr);
+
+    // Runs tasks from the pool until the condition is met, instead of just sitting around waiting for it.
+    template<typename Condition>
+    void help_until(Condition condition)
+    {
+        while (!condition()) {
+            if (!run_one_task())
+                sched_yield();
+        }
+    }
+
+private:
+    template<typename>
+    friend class Future;
+
+    static constexpr size_t chunks_per_worker = 4;
+
+    // Futures post their completion callbacks to this, since events have to be delivered to a Core::Object.
+    static Core::Object& completion_receiver();
+
+    struct Worker {
+        Worker(ThreadPool& pool, size_t index)
+            : pool(pool)
+            , index(index)
+        {
+        }
+
+        ThreadPool& pool;
+        size_t index { 0 };
+        RefPtr<Thread> thread;
+
+        Mutex mutex;
+        // The owner adds and takes tasks at the end, thieves take them from the front.
+        Vector<Task> tasks;
+        // Tasks before this one were stolen already.
+        size_t first_task { 0 };
+    };
+
+    static void push_task(Worker&, Task);
+    static Optional<Task> take_newest_task(Worker&);
+    static Optional<Task> take_oldest_task(Worker&);
+
+    Worker* current_worker() const;
+    Optional<Task> find_task(Worker* worker);
+    bool run_one_task();
+    intptr_t run_worker(Worker&);
+
+    NonnullOwnPtrVector<Worker> m_workers;
+    Atomic<size_t> m_next_worker_for_submission { 0 };
+    Atomic<u64> m_steal_count { 0 };
+
+    // Tasks that were submitted, but haven't been taken from a queue yet.
+    Atomic<size_t> m_queued_task_count { 0 };
+    Atomic<size_t> m_sleeping_worker_count { 0 };
+    pthread_mutex_t m_sleep_mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t m_wake_condition = PTHREAD_COND_INITIALIZER;
+    bool m_exiting { false };
+};
+
+// The result of ThreadPool::async(). This isn't a Core::Object, since the last reference may well be dropped on a worker.
+template<typename Result>
+class Future final : public RefCounted<Future<Result>> {
+public:
+    bool is_resolved() const { return m_resolved.load(AK::MemoryOrder::memory_order_acquire); }
+
+    // Blocks until the result is there, and works on the pool's tasks in the meantime.
+    Result& await()
+    {
+        m_pool.help_until([this] { return is_resolved(); });
+        return m_result.value();
+    }
+
+private:
+    friend class ThreadPool;
+
+    Future(ThreadPool& pool, Function<void(Result&)> on_complete)
+        : m_pool(pool)
+        , m_on_complete(move(on_complete))
+    {
+        if (m_on_complete) {
+            m_event_loop = &Core::EventLoop::current();
+            m_receiver = &ThreadPool::completion_receiver();
+        }
+    }
+
+    void resolve(Result result)
+    {
+        m_result = move(result);
+        m_resolved.store(true, AK::MemoryOrder::memory_order_release);
+        if (!m_on_complete)
+            return;
+        m_event_loop->post_event(*m_receiver, make<Core::DeferredInvocationEvent>([self = NonnullRefPtr<Future>(*this)](auto&) mutable {
+            self->m_on_complete(self->m_result.value());
+        }));
+        Core::EventLoop::wake();
+    }
+
+    ThreadPool& m_pool;
+    Function<void(Result&)> m_on_complete;
+    Core::EventLoop* m_event_loop { nullptr };
+    Core::Object* m_receiver { nullptr };
+    Optional<Result> m_result;
+    Atomic<bool> m_resolved { false };
+};
+
+template<typename Callback>
+void ThreadPool::parallel_for(size_t begin, size_t end, Callback callback, size_t grain_size)
+{
+    if (begin >= end)
+        return;
+
+    size_t count = end - begin;
+    size_t chunk_size = max(grain_size, ceil_div(count, worker_count() * chunks_per_worker));
+    size_t chunk_count = ceil_div(count, chunk_size);
+    auto run_chunk = [&](size_t chunk) {
+        size_t chunk_begin = begin + chunk * chunk_size;
+        size_t chunk_end = min(chunk_begin + chunk_size, end);
+        for (size_t index = chunk_begin; index < chunk_end; ++index)
+            callback(index);
+    };
+
+    Atomic<size_t> remaining_chunks { chunk_count - 1 };
+    for (size_t chunk = 1; chunk < chunk_count; ++chunk) {
+        submit([&, chunk] {
+            run_chunk(chunk);
+            remaining_chunks.fetch_sub(1, AK::MemoryOrder::memory_order_acq_rel);
+        });
+    }
+    run_chunk(0);
+    help_until([&] { return remaining_chunks.load(AK::MemoryOrder::memory_order_acquire) == 0; });
+}
+
+template<typename Result, typename MapCallback, typename CombineCallback>
+Result ThreadPool::parallel_reduce(size_t begin, size_t end, Result identity, MapCallback map, CombineCallback combine, size_t grain_size)
+{
+    if (begin >= end)
+        return identity;
+
+    size_t count = end - begin;
+    size_t chunk_size = max(grain_size, ceil_div(count, worker_count() * chunks_per_worker));
+    size_t chunk_count = ceil_div(count, chunk_size);
+    Vector<Result> chunk_results;
+    chunk_results.resize(chunk_count);
+    parallel_for(
+        0, chunk_count, [&](size_t chunk) {
+            size_t chunk_begin = begin + chunk * chunk_size;
+            size_t chunk_end = min(chunk_begin + chunk_size, end);
+            Result result = identity;
+            for (size_t index = chunk_begin; index < chunk_end; ++index)
+                result = combine(move(result), map(index));
+            chunk_results[chunk] = move(result);
+        });
+
+    Result result = move(identity);
+    for (auto& chunk_result : chunk_results)
+        result = combine(move(result), move(chunk_result));
+    return result;
+}
+
+template<typename Result>
+NonnullRefPtr<Future<Result>> ThreadPool::async(Function<Result()> work, Function<void(Result&)> on_complete)
+{
+    auto future = adopt_ref(*new Future<Result>(*this, move(on_complete)));
+    submit([future, work = move(work)]() mutable {
+        future->resolve(work());
+    });
+    return future;
+}
+
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Debug.h>
+#include <AK/HashMap.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Queue.h>
+#include <AK/String.h>
+#include <AK/URL.h>
+#include <AK/Vector.h>
+#include <AK/WeakPtr.h>
+#include <LibCore/Timer.h>
+
+namespace RequestServer {
+
+// Keeps the connections that finished jobs leave open, so that later requests to the same origin
+// can skip the TCP (and TLS) handshake, and limits how many connections are open to each origin.
+// Jobs that would go over the limit wait for one of the others to release its connection.
+template<typename JobType, typename SocketType>
+class ConnectionPool {
+public:
+    // Same as what most browsers do.
+    static constexpr size_t max_connections_per_origin = 6;
+    // Servers usually time out idle connections after somewhere between 5 seconds and a few minutes.
+    // Reusing one the server has already closed costs a round trip, so don't hold on to them for too long.
+    static constexpr int idle_connection_timeout_ms = 10'000;
+
+    void start_job(JobType& job, const URL& url)
+    {
+        auto key = String::formatted("{}:{}", url.host(), url.port());
+        auto& origin = ensure_origin(key);
+
+        if (!origin.idle_connections.is_empty()) {
+            dbgln_if(REQUESTSERVER_DEBUG, "ConnectionPool: Reusing a connection to {}", key);
+            start_job(job, key, origin, take_idle_connection(origin));
+            return;
+        }
+
+        if (origin.active_jobs >= max_connections_per_origin) {
+            dbgln_if(REQUESTSERVER_DEBUG, "ConnectionPool: Already {} connections to {}, waiting for one to free up", origin.active_jobs, key);
+            origin.waiting_jobs.enqueue(job.template make_weak_ptr<JobType>());
+            return;
+        }
+
+        start_job(job, key, origin, nullptr);
+    }
+
+private:
+    struct IdleConnection {
+        NonnullRefPtr<SocketType> socket;
+        NonnullRefPtr<Core::Timer> timeout_timer;
+    };
+
+    struct Origin {
+        size_t active_jobs { 0 };
+        // Most recently used last, since that's the one the server is least likely to have closed.
+        Vector<IdleConnection> idle_connections;
+        Queue<WeakPtr<JobType>> waiting_jobs;
+    };
+
+    Origin& ensure_origin(const String& key)
+    {
+        if (auto it = m_origins.find(key); it != m_origins.end())
+            return *it->value;
+        auto origin = make<Origin>();
+        auto& origin_ref = *origin;
+        m_origins.set(key, move(origin));
+        return origin_ref;
+    }
+
+    void start_job(JobType& job, const String& key, Origin& origin, RefPtr<SocketType> socket)
+    {
+        ++origin.active_jobs;
+        if (socket)
+            job.set_socket_to_reuse(socket.release_nonnull());
+        job.on_connection_released = [this, key](RefPtr<SocketType> socket) {
+            did_release_connection(key, move(socket));
+        };
+        job.start();
+    }
+
+    void did_release_connection(const String& key, RefPtr<SocketType> socket)
+    {
+        auto& origin = ensure_origin(key);
+        VERIFY(origin.active_jobs > 0);
+        --origin.active_jobs;
+
+        // Hand the connection (or the slot it took up) straight to the next job in line, if there is one.
+        while (!origin.waiting_jobs.is_empty()) {
+            auto job = origin.waiting_jobs.dequeue().strong_ref();
+            // The request may have been cancelled while it was waiting.
+            if (!job)
+                continue;
+            start_job(*job, key, origin, move(socket));
+            return;
+        }
+
+        if (socket) {
+            dbgln_if(REQUESTSERVER_DEBUG, "ConnectionPool: Keeping a connection to {} around", key);
+            watch_idle_connection(key, *socket);
+            auto timeout_timer = Core::Timer::create_single_shot(
+                idle_connection_timeout_ms, [this, key, socket = socket.ptr()] {
+                    drop_idle_connection(key, *socket);
+                });
+            timeout_timer->start();
+            origin.idle_connections.append({ socket.release_nonnull(), move(timeout_timer) });
+            return;
+        }
+
+        if (origin.active_jobs == 0 && origin.idle_connections.is_empty())
+            m_origins.remove(key);
+    }
+
+    void watch_idle_connection(const String& key, SocketType& socket)
+    {
+        // An idle connection shouldn't have anything to say, so any activity means that the server closed it.
+        // Drop it later on, since we're called from inside the socket.
+        auto drop_later = [this, key, socket = &socket] {
+            socket->deferred_invoke([this, key](auto& object) {
+                drop_idle_connection(key, static_cast<SocketType&>(object));
+            });
+        };
+        if constexpr (requires { socket.on_tls_finished; }) {
+            socket.on_tls_ready_to_read = [drop_later](auto&) { drop_later(); };
+            socket.on_tls_error = [drop_later](auto) { drop_later(); };
+            socket.on_tls_finished = move(drop_later);
+        } else {
+            socket.on_ready_to_read = move(drop_later);
+        }
+    }
+
+    NonnullRefPtr<SocketType> take_idle_connection(Origin& origin)
+    {
+        auto connection = origin.idle_connections.take_last();
+        connection.timeout_timer->stop();
+        auto& socket = *connection.socket;
+        if constexpr (requires { socket.on_tls_finished; }) {
+            socket.on_tls_ready_to_read = nullptr;
+            socket.on_tls_error = nullptr;
+            socket.on_tls_finished = nullptr;
+        } else {
+            socket.on_ready_to_read = nullptr;
+        }
+        return move(connection.socket);
+    }
+
+    void drop_idle_connection(const String& key, SocketType& socket)
+    {
+        auto it = m_origins.find(key);
+        if (it == m_origins.end())
+            return;
+        auto& origin = *it->value;
+        origin.idle_connections.remove_first_matching([&](auto& connection) {
+            return connection.socket.ptr() == &socket;
+        });
+        dbgln_if(REQUESTSERVER_DEBUG, "ConnectionPool: Dropped an idle connection to {}", key);
+        if (origin.active_jobs == 0 && origin.idle_connections.is_empty() && origin.waiting_jobs.is_empty())
+            m_origins.remove(it);
+    }
+
+    HashMap<String, NonnullOwnPtr<Origin>> m_origins;
+};
+
+}
@@ -24,7 +24,9 @@ HttpProtocol::HttpProtocol()
 
 OwnPtr<Request> HttpProtocol::start_request(ClientConnection& client, const String& method, const URL& url, const HashMap<String, String>& headers, ReadonlyBytes body)
 {
-    return Detail::start_request(Badge<HttpProtocol> {}, client, method, url, headers, body, get_pipe_for_request());
+    return Detail::start_request(Badge<HttpProtocol> {}, client, method, url, headers, body, get_pipe_for_request(), [&](auto& job) {
+        m_connection_pool.start_job(job, url);
+    });
 }
 
 }
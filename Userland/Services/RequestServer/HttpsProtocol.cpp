@@ -14,6 +14,7 @@
 #include <RequestServer/HttpCommon.h>
 #include <RequestServer/HttpsProtocol.h>
 #include <RequestServer/Request.h>
+#include <time.h>
 
 namespace RequestServer {
 
@@ -24,7 +25,53 @@ HttpsProtocol::HttpsProtocol()
 
 OwnPtr<Request> HttpsProtocol::start_request(ClientConnection& client, const String& method, const URL& url, const HashMap<String, String>& headers, ReadonlyBytes body)
 {
-    return Detail::start_request(Badge<HttpsProtocol> {}, client, method, url, headers, body, get_pipe_for_request());
+    return Detail::start_request(Badge<HttpsProtocol> {}, client, method, url, headers, body, get_pipe_for_request(), [&](auto& job) {
+        prepare_job(job, url);
+        m_connection_pool.start_job(job, url);
+    });
+}
+
+static constexpr size_t max_cached_sessions = 64;
+// Servers keep session state for minutes to hours; don't bother offering anything older than this.
+static constexpr time_t max_session_lifetime = 60 * 60;
+
+void HttpsProtocol::prepare_job(JobType& job, const URL& url)
+{
+    auto key = String::formatted("{}:{}", url.host(), url.port());
+
+    if (auto cached = m_session_cache.get(key); cached.has_value()) {
+        if (cached->expires_at > time(nullptr))
+            job.set_tls_session_to_resume(cached->session);
+        else
+            m_session_cache.remove(key);
+    }
+
+    job.on_tls_session_established = [this, key = move(key)](auto& session) {
+        cache_session(key, session);
+    };
+}
+
+void HttpsProtocol::cache_session(const String& key, const TLS::Session& session)
+{
+    auto now = time(nullptr);
+
+    if (m_session_cache.size() >= max_cached_sessions && !m_session_cache.contains(key)) {
+        // Make room by dropping the session that expires first, which is usually an expired one anyway.
+        String victim;
+        time_t victim_expiry = 0;
+        for (auto& it : m_session_cache) {
+            if (victim.is_null() || it.value.expires_at < victim_expiry) {
+                victim = it.key;
+                victim_expiry = it.value.expires_at;
+            }
+        }
+        m_session_cache.remove(victim);
+    }
+
+    auto lifetime = max_session_lifetime;
+    if (!session.ticket.is_empty() && session.ticket_lifetime_hint != 0)
+        lifetime = min<time_t>(lifetime, session.ticket_lifetime_hint);
+    m_session_cache.set(key, { session, now + lifetime });
 }
 
 }
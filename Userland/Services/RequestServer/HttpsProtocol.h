@@ -13,6 +13,7 @@
 #include <AK/URL.h>
 #include <LibHTTP/HttpsJob.h>
 #include <RequestServer/ClientConnection.h>
+#include <RequestServer/ConnectionPool.h>
 #include <RequestServer/HttpsRequest.h>
 #include <RequestServer/Protocol.h>
 #include <RequestServer/Request.h>
@@ -28,6 +29,18 @@ public:
     ~HttpsProtocol() override = default;
 
     virtual OwnPtr<Request> start_request(ClientConnection&, const String& method, const URL&, const HashMap<String, String>& headers, ReadonlyBytes body) override;
+
+private:
+    void prepare_job(JobType&, const URL&);
+    void cache_session(const String& key, const TLS::Session&);
+
+    struct CachedSession {
+        TLS::Session session;
+        time_t expires_at { 0 };
+    };
+    // Sessions from earlier connections keyed by "host:port", so that reconnecting can skip the full TLS handshake.
+    HashMap<String, CachedSession> m_session_cache;
+    ConnectionPool<JobType, TLS::TLSv12> m_connection_pool;
 };
 
 }
@@ -12,6 +12,7 @@
 #include <RequestServer/GeminiProtocol.h>
 #include <RequestServer/HttpProtocol.h>
 #include <RequestServer/HttpsProtocol.h>
+#include <signal.h>
 
 int main(int, char**)
 {
@@ -20,6 +21,9 @@ int main(int, char**)
         return 1;
     }
 
+    // Pooled connections can be closed by the server at any time, which we'd rather find out about from write() failing.
+    signal(SIGPIPE, SIG_IGN);
+
     // Ensure the certificates are read out here.
     [[maybe_unused]] auto& certs = DefaultRootCACertificates::the();
 
@@ -45,19 +45,29 @@ void Client::die()
 void Client::start()
 {
     m_socket->on_ready_to_read = [this] {
-        StringBuilder builder;
-        for (;;) {
-            auto line = m_socket->read_line();
-            if (line.is_empty())
-                break;
-            builder.append(line);
-            builder.append("\r\n");
+        // A client that keeps the connection open may send its next request right away, before we get back here.
+        while (m_socket->can_read_line()) {
+            StringBuilder builder;
+            for (;;) {
+                auto line = m_socket->read_line();
+                if (line.is_empty())
+                    break;
+                builder.append(line);
+                builder.append("\r\n");
+            }
+
+            auto request = builder.to_byte_buffer();
+            dbgln_if(WEBSERVER_DEBUG, "Got raw request: '{}'", String::copy(request));
+            m_keep_alive = false;
+            handle_request(request);
+            if (!m_keep_alive) {
+                die();
+                return;
+            }
         }
 
-        auto request = builder.to_byte_buffer();
-        dbgln_if(WEBSERVER_DEBUG, "Got raw request: '{}'", String::copy(request));
-        handle_request(request);
-        die();
+        if (m_socket->eof())
+            die();
     };
 }
 
@@ -68,6 +78,11 @@ void Client::handle_request(ReadonlyBytes raw_request)
         return;
     auto& request = request_or_error.value();
 
+    for (auto& header : request.headers()) {
+        if (header.name.equals_ignoring_case("Connection"))
+            m_keep_alive = header.value.equals_ignoring_case("keep-alive");
+    }
+
     if constexpr (WEBSERVER_DEBUG) {
         dbgln("Got HTTP request: {} {}", request.method_name(), request.resource());
         for (auto& header : request.headers()) {
@@ -76,6 +91,8 @@ void Client::handle_request(ReadonlyBytes raw_request)
     }
 
     if (request.method() != HTTP::HttpRequest::Method::GET) {
+        // We don't read request bodies, so we wouldn't know where the next request starts.
+        m_keep_alive = false;
         send_error_response(501, request);
         return;
     }
@@ -131,12 +148,25 @@ void Client::handle_request(ReadonlyBytes raw_request)
         return;
     }
 
+    struct stat st;
+    if (fstat(file->fd(), &st) < 0) {
+        perror("fstat");
+        send_error_response(500, request);
+        return;
+    }
+
     Core::InputFileStream stream { file };
 
-    send_response(stream, request, Core::guess_mime_type_based_on_filename(real_path));
+    send_response(stream, request, Core::guess_mime_type_based_on_filename(real_path), st.st_size);
 }
 
-void Client::send_response(InputStream& response, HTTP::HttpRequest const& request, String const& content_type)
+void Client::append_connection_header(StringBuilder& builder) const
+{
+    // The length of every response is known up front, so the client can tell where it ends without us closing the connection.
+    builder.append(m_keep_alive ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
+}
+
+void Client::send_response(InputStream& response, HTTP::HttpRequest const& request, String const& content_type, size_t content_length)
 {
     StringBuilder builder;
     builder.append("HTTP/1.0 200 OK\r\n");
@@ -147,6 +177,8 @@ void Client::send_response(InputStream& response, HTTP::HttpRequest const& reque
     builder.append("Content-Type: ");
     builder.append(content_type);
     builder.append("\r\n");
+    builder.appendff("Content-Length: {}\r\n", content_length);
+    append_connection_header(builder);
     builder.append("\r\n");
 
     m_socket->write(builder.to_string());
@@ -169,6 +201,8 @@ void Client::send_redirect(StringView redirect_path, HTTP::HttpRequest const& re
     builder.append("Location: ");
     builder.append(redirect_path);
     builder.append("\r\n");
+    builder.append("Content-Length: 0\r\n");
+    append_connection_header(builder);
     builder.append("\r\n");
 
     m_socket->write(builder.to_string());
@@ -273,7 +307,7 @@ void Client::handle_directory_listing(String const& requested_path, String const
 
     auto response = builder.to_string();
     InputMemoryStream stream { response.bytes() };
-    send_response(stream, request, "text/html");
+    send_response(stream, request, "text/html", response.length());
 }
 
 void Client::send_error_response(unsigned code, HTTP::HttpRequest const& request, Vector<String> const& headers)
@@ -289,11 +323,17 @@ void Client::send_error_response(unsigned code, HTTP::HttpRequest const& request
         builder.append("\r\n");
     }
 
+    StringBuilder body_builder;
+    body_builder.append("<!DOCTYPE html><html><body><h1>");
+    body_builder.appendff("{} ", code);
+    body_builder.append(reason_phrase);
+    body_builder.append("</h1></body></html>");
+    auto body = body_builder.to_string();
+
+    builder.appendff("Content-Length: {}\r\n", body.length());
+    append_connection_header(builder);
     builder.append("\r\n");
-    builder.append("<!DOCTYPE html><html><body><h1>");
-    builder.appendff("{} ", code);
-    builder.append(reason_phrase);
-    builder.append("</h1></body></html>");
+    builder.append(body);
     m_socket->write(builder.to_string());
 
     log_response(code, request);
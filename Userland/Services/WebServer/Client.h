@@ -22,15 +22,18 @@ private:
     Client(NonnullRefPtr<Core::TCPSocket>, Core::Object* parent);
 
     void handle_request(ReadonlyBytes);
-    void send_response(InputStream&, HTTP::HttpRequest const&, String const& content_type);
+    void send_response(InputStream&, HTTP::HttpRequest const&, String const& content_type, size_t content_length);
     void send_redirect(StringView redirect, HTTP::HttpRequest const&);
     void send_error_response(unsigned code, HTTP::HttpRequest const&, Vector<String> const& headers = {});
     void die();
     void log_response(unsigned code, HTTP::HttpRequest const&);
     void handle_directory_listing(String const& requested_path, String const& real_path, HTTP::HttpRequest const&);
     bool verify_credentials(Vector<HTTP::HttpRequest::Header> const&);
+    void append_connection_header(StringBuilder&) const;
 
     NonnullRefPtr<Core::TCPSocket> m_socket;
+    // Whether the client asked us to leave the connection open for further requests.
+    bool m_keep_alive { false };
 };
 
 }
@@ -21,6 +21,8 @@
 #include <LibGfx/Painter.h>
 #include <LibGfx/StylePainter.h>
 #include <LibThreading/BackgroundAction.h>
+#include <LibThreading/ThreadPool.h>
+#include <time.h>
 
 namespace WindowServer {
 
@@ -152,6 +154,49 @@ Gfx::IntPoint Compositor::window_transition_offset(Window& window)
     return window.window_stack().transition_offset();
 }
 
+static Time monotonic_now()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return Time::from_timespec(now);
+}
+
+void Compositor::record_compose_time(Time const& compose_start)
+{
+    auto compose_time = (u64)(monotonic_now() - compose_start).to_microseconds();
+    m_statistics.last_compose_time_us = compose_time;
+    m_statistics.max_compose_time_us = max(m_statistics.max_compose_time_us, compose_time);
+    if (m_statistics.frame_count == 0)
+        m_statistics.average_compose_time_us = compose_time;
+    else
+        m_statistics.average_compose_time_us = (m_statistics.average_compose_time_us * 15 + compose_time) / 16;
+    ++m_statistics.frame_count;
+}
+
+Vector<Compositor::ComposeTile> Compositor::compose_tiles() const
+{
+    // A few tiles per worker, so that the ones that are done early can help out with the rest.
+    auto worker_count = Threading::ThreadPool::the().worker_count();
+    int tiles_per_screen = worker_count > 1 ? (int)worker_count * 2 : 1;
+
+    Vector<ComposeTile> tiles;
+    Screen::for_each([&](auto& screen) {
+        auto screen_rect = screen.rect();
+        int tile_count = clamp(screen_rect.height() / minimum_tile_height, 1, tiles_per_screen);
+        int tile_height = ceil_div(screen_rect.height(), tile_count);
+        for (int y = screen_rect.top(); y <= screen_rect.bottom(); y += tile_height)
+            tiles.append({ &screen, { screen_rect.x(), y, screen_rect.width(), min(tile_height, screen_rect.bottom() + 1 - y) } });
+        return IterationDecision::Continue;
+    });
+    return tiles;
+}
+
+void Compositor::ComposeTile::set_up_painter(Gfx::Painter& painter) const
+{
+    painter.translate(-screen->rect().location());
+    painter.add_clip_rect(rect);
+}
+
 void Compositor::compose()
 {
     auto& wm = WindowManager::the();
@@ -169,6 +214,8 @@ void Compositor::compose()
         return;
     }
 
+    auto compose_start = monotonic_now();
+
     if (m_occlusions_dirty) {
         m_occlusions_dirty = false;
         recompute_occlusions();
@@ -319,51 +366,35 @@ void Compositor::compose()
         }
     };
 
-    {
-        // Paint any desktop wallpaper rects that are not somehow underneath any window transparency
-        // rects and outside of any opaque window areas
-        m_opaque_wallpaper_rects.for_each_intersected(dirty_screen_rects, [&](auto& render_rect) {
-            Screen::for_each([&](auto& screen) {
-                auto screen_rect = screen.rect();
-                auto screen_render_rect = screen_rect.intersected(render_rect);
-                if (!screen_render_rect.is_empty()) {
-                    dbgln_if(COMPOSE_DEBUG, "  render wallpaper opaque: {} on screen #{}", screen_render_rect, screen.index());
-                    prepare_rect(screen, render_rect);
-                    auto& back_painter = *screen.compositor_screen_data().m_back_painter;
-                    paint_wallpaper(screen, back_painter, render_rect, screen_rect);
-                }
-                return IterationDecision::Continue;
-            });
-            return IterationDecision::Continue;
-        });
-        m_transparent_wallpaper_rects.for_each_intersected(dirty_screen_rects, [&](auto& render_rect) {
-            Screen::for_each([&](auto& screen) {
-                auto screen_rect = screen.rect();
-                auto screen_render_rect = screen_rect.intersected(render_rect);
-                if (!screen_render_rect.is_empty()) {
-                    dbgln_if(COMPOSE_DEBUG, "  render wallpaper transparent: {} on screen #{}", screen_render_rect, screen.index());
-                    prepare_transparency_rect(screen, render_rect);
-                    auto& temp_painter = *screen.compositor_screen_data().m_temp_painter;
-                    paint_wallpaper(screen, temp_painter, render_rect, screen_rect);
-                }
-                return IterationDecision::Continue;
-            });
+    enum class PaintTarget {
+        BackBuffer,
+        TempBuffer,
+    };
+
+    auto* fullscreen_window = wm.active_fullscreen_window();
+    auto for_each_window_to_compose = [&](auto callback) {
+        if (fullscreen_window && fullscreen_window->is_opaque()) {
+            callback(*fullscreen_window);
+            return;
+        }
+        wm.for_each_visible_window_from_back_to_front([&](Window& window) {
+            callback(window);
             return IterationDecision::Continue;
         });
-    }
+    };
 
-    auto compose_window = [&](Window& window) -> IterationDecision {
+    auto window_color = wm.palette().window();
+
+    auto compose_window = [&](Window& window, auto& callback) {
         if (window.screens().is_empty()) {
             // This window doesn't intersect with any screens, so there's nothing to render
-            return IterationDecision::Continue;
+            return;
         }
         auto transition_offset = window_transition_offset(window);
         auto frame_rect = window.frame().render_rect().translated(transition_offset);
         auto window_rect = window.rect().translated(transition_offset);
         auto frame_rects = frame_rect.shatter(window_rect);
 
-        dbgln_if(COMPOSE_DEBUG, "  window {} frame rect: {}", window.title(), frame_rect);
-
         RefPtr<Gfx::Bitmap> backing_store = window.backing_store();
         auto compose_window_rect = [&](Screen& screen, Gfx::Painter& painter, const Gfx::IntRect& rect) {
             if (!window.is_fullscreen()) {
@@ -371,14 +402,13 @@ void Compositor::compose()
                     Gfx::PainterStateSaver saver(painter);
                     painter.add_clip_rect(intersected_rect);
                     painter.translate(transition_offset);
-                    dbgln_if(COMPOSE_DEBUG, "    render frame: {}", intersected_rect);
                     window.frame().paint(screen, painter, intersected_rect.translated(-transition_offset));
                     return IterationDecision::Continue;
                 });
             }
 
             auto clear_window_rect = [&](const Gfx::IntRect& clear_rect) {
-                auto fill_color = wm.palette().window();
+                auto fill_color = window_color;
                 if (!window.is_opaque())
                     fill_color.set_alpha(255 * window.opacity());
                 painter.fill_rect(clear_rect, fill_color);
@@ -453,15 +483,6 @@ void Compositor::compose()
 
         auto& dirty_rects = window.dirty_rects();
 
-        if constexpr (COMPOSE_DEBUG) {
-            for (auto& dirty_rect : dirty_rects.rects())
-                dbgln("    dirty: {}", dirty_rect);
-            for (auto& r : window.opaque_rects().rects())
-                dbgln("    opaque: {}", r);
-            for (auto& r : window.transparency_rects().rects())
-                dbgln("    transparent: {}", r);
-        }
-
         // Render opaque portions directly to the back buffer
         auto& opaque_rects = window.opaque_rects();
         if (!opaque_rects.is_empty()) {
@@ -470,13 +491,11 @@ void Compositor::compose()
                     auto screen_render_rect = render_rect.intersected(screen->rect());
                     if (screen_render_rect.is_empty())
                         continue;
-                    dbgln_if(COMPOSE_DEBUG, "    render opaque: {} on screen #{}", screen_render_rect, screen->index());
-
-                    prepare_rect(*screen, screen_render_rect);
-                    auto& back_painter = *screen->compositor_screen_data().m_back_painter;
-                    Gfx::PainterStateSaver saver(back_painter);
-                    back_painter.add_clip_rect(screen_render_rect);
-                    compose_window_rect(*screen, back_painter, screen_render_rect);
+                    callback(*screen, PaintTarget::BackBuffer, screen_render_rect, [&](Gfx::Painter& back_painter) {
+                        Gfx::PainterStateSaver saver(back_painter);
+                        back_painter.add_clip_rect(screen_render_rect);
+                        compose_window_rect(*screen, back_painter, screen_render_rect);
+                    });
                 }
                 return IterationDecision::Continue;
             });
@@ -492,11 +511,9 @@ void Compositor::compose()
                     auto screen_render_rect = render_rect.intersected(screen_rect);
                     if (screen_render_rect.is_empty())
                         continue;
-                    dbgln_if(COMPOSE_DEBUG, "    render wallpaper: {} on screen #{}", screen_render_rect, screen->index());
-
-                    auto& temp_painter = *screen->compositor_screen_data().m_temp_painter;
-                    prepare_transparency_rect(*screen, screen_render_rect);
-                    paint_wallpaper(*screen, temp_painter, screen_render_rect, screen_rect);
+                    callback(*screen, PaintTarget::TempBuffer, screen_render_rect, [&](Gfx::Painter& temp_painter) {
+                        paint_wallpaper(*screen, temp_painter, screen_render_rect, screen_rect);
+                    });
                 }
                 return IterationDecision::Continue;
             });
@@ -509,33 +526,106 @@ void Compositor::compose()
                     auto screen_render_rect = render_rect.intersected(screen_rect);
                     if (screen_render_rect.is_empty())
                         continue;
-                    dbgln_if(COMPOSE_DEBUG, "    render transparent: {} on screen #{}", screen_render_rect, screen->index());
-
-                    prepare_transparency_rect(*screen, screen_render_rect);
-                    auto& temp_painter = *screen->compositor_screen_data().m_temp_painter;
-                    Gfx::PainterStateSaver saver(temp_painter);
-                    temp_painter.add_clip_rect(screen_render_rect);
-                    compose_window_rect(*screen, temp_painter, screen_render_rect);
+                    callback(*screen, PaintTarget::TempBuffer, screen_render_rect, [&](Gfx::Painter& temp_painter) {
+                        Gfx::PainterStateSaver saver(temp_painter);
+                        temp_painter.add_clip_rect(screen_render_rect);
+                        compose_window_rect(*screen, temp_painter, screen_render_rect);
+                    });
                 }
                 return IterationDecision::Continue;
             });
         }
-        return IterationDecision::Continue;
     };
 
-    // Paint the window stack.
-    if (m_invalidated_window) {
-        auto* fullscreen_window = wm.active_fullscreen_window();
-        if (fullscreen_window && fullscreen_window->is_opaque()) {
-            compose_window(*fullscreen_window);
-            fullscreen_window->clear_dirty_rects();
-        } else {
-            wm.for_each_visible_window_from_back_to_front([&](Window& window) {
-                compose_window(window);
-                window.clear_dirty_rects();
+    // Walks everything that has to be repainted from back to front, and calls callback() with the screen and the
+    // buffer it goes to, its rect, and a function that paints it.
+    auto for_each_paint_operation = [&](auto callback) {
+        // Paint any desktop wallpaper rects that are not somehow underneath any window transparency
+        // rects and outside of any opaque window areas
+        m_opaque_wallpaper_rects.for_each_intersected(dirty_screen_rects, [&](auto& render_rect) {
+            Screen::for_each([&](auto& screen) {
+                auto screen_rect = screen.rect();
+                auto screen_render_rect = screen_rect.intersected(render_rect);
+                if (!screen_render_rect.is_empty()) {
+                    callback(screen, PaintTarget::BackBuffer, render_rect, [&](Gfx::Painter& back_painter) {
+                        paint_wallpaper(screen, back_painter, render_rect, screen_rect);
+                    });
+                }
                 return IterationDecision::Continue;
             });
-        }
+            return IterationDecision::Continue;
+        });
+        m_transparent_wallpaper_rects.for_each_intersected(dirty_screen_rects, [&](auto& render_rect) {
+            Screen::for_each([&](auto& screen) {
+                auto screen_rect = screen.rect();
+                auto screen_render_rect = screen_rect.intersected(render_rect);
+                if (!screen_render_rect.is_empty()) {
+                    callback(screen, PaintTarget::TempBuffer, render_rect, [&](Gfx::Painter& temp_painter) {
+                        paint_wallpaper(screen, temp_painter, render_rect, screen_rect);
+                    });
+                }
+                return IterationDecision::Continue;
+            });
+            return IterationDecision::Continue;
+        });
+
+        // Paint the window stack.
+        if (m_invalidated_window)
+            for_each_window_to_compose([&](Window& window) { compose_window(window, callback); });
+    };
+
+    // Figure out what needs to be flushed first, which also restores what's behind the cursor before anything
+    // gets painted over it.
+    for_each_paint_operation([&](Screen& screen, PaintTarget target, const Gfx::IntRect& rect, auto&&) {
+        if (target == PaintTarget::BackBuffer)
+            prepare_rect(screen, rect);
+        else
+            prepare_transparency_rect(screen, rect);
+    });
+
+    if (m_invalidated_window) {
+        // The frames are painted from their caches by several threads at once, so they have to be up to date already.
+        for_each_window_to_compose([&](Window& window) {
+            if constexpr (COMPOSE_DEBUG) {
+                dbgln("  window {} frame rect: {}", window.title(), window.frame().render_rect().translated(window_transition_offset(window)));
+                for (auto& dirty_rect : window.dirty_rects().rects())
+                    dbgln("    dirty: {}", dirty_rect);
+                for (auto& r : window.opaque_rects().rects())
+                    dbgln("    opaque: {}", r);
+                for (auto& r : window.transparency_rects().rects())
+                    dbgln("    transparent: {}", r);
+            }
+            if (window.is_fullscreen() || window.dirty_rects().is_empty())
+                return;
+            for (auto* screen : window.screens())
+                window.frame().render_to_cache(*screen);
+        });
+    }
+
+    // Every tile replays the paint operations that intersect it, with painters of its own that are clipped to it.
+    // The flush rects never overlap and everything that is painted from is only read, so the tiles can be painted
+    // at the same time.
+    auto tiles = compose_tiles();
+    Threading::ThreadPool::the().parallel_for(0, tiles.size(), [&](size_t index) {
+        auto& tile = tiles[index];
+        auto& screen_data = tile.screen->compositor_screen_data();
+        if (!screen_data.m_have_flush_rects)
+            return;
+        Gfx::Painter back_painter(*screen_data.m_back_bitmap);
+        tile.set_up_painter(back_painter);
+        Gfx::Painter temp_painter(*screen_data.m_temp_bitmap);
+        tile.set_up_painter(temp_painter);
+        for_each_paint_operation([&](Screen& screen, PaintTarget target, const Gfx::IntRect& rect, auto&& paint) {
+            if (&screen != tile.screen || !rect.intersects(tile.rect))
+                return;
+            paint(target == PaintTarget::BackBuffer ? back_painter : temp_painter);
+        });
+    });
+
+    if (m_invalidated_window) {
+        for_each_window_to_compose([&](Window& window) {
+            window.clear_dirty_rects();
+        });
 
         // Check that there are no overlapping transparent and opaque flush rectangles
         VERIFY(![&]() {
@@ -564,12 +654,18 @@ void Compositor::compose()
         }
 
         // Copy anything rendered to the temporary buffer to the back buffer
-        Screen::for_each([&](auto& screen) {
-            auto screen_rect = screen.rect();
-            auto& screen_data = screen.compositor_screen_data();
-            for (auto& rect : screen_data.m_flush_transparent_rects.rects())
-                screen_data.m_back_painter->blit(rect.location(), *screen_data.m_temp_bitmap, rect.translated(-screen_rect.location()));
-            return IterationDecision::Continue;
+        Threading::ThreadPool::the().parallel_for(0, tiles.size(), [&](size_t index) {
+            auto& tile = tiles[index];
+            auto screen_rect = tile.screen->rect();
+            auto& screen_data = tile.screen->compositor_screen_data();
+            if (screen_data.m_flush_transparent_rects.is_empty())
+                return;
+            Gfx::Painter back_painter(*screen_data.m_back_bitmap);
+            tile.set_up_painter(back_painter);
+            for (auto& rect : screen_data.m_flush_transparent_rects.rects()) {
+                if (rect.intersects(tile.rect))
+                    back_painter.blit(rect.location(), *screen_data.m_temp_bitmap, rect.translated(-screen_rect.location()));
+            }
         });
     }
 
@@ -595,10 +691,12 @@ void Compositor::compose()
         screen_data.draw_cursor(cursor_screen, cursor_rect);
     }
 
-    Screen::for_each([&](auto& screen) {
-        flush(screen);
-        return IterationDecision::Continue;
+    // The screens don't share any state, so they can be flushed at the same time.
+    Threading::ThreadPool::the().parallel_for(0, Screen::count(), [&](size_t index) {
+        flush(*Screen::find_by_index(index));
     });
+
+    record_compose_time(compose_start);
 }
 
 void Compositor::flush(Screen& screen)
@@ -659,14 +757,32 @@ void Compositor::flush(Screen& screen)
         screen_data.m_has_flipped = true;
     }
 
-    auto do_flush = [&](Gfx::IntRect rect) {
+    // Large flushes are split into bands that are copied in parallel.
+    Vector<Gfx::IntRect, 32> bands;
+    auto add_flush_rect = [&](Gfx::IntRect rect) {
         VERIFY(screen_rect.contains(rect));
         rect.translate_by(-screen_rect.location());
+        for (int y = rect.top(); y <= rect.bottom(); y += flush_band_height)
+            bands.append({ rect.x(), y, rect.width(), min(flush_band_height, rect.bottom() + 1 - y) });
+        if (device_can_flush_buffers) {
+            // Whether or not we need to flush buffers, we need to at least track what we modified
+            // so that we can flush these areas next time before we flip buffers. Or, if we don't
+            // support buffer flipping then we will flush them shortly.
+            screen.queue_flush_display_rect(rect);
+        }
+    };
+    for (auto& rect : screen_data.m_flush_rects.rects())
+        add_flush_rect(rect);
+    for (auto& rect : screen_data.m_flush_transparent_rects.rects())
+        add_flush_rect(rect);
+    for (auto& rect : screen_data.m_flush_special_rects.rects())
+        add_flush_rect(rect);
 
+    Threading::ThreadPool::the().parallel_for(0, bands.size(), [&](size_t index) {
         // Almost everything in Compositor is in logical coordinates, with the painters having
         // a scale applied. But this routine accesses the backbuffer pixels directly, so it
         // must work in physical coordinates.
-        auto scaled_rect = rect * screen.scale_factor();
+        auto scaled_rect = bands[index] * screen.scale_factor();
         Gfx::RGBA32* front_ptr = screen_data.m_front_bitmap->scanline(scaled_rect.y()) + scaled_rect.x();
         Gfx::RGBA32* back_ptr = screen_data.m_back_bitmap->scanline(scaled_rect.y()) + scaled_rect.x();
         size_t pitch = screen_data.m_back_bitmap->pitch();
@@ -696,19 +812,7 @@ void Compositor::flush(Screen& screen)
             from_ptr = (const Gfx::RGBA32*)((const u8*)from_ptr + pitch);
             to_ptr = (Gfx::RGBA32*)((u8*)to_ptr + pitch);
         }
-        if (device_can_flush_buffers) {
-            // Whether or not we need to flush buffers, we need to at least track what we modified
-            // so that we can flush these areas next time before we flip buffers. Or, if we don't
-            // support buffer flipping then we will flush them shortly.
-            screen.queue_flush_display_rect(rect);
-        }
-    };
-    for (auto& rect : screen_data.m_flush_rects.rects())
-        do_flush(rect);
-    for (auto& rect : screen_data.m_flush_transparent_rects.rects())
-        do_flush(rect);
-    for (auto& rect : screen_data.m_flush_special_rects.rects())
-        do_flush(rect);
+    });
     if (device_can_flush_buffers && !screen_data.m_screen_can_set_buffer) {
         // If we also support flipping buffers we don't really need to flush these areas right now.
         // Instead, we skip this step and just keep track of them until shortly before the next flip.
@@ -1236,20 +1340,20 @@ void Compositor::recompute_occlusions()
                 if (opaque_rects.is_empty() && transparent_rects.is_empty())
                     return IterationDecision::Continue;
                 VERIFY(!opaque_rects.intersects(transparent_rects));
-                for (auto& covering : opaque_rects.rects()) {
-                    opaque_covering.add(covering);
+                if (!opaque_rects.is_empty()) {
+                    opaque_covering.add(opaque_rects);
                     if (!visible_window_rects.is_empty())
-                        visible_window_rects = visible_window_rects.shatter(covering);
+                        visible_window_rects = visible_window_rects.shatter(opaque_rects);
                     if (!visible_opaque.is_empty()) {
-                        auto uncovered_opaque = visible_opaque.shatter(covering);
+                        auto uncovered_opaque = visible_opaque.shatter(opaque_rects);
                         visible_opaque = move(uncovered_opaque);
                     }
                     if (!transparency_rects.is_empty()) {
-                        auto uncovered_transparency = transparency_rects.shatter(covering);
+                        auto uncovered_transparency = transparency_rects.shatter(opaque_rects);
                         transparency_rects = move(uncovered_transparency);
                     }
                     if (!transparent_covering.is_empty()) {
-                        auto uncovered_transparency = transparent_covering.shatter(covering);
+                        auto uncovered_transparency = transparent_covering.shatter(opaque_rects);
                         transparent_covering = move(uncovered_transparency);
                     }
                 }
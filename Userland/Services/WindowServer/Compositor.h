@@ -8,6 +8,7 @@
 
 #include <AK/OwnPtr.h>
 #include <AK/RefPtr.h>
+#include <AK/Time.h>
 #include <LibCore/Object.h>
 #include <LibGfx/Color.h>
 #include <LibGfx/DisjointRectSet.h>
@@ -182,12 +183,32 @@ public:
 
     void set_flash_flush(bool b) { m_flash_flush = b; }
 
+    struct Statistics {
+        u64 frame_count { 0 };
+        u64 last_compose_time_us { 0 };
+        // Weighted towards the most recent frames.
+        u64 average_compose_time_us { 0 };
+        u64 max_compose_time_us { 0 };
+    };
+    Statistics const& statistics() const { return m_statistics; }
+
     static NonnullOwnPtr<CompositorScreenData> create_screen_data(Badge<Screen>)
     {
         return adopt_own(*new CompositorScreenData());
     }
 
 private:
+    // The screens are split into horizontal tiles, which are painted and flushed by several threads at once.
+    static constexpr int minimum_tile_height = 64;
+    static constexpr int flush_band_height = 64;
+
+    struct ComposeTile {
+        Screen* screen { nullptr };
+        Gfx::IntRect rect;
+
+        void set_up_painter(Gfx::Painter&) const;
+    };
+
     Compositor();
     void init_bitmaps();
     void invalidate_current_screen_number_rects();
@@ -203,6 +224,8 @@ private:
     void recompute_occlusions();
     void change_cursor(const Cursor*);
     void flush(Screen&);
+    Vector<ComposeTile> compose_tiles() const;
+    void record_compose_time(Time const& compose_start);
     Gfx::IntPoint window_transition_offset(Window&);
     void update_animations(Screen&, Gfx::DisjointRectSet& flush_rects);
     void create_window_stack_switch_overlay(WindowStack&);
@@ -247,6 +270,8 @@ private:
     Optional<Gfx::Color> m_custom_background_color;
 
     HashTable<Animation*> m_animations;
+
+    Statistics m_statistics;
 };
 
 }
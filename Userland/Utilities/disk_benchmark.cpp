@@ -4,7 +4,9 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Atomic.h>
 #include <AK/ByteBuffer.h>
+#include <AK/Random.h>
 #include <AK/ScopeGuard.h>
 #include <AK/String.h>
 #include <AK/Types.h>
@@ -12,6 +14,7 @@
 #include <LibCore/ElapsedTimer.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/stat.h>
@@ -40,10 +43,12 @@ static Result average_result(const Vector<Result>& results)
 static void exit_with_usage(int rc)
 {
     warnln("Usage: disk_benchmark [-h] [-d directory] [-t time_per_benchmark] [-f file_size1,file_size2,...] [-b block_size1,block_size2,...]");
+    warnln("       disk_benchmark [-h] -D device [-t time_per_benchmark] [-q queue_depth1,queue_depth2,...] [-b block_size1,block_size2,...]");
     exit(rc);
 }
 
 static Optional<Result> benchmark(const String& filename, int file_size, int block_size, ByteBuffer& buffer, bool allow_cache);
+static int benchmark_device(const String& device, int time_per_benchmark, const Vector<size_t>& queue_depths, const Vector<size_t>& block_sizes);
 
 int main(int argc, char** argv)
 {
@@ -51,10 +56,12 @@ int main(int argc, char** argv)
     int time_per_benchmark = 10;
     Vector<size_t> file_sizes;
     Vector<size_t> block_sizes;
+    Vector<size_t> queue_depths;
+    String device;
     bool allow_cache = false;
 
     int opt;
-    while ((opt = getopt(argc, argv, "chd:t:f:b:")) != -1) {
+    while ((opt = getopt(argc, argv, "chd:t:f:b:D:q:")) != -1) {
         switch (opt) {
         case 'h':
             exit_with_usage(0);
@@ -76,9 +83,24 @@ int main(int argc, char** argv)
             for (const auto& size : String(optarg).split(','))
                 block_sizes.append(atoi(size.characters()));
             break;
+        case 'D':
+            device = optarg;
+            break;
+        case 'q':
+            for (const auto& depth : String(optarg).split(','))
+                queue_depths.append(atoi(depth.characters()));
+            break;
         }
     }
 
+    if (!device.is_null()) {
+        if (queue_depths.size() == 0)
+            queue_depths = { 1, 4, 16, 32 };
+        if (block_sizes.size() == 0)
+            block_sizes = { 4096, 65536 };
+        return benchmark_device(device, time_per_benchmark, queue_depths, block_sizes);
+    }
+
     if (file_sizes.size() == 0) {
         file_sizes = { 131072, 262144, 524288, 1048576, 5242880 };
     }
@@ -175,3 +197,88 @@ Optional<Result> benchmark(const String& filename, int file_size, int block_size
     result.read_bps = (u64)(timer.elapsed() ? (file_size / timer.elapsed()) : file_size) * 1000;
     return result;
 }
+
+struct DeviceWorker {
+    int fd { -1 };
+    size_t block_size { 0 };
+    u64 device_size { 0 };
+    bool random { false };
+    u64 next_offset { 0 };
+    u64 completed_reads { 0 };
+    Atomic<bool>* stop { nullptr };
+};
+
+static void* device_worker(void* argument)
+{
+    auto& worker = *static_cast<DeviceWorker*>(argument);
+    auto buffer = ByteBuffer::create_uninitialized(worker.block_size);
+    u64 block_count = worker.device_size / worker.block_size;
+    while (!worker.stop->load()) {
+        u64 offset;
+        if (worker.random) {
+            offset = (((u64)get_random<u32>() << 32) | get_random<u32>()) % block_count * worker.block_size;
+        } else {
+            offset = worker.next_offset;
+            worker.next_offset = (worker.next_offset + worker.block_size) % (block_count * worker.block_size);
+        }
+        if (pread(worker.fd, buffer.data(), worker.block_size, offset) < 0) {
+            perror("pread");
+            break;
+        }
+        worker.completed_reads++;
+    }
+    return nullptr;
+}
+
+// Reads from the device with as many threads as the queue should be deep, each with one read in flight at a time.
+int benchmark_device(const String& device, int time_per_benchmark, const Vector<size_t>& queue_depths, const Vector<size_t>& block_sizes)
+{
+    int fd = open(device.characters(), O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return 1;
+    }
+    auto device_size = lseek(fd, 0, SEEK_END);
+    if (device_size <= 0) {
+        warnln("Could not determine the size of {}", device);
+        close(fd);
+        return 1;
+    }
+
+    for (auto block_size : block_sizes) {
+        for (bool random : { false, true }) {
+            for (auto queue_depth : queue_depths) {
+                Atomic<bool> stop { false };
+                Vector<DeviceWorker> workers;
+                workers.resize(queue_depth);
+                Vector<pthread_t> threads;
+                for (size_t i = 0; i < queue_depth; ++i) {
+                    // Sequential readers each get a stretch of the device of their own.
+                    workers[i] = { fd, block_size, (u64)device_size, random, (u64)device_size / block_size / queue_depth * i * block_size, 0, &stop };
+                    pthread_t thread;
+                    if (pthread_create(&thread, nullptr, device_worker, &workers[i]) != 0) {
+                        perror("pthread_create");
+                        return 1;
+                    }
+                    threads.append(thread);
+                }
+
+                Core::ElapsedTimer timer;
+                timer.start();
+                sleep(time_per_benchmark);
+                stop.store(true);
+                for (auto thread : threads)
+                    pthread_join(thread, nullptr);
+                auto elapsed = max(timer.elapsed(), 1);
+
+                u64 completed_reads = 0;
+                for (auto& worker : workers)
+                    completed_reads += worker.completed_reads;
+                outln("{} reads: block_size={} queue_depth={} iops={} read_bps={}", random ? "Random" : "Sequential", block_size, queue_depth, completed_reads * 1000 / elapsed, completed_reads * block_size * 1000 / elapsed);
+            }
+        }
+    }
+
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,357 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ByteBuffer.h>
+#include <AK/Function.h>
+#include <AK/NonnullOwnPtrVector.h>
+#include <AK/String.h>
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibCore/IORing.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static constexpr char const* source_file_path = "/tmp/io_ring_benchmark_source";
+static constexpr char const* destination_file_path = "/tmp/io_ring_benchmark_destination";
+static constexpr char const* socket_path = "/tmp/io_ring_benchmark.socket";
+
+static size_t s_file_size;
+static size_t s_block_size;
+static unsigned s_queue_depth;
+static int s_clients;
+static int s_rounds;
+static size_t s_message_size;
+
+// How many syscalls the blocking versions make for the actual I/O, to compare with the ring's io_ring_enter() calls.
+static size_t s_syscalls;
+
+static void check(bool condition, char const* what)
+{
+    if (!condition) {
+        perror(what);
+        exit(1);
+    }
+}
+
+static NonnullRefPtr<Core::IORing> make_ring()
+{
+    auto ring_or_error = Core::IORing::create(s_queue_depth);
+    if (ring_or_error.is_error()) {
+        warnln("{}", ring_or_error.error());
+        exit(1);
+    }
+    return ring_or_error.release_value();
+}
+
+static void report(StringView name, i64 elapsed, size_t operations, double mib, size_t syscalls)
+{
+    elapsed = max(elapsed, (i64)1);
+    outln("{:<36} {:>6} ms {:>9.1} MiB/s {:>8} ops {:>8} syscalls", name, elapsed, mib * 1000 / elapsed, operations, syscalls);
+}
+
+// File copy: read a file block by block, and write each block to another file.
+
+static void copy_with_read_and_write(int source_fd, int destination_fd)
+{
+    auto buffer = ByteBuffer::create_uninitialized(s_block_size);
+    for (;;) {
+        auto nread = read(source_fd, buffer.data(), s_block_size);
+        ++s_syscalls;
+        check(nread >= 0, "read");
+        if (nread == 0)
+            return;
+        auto nwritten = write(destination_fd, buffer.data(), nread);
+        ++s_syscalls;
+        check(nwritten == nread, "write");
+    }
+}
+
+// Keeps up to s_queue_depth blocks in flight, and writes each one out as soon as it has been read.
+static size_t copy_with_io_ring(int source_fd, int destination_fd)
+{
+    auto ring = make_ring();
+    size_t block_count = s_file_size / s_block_size;
+    Vector<ByteBuffer> buffers;
+    Vector<size_t> free_buffers;
+    for (size_t i = 0; i < s_queue_depth; ++i) {
+        buffers.append(ByteBuffer::create_uninitialized(s_block_size));
+        free_buffers.append(i);
+    }
+
+    size_t next_block = 0;
+    size_t blocks_written = 0;
+    while (blocks_written < block_count) {
+        while (next_block < block_count && !free_buffers.is_empty()) {
+            auto buffer_index = free_buffers.take_last();
+            auto& buffer = buffers[buffer_index];
+            u64 offset = next_block++ * s_block_size;
+            ring->read(source_fd, buffer.bytes(), [&, buffer_index, offset](int result) {
+                check(result == (int)s_block_size, "io_ring read");
+                ring->write(destination_fd, buffers[buffer_index].bytes(), [&, buffer_index](int result) {
+                    check(result == (int)s_block_size, "io_ring write");
+                    free_buffers.append(buffer_index);
+                    ++blocks_written;
+                },
+                    offset);
+            },
+                offset);
+        }
+        check(ring->submit_and_wait(1), "io_ring_enter");
+    }
+    return ring->enter_count();
+}
+
+struct FileCopyScenario {
+    StringView name;
+    bool use_io_ring;
+};
+
+static void run(FileCopyScenario const& scenario)
+{
+    int source_fd = open(source_file_path, O_RDONLY);
+    int destination_fd = open(destination_file_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    check(source_fd >= 0 && destination_fd >= 0, "open");
+
+    s_syscalls = 0;
+    Core::ElapsedTimer timer;
+    timer.start();
+    if (scenario.use_io_ring)
+        s_syscalls = copy_with_io_ring(source_fd, destination_fd);
+    else
+        copy_with_read_and_write(source_fd, destination_fd);
+    auto elapsed = timer.elapsed();
+
+    close(source_fd);
+    close(destination_fd);
+    unlink(destination_file_path);
+    report(scenario.name, elapsed, s_file_size / s_block_size, (double)s_file_size / MiB, s_syscalls);
+}
+
+// Echo server: s_clients clients each send s_rounds messages, and wait for each one to come back before sending the next.
+
+static sockaddr_un socket_address()
+{
+    sockaddr_un address {};
+    address.sun_family = AF_LOCAL;
+    strlcpy(address.sun_path, socket_path, sizeof(address.sun_path));
+    return address;
+}
+
+static void run_client()
+{
+    auto address = socket_address();
+    int fd = socket(AF_LOCAL, SOCK_STREAM, 0);
+    check(fd >= 0, "socket");
+    check(connect(fd, (sockaddr const*)&address, sizeof(address)) == 0, "connect");
+
+    auto message = ByteBuffer::create_zeroed(s_message_size);
+    for (int round = 0; round < s_rounds; ++round) {
+        check(send(fd, message.data(), s_message_size, 0) == (ssize_t)s_message_size, "send");
+        size_t received = 0;
+        while (received < s_message_size) {
+            auto nreceived = recv(fd, message.data() + received, s_message_size - received, 0);
+            check(nreceived > 0, "recv");
+            received += nreceived;
+        }
+    }
+    close(fd);
+}
+
+static void serve_with_poll(int server_fd)
+{
+    Vector<pollfd> pollfds;
+    for (int i = 0; i < s_clients; ++i) {
+        int fd = accept(server_fd, nullptr, nullptr);
+        ++s_syscalls;
+        check(fd >= 0, "accept");
+        pollfds.append({ fd, POLLIN, 0 });
+    }
+
+    auto buffer = ByteBuffer::create_uninitialized(s_message_size);
+    size_t open_connections = pollfds.size();
+    while (open_connections > 0) {
+        check(poll(pollfds.data(), pollfds.size(), -1) > 0, "poll");
+        ++s_syscalls;
+        for (auto& pollfd : pollfds) {
+            if (pollfd.fd < 0 || !pollfd.revents)
+                continue;
+            auto nreceived = recv(pollfd.fd, buffer.data(), s_message_size, 0);
+            ++s_syscalls;
+            if (nreceived <= 0) {
+                close(pollfd.fd);
+                pollfd.fd = -1;
+                --open_connections;
+                continue;
+            }
+            for (ssize_t sent = 0; sent < nreceived;) {
+                auto nsent = send(pollfd.fd, buffer.data() + sent, nreceived - sent, 0);
+                ++s_syscalls;
+                check(nsent > 0, "send");
+                sent += nsent;
+            }
+        }
+    }
+}
+
+struct Connection {
+    int fd { -1 };
+    ByteBuffer buffer;
+    size_t size { 0 };
+    size_t sent { 0 };
+};
+
+static size_t serve_with_io_ring(int server_fd)
+{
+    auto ring = make_ring();
+    NonnullOwnPtrVector<Connection> connections;
+
+    Function<void(Connection&)> receive;
+    Function<void(Connection&)> send_rest = [&](Connection& connection) {
+        auto bytes = connection.buffer.bytes().slice(connection.sent, connection.size - connection.sent);
+        ring->send(connection.fd, bytes, 0, [&](int result) {
+            check(result > 0, "io_ring send");
+            connection.sent += result;
+            if (connection.sent < connection.size)
+                send_rest(connection);
+            else
+                receive(connection);
+        });
+    };
+    receive = [&](Connection& connection) {
+        ring->recv(connection.fd, connection.buffer.bytes(), 0, [&](int result) {
+            if (result <= 0) {
+                close(connection.fd);
+                return;
+            }
+            connection.size = result;
+            connection.sent = 0;
+            send_rest(connection);
+        });
+    };
+
+    for (int i = 0; i < s_clients; ++i) {
+        ring->accept(server_fd, 0, [&](int result) {
+            check(result >= 0, "io_ring accept");
+            auto connection = make<Connection>();
+            connection->fd = result;
+            connection->buffer = ByteBuffer::create_uninitialized(s_message_size);
+            receive(*connection);
+            connections.append(move(connection));
+        });
+    }
+
+    // Every connection has either a recv or a send in flight until the client goes away.
+    while (ring->operations_in_flight() > 0)
+        check(ring->submit_and_wait(1), "io_ring_enter");
+    return ring->enter_count();
+}
+
+struct EchoScenario {
+    StringView name;
+    bool use_io_ring;
+};
+
+static void run(EchoScenario const& scenario)
+{
+    unlink(socket_path);
+    int server_fd = socket(AF_LOCAL, SOCK_STREAM, 0);
+    check(server_fd >= 0, "socket");
+    auto address = socket_address();
+    check(bind(server_fd, (sockaddr const*)&address, sizeof(address)) == 0, "bind");
+    check(listen(server_fd, s_clients) == 0, "listen");
+
+    s_syscalls = 0;
+    Core::ElapsedTimer timer;
+    timer.start();
+
+    Vector<pid_t> clients;
+    for (int i = 0; i < s_clients; ++i) {
+        pid_t pid = fork();
+        check(pid >= 0, "fork");
+        if (pid == 0) {
+            run_client();
+            _exit(0);
+        }
+        clients.append(pid);
+    }
+
+    if (scenario.use_io_ring)
+        s_syscalls = serve_with_io_ring(server_fd);
+    else
+        serve_with_poll(server_fd);
+    for (auto pid : clients)
+        waitpid(pid, nullptr, 0);
+    auto elapsed = timer.elapsed();
+
+    close(server_fd);
+    unlink(socket_path);
+    size_t messages = (size_t)s_clients * s_rounds;
+    report(scenario.name, elapsed, messages, (double)messages * s_message_size * 2 / MiB, s_syscalls);
+}
+
+int main(int argc, char** argv)
+{
+    int file_size_in_mib = 64;
+    int block_size = 16 * KiB;
+    int queue_depth = 32;
+    int message_size = 512;
+    s_clients = 8;
+    s_rounds = 2000;
+
+    Core::ArgsParser args_parser;
+    args_parser.set_general_help("Compare file and socket I/O with blocking syscalls against batching it on an I/O ring.");
+    args_parser.add_option(file_size_in_mib, "How many MiB to copy", "size", 's', "MiB");
+    args_parser.add_option(block_size, "How many bytes to copy at once", "block-size", 'b', "bytes");
+    args_parser.add_option(queue_depth, "How many entries the I/O ring has, a power of two", "queue-depth", 'q', "entries");
+    args_parser.add_option(s_clients, "How many clients talk to the echo server at once", "clients", 'c', "count");
+    args_parser.add_option(s_rounds, "How many messages each client sends", "rounds", 'r', "count");
+    args_parser.add_option(message_size, "How many bytes each message has", "message-size", 'm', "bytes");
+    args_parser.parse(argc, argv);
+
+    if (file_size_in_mib <= 0 || block_size <= 0 || queue_depth <= 0 || s_clients <= 0 || s_rounds <= 0 || message_size <= 0) {
+        warnln("All the sizes and counts have to be positive");
+        return 1;
+    }
+    s_file_size = (size_t)file_size_in_mib * MiB / block_size * block_size;
+    s_block_size = block_size;
+    s_queue_depth = queue_depth;
+    s_message_size = message_size;
+
+    int source_fd = open(source_file_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    check(source_fd >= 0, "open");
+    auto block = ByteBuffer::create_zeroed(s_block_size);
+    for (size_t offset = 0; offset < s_file_size; offset += s_block_size)
+        check(write(source_fd, block.data(), s_block_size) == (ssize_t)s_block_size, "write");
+    close(source_fd);
+
+    outln("Copying {} MiB in blocks of {} bytes, with up to {} blocks in flight on the ring", s_file_size / MiB, s_block_size, s_queue_depth);
+    FileCopyScenario file_copy_scenarios[] = {
+        { "file copy: read + write", false },
+        { "file copy: io_ring", true },
+    };
+    for (auto& scenario : file_copy_scenarios)
+        run(scenario);
+    unlink(source_file_path);
+
+    outln("Echoing {} messages of {} bytes for each of {} clients", s_rounds, s_message_size, s_clients);
+    EchoScenario echo_scenarios[] = {
+        { "echo: poll + recv + send", false },
+        { "echo: io_ring", true },
+    };
+    for (auto& scenario : echo_scenarios)
+        run(scenario);
+
+    return 0;
+}
@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ByteBuffer.h>
+#include <AK/Function.h>
+#include <AK/String.h>
+#include <AK/StringView.h>
+#include <LibCore/ArgsParser.h>
+#include <LibCore/ElapsedTimer.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static constexpr char const* source_file_path = "/tmp/pipe_benchmark_source";
+static constexpr size_t source_file_size = 16 * MiB;
+
+static size_t s_total_size;
+static size_t s_block_size;
+static int s_pipe_capacity;
+static ByteBuffer s_buffer;
+static int s_source_fd = -1;
+static int s_null_fd = -1;
+
+static void make_pipe(int fds[2])
+{
+    if (pipe(fds) < 0) {
+        perror("pipe");
+        exit(1);
+    }
+    if (s_pipe_capacity && fcntl(fds[1], F_SETPIPE_SZ, s_pipe_capacity) < 0) {
+        perror("fcntl(F_SETPIPE_SZ)");
+        exit(1);
+    }
+}
+
+static void write_all(int fd, u8 const* data, size_t size)
+{
+    while (size > 0) {
+        auto nwritten = write(fd, data, size);
+        if (nwritten < 0) {
+            perror("write");
+            exit(1);
+        }
+        data += nwritten;
+        size -= nwritten;
+    }
+}
+
+static void splice_all(int fd_in, off_t* offset_in, int fd_out, size_t size)
+{
+    while (size > 0) {
+        auto nspliced = splice(fd_in, offset_in, fd_out, nullptr, size, 0);
+        if (nspliced < 0) {
+            perror("splice");
+            exit(1);
+        }
+        if (nspliced == 0)
+            return;
+        size -= nspliced;
+    }
+}
+
+// Producers write s_total_size bytes into the pipe, in blocks of s_block_size.
+
+static void produce_with_write(int fd)
+{
+    for (size_t offset = 0; offset < s_total_size; offset += s_block_size)
+        write_all(fd, s_buffer.data(), s_block_size);
+}
+
+static void produce_from_file_with_read_and_write(int fd)
+{
+    for (size_t offset = 0; offset < s_total_size; offset += s_block_size) {
+        if (pread(s_source_fd, s_buffer.data(), s_block_size, offset % source_file_size) != (ssize_t)s_block_size) {
+            perror("pread");
+            exit(1);
+        }
+        write_all(fd, s_buffer.data(), s_block_size);
+    }
+}
+
+static void produce_from_file_with_splice(int fd)
+{
+    for (size_t offset = 0; offset < s_total_size; offset += s_block_size) {
+        off_t source_offset = offset % source_file_size;
+        splice_all(s_source_fd, &source_offset, fd, s_block_size);
+    }
+}
+
+// Another process writes into a pipe of its own, and this one passes it on, like a stage in a shell pipeline.
+static void relay(int fd, Function<void(int from_fd, int to_fd)> pass_on)
+{
+    int fds[2];
+    make_pipe(fds);
+    pid_t writer = fork();
+    if (writer == 0) {
+        close(fds[0]);
+        produce_with_write(fds[1]);
+        _exit(0);
+    }
+    close(fds[1]);
+    pass_on(fds[0], fd);
+    waitpid(writer, nullptr, 0);
+}
+
+static void relay_with_read_and_write(int fd)
+{
+    relay(fd, [](int from_fd, int to_fd) {
+        for (;;) {
+            auto nread = read(from_fd, s_buffer.data(), s_block_size);
+            if (nread <= 0)
+                return;
+            write_all(to_fd, s_buffer.data(), nread);
+        }
+    });
+}
+
+static void relay_with_splice(int fd)
+{
+    relay(fd, [](int from_fd, int to_fd) {
+        splice_all(from_fd, nullptr, to_fd, s_total_size);
+    });
+}
+
+// Consumers read from the pipe until it's empty and the producer is gone.
+
+static void consume_with_read(int fd)
+{
+    while (read(fd, s_buffer.data(), s_block_size) > 0)
+        ;
+}
+
+static void consume_with_read_and_write(int fd)
+{
+    for (;;) {
+        auto nread = read(fd, s_buffer.data(), s_block_size);
+        if (nread <= 0)
+            return;
+        write_all(s_null_fd, s_buffer.data(), nread);
+    }
+}
+
+static void consume_with_splice(int fd)
+{
+    while (splice(fd, nullptr, s_null_fd, nullptr, s_block_size, 0) > 0)
+        ;
+}
+
+struct Scenario {
+    StringView name;
+    void (*produce)(int fd);
+    void (*consume)(int fd);
+};
+
+static void run(Scenario const& scenario)
+{
+    Core::ElapsedTimer timer;
+    timer.start();
+
+    int fds[2];
+    make_pipe(fds);
+    pid_t producer = fork();
+    if (producer < 0) {
+        perror("fork");
+        exit(1);
+    }
+    if (producer == 0) {
+        close(fds[0]);
+        scenario.produce(fds[1]);
+        _exit(0);
+    }
+    close(fds[1]);
+    scenario.consume(fds[0]);
+    close(fds[0]);
+    waitpid(producer, nullptr, 0);
+
+    auto elapsed = max(timer.elapsed(), 1);
+    double gib_per_second = (double)s_total_size / GiB * 1000 / elapsed;
+    outln("{:<40} {:>6} ms {:>8.2} GiB/s", scenario.name, elapsed, gib_per_second);
+}
+
+int main(int argc, char** argv)
+{
+    int total_size_in_mib = 1024;
+    int block_size = 64 * KiB;
+
+    Core::ArgsParser args_parser;
+    args_parser.set_general_help("Measure how fast data moves through pipes, with read() and write() and with splice().");
+    args_parser.add_option(total_size_in_mib, "How many MiB to move in each benchmark", "size", 's', "MiB");
+    args_parser.add_option(block_size, "How many bytes to move at once", "block-size", 'b', "bytes");
+    args_parser.add_option(s_pipe_capacity, "Pipe capacity to set with F_SETPIPE_SZ", "capacity", 'c', "bytes");
+    args_parser.parse(argc, argv);
+
+    if (total_size_in_mib <= 0 || block_size <= 0 || s_pipe_capacity < 0 || source_file_size % block_size != 0) {
+        warnln("The size and block size have to be positive, and the block size has to divide {}", source_file_size);
+        return 1;
+    }
+    s_total_size = (size_t)total_size_in_mib * MiB / block_size * block_size;
+    s_block_size = block_size;
+    s_buffer = ByteBuffer::create_zeroed(s_block_size);
+
+    s_null_fd = open("/dev/null", O_WRONLY);
+    s_source_fd = open(source_file_path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (s_null_fd < 0 || s_source_fd < 0) {
+        perror("open");
+        return 1;
+    }
+    unlink(source_file_path);
+    for (size_t offset = 0; offset < source_file_size; offset += s_block_size)
+        write_all(s_source_fd, s_buffer.data(), s_block_size);
+
+    outln("Moving {} MiB in blocks of {} bytes, pipe capacity {}", s_total_size / MiB, s_block_size, s_pipe_capacity ? String::number(s_pipe_capacity) : "default");
+
+    Scenario scenarios[] = {
+        { "write -> read", produce_with_write, consume_with_read },
+        { "file: read + write -> read", produce_from_file_with_read_and_write, consume_with_read },
+        { "file: splice -> read", produce_from_file_with_splice, consume_with_read },
+        { "write -> read + write to /dev/null", produce_with_write, consume_with_read_and_write },
+        { "write -> splice to /dev/null", produce_with_write, consume_with_splice },
+        { "write -> relay: read + write -> read", relay_with_read_and_write, consume_with_read },
+        { "write -> relay: splice -> read", relay_with_splice, consume_with_read },
+    };
+    for (auto& scenario : scenarios)
+        run(scenario);
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <AK/Assertions.h>
+#include <AK/Atomic.h>
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/String.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibThreading/Thread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Each thread keeps this many allocations alive at a time, and randomly frees or replaces them.
+static constexpr size_t live_allocations_per_thread = 512;
+static constexpr size_t operations_per_thread = 1'000'000;
+
+// Every so often a thread frees a chunk that was allocated by another one, which is what producer/consumer code does.
+static Array<Atomic<void*>, 256> s_handed_over_allocations;
+
+static void run_thread(u32 seed)
+{
+    struct Allocation {
+        u8* data { nullptr };
+        size_t size { 0 };
+        u8 pattern { 0 };
+    };
+    Array<Allocation, live_allocations_per_thread> allocations;
+
+    auto next_random = [&] {
+        seed = seed * 1103515245 + 12345;
+        return seed >> 8;
+    };
+
+    for (size_t i = 0; i < operations_per_thread; ++i) {
+        auto random = next_random();
+        auto& allocation = allocations[random % live_allocations_per_thread];
+        if (!allocation.data) {
+            // Mostly small allocations, like the ones made by AK containers.
+            allocation.size = 1 + next_random() % (random & 0x100 ? 2000 : 200);
+            allocation.pattern = random >> 16;
+            allocation.data = (u8*)malloc(allocation.size);
+            VERIFY(allocation.data);
+            memset(allocation.data, allocation.pattern, allocation.size);
+            continue;
+        }
+
+        for (size_t j = 0; j < allocation.size; j += 64)
+            VERIFY(allocation.data[j] == allocation.pattern);
+
+        if ((random & 0x3f) == 0)
+            free(s_handed_over_allocations[next_random() % s_handed_over_allocations.size()].exchange(allocation.data));
+        else
+            free(allocation.data);
+        allocation.data = nullptr;
+    }
+
+    for (auto& allocation : allocations)
+        free(allocation.data);
+}
+
+static void benchmark(size_t threads_count)
+{
+    NonnullRefPtrVector<Threading::Thread> threads;
+    Core::ElapsedTimer timer;
+    timer.start();
+
+    for (size_t i = 0; i < threads_count; i++) {
+        threads.append(Threading::Thread::construct([i] {
+            run_thread(i + 1);
+            return 0;
+        }));
+        threads.last().start();
+    }
+    for (auto& thread : threads)
+        [[maybe_unused]] auto res = thread.join();
+
+    auto elapsed_ms = max(timer.elapsed(), 1);
+    auto operations = threads_count * operations_per_thread;
+    outln("{} threads: {} ms, {} operations/ms", threads_count, elapsed_ms, operations / elapsed_ms);
+}
+
+int main(int argc, char** argv)
+{
+    size_t max_threads_count = 8;
+    if (argc >= 2) {
+        auto number = String(argv[1]).to_uint();
+        if (!number.has_value() || number.value() == 0) {
+            warnln("usage: test-malloc [max number of threads]");
+            return 1;
+        }
+        max_threads_count = number.value();
+    }
+
+    for (size_t threads_count = 1; threads_count <= max_threads_count; threads_count *= 2)
+        benchmark(threads_count);
+
+    for (auto& allocation : s_handed_over_allocations)
+        free(allocation.exchange(nullptr));
+
+    return 0;
+}